@@ -0,0 +1,41 @@
+// Resident memory of the benchmark process, shared by the separation benchmarks.
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+ #include <psapi.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#elif JUCE_LINUX
+ #include <unistd.h>
+#endif
+
+namespace undergroundBeats {
+namespace benchmarks {
+
+// Resident memory of this process in bytes, or 0 where it can't be read
+inline juce::int64 getResidentBytes()
+{
+#if JUCE_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return (juce::int64) counters.WorkingSetSize;
+#elif JUCE_MAC
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) == KERN_SUCCESS)
+        return (juce::int64) info.resident_size;
+#elif JUCE_LINUX
+    // The second field of statm is the resident size in pages
+    const auto fields = juce::StringArray::fromTokens(juce::File("/proc/self/statm").loadFileAsString(), false);
+    if (fields.size() > 1)
+        return fields[1].getLargeIntValue() * (juce::int64) sysconf(_SC_PAGESIZE);
+#endif
+    return 0;
+}
+
+} // namespace benchmarks
+} // namespace undergroundBeats
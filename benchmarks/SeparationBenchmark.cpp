@@ -0,0 +1,268 @@
+// Measures separation throughput for each ONNX Runtime session configuration.
+//
+// Usage: SeparationBenchmark <model.onnx> [seconds]
+//
+// A synthetic stereo mix of the given length (default 30 s) is separated once per
+// configuration. For each one the benchmark prints the time to create and warm up the
+// session, the time to separate the mix, and how many times faster than real time that is.
+//
+// The mix is then separated with the default settings and 1, 2, 4... windows in flight at
+// once, up to the number of physical cores, printing the speed-up over one window at a time.
+//
+// If the model has a quantized variant beside it (<model>_int8.onnx), both variants then
+// separate the same mix with the default settings, and the benchmark also prints how much
+// resident memory each one's session adds and the peak while it separates.
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include "undergroundBeats/ml/ONNXModelLoader.h"
+#include "undergroundBeats/ml/ONNXSourceSeparator.h"
+#include "ProcessMemory.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+using namespace undergroundBeats::ml;
+using undergroundBeats::benchmarks::getResidentBytes;
+
+namespace {
+
+constexpr double sampleRate = 44100.0;
+
+using Settings = ONNXModelLoader::SessionSettings;
+
+juce::AudioBuffer<float> makeMix(int seconds)
+{
+    juce::AudioBuffer<float> mix(2, (int) sampleRate * seconds);
+    juce::Random random(1);
+
+    // A bass line, a lead and noise bursts as drums, so the model has something to separate
+    for (int i = 0; i < mix.getNumSamples(); ++i)
+    {
+        const double t = i / sampleRate;
+        const float bass = 0.3f * (float) std::sin(juce::MathConstants<double>::twoPi * 55.0 * t);
+        const float lead = 0.2f * (float) std::sin(juce::MathConstants<double>::twoPi * 440.0 * t);
+        const float drums = std::fmod(t, 0.5) < 0.05 ? 0.5f * (random.nextFloat() * 2.0f - 1.0f) : 0.0f;
+
+        mix.setSample(0, i, bass + lead + drums);
+        mix.setSample(1, i, bass - lead + drums);
+    }
+
+    return mix;
+}
+
+juce::String formatMegabytes(juce::int64 bytes)
+{
+    return juce::String((double) bytes / (1024.0 * 1024.0), 1) + " MB";
+}
+
+std::vector<Settings> makeConfigurations()
+{
+    std::vector<Settings> configurations;
+    const int cores = juce::SystemStats::getNumPhysicalCpus();
+
+    configurations.push_back({}); // The app's default
+
+    for (int threads : { 1, 2, cores })
+    {
+        Settings settings;
+        settings.useSharedThreadPools = false;
+        settings.intraOpThreads = threads;
+        configurations.push_back(settings);
+    }
+
+    Settings parallel;
+    parallel.useSharedThreadPools = false;
+    parallel.intraOpThreads = cores;
+    parallel.interOpThreads = 2;
+    parallel.executionMode = Settings::ExecutionMode::Parallel;
+    configurations.push_back(parallel);
+
+    Settings basic;
+    basic.optimization = Settings::Optimization::Basic;
+    configurations.push_back(basic);
+
+    for (auto provider : { Settings::Provider::Xnnpack, Settings::Provider::OneDnn })
+    {
+        if (!ONNXModelLoader::isProviderAvailable(provider))
+            continue;
+
+        Settings settings;
+        settings.useSharedThreadPools = false;
+        settings.intraOpThreads = cores;
+        settings.provider = provider;
+        configurations.push_back(settings);
+    }
+
+    return configurations;
+}
+
+void measure(ONNXModelLoader& loader, const std::string& modelPath, const Settings& settings,
+             const juce::AudioBuffer<float>& mix)
+{
+    loader.clearSessions();
+    loader.setSessionSettings(settings);
+
+    const auto loadStart = juce::Time::getHighResolutionTicks();
+    ONNXSourceSeparator separator(modelPath, loader);
+    const auto loadSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - loadStart);
+
+    // One window at a time, so only the session settings differ
+    separator.setParallelWindows(1);
+
+    std::cout << juce::String(settings.describe()).paddedRight(' ', 40);
+
+    if (!separator.isReady())
+    {
+        std::cout << "failed to load" << std::endl;
+        return;
+    }
+
+    const auto start = juce::Time::getHighResolutionTicks();
+    const bool separated = separator.separate(mix, sampleRate);
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    if (!separated)
+    {
+        std::cout << "separation failed" << std::endl;
+        return;
+    }
+
+    const auto audioSeconds = mix.getNumSamples() / sampleRate;
+    std::cout << juce::String(loadSeconds, 2).paddedLeft(' ', 7) << " s load"
+              << juce::String(seconds, 2).paddedLeft(' ', 8) << " s separate"
+              << juce::String(audioSeconds / seconds, 1).paddedLeft(' ', 7) << "x real time" << std::endl;
+}
+
+// Separates the mix with more and more windows in flight, each on the shared session
+void measureParallelWindows(ONNXModelLoader& loader, const std::string& modelPath, const juce::AudioBuffer<float>& mix)
+{
+    loader.clearSessions();
+    loader.setSessionSettings({});
+
+    ONNXSourceSeparator separator(modelPath, loader);
+    if (!separator.isReady())
+    {
+        std::cout << "failed to load" << std::endl;
+        return;
+    }
+
+    const auto audioSeconds = mix.getNumSamples() / sampleRate;
+    double oneWindowSeconds = 0.0;
+
+    for (int windows = 1; windows <= juce::SystemStats::getNumPhysicalCpus(); windows *= 2)
+    {
+        separator.setParallelWindows(windows);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        const bool separated = separator.separate(mix, sampleRate);
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+        std::cout << (juce::String(windows) + " windows").paddedRight(' ', 12);
+
+        if (!separated)
+        {
+            std::cout << "separation failed" << std::endl;
+            return;
+        }
+
+        if (windows == 1)
+            oneWindowSeconds = seconds;
+
+        const auto& timings = separator.getLastTimings();
+        std::cout << juce::String(seconds, 2).paddedLeft(' ', 7) << " s separate"
+                  << juce::String(audioSeconds / seconds, 1).paddedLeft(' ', 7) << "x real time"
+                  << juce::String(oneWindowSeconds / seconds, 2).paddedLeft(' ', 7) << "x speed-up"
+                  << juce::String(timings.inferenceSeconds, 2).paddedLeft(' ', 8) << " s in inference" << std::endl;
+    }
+}
+
+// Separates the mix with one model variant, sampling resident memory while it runs
+void measureVariant(ONNXModelLoader& loader, const std::string& modelPath, ModelVariant variant,
+                    const juce::AudioBuffer<float>& mix)
+{
+    loader.clearSessions();
+    loader.setSessionSettings({});
+
+    const auto residentBefore = getResidentBytes();
+    const auto loadStart = juce::Time::getHighResolutionTicks();
+    ONNXSourceSeparator separator(ONNXSourceSeparator::getVariantPath(modelPath, variant), loader);
+    const auto loadSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - loadStart);
+    const auto residentLoaded = getResidentBytes();
+
+    std::cout << juce::String(ONNXSourceSeparator::getVariantName(variant)).paddedRight(' ', 10);
+
+    if (!separator.isReady())
+    {
+        std::cout << "failed to load" << std::endl;
+        return;
+    }
+
+    std::atomic<bool> separating { true };
+    std::atomic<juce::int64> peakResident { residentLoaded };
+    std::thread sampler([&]
+    {
+        while (separating.load())
+        {
+            peakResident = juce::jmax(peakResident.load(), getResidentBytes());
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    const auto start = juce::Time::getHighResolutionTicks();
+    const bool separated = separator.separate(mix, sampleRate);
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    separating = false;
+    sampler.join();
+
+    if (!separated)
+    {
+        std::cout << "separation failed" << std::endl;
+        return;
+    }
+
+    std::cout << juce::String(loadSeconds, 2).paddedLeft(' ', 7) << " s load"
+              << juce::String(seconds, 2).paddedLeft(' ', 8) << " s separate"
+              << formatMegabytes(residentLoaded - residentBefore).paddedLeft(' ', 11) << " session"
+              << formatMegabytes(peakResident.load()).paddedLeft(' ', 11) << " peak" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: SeparationBenchmark <model.onnx> [seconds]" << std::endl;
+        return 1;
+    }
+
+    const std::string modelPath = argv[1];
+    const int seconds = argc > 2 ? juce::jmax(1, juce::String(argv[2]).getIntValue()) : 30;
+
+    std::cout << "Separating a " << seconds << " s stereo mix with " << modelPath << std::endl;
+
+    const auto mix = makeMix(seconds);
+    ONNXModelLoader loader;
+
+    for (const auto& settings : makeConfigurations())
+        measure(loader, modelPath, settings, mix);
+
+    std::cout << std::endl << "Windows separated at once, default settings" << std::endl;
+    measureParallelWindows(loader, modelPath, mix);
+
+    const auto fastPath = ONNXSourceSeparator::getVariantPath(modelPath, ModelVariant::Fast);
+    if (juce::File::getCurrentWorkingDirectory().getChildFile(fastPath).existsAsFile())
+    {
+        std::cout << std::endl << "Model variants, default settings" << std::endl;
+
+        // The quantized model goes first, so the larger one's pages don't count towards its peak
+        for (auto variant : { ModelVariant::Fast, ModelVariant::Quality })
+            measureVariant(loader, modelPath, variant, mix);
+    }
+
+    return 0;
+}
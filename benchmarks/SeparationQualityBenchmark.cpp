@@ -0,0 +1,334 @@
+// Measures how well and how fast each registered separator separates a synthetic mix.
+//
+// Usage: SeparationQualityBenchmark [seconds] [output.json]
+//
+// Four stems (drums, bass, vocals, other) are generated, so the true sources are known
+// without any dataset, and summed into a stereo mix of the given length (default 30 s).
+// Every backend of the default SeparatorRegistry, in each variant that is installed, then
+// separates the mix. Run it from the directory holding models/, as the app is.
+//
+// For each run the benchmark reports, per stem, the SDR and scale-invariant SDR of the
+// estimate against its source and the SDR of the unseparated mix as a baseline; the real
+// time factor; the resident memory the session adds and the peak while it separates; and
+// the time spent loading the session, preparing windows, in ONNX Runtime and adding the
+// windows into the stems. Stems a backend makes that weren't generated (e.g. "rest" or
+// "accompaniment") are scored against the mix minus the backend's other stems.
+//
+// The results are written as JSON, to the file if one is given and to stdout otherwise,
+// so runs before and after a change to the models or the pipeline can be compared.
+// Backends whose model isn't installed are listed with "available": false.
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include "undergroundBeats/ml/ONNXModelLoader.h"
+#include "undergroundBeats/ml/ONNXSourceSeparator.h"
+#include "undergroundBeats/ml/SeparatorRegistry.h"
+#include "ProcessMemory.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <thread>
+
+using namespace undergroundBeats::ml;
+using undergroundBeats::benchmarks::getResidentBytes;
+
+namespace {
+
+constexpr double sampleRate = 44100.0;
+constexpr double tempo = 120.0;
+
+// Keeps the ratios finite for silent references and perfect estimates
+constexpr double energyFloor = 1.0e-12;
+
+struct Track
+{
+    juce::AudioBuffer<float> mix;
+    std::map<std::string, juce::AudioBuffer<float>> stems;
+};
+
+double sine(double frequency, double t)
+{
+    return std::sin(juce::MathConstants<double>::twoPi * frequency * t);
+}
+
+// Each stem has the character the models are trained on: percussive noise and a pitched
+// kick, a low harmonic line, a vibrato lead in phrases with gaps, and a wide sustained pad
+Track makeTrack(int seconds)
+{
+    const int numSamples = (int) sampleRate * seconds;
+    const double beat = 60.0 / tempo;
+    const double bassNotes[] = { 55.0, 55.0, 73.42, 65.41 };
+    const double leadNotes[] = { 440.0, 493.88, 523.25, 587.33, 523.25, 493.88 };
+    const double chord[] = { 220.0, 261.63, 329.63 };
+
+    Track track;
+    for (const char* name : { "drums", "bass", "vocals", "other" })
+        track.stems[name].setSize(2, numSamples);
+
+    auto& drums = track.stems["drums"];
+    auto& bass = track.stems["bass"];
+    auto& vocals = track.stems["vocals"];
+    auto& other = track.stems["other"];
+    juce::Random random(1);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const double t = i / sampleRate;
+        const double beatTime = std::fmod(t, beat);
+        const double offBeatTime = std::fmod(t + beat / 2.0, beat);
+        const int bar = (int) (t / (4.0 * beat));
+
+        const double kick = 0.6 * std::exp(-beatTime * 18.0) * sine(50.0 + 60.0 * std::exp(-beatTime * 30.0), beatTime);
+        const double hat = 0.15 * std::exp(-offBeatTime * 60.0) * (random.nextDouble() * 2.0 - 1.0);
+        drums.setSample(0, i, (float) (kick + hat));
+        drums.setSample(1, i, (float) (kick + 0.8 * hat));
+
+        const double bassFrequency = bassNotes[bar % 4];
+        double bassSample = 0.0;
+        for (int harmonic = 1; harmonic <= 4; ++harmonic)
+            bassSample += 0.25 / harmonic * sine(bassFrequency * harmonic, t);
+        bass.setSample(0, i, (float) bassSample);
+        bass.setSample(1, i, (float) bassSample);
+
+        // Two beats sung, then two beats of silence
+        const bool singing = std::fmod(t, 4.0 * beat) < 2.0 * beat;
+        const double leadFrequency = leadNotes[(int) (t / beat) % 6] * (1.0 + 0.01 * sine(5.5, t));
+        const double lead = singing ? 0.2 * (sine(leadFrequency, t) + 0.3 * sine(2.0 * leadFrequency, t)
+                                             + 0.1 * sine(3.0 * leadFrequency, t))
+                                    : 0.0;
+        vocals.setSample(0, i, (float) (0.6 * lead));
+        vocals.setSample(1, i, (float) (0.4 * lead));
+
+        const double swell = 0.5 + 0.5 * sine(0.125, t);
+        other.setSample(0, i, (float) (0.08 * swell * (sine(chord[0], t) + sine(chord[1], t))));
+        other.setSample(1, i, (float) (0.08 * swell * (sine(chord[1], t) + sine(chord[2], t))));
+    }
+
+    track.mix.setSize(2, numSamples);
+    track.mix.clear();
+    for (const auto& stem : track.stems)
+        for (int ch = 0; ch < 2; ++ch)
+            track.mix.addFrom(ch, 0, stem.second, ch, 0, numSamples);
+
+    return track;
+}
+
+// The source a backend's stem should recover: a generated stem, or for complements such
+// as "rest" the mix minus the backend's generated stems
+juce::AudioBuffer<float> getReference(const Track& track, const std::vector<std::string>& stemNames, const std::string& name)
+{
+    const auto generated = track.stems.find(name);
+    if (generated != track.stems.end())
+        return generated->second;
+
+    juce::AudioBuffer<float> reference(track.mix);
+    for (const auto& other : stemNames)
+    {
+        const auto stem = track.stems.find(other);
+        if (stem != track.stems.end())
+            for (int ch = 0; ch < reference.getNumChannels(); ++ch)
+                reference.addFrom(ch, 0, stem->second, ch, 0, reference.getNumSamples(), -1.0f);
+    }
+
+    return reference;
+}
+
+// Both are taken over every channel at once, as the usual evaluation tools do
+struct Scores
+{
+    double sdr = 0.0;
+    double siSdr = 0.0;
+};
+
+Scores score(const juce::AudioBuffer<float>& reference, const juce::AudioBuffer<float>& estimate)
+{
+    double referenceEnergy = 0.0, errorEnergy = 0.0, dot = 0.0;
+    const int numChannels = juce::jmin(reference.getNumChannels(), estimate.getNumChannels());
+    const int numSamples = juce::jmin(reference.getNumSamples(), estimate.getNumSamples());
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* r = reference.getReadPointer(ch);
+        const float* e = estimate.getReadPointer(ch);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            referenceEnergy += (double) r[i] * r[i];
+            errorEnergy += ((double) r[i] - e[i]) * ((double) r[i] - e[i]);
+            dot += (double) r[i] * e[i];
+        }
+    }
+
+    // SI-SDR scales the reference to best fit the estimate, so a gain error isn't counted as distortion
+    const double scale = dot / (referenceEnergy + energyFloor);
+    double targetEnergy = 0.0, residualEnergy = 0.0;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* r = reference.getReadPointer(ch);
+        const float* e = estimate.getReadPointer(ch);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double target = scale * r[i];
+            targetEnergy += target * target;
+            residualEnergy += (e[i] - target) * (e[i] - target);
+        }
+    }
+
+    Scores scores;
+    scores.sdr = 10.0 * std::log10((referenceEnergy + energyFloor) / (errorEnergy + energyFloor));
+    scores.siSdr = 10.0 * std::log10((targetEnergy + energyFloor) / (residualEnergy + energyFloor));
+    return scores;
+}
+
+double round3(double value)
+{
+    return std::round(value * 1000.0) / 1000.0;
+}
+
+juce::var measure(ONNXModelLoader& loader, const SeparatorRegistry::Backend& backend, ModelVariant variant,
+                  const Track& track)
+{
+    auto* run = new juce::DynamicObject();
+    juce::var result(run);
+    run->setProperty("backend", juce::String(backend.capabilities.id));
+    run->setProperty("variant", ONNXSourceSeparator::getVariantName(variant));
+    run->setProperty("model", juce::String(SeparatorRegistry::getModelPath(backend, variant)));
+    run->setProperty("available", SeparatorRegistry::isAvailable(backend));
+
+    if (!SeparatorRegistry::isAvailable(backend))
+        return result;
+
+    loader.clearSessions();
+
+    const auto residentBefore = getResidentBytes();
+    const auto loadStart = juce::Time::getHighResolutionTicks();
+    auto separator = backend.create(loader, variant);
+    const auto loadSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - loadStart);
+    const auto residentLoaded = getResidentBytes();
+
+    if (separator == nullptr || !separator->isReady())
+    {
+        run->setProperty("error", "failed to load");
+        return result;
+    }
+
+    std::atomic<bool> separating { true };
+    std::atomic<juce::int64> peakResident { residentLoaded };
+    std::thread sampler([&]
+    {
+        while (separating.load())
+        {
+            peakResident = juce::jmax(peakResident.load(), getResidentBytes());
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    const auto start = juce::Time::getHighResolutionTicks();
+    auto stems = separator->process(track.mix);
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    separating = false;
+    sampler.join();
+
+    const auto names = separator->getSourceNames();
+    if (stems.size() != names.size())
+    {
+        run->setProperty("error", "separation failed");
+        return result;
+    }
+
+    const double audioSeconds = track.mix.getNumSamples() / sampleRate;
+    run->setProperty("realtimeFactor", round3(audioSeconds / seconds));
+    run->setProperty("sessionResidentBytes", residentLoaded - residentBefore);
+    run->setProperty("peakResidentBytes", peakResident.load());
+
+    auto* stages = new juce::DynamicObject();
+    stages->setProperty("loadSeconds", round3(loadSeconds));
+    stages->setProperty("separateSeconds", round3(seconds));
+    if (auto* onnx = dynamic_cast<ONNXSourceSeparator*>(separator.get()))
+    {
+        const auto& timings = onnx->getLastTimings();
+        stages->setProperty("preprocessSeconds", round3(timings.preprocessSeconds));
+        stages->setProperty("inferenceSeconds", round3(timings.inferenceSeconds));
+        stages->setProperty("postprocessSeconds", round3(timings.postprocessSeconds));
+        stages->setProperty("windows", timings.numWindows);
+    }
+    run->setProperty("stages", juce::var(stages));
+
+    juce::Array<juce::var> stemScores;
+    double sdrSum = 0.0, siSdrSum = 0.0;
+
+    for (const auto& name : names)
+    {
+        const auto reference = getReference(track, names, name);
+        const auto scores = score(reference, stems[name]);
+        const auto baseline = score(reference, track.mix);
+
+        auto* stem = new juce::DynamicObject();
+        stem->setProperty("name", juce::String(name));
+        stem->setProperty("sdr", round3(scores.sdr));
+        stem->setProperty("siSdr", round3(scores.siSdr));
+        stem->setProperty("mixSdr", round3(baseline.sdr));
+        stemScores.add(juce::var(stem));
+
+        sdrSum += scores.sdr;
+        siSdrSum += scores.siSdr;
+    }
+
+    run->setProperty("stems", stemScores);
+    run->setProperty("meanSdr", round3(sdrSum / (double) names.size()));
+    run->setProperty("meanSiSdr", round3(siSdrSum / (double) names.size()));
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const int seconds = argc > 1 ? juce::jmax(1, juce::String(argv[1]).getIntValue()) : 30;
+    const juce::File output = argc > 2 ? juce::File::getCurrentWorkingDirectory().getChildFile(argv[2]) : juce::File();
+
+    std::cerr << "Separating a " << seconds << " s synthetic mix with every registered separator" << std::endl;
+
+    const auto track = makeTrack(seconds);
+    const auto registry = SeparatorRegistry::createDefault();
+    ONNXModelLoader loader;
+    juce::Array<juce::var> runs;
+
+    for (const auto& backend : registry.getBackends())
+    {
+        for (auto variant : { ModelVariant::Quality, ModelVariant::Fast })
+        {
+            // A missing quantized model would only run the full-precision one again
+            if (SeparatorRegistry::getAvailableVariant(backend, variant) != variant)
+                continue;
+
+            std::cerr << "  " << backend.capabilities.id << " (" << ONNXSourceSeparator::getVariantName(variant) << ")" << std::endl;
+            runs.add(measure(loader, backend, variant, track));
+        }
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("audioSeconds", seconds);
+    report->setProperty("sampleRate", sampleRate);
+    report->setProperty("cpus", juce::SystemStats::getNumCpus());
+    report->setProperty("runs", runs);
+
+    const auto json = juce::JSON::toString(juce::var(report));
+
+    if (output == juce::File())
+    {
+        std::cout << json << std::endl;
+    }
+    else if (!output.replaceWithText(json))
+    {
+        std::cerr << "Could not write " << output.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
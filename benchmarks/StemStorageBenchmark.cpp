@@ -0,0 +1,80 @@
+// Measures what the render loop pays to read a block from each kind of in-memory stem.
+//
+// Usage: StemStorageBenchmark [blockSize]
+//
+// For every source type the benchmark reads a four-minute stereo stem block by block,
+// as renderStems() does, and prints the average cost per block and per sample, the
+// share of the block's real-time budget at 48 kHz, and the RAM the stem occupies.
+
+#include <juce_core/juce_core.h>
+#include "undergroundBeats/audio/CompactStemSource.h"
+#include "undergroundBeats/audio/StemSource.h"
+#include <iostream>
+
+using namespace undergroundBeats::audio;
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int stemSeconds = 240;
+constexpr int passes = 5;
+
+juce::AudioBuffer<float> makeStem()
+{
+    juce::AudioBuffer<float> stem(2, (int) sampleRate * stemSeconds);
+    juce::Random random(1);
+
+    for (int ch = 0; ch < stem.getNumChannels(); ++ch)
+        for (int i = 0; i < stem.getNumSamples(); ++i)
+            stem.setSample(ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+    return stem;
+}
+
+void measure(const char* name, StemSource& source, int blockSize)
+{
+    juce::AudioBuffer<float> block(2, blockSize);
+    const auto length = source.getLengthInSamples();
+    juce::int64 blocks = 0;
+    float guard = 0.0f; // Keeps the reads from being optimised away
+
+    const auto start = juce::Time::getHighResolutionTicks();
+
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (juce::int64 position = 0; position + blockSize <= length; position += blockSize)
+        {
+            source.read(block, 0, blockSize, position);
+            guard += block.getSample(1, blockSize - 1);
+            ++blocks;
+        }
+    }
+
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    const auto nanosecondsPerBlock = seconds * 1.0e9 / (double) blocks;
+    const auto budgetNanoseconds = blockSize / sampleRate * 1.0e9;
+
+    std::cout << juce::String(name).paddedRight(' ', 10)
+              << juce::String(nanosecondsPerBlock, 1).paddedLeft(' ', 10) << " ns/block"
+              << juce::String(nanosecondsPerBlock / blockSize, 3).paddedLeft(' ', 8) << " ns/sample"
+              << juce::String(100.0 * nanosecondsPerBlock / budgetNanoseconds, 4).paddedLeft(' ', 9) << " % of budget"
+              << juce::String((double) source.getResidentBytes() / (1024.0 * 1024.0), 1).paddedLeft(' ', 8) << " MB"
+              << (guard == 12345.0f ? " " : "") << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const int blockSize = argc > 1 ? juce::jmax(16, juce::String(argv[1]).getIntValue()) : 512;
+
+    std::cout << "Reading a " << stemSeconds << " s stereo stem in blocks of " << blockSize << " samples" << std::endl;
+
+    auto stem = makeStem();
+    MemoryStemSource memory(SharedAudio::copyOf(stem));
+    CompactStemSource compact(stem);
+
+    measure("float32", memory, blockSize);
+    measure("float16", compact, blockSize);
+    return 0;
+}
@@ -8,10 +8,21 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_gui_extra/juce_gui_extra.h>
 #include <juce_dsp/juce_dsp.h>
+#include <array>
 #include <vector>
 #include <atomic> // For atomic flag
 #include <functional>
 #include "ml/ONNXModelLoader.h" // Use quotes for local header
+#include "ml/SeparatorRegistry.h"
+#include "audio/AutomationEngine.h"
+#include "audio/BatchImportQueue.h"
+#include "audio/MidiControlMap.h"
+#include "audio/StemSlicePlayer.h"
+#include "audio/PresetMorphEngine.h"
+#include "audio/OfflineRenderer.h"
+#include "audio/StemLoadPipeline.h"
+#include "audio/StemRenderer.h"
+#include "audio/StemSource.h"
 
 // Add a namespace to match the namespace used in Main.cpp
 namespace undergroundBeats {
@@ -21,7 +32,8 @@ namespace undergroundBeats {
  * The main audio processing class for UndergroundBeats.
  * Handles audio processing, parameter management, and playback state.
 */
-class UndergroundBeatsProcessor  : public juce::AudioProcessor
+class UndergroundBeatsProcessor  : public juce::AudioProcessor,
+                                   private juce::AudioProcessorParameter::Listener
 {
 public:
     //==============================================================================
@@ -65,12 +77,82 @@ public:
     // File Loading Methods
     //==============================================================================
     /**
-     * Load an audio file for processing
+     * Load an audio file for processing. Blocks until the file is decoded and separated;
+     * UI code should use loadAudioFileAsync() instead.
      * @param audioFile The file to load
      * @return true if the file was loaded successfully, false otherwise
      */
     bool loadAudioFile(const juce::File& audioFile);
 
+    /**
+     * Starts loading an audio file on a background thread, cancelling any load in
+     * progress. The stems are published when separation finishes.
+     * @param audioFile The file to load
+     * @return true if the load was started, false if the file does not exist
+     */
+    bool loadAudioFileAsync(const juce::File& audioFile);
+
+    /** Returns the background load pipeline, e.g. to listen for progress. */
+    audio::StemLoadPipeline& getLoadPipeline();
+
+    /**
+     * Chooses whether stems of files loaded from now on stay in RAM or are streamed from
+     * a PCM cache on disk. Streamed stems keep about ramBudgetMegabytes resident in total.
+     */
+    void setStreamingPlayback(bool shouldStream, int ramBudgetMegabytes = defaultStreamingBudgetMegabytes);
+
+    /** Returns true if newly loaded stems are streamed from disk. */
+    bool isStreamingPlayback() const;
+
+    /**
+     * Stores stems of files loaded from now on that are held in RAM as half-precision
+     * floats, halving their memory. Slice pads don't play compact stems.
+     */
+    void setHalfPrecisionStems(bool shouldUseHalfPrecision);
+
+    /** Returns true if newly loaded in-memory stems are stored as half-precision floats. */
+    bool isHalfPrecisionStems() const;
+
+    /**
+     * Chooses the separation model for files loaded from now on: Fast runs the INT8
+     * quantized model if it is installed, Quality the full-precision one. Each variant's
+     * stems are cached apart, and the chosen model is preloaded.
+     */
+    void setSeparationVariant(ml::ModelVariant variant);
+
+    /** Returns the separation model variant that new loads ask for. */
+    ml::ModelVariant getSeparationVariant() const;
+
+    /**
+     * Chooses the separator for files loaded from now on: the cheapest installed backend
+     * that separates every stem asked for, e.g. a 2-stem vocals model for {"vocals"}.
+     * An empty list goes back to the default 4-stem model. Its model is preloaded.
+     * @return False if no installed backend gives those stems; the choice is unchanged then.
+     */
+    bool setRequestedStems(const std::vector<std::string>& stems);
+
+    /** Returns the separator backends new loads can choose from. */
+    const ml::SeparatorRegistry& getSeparatorRegistry() const { return separatorRegistry; }
+
+    /**
+     * Queues files to be decoded and separated in the background without loading them,
+     * so they load from the separation cache later. Missing files are skipped.
+     */
+    void importFilesInBackground(const juce::Array<juce::File>& audioFiles);
+
+    /** Returns the background import queue, e.g. to show its jobs or change its limits. */
+    audio::BatchImportQueue& getBatchImportQueue();
+
+    /**
+     * Starts bouncing the timeline to files in the background, with the current parameter
+     * values and automation. Progress and the outcome are reported by getOfflineRenderer().
+     * @return false if no stems are loaded or a render is already running
+     */
+    bool startOfflineRender(const audio::OfflineRenderer::Options& options);
+
+    /** Returns the offline renderer, e.g. to show its progress or cancel it. */
+    audio::OfflineRenderer& getOfflineRenderer();
+
     //==============================================================================
 
     /**
@@ -83,8 +165,14 @@ public:
 
     // Stem Access (NEW)
     //==============================================================================
-    /** Returns a constant reference to the vector of separated stem audio buffers. */
-    const std::vector<juce::AudioBuffer<float>>& getSeparatedStemBuffers() const;
+    /**
+     * Returns the stems, each held in RAM or streamed from disk. Stems are immutable once
+     * loaded and shared by reference, so snapshots (e.g. undo history) never copy audio.
+     */
+    const std::vector<audio::StemSourcePtr>& getStemSources() const;
+
+    /** Returns what each stem holds (e.g. "vocals"), in the order of getStemSources(). */
+    const std::vector<std::string>& getStemNames() const { return stemNames; }
 
 
     //==============================================================================
@@ -105,6 +193,64 @@ public:
     /** Returns true if audio playback is currently paused. */
     bool isPaused() const;
 
+    /** Returns the playback position (in samples) at the start of the last rendered block. */
+    juce::int64 getPlaybackPosition() const;
+
+    //==============================================================================
+    // Automation
+    //==============================================================================
+    /** Arms or disarms automation recording. Disarming commits the recorded moves. */
+    void setAutomationRecording(bool shouldRecord);
+
+    /** Returns true while automation recording is armed. */
+    bool isAutomationRecording() const;
+
+    /** Returns the automation engine holding one lane per parameter. */
+    audio::AutomationEngine& getAutomationEngine();
+
+    //==============================================================================
+    // MIDI Control
+    //==============================================================================
+    /** Binds the next incoming MIDI CC to the parameter with this ID. */
+    void beginMidiLearn(const juce::String& parameterID);
+
+    /** Removes all MIDI CC bindings of the parameter with this ID. */
+    void clearMidiMappings(const juce::String& parameterID);
+
+    /** Chops a stem into equal slices playable from consecutive MIDI notes starting at C1. */
+    void sliceStemToPads(int stemIndex, int numSlices);
+
+    /** Returns the CC-to-parameter map. */
+    audio::MidiControlMap& getMidiControlMap();
+
+    /** Returns the player that triggers stem slices from MIDI notes. */
+    audio::StemSlicePlayer& getStemSlicePlayer();
+
+    //==============================================================================
+    // Preset Morphing
+    //==============================================================================
+    /** ID of the parameter that morphs between the two selected snapshots. */
+    static const juce::String presetMorphParameterID;
+
+    /**
+     * Stores the current parameter values as a morph snapshot. If the slot is one end of
+     * the morph pair, the morph control moves to that end.
+     */
+    void storeMorphSnapshot(int slot);
+
+    /**
+     * Loads a preset file (a saved parameter state XML) into a morph snapshot slot.
+     * Parameters missing from the file keep their current values.
+     * @return true if the file could be read.
+     */
+    bool loadMorphSnapshot(int slot, const juce::File& presetFile);
+
+    /** Chooses the snapshots at the two ends of the morph control. */
+    void setMorphPair(int slotA, int slotB);
+
+    /** Returns the engine holding the morph snapshots. */
+    audio::PresetMorphEngine& getPresetMorphEngine();
+
     //==============================================================================
     // Parameter Management (NEW)
     //==============================================================================
@@ -114,9 +260,34 @@ public:
     /** Returns a reference to the flag indicating parameter changes. */
     std::atomic<bool>& getParametersChangedFlag();
 
+    //==============================================================================
+    // Undo History
+    //==============================================================================
+    /** Returns the undo manager shared by parameter changes and stem swaps. */
+    juce::UndoManager& getUndoManager();
+
+    /**
+     * Caps the memory retained by the undo history.
+     * @param maxMegabytes Memory budget for undo history: the stems it has replaced, plus its actions; at most 2047.
+     * @param minTransactions Number of transactions kept even if they exceed the budget.
+     */
+    void setUndoHistoryLimit(int maxMegabytes, int minTransactions = 10);
+
+    /** Closes the current undo transaction so the next change starts a new one. */
+    void beginUndoTransaction(const juce::String& name = {});
+
     /** Generates a unique parameter ID string for a given stem index and parameter type. */
     static juce::String getStemParameterID(int stemIndex, const juce::String& paramType); // e.g., "Volume", "Gain"
 
+    /** Maximum number of stems that have parameters. */
+    static constexpr int maxStems = 8;
+
+    /** RAM used by streamed stems unless setStreamingPlayback() says otherwise. */
+    static constexpr int defaultStreamingBudgetMegabytes = 64;
+
+    /** Disk space the cache of separated tracks may use. */
+    static constexpr int defaultSeparationCacheMegabytes = 2048;
+
 private:
     //==============================================================================
     // Parameter Management (NEW)
@@ -124,44 +295,119 @@ private:
     juce::UndoManager undoManager; // Optional but good practice for state management
     std::atomic<bool> parametersChanged { false }; // Flag for UI updates
 
+    // Parameter changes closer together than this are coalesced into one undo transaction
+    static constexpr juce::uint32 undoCoalesceWindowMs = 500;
+    static constexpr int defaultUndoLimitMegabytes = 256;
+    juce::uint32 lastParameterChangeTime = 0;
+
+    // The value each parameter had before its latest change, from any thread; an undoable
+    // move made on the message thread restores it. The APVTS has no undo manager of its
+    // own, so values written by automation, MIDI CCs and morphing never reach the history.
+    std::unique_ptr<std::atomic<float>[]> parameterUndoValues;
+    bool applyingParameterUndo = false; // Set while an undo action moves a parameter, or state is restored
+
     // Helper function to create the parameter layout (NEW)
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    // Raw parameter values for one stem, looked up once so the audio thread never builds ID strings
+    using StemParameterRefs = std::array<std::atomic<float>*, audio::StemRenderer::numParameters>;
+    std::vector<StemParameterRefs> stemParameterRefs;
+    std::vector<audio::StemRenderer::ParameterIndices> stemParameterIndices; // The same parameters by index, for renders
+    void cacheStemParameterRefs();
+    audio::StemRenderer::ParameterValues readStemParameters(int stemIdx) const;
+
     //==============================================================================
-    // DSP Effect Chains per Stem (NEW)
-    using StemEffectChain = juce::dsp::ProcessorChain<
-        juce::dsp::IIR::Filter<float>,  // EQ Band 1
-        juce::dsp::IIR::Filter<float>,  // EQ Band 2
-        juce::dsp::IIR::Filter<float>,  // EQ Band 3
-        juce::dsp::Compressor<float>,   // Compressor
-        juce::dsp::Reverb,              // Reverb
-        juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear>, // Delay
-        juce::dsp::Chorus<float>,       // Chorus
-        juce::dsp::WaveShaper<float, std::function<float(float)>>,   // Saturation (std::function)
-        juce::dsp::Gain<float>          // Placeholder Style Transfer
-    >;
+    // Sub-block rendering
+    // processBlock splits each block at automation breakpoints and MIDI events and renders
+    // every sub-block with the parameter values in effect at its first sample.
+    void renderStems(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, bool renderTimeline);
+    void applyParameterValue(int parameterIndex, float normalisedValue);
 
-    std::vector<std::unique_ptr<StemEffectChain>> stemEffectChains; // Use unique_ptr
+    juce::AudioBuffer<float> stemScratchBuffer; // Preallocated in prepareToPlay
+
+    //==============================================================================
+    // Automation
+    audio::AutomationEngine automationEngine;
+
+    // AudioProcessorParameter::Listener - records moves made on the message thread
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
+
+    //==============================================================================
+    // MIDI Control
+    audio::MidiControlMap midiControlMap;
+    audio::StemSlicePlayer stemSlicePlayer;
+    void handleMidiEvent(const juce::MidiMessage& message);
+    int getParameterIndex(const juce::String& parameterID);
+
+    //==============================================================================
+    // Preset Morphing
+    audio::PresetMorphEngine presetMorphEngine;
+    std::atomic<float>* presetMorphAmount = nullptr;
+    void initialisePresetMorph();
+    void applyPresetMorph();
+    std::vector<float> captureParameterValues() const;
+
+    //==============================================================================
+    // DSP Effect Chains per Stem (NEW)
+    std::vector<std::unique_ptr<audio::StemRenderer>> stemRenderers; // The offline renderer renders through the same class
 
     //==============================================================================
     // Playback State Variables (NEW)
     std::atomic<bool> playing { false }; // Use atomic for thread safety from UI calls
     std::atomic<bool> paused { false };
     juce::int64 playbackPosition { 0 }; // Current playback position in samples
+    std::atomic<juce::int64> publishedPlaybackPosition { 0 }; // Block-start position readable from other threads
     // Add other necessary state variables like current position, sample rate etc.
     // double currentSampleRate = 0.0;
     
     // Audio file related members
     juce::AudioFormatManager formatManager;
-    std::unique_ptr<juce::AudioFormatReader> currentAudioReader;
-    juce::AudioBuffer<float> audioBuffer;
     juce::File currentAudioFile;
+    audio::SharedAudio mixBuffer; // The decoded file, shared by placeholder stems; empty when stems are streamed or compact
 
     // ML related members (NEW)
     ml::ONNXModelLoader modelLoader; // Instance of the model loader
+    ml::SeparatorRegistry separatorRegistry { ml::SeparatorRegistry::createDefault() };
 
     // Stem separation related members (NEW)
-    std::vector<juce::AudioBuffer<float>> separatedStemBuffers;
+    std::vector<audio::StemSourcePtr> stemSources;
+    std::vector<std::string> stemNames; // Message thread only
+    juce::SpinLock stemLock; // Held while the stem list changes; the audio thread only try-locks it
+    double stemSampleRate = 0.0; // Rate the stems in stemSources were converted to
+
+    // Stem sets already converted to other device rates, least recently used first, so
+    // switching back to a rate doesn't resample again. Cleared when a stem changes.
+    std::vector<std::pair<int, std::vector<audio::StemSourcePtr>>> stemSetsByRate;
+    static constexpr size_t maxCachedStemRates = 2;
+    void conformStemsToSampleRate(double sampleRate);
+
+    // Fills the read-ahead of streamed stems; the destructor releases every stem before it stops
+    juce::TimeSliceThread readAheadThread { "Stem Read-Ahead" };
+
+    // Separated tracks kept on disk across sessions, so reloading one skips separation
+    audio::SeparationCache separationCache {
+        juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+            .getChildFile("UndergroundBeats").getChildFile("SeparationCache"),
+        (juce::int64) defaultSeparationCacheMegabytes * 1024 * 1024 };
+
+    // Background decode/separate; declared after formatManager and modelLoader, which it uses
+    audio::StemLoadPipeline loadPipeline { formatManager, modelLoader };
+
+    // Separates dropped batches into separationCache; declared after it so it stops first
+    audio::BatchImportQueue batchImport { formatManager, modelLoader, separationCache };
+
+    // Bounces to files; declared after readAheadThread, since a render may hold streamed stems
+    audio::OfflineRenderer offlineRenderer;
+    void publishLoadResult(audio::StemLoadPipeline::Result&& result);
+
+    // Undoable stem replacement that keeps references to both sources instead of copies
+    class StemSwapAction;
+
+    // Undoable move of one parameter made on the message thread
+    class ParameterChangeAction;
+    void setParameterFromUndo(int parameterIndex, float normalisedValue);
+    void setStemSource(int stemIndex, audio::StemSourcePtr newSource);
 
 
     //==============================================================================
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <vector>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @struct AutomationBreakpoint
+ * @brief A single recorded parameter value at a sample position on the playback timeline.
+ *
+ * Values are stored normalised (0.0 - 1.0) so a breakpoint can be applied to any
+ * juce::AudioProcessorParameter without knowing its range.
+ */
+struct AutomationBreakpoint
+{
+    juce::int64 samplePosition = 0;
+    float value = 0.0f;
+};
+
+/**
+ * @class AutomationLane
+ * @brief A sorted breakpoint array for one parameter, with a playback cursor.
+ *
+ * The lane holds its value between breakpoints (step automation). The cursor lets the
+ * audio thread walk the lane forwards in O(changes in block); a binary search is only
+ * needed after a seek.
+ */
+class AutomationLane
+{
+public:
+    /**
+     * @brief Replaces the region covered by a recorded take with the take's breakpoints.
+     * @param take Breakpoints sorted by sample position.
+     */
+    void mergeTake(const std::vector<AutomationBreakpoint>& take);
+
+    /**
+     * @brief Replaces all breakpoints. The input is sorted if required.
+     * @param newBreakpoints The new breakpoints.
+     */
+    void setBreakpoints(std::vector<AutomationBreakpoint> newBreakpoints);
+
+    /** @brief Removes all breakpoints. */
+    void clear();
+
+    /** @brief Returns true if the lane has no breakpoints. */
+    bool isEmpty() const { return breakpoints.empty(); }
+
+    /** @brief Returns the lane's breakpoints, sorted by sample position. */
+    const std::vector<AutomationBreakpoint>& getBreakpoints() const { return breakpoints; }
+
+    /**
+     * @brief Returns the value in effect at a position, or a negative value if the
+     *        position lies before the first breakpoint.
+     */
+    float getValueAt(juce::int64 samplePosition) const;
+
+    /**
+     * @brief Moves the cursor to the first breakpoint at or after a position (binary search).
+     * @param samplePosition The new playback position.
+     */
+    void seek(juce::int64 samplePosition);
+
+    /** @brief Returns the breakpoint under the cursor, or nullptr if the cursor is past the end. */
+    const AutomationBreakpoint* peek() const;
+
+    /** @brief Advances the cursor by one breakpoint. */
+    void advance() { ++cursor; }
+
+private:
+    std::vector<AutomationBreakpoint> breakpoints;
+    size_t cursor = 0;
+};
+
+/**
+ * @class AutomationEngine
+ * @brief Records parameter moves against the playback position and renders them back
+ *        sample-accurately.
+ *
+ * Recording runs on the message thread and collects a take per parameter; takes are
+ * merged into the lanes when recording stops. Playback runs on the audio thread: at the
+ * start of every block the engine gathers the breakpoints that fall inside the block into
+ * a preallocated event list, which the processor uses to split the block into sub-blocks.
+ * The lanes are shared between the threads through a SpinLock that the audio thread only
+ * ever try-locks, so a block in which the message thread is committing a take simply plays
+ * without automation.
+ */
+class AutomationEngine
+{
+public:
+    /** @brief A breakpoint that falls inside the current block. */
+    struct BlockEvent
+    {
+        int sampleOffset = 0;   // Offset from the start of the block
+        int parameterIndex = 0; // Index into the processor's parameter list
+        float value = 0.0f;     // Normalised value
+    };
+
+    /** @brief Maximum number of breakpoints rendered in a single block; extras are deferred. */
+    static constexpr int maxEventsPerBlock = 1024;
+
+    AutomationEngine();
+    ~AutomationEngine();
+
+    /**
+     * @brief Allocates one lane per parameter. Must be called before recording or playback.
+     * @param numParameters Number of parameters exposed by the processor.
+     */
+    void initialise(int numParameters);
+
+    /** @brief Returns the number of lanes (one per parameter). */
+    int getNumLanes() const { return static_cast<int>(lanes.size()); }
+
+    //==============================================================================
+    // Recording (message thread)
+
+    /** @brief Arms or disarms recording. Disarming commits the recorded takes. */
+    void setRecording(bool shouldRecord);
+
+    /** @brief Returns true while recording is armed. */
+    bool isRecording() const { return recording.load(); }
+
+    /**
+     * @brief Captures a parameter move. Ignored unless recording is armed.
+     * @param parameterIndex Index of the parameter that moved.
+     * @param normalisedValue The new normalised value.
+     * @param samplePosition Playback position at which the move happened.
+     */
+    void recordParameterChange(int parameterIndex, float normalisedValue, juce::int64 samplePosition);
+
+    /** @brief Merges all pending takes into their lanes. */
+    void commitRecording();
+
+    /** @brief Removes the automation of one parameter. */
+    void clearLane(int parameterIndex);
+
+    /** @brief Removes all automation. */
+    void clearAll();
+
+    /** @brief Enables or disables automation playback. */
+    void setPlaybackEnabled(bool shouldPlay) { playbackEnabled = shouldPlay; }
+
+    /** @brief Returns true if automation is played back. */
+    bool isPlaybackEnabled() const { return playbackEnabled.load(); }
+
+    /** @brief Returns a copy of a lane's breakpoints (message thread). */
+    std::vector<AutomationBreakpoint> getLaneBreakpoints(int parameterIndex) const;
+
+    /** @brief Replaces a lane's breakpoints (message thread). */
+    void setLaneBreakpoints(int parameterIndex, std::vector<AutomationBreakpoint> newBreakpoints);
+
+    /** @brief Writes all non-empty lanes into an XML element as compact base64 blocks. */
+    std::unique_ptr<juce::XmlElement> createXml() const;
+
+    /** @brief Restores lanes previously written by createXml(). */
+    void restoreFromXml(const juce::XmlElement& xml);
+
+    //==============================================================================
+    // Playback (audio thread)
+
+    /**
+     * @brief Collects the breakpoints inside [blockStart, blockStart + numSamples).
+     *        Reseeks all lanes if the block does not follow the previous one.
+     * @return True if there are events to apply in this block.
+     */
+    bool prepareBlock(juce::int64 blockStart, int numSamples);
+
+    /** @brief Events gathered by prepareBlock(), sorted by sample offset. */
+    const BlockEvent* getBlockEvents() const { return blockEvents.data(); }
+
+    /** @brief Number of events gathered by prepareBlock(). */
+    int getNumBlockEvents() const { return numBlockEvents; }
+
+private:
+    void rebuildActiveLanes();
+    void seekAllLanes(juce::int64 samplePosition);
+
+    std::vector<AutomationLane> lanes;
+    std::vector<int> activeLanes; // Indices of non-empty lanes
+    std::vector<std::vector<AutomationBreakpoint>> pendingTakes;
+
+    std::vector<BlockEvent> blockEvents;
+    int numBlockEvents = 0;
+    juce::int64 expectedBlockStart = -1;
+
+    std::atomic<bool> recording { false };
+    std::atomic<bool> playbackEnabled { true };
+    mutable juce::SpinLock laneLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AutomationEngine)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+#include "SeparationCache.h"
+#include "StemLoadPipeline.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace undergroundBeats {
+
+namespace ml { class ONNXModelLoader; }
+
+namespace audio {
+
+/**
+ * @class BatchImportQueue
+ * @brief Decodes and separates many files in the background, filling the SeparationCache.
+ *
+ * Every file is a job that runs the load pipeline's stages on a worker thread; nothing is
+ * published for playback. Once a track is in the cache, loading it later skips straight
+ * to analysis.
+ *
+ * Two limits keep a large batch from swamping the machine: at most maxConcurrentJobs run
+ * at once, and a running job first reserves an estimate of the memory it will need,
+ * waiting until the reservations of the other jobs leave room within memoryBudgetBytes.
+ * A job is always let through when nothing else holds memory, so a single track larger
+ * than the budget still imports.
+ *
+ * Jobs are added and listeners are called on the message thread.
+ */
+class BatchImportQueue : private juce::AsyncUpdater
+{
+public:
+    enum class JobState
+    {
+        Queued,
+        WaitingForMemory,
+        Running,
+        Finished,
+        Failed,
+        Cancelled
+    };
+
+    /** @brief A snapshot of one job, for display. */
+    struct JobInfo
+    {
+        juce::File file;
+        JobState state = JobState::Queued;
+        StemLoadPipeline::Stage stage = StemLoadPipeline::Stage::Idle;
+        float progress = 0.0f;    // Of the current stage, 0 - 1
+        bool wasCached = false;   // Finished without work because the track was already cached
+        juce::String error;
+    };
+
+    struct Limits
+    {
+        int maxConcurrentJobs = 2;
+        size_t memoryBudgetBytes = (size_t) 1024 * 1024 * 1024;
+    };
+
+    /** @brief Receives changes on the message thread. */
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        /** @brief Called when jobs are added or removed or change state (not on every progress step). */
+        virtual void batchImportChanged() = 0;
+    };
+
+    /**
+     * @brief Constructor. All three references must outlive the queue.
+     */
+    BatchImportQueue(juce::AudioFormatManager& formatManager, ml::ONNXModelLoader& modelLoader,
+                     SeparationCache& separationCache);
+    ~BatchImportQueue() override;
+
+    /**
+     * @brief Queues files for import.
+     * @param targetSampleRate Rate the stems are cached at; use the playback rate so later loads hit.
+     * @param separation Backend and model variant to separate with; use the ones loads run so they hit too.
+     */
+    void addFiles(const juce::Array<juce::File>& files, double targetSampleRate,
+                  const StemLoadPipeline::SeparationOptions& separation = {});
+
+    /** @brief Changes the limits; jobs already running keep their reservations. */
+    void setLimits(const Limits& newLimits);
+    Limits getLimits() const;
+
+    /** @brief Cancels every queued and running job. */
+    void cancelAll();
+
+    /** @brief Removes finished, failed and cancelled jobs from the list. */
+    void clearFinished();
+
+    /** @brief Returns a snapshot of every job in the order they were added. */
+    std::vector<JobInfo> getJobs() const;
+
+    /** @brief Returns true while any job is queued or running. */
+    bool isBusy() const;
+
+    /**
+     * @brief Starts jobs that are ready and notifies listeners now, rather than when the
+     *        message loop gets to it; message thread only. Nothing happens if nothing changed.
+     */
+    void dispatchPendingUpdates() { handleUpdateNowIfNeeded(); }
+
+    /**
+     * @brief Estimates the peak memory of importing one file: the decoded mix, its resampled
+     *        copy, and the stems plus the separator's working copies at the target rate.
+     */
+    static size_t estimateMemory(juce::int64 lengthInSamples, double fileSampleRate, double targetSampleRate,
+                                 int numChannels);
+
+    void addListener(Listener* listener) { listeners.add(listener); }
+    void removeListener(Listener* listener) { listeners.remove(listener); }
+
+private:
+    struct Job;
+    class Worker;
+
+    void handleAsyncUpdate() override;
+    void startReadyJobs();
+    bool reserveMemory(size_t bytes, const std::function<bool()>& shouldExit);
+    void releaseMemory(size_t bytes);
+    void jobStateChanged();
+
+    juce::AudioFormatManager& formatManager;
+    ml::ONNXModelLoader& modelLoader;
+    SeparationCache& separationCache;
+
+    mutable juce::CriticalSection lock; // Guards jobs, limits and the memory reservation
+    std::vector<std::unique_ptr<Job>> jobs;
+    Limits limits;
+    size_t reservedBytes = 0;
+    juce::WaitableEvent memoryReleased;
+
+    juce::ThreadPool pool { juce::jmax(1, juce::SystemStats::getNumCpus()) };
+    juce::ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchImportQueue)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
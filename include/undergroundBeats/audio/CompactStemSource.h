@@ -0,0 +1,46 @@
+#pragma once
+
+#include "StemSource.h"
+#include <vector>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class CompactStemSource
+ * @brief A stem held in RAM as half-precision floats.
+ *
+ * Half the size of a MemoryStemSource. The 11-bit mantissa leaves quantisation noise
+ * around -66 dB relative to each sample, below what the effects chain and output dither
+ * let through for stems, but the original float stem can't be recovered from it.
+ *
+ * read() converts straight into the destination block, so the audio thread pays a
+ * vectorised conversion per rendered sample and nothing else. Like streamed stems, it
+ * has no float buffer to hand out: the waveform is drawn from an overview and slice
+ * pads, which need one, stay silent.
+ */
+class CompactStemSource : public StemSource
+{
+public:
+    /** @brief Converts a stem; the source buffer is only read during the call. */
+    explicit CompactStemSource(const juce::AudioBuffer<float>& stem);
+
+    int getNumChannels() const override { return (int) channels.size(); }
+    juce::int64 getLengthInSamples() const override { return lengthInSamples; }
+    bool read(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+              juce::int64 sourceStartSample) override;
+    const juce::AudioBuffer<float>* getResidentBuffer() const override { return nullptr; }
+    const juce::AudioBuffer<float>* getDisplayBuffer() const override { return &overview; }
+    size_t getResidentBytes() const override;
+    SharedAudio readEntireStem() const override;
+
+private:
+    const int lengthInSamples;
+    std::vector<std::vector<juce::uint16>> channels;
+    juce::AudioBuffer<float> overview;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CompactStemSource)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
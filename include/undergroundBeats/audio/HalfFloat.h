@@ -0,0 +1,21 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @brief Converts floats to IEEE 754 half precision, rounding to nearest even.
+ *
+ * Values beyond the half range become infinity. Uses the CPU's conversion instructions
+ * where they exist (NEON on 64-bit ARM; F16C on x86, checked at run time unless the build
+ * targets it) and bit manipulation otherwise.
+ */
+void convertFloatToHalf(const float* source, juce::uint16* destination, int numSamples);
+
+/** @brief Converts IEEE 754 half precision values to floats; exact. Safe on the audio thread. */
+void convertHalfToFloat(const juce::uint16* source, float* destination, int numSamples);
+
+} // namespace audio
+} // namespace undergroundBeats
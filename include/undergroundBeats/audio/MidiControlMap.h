@@ -0,0 +1,88 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class MidiControlMap
+ * @brief Maps MIDI CC numbers to processor parameter indices, with MIDI learn.
+ *
+ * The map is a flat table of 128 atomics indexed by controller number, so the audio
+ * thread resolves a CC with a single load and the message thread can rebind entries at
+ * any time without locks. Controllers are treated as omni (the channel is ignored).
+ *
+ * MIDI learn: arm learning for a parameter with beginLearn(); the next controller that
+ * arrives on the audio thread is bound to that parameter and learning disarms itself.
+ */
+class MidiControlMap
+{
+public:
+    static constexpr int numControllers = 128;
+    static constexpr int unmapped = -1;
+
+    MidiControlMap();
+
+    //==============================================================================
+    // Mapping (message thread)
+
+    /**
+     * @brief Binds a controller to a parameter, replacing any previous binding of the
+     *        controller. A parameter may be driven by several controllers.
+     * @param controllerNumber CC number (0 - 127).
+     * @param parameterIndex Index into the processor's parameter list.
+     */
+    void setMapping(int controllerNumber, int parameterIndex);
+
+    /** @brief Removes the binding of one controller. */
+    void clearMapping(int controllerNumber);
+
+    /** @brief Removes every binding that targets a parameter. */
+    void clearMappingsForParameter(int parameterIndex);
+
+    /** @brief Removes all bindings and cancels learning. */
+    void clearAll();
+
+    /** @brief Returns the parameter bound to a controller, or unmapped. */
+    int getMapping(int controllerNumber) const;
+
+    /** @brief Arms MIDI learn: the next incoming controller is bound to this parameter. */
+    void beginLearn(int parameterIndex) { learnTarget = parameterIndex; }
+
+    /** @brief Cancels MIDI learn. */
+    void cancelLearn() { learnTarget = unmapped; }
+
+    /** @brief Returns the parameter waiting for a controller, or unmapped. */
+    int getLearnTarget() const { return learnTarget.load(); }
+
+    /** @brief Writes all bindings into an XML element. */
+    std::unique_ptr<juce::XmlElement> createXml() const;
+
+    /** @brief Restores bindings previously written by createXml(). */
+    void restoreFromXml(const juce::XmlElement& xml);
+
+    //==============================================================================
+    // Lookup (audio thread)
+
+    /**
+     * @brief Resolves a controller to a parameter, completing MIDI learn if armed.
+     * @return The parameter index, or unmapped.
+     */
+    int handleController(int controllerNumber);
+
+    /** @brief Converts a 7-bit controller value to a normalised parameter value. */
+    static float toNormalisedValue(int controllerValue) { return juce::jlimit(0, 127, controllerValue) / 127.0f; }
+
+private:
+    std::array<std::atomic<int>, numControllers> table;
+    std::atomic<int> learnTarget { unmapped };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiControlMap)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
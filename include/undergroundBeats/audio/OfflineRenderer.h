@@ -0,0 +1,137 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+#include "AutomationEngine.h"
+#include "StemRenderer.h"
+#include "StemSource.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class OfflineRenderer
+ * @brief Bounces the timeline to files, faster than real time.
+ *
+ * A render plays the stems from the start to the end of the shortest one through the
+ * same StemRenderer chains and automation as playback, so with the same parameters the
+ * files hold exactly what the audio device would have played. MIDI input (CCs and slice
+ * notes) is live performance and is not part of a render.
+ *
+ * The timeline is rendered in batches of blocks. Within a batch every stem is processed
+ * on its own thread, since stems only meet in the final sum; the results are then summed
+ * in stem order, as in processBlock, and handed to background writers.
+ *
+ * Each stem file holds that stem's contribution to the mix after its effects and gain,
+ * silent where it is muted or another stem is soloed, so the stem files add up to the mix.
+ */
+class OfflineRenderer : private juce::AsyncUpdater
+{
+public:
+    enum class FileFormat
+    {
+        Wav,
+        Flac
+    };
+
+    enum class SampleFormat
+    {
+        Int24,
+        Float32 // WAV only; FLAC files are always written as 24-bit
+    };
+
+    /** @brief What to write and where. */
+    struct Options
+    {
+        juce::File outputDirectory;
+        juce::String baseName { "Mix" };  // Files are <baseName>.wav and <baseName>_Stem1.wav, ...
+        bool includeMix = true;
+        bool includeStems = false;
+        FileFormat fileFormat = FileFormat::Wav;
+        SampleFormat sampleFormat = SampleFormat::Int24;
+        int numThreads = 0;                // Stems rendered at once; 0 uses one per CPU core
+    };
+
+    /**
+     * @brief Everything a render reads, captured on the message thread when it starts so
+     *        playback and editing can carry on while it runs.
+     */
+    struct Session
+    {
+        std::vector<StemSourcePtr> stems;
+        double sampleRate = 0.0;
+        int numOutputChannels = 2;
+
+        std::vector<StemRenderer::ParameterIndices> stemParameters;  // One per stem
+        std::vector<float> parameterValues;                          // Raw value of every parameter
+        std::vector<std::vector<AutomationBreakpoint>> automation;   // Lane of every parameter
+
+        /** @brief Converts an automation value of a parameter to its raw value; called on the render thread. */
+        std::function<float(int parameterIndex, float normalisedValue)> denormalise;
+    };
+
+    /** @brief Samples per automation block; parameters change at breakpoints within it. */
+    static constexpr int blockSize = 4096;
+
+    /** @brief Blocks each stem renders before the results are summed and written. */
+    static constexpr int blocksPerBatch = 16;
+
+    OfflineRenderer();
+    ~OfflineRenderer() override;
+
+    /**
+     * @brief Starts a render on a background thread.
+     * @return False if a render is already running.
+     */
+    bool start(Session session, const Options& options);
+
+    /** @brief Stops the render in progress; its partly written files are deleted. */
+    void cancel();
+
+    /** @brief Returns true while a render is running. */
+    bool isRendering() const { return rendering.load(); }
+
+    /** @brief Returns the progress (0 - 1) of the render in progress. */
+    float getProgress() const { return progress.load(); }
+
+    /** @brief Called on the message thread when a render finishes, fails or is cancelled. */
+    std::function<void(const juce::Result&)> onFinished;
+
+    //==============================================================================
+    /**
+     * @brief Renders synchronously on the calling thread.
+     * @param shouldExit Polled between batches; returning true abandons the render.
+     * @param reportProgress Called with the fraction rendered (0 - 1).
+     * @return An error if nothing could be rendered, a file could not be written, or the
+     *         render was cancelled; files of a failed render are deleted.
+     */
+    static juce::Result render(const Session& session, const Options& options,
+                               const std::function<bool()>& shouldExit,
+                               const std::function<void(float)>& reportProgress);
+
+    /** @brief Returns the file a render writes the mix (stemIndex < 0) or a stem to. */
+    static juce::File getOutputFile(const Options& options, int stemIndex);
+
+private:
+    class RenderJob;
+
+    void handleAsyncUpdate() override;
+
+    juce::ThreadPool pool { 1 };
+    std::atomic<bool> rendering { false };
+    std::atomic<float> progress { 0.0f };
+
+    juce::CriticalSection resultLock;
+    juce::Result finishedResult { juce::Result::ok() };
+    bool hasFinishedResult = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineRenderer)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+#include <functional>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class ParallelAudioDecoder
+ * @brief Decodes a long file as independent segments on several threads.
+ *
+ * Compressed formats decode at a fraction of real time per core, so a five-minute MP3
+ * spends most of its load here. The file is split into segments whose starts fall on
+ * frame boundaries; every worker opens its own reader, seeks to its segment and decodes
+ * it straight into its slice of one preallocated buffer. Lossy decoders need a little
+ * history before their first output is exact, so each worker decodes a short pre-roll
+ * before its segment and throws it away.
+ *
+ * Short files, and files that would only make one segment, are decoded on the calling
+ * thread.
+ */
+class ParallelAudioDecoder
+{
+public:
+    /** @brief Segment starts are multiples of this; four MP3 frames, and a FLAC block size. */
+    static constexpr int segmentAlignment = 4 * 1152;
+
+    /** @brief Samples decoded and discarded before each segment but the first. */
+    static constexpr int prerollSamples = 2 * 1152;
+
+    /** @brief Files shorter than this are decoded on one thread. */
+    static constexpr int minSamplesPerSegment = 1 << 19;
+
+    /** @brief Samples decoded between checks for cancellation. */
+    static constexpr int chunkSize = 1 << 16;
+
+    /**
+     * @brief Decodes the first destination.getNumChannels() channels of a file.
+     * @param file The file to decode.
+     * @param formatManager Formats used to open a reader per segment.
+     * @param destination Preallocated to the file's length; filled in place.
+     * @param numThreads Upper bound on the worker threads; 0 uses one per CPU core.
+     * @param shouldExit Polled on the calling thread while the workers run; returning true
+     *        stops every worker at its next chunk.
+     * @param reportProgress Called on the calling thread with the fraction decoded (0 - 1).
+     * @return False if a segment could not be opened or the decode was stopped.
+     */
+    static bool decode(const juce::File& file, juce::AudioFormatManager& formatManager,
+                       juce::AudioBuffer<float>& destination, int numThreads,
+                       const std::function<bool()>& shouldExit,
+                       const std::function<void(float)>& reportProgress);
+};
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "SharedAudio.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class PolyphaseResampler
+ * @brief Offline windowed-sinc sample rate conversion by a rational factor.
+ *
+ * The conversion is expressed as upsampling by L, low-pass filtering and downsampling
+ * by M. Only the output samples are ever computed: each one is the dot product of a
+ * short run of input samples with one of L phases of a Kaiser-windowed sinc filter.
+ * The phases are stored reversed and contiguous, and the input is padded with silence,
+ * so the inner loop is a branch-free product of two float arrays.
+ *
+ * Rates are rounded to whole hertz; ratios whose reduced form needs more than
+ * maxPhases phases are approximated by the closest ratio that doesn't.
+ *
+ * This is meant for load time and for preparing stems at a new device rate, never
+ * for the audio thread.
+ */
+class PolyphaseResampler
+{
+public:
+    /** Upper bound on L, which sets the size of the filter bank. */
+    static constexpr int maxPhases = 1024;
+
+    /**
+     * @brief Designs the filter bank for a conversion.
+     * @param sourceRate Rate of the input.
+     * @param targetRate Rate of the output.
+     * @param tapsPerPhase Filter length in input samples when upsampling; longer is sharper.
+     */
+    PolyphaseResampler(double sourceRate, double targetRate, int tapsPerPhase = 32);
+
+    /** @brief Returns the number of output samples produced for an input length. */
+    int getOutputLength(int inputLength) const;
+
+    /** @brief Resamples every channel of a buffer. */
+    juce::AudioBuffer<float> process(const juce::AudioBuffer<float>& input) const;
+
+    /** @brief Resamples a shared buffer, returning the same handle if the rates match. */
+    static SharedAudio resample(const SharedAudio& input, double sourceRate, double targetRate);
+
+    int getUpsamplingFactor() const { return upFactor; }
+    int getDownsamplingFactor() const { return downFactor; }
+
+private:
+    void processChannel(const float* input, int inputLength, float* output, int outputLength,
+                        std::vector<float>& padded) const;
+
+    int upFactor = 1;       // L
+    int downFactor = 1;     // M
+    int taps = 0;           // Coefficients per phase
+    int centreDelay = 0;    // Group delay of the prototype filter, in upsampled samples
+    std::vector<float> phases; // L rows of taps coefficients, each reversed
+};
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <vector>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class PresetMorphEngine
+ * @brief Morphs every parameter between two stored snapshots from a single control.
+ *
+ * Snapshots hold one normalised value per parameter and live in a fixed number of
+ * slots that are allocated up front, so storing a snapshot only copies values. When a
+ * pair of slots is chosen, the engine builds the list of parameters that actually
+ * differ between them; the audio thread then walks only that list, and only when the
+ * morph amount has moved. Continuous parameters are interpolated linearly, discrete
+ * ones (toggles, choices) switch from A to B when the amount crosses the threshold.
+ *
+ * Slots and the difference list are shared with the audio thread through a SpinLock
+ * that the audio thread only try-locks, like the automation lanes.
+ */
+class PresetMorphEngine
+{
+public:
+    /** @brief A parameter value produced by the morph for the current sub-block. */
+    struct Change
+    {
+        int parameterIndex = 0;
+        float value = 0.0f;
+    };
+
+    static constexpr int numSlots = 8;
+
+    PresetMorphEngine();
+    ~PresetMorphEngine();
+
+    /**
+     * @brief Allocates the slots and the difference list. Must be called before use.
+     * @param discreteFlags One entry per parameter; true for parameters that must not be interpolated.
+     * @param excludedParameter A parameter that is never stored or morphed (the morph control itself).
+     */
+    void initialise(const std::vector<bool>& discreteFlags, int excludedParameter);
+
+    //==============================================================================
+    // Snapshots (message thread)
+
+    /**
+     * @brief Stores a snapshot into a slot.
+     * @param slot Slot index (0 - numSlots-1).
+     * @param values One normalised value per parameter.
+     */
+    void storeSnapshot(int slot, const std::vector<float>& values);
+
+    /** @brief Marks a slot as empty. */
+    void clearSnapshot(int slot);
+
+    /** @brief Returns true if the slot holds a snapshot. */
+    bool hasSnapshot(int slot) const;
+
+    /** @brief Returns a copy of a stored snapshot, or an empty vector. */
+    std::vector<float> getSnapshot(int slot) const;
+
+    /**
+     * @brief Chooses the snapshots the morph control moves between and rebuilds the
+     *        list of parameters that differ. Morphing is off until both slots are filled.
+     */
+    void setMorphPair(int slotA, int slotB);
+
+    /** @brief Returns the slot at morph amount 0. */
+    int getSlotA() const { return slotA; }
+
+    /** @brief Returns the slot at morph amount 1. */
+    int getSlotB() const { return slotB; }
+
+    /** @brief Sets the morph amount at which discrete parameters switch to B (default 0.5). */
+    void setSwitchThreshold(float newThreshold) { switchThreshold = juce::jlimit(0.0f, 1.0f, newThreshold); }
+
+    /** @brief Writes the snapshots and the chosen pair into an XML element. */
+    std::unique_ptr<juce::XmlElement> createXml() const;
+
+    /** @brief Restores snapshots previously written by createXml(). */
+    void restoreFromXml(const juce::XmlElement& xml);
+
+    //==============================================================================
+    // Morphing (audio thread)
+
+    /**
+     * @brief Computes the parameter values for a morph amount. Does nothing unless the
+     *        amount or the pair changed since the last call.
+     * @return The number of changes available through getChanges().
+     */
+    int process(float morphAmount);
+
+    /** @brief Values computed by the last call to process(). */
+    const Change* getChanges() const { return changes.data(); }
+
+private:
+    struct Difference
+    {
+        int parameterIndex = 0;
+        float valueA = 0.0f;
+        float valueB = 0.0f;
+        bool discrete = false;
+    };
+
+    void rebuildDifferences();
+
+    int numParameters = 0;
+    int excluded = -1;
+    std::vector<bool> discrete;
+    std::vector<std::vector<float>> slots;
+    std::vector<bool> slotFilled;
+    int slotA = 0;
+    int slotB = 1;
+    float switchThreshold = 0.5f;
+
+    std::vector<Difference> differences;
+    std::vector<Change> changes;
+    float lastAmount = -1.0f;
+    bool differencesChanged = false;
+
+    mutable juce::SpinLock morphLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetMorphEngine)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
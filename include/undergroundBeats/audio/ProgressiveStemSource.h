@@ -0,0 +1,157 @@
+#pragma once
+
+#include "StemSource.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class ProgressiveSeparation
+ * @brief Stems that are filled in by the separator while they are already being played.
+ *
+ * The track is divided into segments of the separator's window hop. The separator writes
+ * into the stem buffers through views from getWriteViews() and marks each segment once no
+ * window adds to it any more; from then on the segment is never written again. Until a
+ * segment is finished, every stem plays an equal share of the mix there, so the stems
+ * still add up to the track.
+ *
+ * The separation may run at a rate other than playback's, e.g. a model's native rate. The
+ * mix, stems and segments are then all at that rate, and the sources convert to the
+ * playback rate as they read.
+ *
+ * This is the one exception to stems being immutable once published: the buffers change
+ * after publication, but only in segments that no reader uses yet.
+ */
+class ProgressiveSeparation
+{
+public:
+    /**
+     * @param mix The track being separated, played where the stems aren't ready.
+     * @param numStems Stems the separator produces.
+     * @param segmentLength Samples per segment; the last segment runs to the end of the track.
+     * @param mixRate The rate of the mix and the stems.
+     * @param playbackRate The rate the sources play at; if either rate is 0 or they are equal,
+     *                     the sources play the stems as they are.
+     */
+    ProgressiveSeparation(SharedAudio mix, int numStems, int segmentLength,
+                          double mixRate = 0.0, double playbackRate = 0.0);
+
+    /** @brief Playback sources, one per stem, sharing this separation. */
+    static std::vector<StemSourcePtr> createSources(const std::shared_ptr<ProgressiveSeparation>& separation);
+
+    /** @brief Buffers referring to the stems' memory, for the separator to write into. */
+    std::vector<juce::AudioBuffer<float>> getWriteViews();
+
+    /** @brief Makes a segment audible; called by the separator when no window adds to it any more. */
+    void markSegmentFinished(int segment);
+
+    /** @brief Returns true once a segment of the stems is final. */
+    bool isSegmentFinished(int segment) const { return finished[(size_t) segment].load(std::memory_order_acquire); }
+
+    /** @brief Returns true once every segment is final. */
+    bool isComplete() const { return numFinished.load(std::memory_order_acquire) == numSegments; }
+
+    /** @brief The sample of the mix last played, which the separator works outwards from. */
+    juce::int64 getPriorityPosition() const { return playbackPosition.load(std::memory_order_relaxed); }
+
+    /** @brief Called by the sources on the audio thread with the position they read, at the playback rate. */
+    void notePlaybackPosition(juce::int64 position)
+    {
+        playbackPosition.store((juce::int64) ((double) position * step), std::memory_order_relaxed);
+    }
+
+    /** @brief Returns true if the sources convert the stems to another rate as they play them. */
+    bool isResampled() const { return resampled; }
+
+    /** @brief Samples of the mix per sample played; 1 unless resampled. */
+    double getStep() const { return step; }
+
+    /** @brief The length of the sources at the playback rate. */
+    juce::int64 getPlaybackLength() const { return playbackLength; }
+
+    double getMixRate() const { return mixRate; }
+    double getPlaybackRate() const { return playbackRate; }
+
+    /** @brief Returns the segment holding a sample; positions past the end map to the last one. */
+    int getSegment(juce::int64 position) const;
+
+    /** @brief Returns the sample after the last one of a segment. */
+    juce::int64 getSegmentEnd(int segment) const;
+
+    const SharedAudio& getMix() const { return mix; }
+    const std::vector<SharedAudio>& getStems() const { return stems; }
+    int getNumStems() const { return (int) stems.size(); }
+    int getNumSegments() const { return numSegments; }
+
+private:
+    const SharedAudio mix;
+    std::vector<SharedAudio> stems;
+    const int segmentLength;
+    const int numSegments;
+    const double mixRate, playbackRate;
+    const bool resampled;
+    const double step;
+    const juce::int64 playbackLength;
+
+    std::unique_ptr<std::atomic<bool>[]> finished;
+    std::atomic<int> numFinished { 0 };
+    std::atomic<juce::int64> playbackPosition { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProgressiveSeparation)
+};
+
+//==============================================================================
+/**
+ * @class ProgressiveStemSource
+ * @brief Plays one stem of a ProgressiveSeparation: the separated stem where it is
+ *        finished and its share of the mix elsewhere.
+ *
+ * A resampled separation is read through 4-point Lagrange interpolation, which needs no
+ * state, so reads can jump anywhere. It is meant for the preview; the finished stems are
+ * converted properly by the load pipeline and replace it.
+ *
+ * Slices need the whole stem, so getResidentBuffer() stays null. The waveform is drawn
+ * from an overview of its own rather than the stem, which the separator may be writing:
+ * getDisplayBuffer() redraws the parts of it whose segments have finished since it was
+ * last called, and reads the stem nowhere else.
+ */
+class ProgressiveStemSource : public StemSource
+{
+public:
+    ProgressiveStemSource(std::shared_ptr<ProgressiveSeparation> separation, int stemIndex);
+
+    int getNumChannels() const override;
+    juce::int64 getLengthInSamples() const override;
+    bool read(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+              juce::int64 sourceStartSample) override;
+    const juce::AudioBuffer<float>* getResidentBuffer() const override { return nullptr; }
+    /** @brief Brings the overview up to date with the finished segments; message thread only. */
+    const juce::AudioBuffer<float>* getDisplayBuffer() const override;
+    size_t getResidentBytes() const override;
+
+    /** @brief The stem once separation has finished; an invalid handle before that. */
+    SharedAudio readEntireStem() const override;
+
+private:
+    bool readResampled(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+                       juce::int64 sourceStartSample);
+    void drawOverview(juce::int64 startSample, juce::int64 endSample) const;
+
+    const std::shared_ptr<ProgressiveSeparation> separation;
+    const int stemIndex;
+    const float mixGain; // Each stem's share of the mix
+
+    // Touched only by the message thread. A segment is drawn from the stem once it is marked
+    // in drawnSegments, which happens only after it has been seen finished.
+    mutable juce::AudioBuffer<float> overview;
+    mutable std::vector<bool> drawnSegments;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProgressiveStemSource)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
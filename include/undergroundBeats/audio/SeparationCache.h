@@ -0,0 +1,97 @@
+#pragma once
+
+#include "SharedAudio.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <optional>
+#include <vector>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class SeparationCache
+ * @brief On-disk cache of decoded mixes and their separated stems.
+ *
+ * Entries are keyed by a hash of the source file's contents, the identity of the
+ * separation model and the playback rate, so a renamed copy of a track hits and a
+ * re-exported one misses. Each entry is a directory holding the mix and every stem as
+ * a PCM file, plus a manifest written last; a directory without a manifest is an
+ * unfinished write and is ignored.
+ *
+ * PCM files are a 64-byte header followed by planar 32-bit float channels, so they can
+ * be memory-mapped and copied out without parsing. The header carries a checksum of the
+ * samples; an entry that fails any check on read is deleted and reported as a miss.
+ *
+ * The cache is bounded by size on disk: after every store the least recently used
+ * entries are removed until it fits. Reading an entry marks it as used.
+ *
+ * All methods may be called from any thread; they block on disk access.
+ */
+class SeparationCache
+{
+public:
+    /** @brief What an entry holds. */
+    struct Entry
+    {
+        double sampleRate = 0.0;
+        SharedAudio mix;
+        std::vector<SharedAudio> stems;
+        juce::String modelVariant; // Which build of the model separated the stems, e.g. "fast"
+    };
+
+    /**
+     * @brief Constructor.
+     * @param directory Where entries are kept; created on the first store.
+     * @param maxSizeBytes Upper bound on the cache's size on disk.
+     */
+    SeparationCache(const juce::File& directory, juce::int64 maxSizeBytes);
+
+    /**
+     * @brief Builds the key for a source file. Hashes the whole file, so it reads it from disk.
+     * @param sourceFile The file as loaded by the user.
+     * @param modelIdentity Changes whenever the separation would give different stems.
+     * @param sampleRate Rate the mix and stems are stored at.
+     */
+    static juce::String makeKey(const juce::File& sourceFile, const juce::String& modelIdentity, double sampleRate);
+
+    /** @brief Returns the entry for a key, or nothing if it is missing or damaged. */
+    std::optional<Entry> lookup(const juce::String& key);
+
+    /** @brief Returns true if an entry is stored for a key, without reading or verifying it. */
+    bool contains(const juce::String& key) const;
+
+    /** @brief Stores an entry, replacing any with the same key, then trims the cache. */
+    bool store(const juce::String& key, const Entry& entry);
+
+    /** @brief Changes the size limit, trimming the cache if needed. */
+    void setMaxSize(juce::int64 maxSizeBytes);
+
+    /** @brief Returns the total size of the stored entries in bytes. */
+    juce::int64 getSizeOnDisk() const;
+
+    /** @brief Removes every entry. */
+    void clear();
+
+    //==============================================================================
+    /** @brief Writes a buffer as a PCM file. */
+    static bool writePcmFile(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate);
+
+    /**
+     * @brief Reads a PCM file through a memory map, verifying its header and checksum.
+     * @return The audio, or an invalid handle if the file is missing or damaged.
+     */
+    static SharedAudio readPcmFile(const juce::File& file, double& sampleRate);
+
+private:
+    void trimToSize();
+
+    const juce::File directory;
+    juce::int64 maxSize;
+    mutable juce::CriticalSection lock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SeparationCache)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
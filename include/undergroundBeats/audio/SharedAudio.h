@@ -0,0 +1,75 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <memory>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class SharedAudio
+ * @brief A reference-counted handle to an audio buffer with copy-on-write.
+ *
+ * Copying a handle shares the audio; the data is only duplicated when write() is
+ * called on a handle whose buffer is also held elsewhere. Identical audio (the mix
+ * standing in for every placeholder stem, a variation that leaves its input
+ * untouched) is therefore stored once.
+ *
+ * Reads through shared handles are safe from any thread. write() must only be called
+ * by the thread that owns the handle, before the handle has been published to others;
+ * buffers handed to the audio thread are never written again.
+ */
+class SharedAudio
+{
+public:
+    /** @brief An empty handle. */
+    SharedAudio() = default;
+
+    /** @brief Takes ownership of a buffer without copying it. */
+    explicit SharedAudio(juce::AudioBuffer<float>&& buffer);
+
+    /** @brief Creates a handle holding a copy of a buffer. */
+    static SharedAudio copyOf(const juce::AudioBuffer<float>& buffer);
+
+    /** @brief Returns true if the handle refers to audio. */
+    bool isValid() const { return data != nullptr; }
+    explicit operator bool() const { return isValid(); }
+
+    /** @brief The audio. Must only be called on a valid handle. */
+    const juce::AudioBuffer<float>& read() const { return *data; }
+    const juce::AudioBuffer<float>& operator*() const { return *data; }
+    const juce::AudioBuffer<float>* operator->() const { return data.get(); }
+    const juce::AudioBuffer<float>* get() const { return data.get(); }
+
+    /**
+     * @brief Returns the audio for modification, first copying it if any other handle
+     *        shares it. Must only be called on a valid handle.
+     */
+    juce::AudioBuffer<float>& write();
+
+    /** @brief Returns true if no other handle shares this audio. */
+    bool isUnique() const { return data != nullptr && data.use_count() == 1; }
+
+    /** @brief Returns true if both handles refer to the same audio. */
+    bool sharesDataWith(const SharedAudio& other) const { return data == other.data; }
+
+    /** @brief Bytes of sample data held by the buffer. */
+    size_t getSizeInBytes() const;
+
+    /**
+     * @brief Turns the handle into a plain buffer, moving the audio out if this handle
+     *        is the only owner and copying it otherwise. Leaves the handle empty.
+     */
+    juce::AudioBuffer<float> release();
+
+    void reset() { data.reset(); }
+
+    bool operator==(const SharedAudio& other) const { return data == other.data; }
+    bool operator!=(const SharedAudio& other) const { return data != other.data; }
+
+private:
+    std::shared_ptr<juce::AudioBuffer<float>> data;
+};
+
+} // namespace audio
+} // namespace undergroundBeats
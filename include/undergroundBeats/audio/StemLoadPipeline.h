@@ -0,0 +1,241 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+#include "SeparationCache.h"
+#include "StemSource.h"
+#include "undergroundBeats/ml/AudioSourceSeparator.h"
+#include "undergroundBeats/ml/SeparatorRegistry.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace undergroundBeats {
+
+namespace ml { class ONNXModelLoader; }
+
+namespace audio {
+
+/**
+ * @class StemLoadPipeline
+ * @brief Loads a file and separates it into stems on a background thread.
+ *
+ * A load runs through the stages Decode, Resample, Separate, Analyze, Cache and Publish.
+ * All but Publish run on a worker thread and report their progress; listeners are notified
+ * on the message thread. Publish runs on the message thread and hands the finished
+ * result to onPublish, so the owner can swap it in for the audio thread in one step.
+ *
+ * With a SeparationCache set, a track that was separated before at the same rate and
+ * with the same model variant is read back from disk and goes straight to Analyze.
+ *
+ * Background loads publish a preview as soon as Separate starts: ProgressiveStemSources
+ * that play each separated segment as it becomes ready, and the mix everywhere else. The
+ * separator works from the playhead onwards, so playback can start straight away; the
+ * finished result then replaces the preview without stopping it.
+ *
+ * Starting a new load cancels the one in flight: its worker stops at the next chunk
+ * or stage boundary and its result is discarded, even if it had already finished.
+ */
+class StemLoadPipeline : private juce::AsyncUpdater
+{
+public:
+    enum class Stage
+    {
+        Idle,
+        Decode,
+        Resample,
+        Separate,
+        Analyze,
+        Cache,
+        Publish,
+        Finished,
+        Failed,
+        Cancelled
+    };
+
+    /** @brief Returns a display name for a stage. */
+    static juce::String getStageName(Stage stage);
+
+    /** @brief Everything a finished load produces. */
+    struct Result
+    {
+        juce::File file;
+        double sampleRate = 0.0;
+        SharedAudio mix;                 // The decoded (and resampled) file
+        std::vector<SharedAudio> stems;  // Separated stems, or handles to the mix as placeholders
+        std::vector<StemSourcePtr> sources; // Cache: how each stem is played, in RAM or streamed
+        bool separated = false;          // False if separation failed and placeholders are used
+        juce::String modelVariant;       // The model variant that separated the stems, if they were
+        std::vector<std::string> stemNames; // What each stem holds, as the separator names it
+        std::vector<float> stemPeaks;    // Analyze: peak level per stem
+        std::vector<float> stemRms;      // Analyze: RMS level per stem
+        juce::String error;
+        bool isPreview = false;          // Published while Separate runs; a final result follows
+        bool followsPreview = false;     // A preview of this file was published before it
+    };
+
+    /**
+     * @brief Controls whether finished stems stay in RAM or are streamed from disk.
+     *
+     * When streaming, the Cache stage writes every stem to a PCM file and keeps only
+     * a resident head, the read-ahead window and a waveform overview per stem, so a
+     * loaded file costs roughly ramBudgetBytes however long it is.
+     */
+    struct StreamingOptions
+    {
+        bool enabled = false;
+        size_t ramBudgetBytes = 64 * 1024 * 1024;       // Shared by all stems of a file
+        juce::File cacheDirectory;
+        juce::TimeSliceThread* readAheadThread = nullptr; // Must outlive the published sources
+        bool halfPrecision = false;                       // Stems kept in RAM are stored as float16
+    };
+
+    /** @brief Which separator the following loads run. */
+    struct SeparationOptions
+    {
+        ml::SeparatorRegistry::Backend backend = ml::SeparatorRegistry::createDefault().getDefaultBackend();
+        ml::ModelVariant variant = ml::ModelVariant::Quality; // Used if the backend has it installed
+    };
+
+    /** @brief Receives progress on the message thread. */
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        /** @brief Called when the stage or its progress (0 - 1) changes. */
+        virtual void loadProgressChanged(Stage stage, float progress) = 0;
+    };
+
+    /**
+     * @brief Constructor.
+     * @param formatManager Formats used to decode files; must outlive the pipeline.
+     * @param modelLoader Model loader used by the separator; must outlive the pipeline.
+     */
+    StemLoadPipeline(juce::AudioFormatManager& formatManager, ml::ONNXModelLoader& modelLoader);
+    ~StemLoadPipeline() override;
+
+    /**
+     * @brief Starts loading a file, cancelling any load in progress.
+     * @param file The audio file to load.
+     * @param targetSampleRate Rate the stems should be played at; 0 keeps the file's rate.
+     */
+    void load(const juce::File& file, double targetSampleRate);
+
+    /** @brief Sets how stems of the following loads are held for playback. */
+    void setStreamingOptions(const StreamingOptions& options);
+
+    /** @brief Returns the options used by the following loads. */
+    StreamingOptions getStreamingOptions() const;
+
+    /**
+     * @brief Sets the cache that separated tracks are read from and stored to.
+     * @param cache Must outlive the pipeline; nullptr disables caching.
+     */
+    void setSeparationCache(SeparationCache* cache);
+
+    /** @brief Returns the cache used by the following loads, or nullptr. */
+    SeparationCache* getSeparationCache() const;
+
+    /** @brief Sets which separator backend and model variant the following loads run. */
+    void setSeparationOptions(const SeparationOptions& options);
+
+    /** @brief Returns the separation options used by the following loads. */
+    SeparationOptions getSeparationOptions() const;
+
+    /** @brief Identifies a backend and the variant of it that runs in cache keys. */
+    static juce::String getModelIdentity(const SeparationOptions& separation);
+
+    /** @brief Cancels the load in progress, if any. */
+    void cancel();
+
+    /**
+     * @brief Publishes a waiting result and notifies listeners now, rather than when the
+     *        message loop gets to it; message thread only. Nothing happens if nothing waits.
+     */
+    void dispatchPendingUpdates() { handleUpdateNowIfNeeded(); }
+
+    /** @brief Returns true while a load is running. */
+    bool isLoading() const;
+
+    /** @brief Returns the current stage. */
+    Stage getStage() const { return currentStage.load(); }
+
+    /** @brief Returns the progress (0 - 1) of the current stage. */
+    float getStageProgress() const { return currentProgress.load(); }
+
+    void addListener(Listener* listener) { listeners.add(listener); }
+    void removeListener(Listener* listener) { listeners.remove(listener); }
+
+    /**
+     * @brief Called on the message thread with the result of every load that was not cancelled,
+     *        and before that with its preview if one was made (see Result::isPreview).
+     */
+    std::function<void(Result&&)> onPublish;
+
+    //==============================================================================
+    /**
+     * @brief Runs the worker stages synchronously on the calling thread.
+     * @param streaming Decides whether the Cache stage creates in-memory or streamed sources.
+     * @param separationCache Checked before decoding and filled after separating; may be nullptr.
+     * @param separation The backend to separate with, and its model variant if that is available.
+     * @param shouldExit Polled between chunks; returning true abandons the load.
+     * @param reportProgress Called with each stage and its progress.
+     * @param publishPreview If set, called from Separate with stems that fill in as they are
+     *                       separated; the result returned then has followsPreview set.
+     * @return The result; error is set if the load failed or was cancelled.
+     */
+    static Result runStages(const juce::File& file, double targetSampleRate,
+                            juce::AudioFormatManager& formatManager, ml::ONNXModelLoader& modelLoader,
+                            const StreamingOptions& streaming,
+                            SeparationCache* separationCache,
+                            const SeparationOptions& separation,
+                            const std::function<bool()>& shouldExit,
+                            const std::function<void(Stage, float)>& reportProgress,
+                            const std::function<void(Result&&)>& publishPreview = {});
+
+    /**
+     * @brief Converts a set of stem sources to another sample rate. Blocks while it reads,
+     *        resamples and (for streamed stems) rewrites every stem, so it must not be called
+     *        on the audio thread.
+     * @param streaming How the converted sources are held, as for a new load.
+     * @return The converted sources in the same order, or an empty vector if a stem could not be read.
+     */
+    static std::vector<StemSourcePtr> resampleSources(const std::vector<StemSourcePtr>& sources,
+                                                      double sourceRate, double targetRate,
+                                                      const StreamingOptions& streaming);
+
+private:
+    class LoadJob;
+
+    void handleAsyncUpdate() override;
+    void setProgress(Stage stage, float progress);
+    void finishJob(int generation, Result&& result, bool cancelled);
+    void publishPreview(int generation, Result&& preview);
+
+    juce::AudioFormatManager& formatManager;
+    ml::ONNXModelLoader& modelLoader;
+
+    juce::ThreadPool pool { 1 };
+    std::atomic<int> generation { 0 };
+    std::atomic<Stage> currentStage { Stage::Idle };
+    std::atomic<float> currentProgress { 0.0f };
+
+    juce::CriticalSection resultLock;
+    StreamingOptions streamingOptions;
+    SeparationCache* separationCache = nullptr;
+    SeparationOptions separationOptions;
+    std::unique_ptr<Result> pendingResult;
+    int pendingGeneration = -1;
+
+    juce::ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StemLoadPipeline)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <functional>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class StemRenderer
+ * @brief The effect chain of one stem and the mapping from its parameters onto it.
+ *
+ * Playback and the offline renderer both render stems through this class, so a bounce
+ * goes through exactly the same processing as the audio device. A stem's parameters are
+ * passed as an array of raw (denormalised) values indexed by Parameter; every call to
+ * process() applies them before processing, which keeps the output independent of how
+ * the audio is split into blocks.
+ */
+class StemRenderer
+{
+public:
+    /** @brief The per-stem parameters, named as in UndergroundBeatsProcessor::getStemParameterID(). */
+    enum Parameter
+    {
+        volume, gain, mute, solo,
+        eq1Enable, eq1Freq, eq1Gain, eq1Q,
+        eq2Enable, eq2Freq, eq2Gain, eq2Q,
+        eq3Enable, eq3Freq, eq3Gain, eq3Q,
+        compEnable, compThreshold, compRatio, compAttack, compRelease,
+        reverbEnable, reverbRoomSize, reverbDamping, reverbWetLevel, reverbDryLevel, reverbWidth, reverbFreeze,
+        chorusEnable, chorusRate, chorusDepth, chorusCentreDelay, chorusFeedback, chorusMix,
+        saturationEnable, saturationAmount,
+        numParameters
+    };
+
+    /** @brief Raw values of a stem's parameters, indexed by Parameter. */
+    using ParameterValues = std::array<float, numParameters>;
+
+    /** @brief Where each of a stem's parameters sits in the processor's parameter list; -1 if missing. */
+    using ParameterIndices = std::array<int, numParameters>;
+
+    /** @brief Returns the type suffix of a parameter's ID, e.g. "EQ1_Freq". */
+    static juce::String getParameterType(int parameter);
+
+    /** @brief Returns the values used for parameters a stem doesn't have. */
+    static const ParameterValues& getDefaultValues();
+
+    /** @brief Returns true if a stem with these values is heard, given whether any stem is soloed. */
+    static bool isAudible(const ParameterValues& values, bool anySoloActive);
+
+    /** @brief Returns true if the stem is soloed. */
+    static bool isSoloed(const ParameterValues& values) { return values[solo] > 0.5f; }
+
+    /** @brief Returns the gain the processed stem is mixed with. */
+    static float getOutputGain(const ParameterValues& values);
+
+    StemRenderer();
+
+    /** @brief Prepares the chain for stereo processing and resets its state. */
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /**
+     * @brief Applies the values to the chain and processes the first numSamples of a
+     *        stereo buffer in place. numSamples must not exceed the prepared block size.
+     */
+    void process(juce::AudioBuffer<float>& stereo, int numSamples, const ParameterValues& values);
+
+private:
+    void applyParameters(const ParameterValues& values);
+
+    using EffectChain = juce::dsp::ProcessorChain<
+        juce::dsp::IIR::Filter<float>,  // EQ Band 1
+        juce::dsp::IIR::Filter<float>,  // EQ Band 2
+        juce::dsp::IIR::Filter<float>,  // EQ Band 3
+        juce::dsp::Compressor<float>,   // Compressor
+        juce::dsp::Reverb,              // Reverb
+        juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear>, // Delay
+        juce::dsp::Chorus<float>,       // Chorus
+        juce::dsp::WaveShaper<float, std::function<float(float)>>,   // Saturation (std::function)
+        juce::dsp::Gain<float>          // Placeholder Style Transfer
+    >;
+
+    EffectChain chain;
+    double currentSampleRate = 44100.0;
+
+    // The values the EQ and saturation were last built from. Rebuilding them allocates,
+    // so applyParameters() only does it when one of these changes; prepare() resets them.
+    ParameterValues appliedValues {};
+    bool hasAppliedValues = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StemRenderer)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
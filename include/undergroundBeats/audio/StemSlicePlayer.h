@@ -0,0 +1,121 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <array>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @struct StemSlice
+ * @brief A region of a stem that is played when a MIDI note arrives.
+ */
+struct StemSlice
+{
+    int stemIndex = -1;            // Stem the region is read from; -1 means the note is unassigned
+    juce::int64 startSample = 0;   // First sample of the region in the stem
+    int numSamples = 0;            // Length of the region
+    bool oneShot = true;           // One-shot slices ignore note-off; gated slices fade out on it
+};
+
+/**
+ * @class StemSlicePlayer
+ * @brief Plays regions of stems from MIDI notes, e.g. a drum stem from pads.
+ *
+ * Each of the 128 notes can be assigned a slice. Note-ons start one of a fixed pool of
+ * voices, so triggering never allocates; when the pool is full the oldest voice is
+ * stolen. Voices are mixed into each stem's signal before its effect chain, so slices
+ * are processed exactly like the timeline playback of the same stem.
+ *
+ * Slice assignments are written on the message thread and read on the audio thread
+ * through a SpinLock that the audio thread only try-locks, like the automation lanes.
+ */
+class StemSlicePlayer
+{
+public:
+    static constexpr int numNotes = 128;
+    static constexpr int maxVoices = 16;
+    static constexpr int fadeSamples = 32; // Anti-click ramp at slice edges and on note-off
+
+    StemSlicePlayer();
+
+    //==============================================================================
+    // Slice assignment (message thread)
+
+    /** @brief Assigns a slice to a note. */
+    void setSlice(int noteNumber, const StemSlice& slice);
+
+    /** @brief Returns the slice assigned to a note (unassigned if stemIndex is -1). */
+    StemSlice getSlice(int noteNumber) const;
+
+    /** @brief Removes all slice assignments. */
+    void clearSlices();
+
+    /**
+     * @brief Chops a stem into equal regions mapped to consecutive notes.
+     * @param stemIndex Stem to slice.
+     * @param stemLength Length of the stem in samples.
+     * @param numSlices Number of regions.
+     * @param firstNote Note that triggers the first region (36 is C1, the usual first pad).
+     */
+    void sliceEvenly(int stemIndex, juce::int64 stemLength, int numSlices, int firstNote = 36);
+
+    /** @brief Writes all slice assignments into an XML element. */
+    std::unique_ptr<juce::XmlElement> createXml() const;
+
+    /** @brief Restores slice assignments previously written by createXml(). */
+    void restoreFromXml(const juce::XmlElement& xml);
+
+    //==============================================================================
+    // Playback (audio thread)
+
+    /** @brief Starts a voice for the note's slice, if it has one. */
+    void noteOn(int noteNumber, float velocity);
+
+    /** @brief Releases gated voices playing the note. */
+    void noteOff(int noteNumber);
+
+    /** @brief Stops every voice immediately. */
+    void allNotesOff();
+
+    /** @brief Returns true if any voice is playing the given stem. */
+    bool isStemActive(int stemIndex) const;
+
+    /**
+     * @brief Adds the voices of one stem into a destination buffer. Does not advance the voices.
+     * @param stemIndex Stem being rendered.
+     * @param stemBuffer The stem's audio.
+     * @param destination Buffer to add into, starting at sample 0.
+     * @param numSamples Number of samples to render.
+     */
+    void renderStem(int stemIndex, const juce::AudioBuffer<float>& stemBuffer,
+                    juce::AudioBuffer<float>& destination, int numSamples) const;
+
+    /** @brief Advances every voice by a rendered sub-block and retires finished ones. */
+    void advance(int numSamples);
+
+private:
+    struct Voice
+    {
+        bool active = false;
+        int noteNumber = -1;
+        StemSlice slice;
+        int position = 0;     // Samples played so far
+        int endPosition = 0;  // Shortened on note-off for gated slices
+        float gain = 1.0f;
+        juce::uint32 age = 0; // Start order, for stealing the oldest voice
+    };
+
+    std::array<StemSlice, numNotes> slices;
+    std::array<Voice, maxVoices> voices;
+    juce::uint32 voiceCounter = 0;
+    int numActiveVoices = 0;
+
+    mutable juce::SpinLock sliceLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StemSlicePlayer)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "SharedAudio.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <memory>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class StemSource
+ * @brief Where a stem's audio comes from during playback.
+ *
+ * The audio thread only ever reads stems through read(), which must not block or
+ * allocate: a source whose data isn't available yet fills silence and returns false.
+ * Sources are immutable once published and are shared by reference, like the buffers
+ * they replace, so undo history and the UI can hold on to them cheaply.
+ */
+class StemSource
+{
+public:
+    /** @brief Samples per point in the overview drawn for sources without a float copy. */
+    static constexpr int overviewDecimation = 256;
+
+    virtual ~StemSource() = default;
+
+    /** @brief Number of channels in the source audio. */
+    virtual int getNumChannels() const = 0;
+
+    /** @brief Length of the stem in samples. */
+    virtual juce::int64 getLengthInSamples() const = 0;
+
+    /**
+     * @brief Copies samples into a buffer, up-mixing a mono source to every destination channel.
+     *        Called on the audio thread.
+     * @return False if some of the samples were not available and were filled with silence.
+     */
+    virtual bool read(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+                      juce::int64 sourceStartSample) = 0;
+
+    /** @brief The whole stem if it is held in memory, or nullptr if it is streamed. */
+    virtual const juce::AudioBuffer<float>* getResidentBuffer() const = 0;
+
+    /** @brief A buffer suitable for drawing the waveform; may be a decimated overview. */
+    virtual const juce::AudioBuffer<float>* getDisplayBuffer() const = 0;
+
+    /** @brief Bytes of audio this source keeps in RAM. */
+    virtual size_t getResidentBytes() const = 0;
+
+    /**
+     * @brief The whole stem in memory, e.g. to resample it. May read from disk, so it
+     *        must never be called on the audio thread.
+     * @return The audio, or an invalid handle if it could not be read.
+     */
+    virtual SharedAudio readEntireStem() const = 0;
+};
+
+using StemSourcePtr = std::shared_ptr<StemSource>;
+
+//==============================================================================
+/**
+ * @class MemoryStemSource
+ * @brief A stem held entirely in RAM.
+ *
+ * The audio is a SharedAudio handle, so placeholder stems that all use the decoded mix
+ * cost one copy.
+ */
+class MemoryStemSource : public StemSource
+{
+public:
+    explicit MemoryStemSource(SharedAudio audio);
+
+    int getNumChannels() const override;
+    juce::int64 getLengthInSamples() const override;
+    bool read(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+              juce::int64 sourceStartSample) override;
+    const juce::AudioBuffer<float>* getResidentBuffer() const override { return audio.get(); }
+    const juce::AudioBuffer<float>* getDisplayBuffer() const override { return audio.get(); }
+    size_t getResidentBytes() const override;
+    SharedAudio readEntireStem() const override { return audio; }
+
+    /** @brief The shared audio. */
+    const SharedAudio& getAudio() const { return audio; }
+
+private:
+    const SharedAudio audio;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MemoryStemSource)
+};
+
+//==============================================================================
+/**
+ * @brief Copies part of a buffer into another, up-mixing mono and zero-filling any part
+ *        of the range that lies outside the source. Shared by the stem sources.
+ * @return The number of samples that came from the source.
+ */
+int copyStemSamples(const juce::AudioBuffer<float>& source, juce::int64 sourceStartSample,
+                    juce::AudioBuffer<float>& destination, int destStartSample, int numSamples);
+
+/**
+ * @brief Makes a waveform overview holding the loudest sample of every
+ *        StemSource::overviewDecimation samples, so the drawn shape matches the full stem.
+ */
+juce::AudioBuffer<float> makeStemOverview(const juce::AudioBuffer<float>& stem);
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "StemSource.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+
+namespace undergroundBeats {
+namespace audio {
+
+/**
+ * @class StreamingStemSource
+ * @brief A stem played from a PCM cache file on disk.
+ *
+ * The stem is written once to an uncompressed 32-bit float WAV file, so reading it back
+ * is a plain copy. Playback reads through a juce::BufferingAudioReader, whose background
+ * thread keeps a window of blocks around the play position filled; the audio thread never
+ * waits for the disk and gets silence if the window hasn't caught up.
+ *
+ * The start of the stem is also kept resident. Playback jumps back there on stop and on
+ * every loop, so the most common seek is served without waiting for read-ahead.
+ *
+ * The cache file belongs to the source and is deleted with it.
+ */
+class StreamingStemSource : public StemSource
+{
+public:
+    /** @brief How the source's RAM budget is divided between the resident head and read-ahead. */
+    static constexpr float headFraction = 0.25f;
+
+    /** @brief Samples per block of juce::BufferingAudioReader, which holds whole blocks. */
+    static constexpr int readAheadBlockSamples = 1 << 15;
+
+    /**
+     * @brief The fewest blocks the read-ahead holds: the one being played and the next. The
+     *        head gives way to them first; a budget too small for them alone is exceeded.
+     */
+    static constexpr int minimumReadAheadBlocks = 2;
+
+    /** @brief The smallest budget a source for a stem of this shape keeps to: its overview and the minimum read-ahead. */
+    static size_t getMinimumRamBudget(int numChannels, juce::int64 lengthInSamples)
+    {
+        const auto overviewSamples = (lengthInSamples + overviewDecimation - 1) / overviewDecimation;
+        const auto samples = (juce::int64) minimumReadAheadBlocks * readAheadBlockSamples + juce::jmax((juce::int64) 0, overviewSamples);
+        return (size_t) samples * (size_t) juce::jmax(1, numChannels) * sizeof(float);
+    }
+
+    /**
+     * @brief Writes a stem to a cache file and opens it for streaming.
+     * @param stem The audio to stream; only read during this call.
+     * @param sampleRate Rate stored in the cache file.
+     * @param cacheFile File to write; overwritten if it exists.
+     * @param ramBudgetBytes Upper bound on the audio this source keeps in memory, unless it
+     *                       is below getMinimumRamBudget().
+     * @param readAheadThread Thread that fills the read-ahead; must outlive the source.
+     * @return The source, or nullptr if the cache file could not be written or opened.
+     */
+    static std::shared_ptr<StreamingStemSource> create(const juce::AudioBuffer<float>& stem, double sampleRate,
+                                                       const juce::File& cacheFile, size_t ramBudgetBytes,
+                                                       juce::TimeSliceThread& readAheadThread);
+
+    ~StreamingStemSource() override;
+
+    int getNumChannels() const override { return numChannels; }
+    juce::int64 getLengthInSamples() const override { return lengthInSamples; }
+    bool read(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+              juce::int64 sourceStartSample) override;
+    const juce::AudioBuffer<float>* getResidentBuffer() const override { return nullptr; }
+    const juce::AudioBuffer<float>* getDisplayBuffer() const override { return &overview; }
+    size_t getResidentBytes() const override;
+    SharedAudio readEntireStem() const override;
+
+    /** @brief The cache file the stem streams from. */
+    const juce::File& getCacheFile() const { return cacheFile; }
+
+    /**
+     * @brief Opens a source of its own on the cache file, which reads straight from disk and
+     *        waits for it, for offline work that must see every sample. Only one thread may
+     *        read it at a time, and this source must outlive it.
+     * @return The source, or nullptr if the cache file could not be opened.
+     */
+    StemSourcePtr createFileReader() const;
+
+private:
+    StreamingStemSource(const juce::AudioBuffer<float>& stem, const juce::File& cacheFile,
+                        int headSamples, int readAheadSamples);
+
+    bool openReader(juce::TimeSliceThread& readAheadThread);
+
+    const juce::File cacheFile;
+    const int numChannels;
+    const juce::int64 lengthInSamples;
+    const int readAheadSamples; // Resident in the reader's blocks, including the one being played
+
+    juce::AudioBuffer<float> head;      // The first samples of the stem, always resident
+    juce::AudioBuffer<float> overview;  // Peak-per-bin copy for the waveform display
+    std::unique_ptr<juce::BufferingAudioReader> reader;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StreamingStemSource)
+};
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "../audio/BatchImportQueue.h"
+#include <functional>
+#include <vector>
+
+namespace undergroundBeats {
+
+/**
+ * Lists the jobs of a batch import with the stage and progress of each, plus buttons to
+ * cancel the batch and to clear finished jobs.
+ */
+class BatchImportComponent : public juce::Component,
+                             private juce::ListBoxModel,
+                             private audio::BatchImportQueue::Listener,
+                             private juce::Timer
+{
+public:
+    explicit BatchImportComponent(audio::BatchImportQueue& queue);
+    ~BatchImportComponent() override;
+
+    void resized() override;
+    void paint(juce::Graphics& g) override;
+
+    // Called when the list goes from empty to not empty or back, so the owner can show or hide it
+    std::function<void(bool hasJobs)> onHasJobsChanged;
+
+private:
+    // ListBoxModel
+    int getNumRows() override;
+    void paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
+
+    // BatchImportQueue::Listener
+    void batchImportChanged() override;
+
+    // Progress within a stage isn't broadcast, so it is polled while jobs run
+    void timerCallback() override;
+
+    static juce::String describe(const audio::BatchImportQueue::JobInfo& job);
+
+    audio::BatchImportQueue& importQueue;
+    std::vector<audio::BatchImportQueue::JobInfo> jobs;
+
+    juce::Label titleLabel { {}, "Batch import" };
+    juce::ListBox jobList { "Batch import jobs", this };
+    juce::TextButton cancelButton { "Cancel" };
+    juce::TextButton clearButton { "Clear" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchImportComponent)
+};
+
+} // namespace undergroundBeats
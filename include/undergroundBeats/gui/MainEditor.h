@@ -1,6 +1,7 @@
 #pragma once
 
 #include "JuceHeader.h"
+#include "../audio/StemLoadPipeline.h"
 #include <vector>
 #include <memory>
 
@@ -21,10 +22,12 @@ class SaturationPanelComponent;
 class StyleTransferPanelComponent;
 class EffectIconBarComponent;
 class StemControlPanel;
+class BatchImportComponent;
 
 //==============================================================================
 class MainEditor : public juce::AudioProcessorEditor,
-                   private juce::Timer
+                   private juce::Timer,
+                   private audio::StemLoadPipeline::Listener
 {
   public:
     MainEditor(UndergroundBeatsProcessor&);
@@ -42,6 +45,9 @@ class MainEditor : public juce::AudioProcessorEditor,
     // Update the stem displays with the latest audio buffers
     void updateStemDisplays();
 
+    // StemLoadPipeline::Listener - shows the background load's stage and progress
+    void loadProgressChanged(audio::StemLoadPipeline::Stage stage, float progress) override;
+
     UndergroundBeatsProcessor& processorRef;
 
     // Unique pointers require full definition visibility in .cpp for destructor
@@ -56,6 +62,7 @@ class MainEditor : public juce::AudioProcessorEditor,
     std::unique_ptr<SaturationPanelComponent> saturationPanel;
     std::unique_ptr<StyleTransferPanelComponent> styleTransferPanel;
     std::unique_ptr<EffectIconBarComponent> effectIconBar;
+    std::unique_ptr<BatchImportComponent> batchImportPanel; // Shown below the sidebar while it lists jobs
 
     // Vector of stem control panels for displaying the separated stems
     std::vector<std::unique_ptr<StemControlPanel>> stemPanels;
@@ -63,6 +70,10 @@ class MainEditor : public juce::AudioProcessorEditor,
     // Component to hold the stem panels
     std::unique_ptr<juce::Component> stemContainer;
 
+    // Progress of the file currently being loaded and separated
+    double loadProgress = 0.0;
+    juce::ProgressBar loadProgressBar { loadProgress };
+
     // Callback functions for effect toggles
     void toggleEQPanel();
     void toggleCompressorPanel();
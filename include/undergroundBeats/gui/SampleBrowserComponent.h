@@ -46,6 +46,10 @@ public:
 
     // ** NEW ** Callback for when a file is chosen via double-click
     std::function<void(const juce::File&)> onFileChosenForProcessing;
+
+    // Callback for a drop of several files or of folders; receives every suitable file,
+    // folders searched recursively. Without it only the first suitable file is used.
+    std::function<void(const juce::Array<juce::File>&)> onFilesDroppedForBatch;
     
     // ** NEW ** Get the currently selected file
     juce::File getSelectedFile() const { return selectedFile; }
@@ -86,6 +90,9 @@ private:
     // Create a new wildcard filter for audio files
     static juce::WildcardFileFilter* createAudioFileFilter();
     
+    // Expands dropped paths to the suitable files they contain, searching folders recursively
+    juce::Array<juce::File> findSuitableFiles(const juce::StringArray& paths) const;
+
     // Add a file to the recent files list
     void addToRecentFiles(const juce::File& file);
     
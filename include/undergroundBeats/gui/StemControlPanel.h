@@ -102,10 +102,29 @@ public:
         soloButton.setAccessible(true);
         muteButton.setAccessible(true);
         zoomSlider.setAccessible(true);
+
+        // Right-click on a parameter slider opens the MIDI menu
+        volumeSlider.addMouseListener(this, false);
+        gainSlider.addMouseListener(this, false);
     }
 
     /** Destructor. */
-    ~StemControlPanel() override = default;
+    ~StemControlPanel() override
+    {
+        volumeSlider.removeMouseListener(this);
+        gainSlider.removeMouseListener(this);
+    }
+
+    void mouseDown(const juce::MouseEvent& event) override
+    {
+        if (processorRef == nullptr || !event.mods.isPopupMenu())
+            return;
+
+        if (event.eventComponent == &volumeSlider)
+            showMidiMenu("Volume");
+        else if (event.eventComponent == &gainSlider)
+            showMidiMenu("Gain");
+    }
 
     void paint(juce::Graphics& g) override
     {
@@ -173,6 +192,13 @@ public:
         waveformDisplay.setAudioBuffer(buffer);
     }
 
+    // Rename the stem, e.g. when a file separated by another model is loaded
+    void setStemName(const juce::String& name)
+    {
+        stemName = name;
+        nameLabel.setText(stemName, juce::dontSendNotification);
+    }
+
     // Set zoom factor
     void setZoomFactor(float zoom)
     {
@@ -231,6 +257,33 @@ public:
     }
 
 private:
+    // MIDI learn / clear for one of this stem's parameters, plus slicing the stem onto pads
+    void showMidiMenu(const juce::String& paramType)
+    {
+        const auto paramID = UndergroundBeatsProcessor::getStemParameterID(stemIndex, paramType);
+
+        juce::PopupMenu menu;
+        menu.addItem(1, "MIDI Learn");
+        menu.addItem(2, "Clear MIDI Mapping");
+        menu.addSeparator();
+        menu.addItem(3, "Slice Stem to Pads (16)");
+
+        juce::Component::SafePointer<StemControlPanel> safeThis(this);
+        menu.showMenuAsync(juce::PopupMenu::Options(), [safeThis, paramID](int result)
+        {
+            if (safeThis == nullptr || safeThis->processorRef == nullptr)
+                return;
+
+            auto* processor = safeThis->processorRef;
+            if (result == 1)
+                processor->beginMidiLearn(paramID);
+            else if (result == 2)
+                processor->clearMidiMappings(paramID);
+            else if (result == 3)
+                processor->sliceStemToPads(safeThis->stemIndex, 16);
+        });
+    }
+
     // Button listener implementation
     void buttonClicked(juce::Button* button) override
     {
@@ -17,7 +17,8 @@ class SidebarComponent; // Forward declaration within namespace
  */
 class TopBarComponent : public juce::Component,
                           public juce::Button::Listener,
-                          public juce::ChangeListener
+                          public juce::ChangeListener,
+                          private juce::Timer
 {
 public:
     // Constructor signature uses types within this namespace
@@ -31,6 +32,13 @@ public:
     void changeListenerCallback(juce::ChangeBroadcaster* source) override;
 
 private:
+    // Shows the export's progress on its button while a render runs
+    void timerCallback() override;
+
+    // Asks which parts to export, then where, and starts the render
+    void showExportMenu();
+    void chooseExportFile(bool includeStems, bool asFloat);
+
     // Reference types are within this namespace
     UndergroundBeatsProcessor& processorRef;
     SidebarComponent& sidebarRef;
@@ -38,7 +46,17 @@ private:
     juce::Label projectNameLabel { {}, "Untitled Project" };
     juce::Label saveStatusIndicator;
     juce::TextButton loadButton { "Load Selected" };
+    juce::TextButton undoButton { "Undo" };
+    juce::TextButton redoButton { "Redo" };
+
+    // Preset morph: store the current sound as A or B, then blend with the slider
+    juce::TextButton storeMorphAButton { "A" };
+    juce::TextButton storeMorphBButton { "B" };
+    juce::Slider morphSlider { juce::Slider::LinearHorizontal, juce::Slider::NoTextBox };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> morphAttachment;
     juce::TextButton saveButton { "Save" };
+    juce::TextButton exportButton { "Export" };
+    std::unique_ptr<juce::FileChooser> exportChooser;
     juce::TextButton settingsButton { "Settings" };
     juce::TextButton helpButton { "?" };
 
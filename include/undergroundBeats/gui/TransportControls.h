@@ -51,6 +51,7 @@ private:
     juce::TextButton playButton;
     juce::TextButton pauseButton;
     juce::TextButton stopButton;
+    juce::TextButton recordButton; // Arms automation recording
 
     // The processor that we'll control
     UndergroundBeatsProcessor* audioProcessor;
@@ -3,6 +3,7 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_audio_utils/juce_audio_utils.h>
+#include "undergroundBeats/audio/SharedAudio.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -67,13 +68,16 @@ public:
     /**
      * @brief Adds a new variation to be displayed.
      * @param variationId Unique ID for this variation.
-     * @param audioBuffer The audio data for the variation.
+     * @param variationAudio The audio data for the variation; shared with the generator, not copied.
      * @param componentName The name of the original component this variation belongs to.
      */
     void addVariation(const std::string& variationId,
-                      const juce::AudioBuffer<float>& audioBuffer,
+                      const audio::SharedAudio& variationAudio,
                       const std::string& componentName); // Added componentName
 
+    /** @brief Returns the audio of a displayed variation, or an empty handle. */
+    audio::SharedAudio getVariationAudio(const std::string& variationId) const;
+
     // --- Component Overrides ---
     void paint(juce::Graphics& g) override;
     void resized() override;
@@ -92,6 +96,7 @@ private:
     struct VariationInfo {
         std::string id;
         std::string componentName; // Store associated component name
+        audio::SharedAudio sharedAudio; // Shared with the generator's result
         std::unique_ptr<VariationThumbnailComponent> thumbnailComponent;
     };
 
@@ -8,6 +8,15 @@
 namespace undergroundBeats {
 namespace ml {
 
+/**
+ * @brief Which build of a separation model to run: the full-precision model, or an INT8
+ *        quantized one that runs several times faster on CPUs at some cost in quality.
+ */
+enum class ModelVariant {
+    Quality,
+    Fast
+};
+
 /**
  * @class AudioSourceSeparator
  * @brief Abstract base class for audio source separation algorithms.
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "undergroundBeats/ml/ONNXModelLoader.h"
+#include "undergroundBeats/audio/SharedAudio.h"
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <memory>
 #include <string>
@@ -48,6 +49,18 @@ public:
         int numVariations,
         float creativityFactor = 0.5f);
     
+    /**
+     * @brief Generate variations of shared audio without copying it up front
+     * @param input The audio to generate variations from
+     * @param numVariations The number of variations to generate
+     * @param creativityFactor How creative the variations should be (0.0-1.0)
+     * @return Handles to the generated variations
+     */
+    std::vector<audio::SharedAudio> generateVariations(
+        const audio::SharedAudio& input,
+        int numVariations,
+        float creativityFactor = 0.5f);
+    
     /**
      * @brief Set the random seed for reproducible variations
      * @param seed The seed value
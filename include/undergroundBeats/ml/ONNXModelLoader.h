@@ -1,7 +1,12 @@
 #pragma once
 
 #include <string>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <future>
+#include <vector>
+#include <juce_core/juce_core.h>
 #include <onnxruntime_cxx_api.h> // Include ONNX Runtime C++ API
 
 namespace undergroundBeats {
@@ -10,34 +15,132 @@ namespace ml {
 /**
  * @class ONNXModelLoader
  * @brief Responsible for loading and managing ONNX models.
+ *
+ * Sessions are cached by model file and session options, so every separator and generator
+ * using a model shares one session (Ort::Session::Run may be called from several threads at
+ * once). A session is created on first use, or ahead of time by preloadModels().
+ *
+ * Every loader uses one process-wide environment whose intra-op and inter-op thread pools
+ * are shared by all sessions, so separations and variations running at the same time share
+ * the cores instead of each session starting a pool as large as the machine.
  */
 class ONNXModelLoader {
 public:
+    /** @brief Sizes of the shared thread pools; 0 lets ONNX Runtime choose (one per physical core). */
+    struct ThreadingSettings
+    {
+        int intraOpThreads = 0;
+        int interOpThreads = 0;
+    };
+
+    /**
+     * @brief Sets the sizes of the shared thread pools.
+     * @return False if the environment already exists; the pools can't be resized once created.
+     */
+    static bool configureThreading(const ThreadingSettings& settings);
+
+    /** @brief Returns the process-wide environment, creating it on first use. */
+    static Ort::Env& getSharedEnvironment();
+
+    /** @brief How sessions are created; part of the session cache key. */
+    struct SessionSettings
+    {
+        enum class ExecutionMode { Sequential, Parallel };
+        enum class Optimization { Disabled, Basic, Extended, All };
+        enum class Provider { Default, Xnnpack, OneDnn };
+
+        // Shared pools are sized by configureThreading(); otherwise the session gets its own
+        // pools of these sizes (0 lets ONNX Runtime choose)
+        bool useSharedThreadPools = true;
+        int intraOpThreads = 0;
+        int interOpThreads = 0;
+
+        ExecutionMode executionMode = ExecutionMode::Sequential; // Parallel runs independent branches at once
+        Optimization optimization = Optimization::All;
+        Provider provider = Provider::Default; // Falls back to Default if not built into ONNX Runtime
+
+        // If set, the optimized graph is saved here and loaded by later sessions instead of
+        // optimizing again. Only used with the Default provider, whose graphs are portable.
+        juce::File optimizedModelDirectory;
+
+        /** @brief A short description, e.g. "shared pools, sequential, all". */
+        std::string describe() const;
+    };
+
+    /** @brief Returns true if ONNX Runtime was built with this execution provider. */
+    static bool isProviderAvailable(SessionSettings::Provider provider);
+
     /**
-     * @brief Constructor. Initializes the ONNX Runtime environment.
+     * @brief Constructor. Uses the shared ONNX Runtime environment.
      */
     ONNXModelLoader();
 
     /**
-     * @brief Destructor.
+     * @brief Destructor. Waits for a preload in progress.
      */
     ~ONNXModelLoader();
 
     /**
-     * @brief Loads an ONNX model from the specified file path.
+     * @brief Sets how sessions are created from now on. Cached sessions keep their settings,
+     *        but getSession() only returns ones created with the current settings.
+     */
+    void setSessionSettings(const SessionSettings& newSettings);
+
+    /** @brief Returns the settings new sessions are created with. */
+    SessionSettings getSessionSettings() const;
+
+    /**
+     * @brief Loads an ONNX model from the specified file path into a new, uncached session.
      * @param modelPath Path to the .onnx model file.
      * @return A unique pointer to the ONNX session if successful, nullptr otherwise.
      */
     std::unique_ptr<Ort::Session> loadModel(const std::string& modelPath);
 
+    /** @brief Loads a model into a new, uncached session created with these settings. */
+    std::unique_ptr<Ort::Session> loadModel(const std::string& modelPath, const SessionSettings& sessionSettings);
+
+    /**
+     * @brief Returns the shared, warmed-up session for a model, loading it if needed.
+     *        If the model is being preloaded, waits for that instead of loading it twice.
+     * @param modelPath Path to the .onnx model file.
+     * @return The session, or nullptr if the model is missing or invalid.
+     */
+    std::shared_ptr<Ort::Session> getSession(const std::string& modelPath);
+
+    /**
+     * @brief Loads and warms up the sessions for these models on a background thread,
+     *        so the first inference doesn't pay for loading and optimizing the model.
+     */
+    void preloadModels(const std::vector<std::string>& modelPaths);
+
+    /**
+     * @brief Drops the cached sessions; users holding one keep it alive until they finish.
+     */
+    void clearSessions();
+
     /**
      * @brief Returns a reference to the ONNX Runtime environment.
      */
     Ort::Env& getEnvironment();
 
 private:
-    Ort::Env env; // ONNX Runtime environment
-    Ort::SessionOptions sessionOptions; // Session options
+    using SessionFuture = std::shared_future<std::shared_ptr<Ort::Session>>;
+
+    // The cache key: the model file's path, size and modification time, plus the settings
+    static std::string makeSessionKey(const std::string& modelPath, const SessionSettings& sessionSettings);
+
+    static Ort::SessionOptions makeSessionOptions(const SessionSettings& sessionSettings);
+
+    // Runs one inference on zeros, so lazy allocations happen before real work arrives
+    static void warmUp(Ort::Session& session);
+
+    Ort::Env& env; // The shared ONNX Runtime environment
+
+    mutable std::mutex sessionLock;
+    SessionSettings settings;
+    std::map<std::string, SessionFuture> sessions;
+
+    juce::ThreadPool preloadPool { 1 };
 };
 
 } // namespace ml
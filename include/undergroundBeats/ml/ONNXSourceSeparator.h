@@ -2,7 +2,11 @@
 
 #include "undergroundBeats/ml/AudioSourceSeparator.h"
 #include "undergroundBeats/ml/ONNXModelLoader.h"
+#include "undergroundBeats/ml/STFTProcessor.h"
+#include "undergroundBeats/audio/SharedAudio.h"
 #include <onnxruntime_cxx_api.h>
+#include <exception>
+#include <functional>
 #include <string>
 #include <vector>
 #include <memory>
@@ -14,20 +18,98 @@ namespace ml {
 /**
  * @class ONNXSourceSeparator
  * @brief Implements audio source separation using an ONNX model.
+ *
+ * The model takes a [batch, channels, samples] window of the mix and returns either one
+ * [batch, sources, channels, samples] tensor or one [batch, channels, samples] tensor per
+ * source. Tracks are separated window by window: each window overlaps its neighbours by
+ * chunkOverlap, and the overlaps are crossfaded with complementary raised-cosine fades, so
+ * apart from the stems themselves memory does not grow with the length of the track.
+ *
+ * Source names come from the model's "sources" metadata (comma separated) if it has any.
+ *
+ * Models whose input is [batch, channels, bins, frames] work on spectrograms: each window
+ * is transformed here by an STFTProcessor, the model gets its magnitudes and returns a mask
+ * per source ([batch, sources, channels, bins, frames] stacked, or [batch, channels, bins,
+ * frames] each), and the masked spectrograms are inverted back to audio here, so only the
+ * network itself runs in ONNX Runtime. The metadata keys "stft_fft_size" and "stft_hop"
+ * set the transform (4096 and a quarter of the FFT size otherwise), and "spectrogram_output" = "magnitude"
+ * marks models that return magnitudes rather than masks.
+ *
+ * A model may come with an INT8 quantized variant (see getVariantPath()), made with ONNX
+ * Runtime's dynamic or static quantization tools; ONNX Runtime runs the quantized operators
+ * itself, so both variants are separated the same way here.
+ *
+ * Several windows are separated at once (see setParallelWindows()): each runs on a lane of
+ * its own buffers, bindings and transform, all calling Run on the one shared session, while
+ * the calling thread adds finished windows into the stems. One window's overlap-add thus
+ * overlaps the next windows' transforms and inference.
  */
 class ONNXSourceSeparator : public AudioSourceSeparator {
 public:
+    /** @brief Samples per window for models whose input length is not fixed. */
+    static constexpr int defaultChunkSamples = 44100 * 8;
+
+    /** @brief Fraction of each window shared with the next one; at most 0.5. */
+    static constexpr float chunkOverlap = 0.25f;
+
+    /**
+     * @brief Hooks into separateInto(), called on the separating thread.
+     *
+     * The track is divided into segments of getWindowHop() samples. Window w starts at
+     * segment w and overlaps the start of segment w + 1, so a segment is final once the
+     * windows on both sides of its start are separated.
+     */
+    struct WindowCallbacks {
+        /** Polled between windows; returning true abandons the separation. */
+        std::function<bool()> shouldExit;
+
+        /** Called after each window with the fraction separated (0 - 1). */
+        std::function<void(float)> reportProgress;
+
+        /** The sample to separate first; windows from just before it onwards go first. */
+        std::function<juce::int64()> getPriorityPosition;
+
+        /** Called with each segment once no window adds to it any more. */
+        std::function<void(int)> segmentFinished;
+    };
+
+    /** @brief Most windows separated at once when the number is chosen automatically. */
+    static constexpr int maxAutoParallelWindows = 4;
+
+    /**
+     * @brief Time spent in each step of the last separation, summed over its windows; with
+     *        parallel windows the sum can exceed the time the separation took.
+     */
+    struct StageTimings {
+        double preprocessSeconds = 0.0;  // Copying windows in, and the forward STFT for spectrogram models
+        double inferenceSeconds = 0.0;   // ONNX Runtime
+        double postprocessSeconds = 0.0; // Masking, the inverse STFT and overlap-add into the stems
+        int numWindows = 0;
+    };
+
+    /**
+     * @brief Returns the file of a model variant: the model itself for Quality, and the
+     *        quantized model beside it, named <model>_int8.onnx, for Fast.
+     */
+    static std::string getVariantPath(const std::string& modelPath, ModelVariant variant);
+
+    /** @brief Returns "quality" or "fast", as recorded with cached stems. */
+    static const char* getVariantName(ModelVariant variant);
+
     /**
      * @brief Default constructor for creating an empty separator instance.
      */
     ONNXSourceSeparator();
 
     /**
-     * @brief Constructor. Loads the ONNX model using the provided loader.
+     * @brief Constructor. Takes the model's shared session from the loader, which loads it
+     *        unless it is cached or was preloaded.
      * @param modelPath Path to the .onnx source separation model file.
      * @param modelLoader A reference to the ONNXModelLoader instance.
+     * @param preferredChunkSamples Window length for models whose input leaves it dynamic;
+     *                              0 keeps defaultChunkSamples. A fixed window always wins.
      */
-    ONNXSourceSeparator(const std::string& modelPath, ONNXModelLoader& modelLoader);
+    ONNXSourceSeparator(const std::string& modelPath, ONNXModelLoader& modelLoader, int preferredChunkSamples = 0);
 
     /**
      * @brief Destructor.
@@ -43,8 +125,10 @@ public:
 
     /**
      * @brief Gets the names of the sources produced by the loaded model.
-     *        (Placeholder - needs implementation based on model metadata or configuration).
-     * @return A vector of source names.
+     *        They come from the comma-separated "sources" entry of the model's metadata, or
+     *        are drums, bass, vocals and other if it has none. Either list is cut or padded with
+     *        "source N" to the number of sources the model's outputs hold.
+     * @return A vector of source names, in the order the stems are returned.
      */
     std::vector<std::string> getSourceNames() const override;
 
@@ -62,10 +146,62 @@ public:
     
     /**
      * @brief Load and separate an audio file into stems.
+     *        Callers that already hold the decoded audio should use separate() instead.
      * @param audioFile The audio file to load and separate.
      * @return True if loading and separation succeeded, false otherwise.
      */
     bool loadAndSeparate(const juce::File& audioFile);
+
+    /**
+     * @brief Separates audio that has already been decoded into stems.
+     *        The stems are stored without further copies until takeStems() moves them out.
+     * @param mix The decoded audio.
+     * @param sampleRate The rate of the decoded audio; the stems share it.
+     * @param shouldExit Polled between windows; returning true abandons the separation.
+     * @param reportProgress Called after each window with the fraction separated (0 - 1).
+     * @return True if separation succeeded, false otherwise.
+     */
+    bool separate(const juce::AudioBuffer<float>& mix, double sampleRate,
+                  const std::function<bool()>& shouldExit = {},
+                  const std::function<void(float)>& reportProgress = {});
+
+    /**
+     * @brief Separates audio into stems the caller owns, segment by segment, so that finished
+     *        parts can be used while the rest is still being separated.
+     * @param mix The decoded audio.
+     * @param stems One cleared buffer per source, the size of the mix; separated windows are
+     *              added into them.
+     * @param callbacks Cancellation, progress and the order windows are separated in.
+     * @return True if separation succeeded, false if not ready, cancelled or failed.
+     */
+    bool separateInto(const juce::AudioBuffer<float>& mix, std::vector<juce::AudioBuffer<float>>& stems,
+                      const WindowCallbacks& callbacks);
+
+    /**
+     * @brief Samples between the starts of consecutive windows; the length of a segment.
+     */
+    int getWindowHop() const { return chunkSamples - overlapSamples; }
+
+    /**
+     * @brief Returns how long each step of the last separation took; cleared when one starts.
+     */
+    const StageTimings& getLastTimings() const { return timings; }
+
+    /**
+     * @brief Sets how many windows are separated at once. Each one holds a window of input
+     *        and output, so memory grows with the number.
+     * @param numWindows At least 1; 0 chooses one per two physical cores, up to maxAutoParallelWindows.
+     */
+    void setParallelWindows(int numWindows);
+
+    /** @brief Returns how many windows are separated at once, resolving the automatic choice. */
+    int getParallelWindows() const;
+
+    /**
+     * @brief Hands the separated stems over to the caller, leaving the separator empty.
+     * @return The stems in source order, as handles that are never copied until written.
+     */
+    std::vector<audio::SharedAudio> takeStems();
     
     /**
      * @brief Gets the number of available stems after separation.
@@ -76,9 +212,10 @@ public:
     /**
      * @brief Gets a specific stem's audio buffer by index.
      * @param stemIndex The index of the stem to retrieve.
-     * @return The audio buffer for the specified stem.
+     * @return The audio buffer for the specified stem; valid until the stems change.
+     * @throws std::out_of_range if there is no stem at that index.
      */
-    juce::AudioBuffer<float> getStemBuffer(int stemIndex) const;
+    const juce::AudioBuffer<float>& getStemBuffer(int stemIndex) const;
     
     /**
      * @brief Gets the sample rate of a specific stem.
@@ -97,45 +234,131 @@ public:
 
 private:
     /**
-     * @brief Preprocesses the input JUCE audio buffer into the format expected by the ONNX model.
-     * @param inputBuffer The input audio buffer.
-     * @return A vector of Ort::Value containing the preprocessed input tensors.
+     * @brief Everything one window in flight needs: its input and output tensors, bound to the
+     *        session once, and for spectrogram models its transform and spectrograms.
      */
-    std::vector<Ort::Value> preprocess(const juce::AudioBuffer<float>& inputBuffer);
+    struct WindowLane {
+        std::vector<float> inputData;               // One window of input, reused for every window
+        std::vector<std::vector<float>> outputData; // One window of each output, reused likewise
+
+        // Tensors over inputData and outputData, bound once so windows allocate nothing
+        std::vector<Ort::Value> boundTensors;
+        std::unique_ptr<Ort::IoBinding> binding;
+
+        // Spectrogram models only: the transform, and per window the mix, its spectrogram, one
+        // masked spectrogram at a time and each source's rebuilt audio
+        std::unique_ptr<STFTProcessor> stft;
+        juce::AudioBuffer<float> windowAudio;
+        STFTProcessor::Spectrogram mixSpectrogram;
+        STFTProcessor::Spectrogram sourceSpectrogram;
+        std::vector<juce::AudioBuffer<float>> sourceWindows;
+
+        // The window being separated, and how it went; set before and after processWindow()
+        int window = 0;
+        StageTimings windowTimings;
+        std::exception_ptr error;
+    };
 
     /**
-     * @brief Runs inference on the preprocessed input tensors using the ONNX session.
-     * @param inputTensors The preprocessed input tensors.
-     * @return A vector of Ort::Value containing the output tensors from the model.
+     * @brief Separates the mix window by window into one buffer per source, several windows
+     *        at once if there are lanes for them.
+     * @return True if every window was added into the stems, false if not ready or cancelled.
+     * @throws Ort::Exception if the model rejects a window.
      */
-    std::vector<Ort::Value> runInference(std::vector<Ort::Value>& inputTensors);
+    bool separateInChunks(const juce::AudioBuffer<float>& mix, std::vector<juce::AudioBuffer<float>>& stems,
+                          const WindowCallbacks& callbacks);
 
     /**
-     * @brief Postprocesses the output tensors from the model into JUCE audio buffers for each source.
-     * @param outputTensors The output tensors from the model.
-     * @return A map of source names to separated audio buffers.
+     * @brief Allocates one cleared buffer per source, the size of the mix.
+     */
+    std::vector<juce::AudioBuffer<float>> createStems(const juce::AudioBuffer<float>& mix) const;
+
+    /**
+     * @brief Creates a lane and binds its tensors to the session.
+     */
+    std::unique_ptr<WindowLane> createLane() const;
+
+    /**
+     * @brief Makes sure there are this many lanes, and threads to run them on if there is more than one.
+     */
+    void prepareLanes(int numLanes);
+
+    /**
+     * @brief Preprocesses, infers and (for spectrogram models) reconstructs the lane's window,
+     *        recording the time each step took. Safe to call on several lanes at once.
+     */
+    void processWindow(WindowLane& lane, const juce::AudioBuffer<float>& mix, int start, int length) const;
+
+    /**
+     * @brief Copies one window of the mix into the lane's input tensor, zero-padding the end
+     *        of the track and mapping the mix's channels onto the model's. Spectrogram models
+     *        get the magnitudes of the window's STFT instead.
      */
-    std::map<std::string, juce::AudioBuffer<float>> postprocess(std::vector<Ort::Value>& outputTensors);
+    void preprocess(WindowLane& lane, const juce::AudioBuffer<float>& inputBuffer, int start, int length) const;
+
+    /**
+     * @brief Runs the session on the lane's bound tensors; the outputs land in its outputData.
+     */
+    void runInference(WindowLane& lane) const;
+
+    /**
+     * @brief Adds one window of a lane's output into the stems, faded in where it overlaps the
+     *        previous window and out where it overlaps the next. Only one lane may add at a time.
+     */
+    void postprocess(const WindowLane& lane, int start, int length, bool fadeIn, bool fadeOut,
+                     std::vector<juce::AudioBuffer<float>>& stems) const;
+
+    /**
+     * @brief Masks the lane's spectrogram with each source's output and inverts it into its sourceWindows.
+     */
+    void reconstructSources(WindowLane& lane) const;
+
+    /**
+     * @brief Returns one channel of a source's output for the lane's current window.
+     */
+    const float* getWindowOutput(const WindowLane& lane, size_t source, int channel) const;
+
+    /**
+     * @brief Sets up the transform and the input shape for a model that takes spectrograms.
+     */
+    void configureSpectrogramInput(const std::vector<int64_t>& dims);
 
     // Member variables
     ONNXModelLoader& loader; // Reference to the model loader
-    std::unique_ptr<Ort::Session> session; // ONNX inference session
+    std::shared_ptr<Ort::Session> session; // ONNX inference session, shared through the loader's cache
     Ort::AllocatorWithDefaultOptions allocator; // Default allocator
 
     std::vector<std::string> inputNames;  // Names of the model's input nodes
     std::vector<std::string> outputNames; // Names of the model's output nodes
-    std::vector<const char*> inputNamesCharPtr; // C-style char* for Ort::Session::Run
-    std::vector<const char*> outputNamesCharPtr; // C-style char* for Ort::Session::Run
 
-    std::vector<int64_t> inputDims; // Expected dimensions for input tensor (placeholder)
-    std::vector<int64_t> outputDims; // Expected dimensions for output tensor(s) (placeholder)
+    std::vector<int64_t> inputShape; // [1, modelChannels, chunkSamples], or [1, modelChannels, bins, frames]
+    std::vector<std::vector<int64_t>> outputShapes; // Of each output, as bound
+    int modelChannels = 2;           // Channels the model expects
+    int chunkSamples = defaultChunkSamples;
+    int overlapSamples = 0;
+    bool stackedOutput = false;      // One output holding every source
+    int outputChannels = 2;
+    int outputSamples = 0;
+    std::vector<float> fadeInCurve;  // Rises over overlapSamples; the fade out is its complement
+
+    // Spectrogram models only: how each lane's transform is made
+    bool spectrogramInput = false;
+    STFTProcessor::Settings stftSettings;
+    bool outputsMagnitudes = false;  // The model returns magnitudes, which are turned into masks
+    Ort::MemoryInfo memoryInfo { Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault) };
+
+    // One lane per window in flight; lanes beyond the first are made on the first separation that uses them
+    int parallelWindows = 0;
+    std::vector<std::unique_ptr<WindowLane>> lanes;
+    std::unique_ptr<juce::ThreadPool> lanePool;
 
-    std::vector<std::string> sourceNames; // Names of the output sources (e.g., "drums", "bass") - needs initialization
+    std::vector<std::string> sourceNames; // Names of the output sources (e.g., "drums", "bass")
+    StageTimings timings;
 
     bool ready = false; // Flag indicating if the model loaded successfully
 
     // Storage for separated stems
-    std::vector<juce::AudioBuffer<float>> stemBuffers;
+    std::vector<audio::SharedAudio> stemBuffers;
     std::vector<std::string> stemNames;
     double stemSampleRate = 44100.0; // Default sample rate for stems
 };
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include <complex>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace undergroundBeats {
+namespace ml {
+
+/**
+ * @class STFTProcessor
+ * @brief Short-time Fourier transform and its overlap-add inverse, for separation models
+ *        that work on spectrograms.
+ *
+ * Frames use a periodic Hann window and are centred on multiples of the hop, with silence
+ * before the start and after the end, so a buffer of n samples has n / hop + 1 frames and
+ * every sample is covered the same way. The inverse weights each frame by the window again
+ * and divides by the summed squared windows, so transforming and inverting an unchanged
+ * spectrogram gives back the input for any hop up to half the frame.
+ *
+ * Frames are independent, so both directions are split across a small pool of threads:
+ * forward by channel and runs of frames, inverse by channel and runs of output samples
+ * (each run recomputing the frames that overlap its edges, so no two threads add into the
+ * same sample). Every thread has its own FFT and scratch space.
+ */
+class STFTProcessor {
+public:
+    struct Settings {
+        int fftOrder = 12;   // Frames of 2^fftOrder samples
+        int hopSize = 1024;  // Samples between frame centres; at most half a frame
+        int numThreads = 0;  // Threads that transform at once, counting the caller; 0 uses one per core
+    };
+
+    /** @brief Complex bins of every frame: [channel][frame][bin], bins 0 to fftSize / 2. */
+    struct Spectrogram {
+        int numChannels = 0;
+        int numFrames = 0;
+        int numBins = 0;
+        std::vector<std::complex<float>> bins;
+
+        /** @brief Resizes without clearing; reuses the allocation if it is big enough. */
+        void setSize(int channels, int frames, int binsPerFrame);
+
+        std::complex<float>* getFrame(int channel, int frame)
+        {
+            return bins.data() + (static_cast<size_t>(channel) * numFrames + frame) * numBins;
+        }
+
+        const std::complex<float>* getFrame(int channel, int frame) const
+        {
+            return bins.data() + (static_cast<size_t>(channel) * numFrames + frame) * numBins;
+        }
+    };
+
+    explicit STFTProcessor(const Settings& settings = {});
+    ~STFTProcessor();
+
+    int getFFTSize() const { return fftSize; }
+    int getHopSize() const { return hopSize; }
+    int getNumBins() const { return fftSize / 2 + 1; }
+
+    /** @brief Returns the number of frames for a number of samples. */
+    int getNumFrames(int numSamples) const { return numSamples / hopSize + 1; }
+
+    /**
+     * @brief Transforms samples [start, start + length) of every channel.
+     * @param spectrogram Resized to the buffer's channels and getNumFrames(length) frames.
+     */
+    void forward(const juce::AudioBuffer<float>& audio, int start, int length, Spectrogram& spectrogram);
+
+    /**
+     * @brief Rebuilds samples from a spectrogram, as the inverse of forward().
+     * @param destination Receives samples [0, length) of the spectrogram's channels at
+     *                    destStart, replacing what was there.
+     */
+    void inverse(const Spectrogram& spectrogram, juce::AudioBuffer<float>& destination, int destStart, int length);
+
+    /**
+     * @brief Writes the magnitude of every bin as [channel][bin][frame], the layout of a
+     *        [batch, channels, bins, frames] model input.
+     */
+    static void getMagnitudes(const Spectrogram& spectrogram, float* destination);
+
+    /**
+     * @brief Scales every bin of a spectrogram by a real mask.
+     * @param mask [channel][bin][frame], as getMagnitudes() writes; one channel is used for all.
+     * @param maskChannels Channels in the mask.
+     * @param result Resized to the source and filled with the masked bins.
+     */
+    static void applyMask(const Spectrogram& source, const float* mask, int maskChannels, Spectrogram& result);
+
+private:
+    // One per thread, so FFTs run at once without sharing scratch space
+    struct Worker {
+        explicit Worker(int order) : fft(order) {}
+
+        juce::dsp::FFT fft;
+        std::vector<float> frame;  // 2 * fftSize: the engine works in place on twice the frame
+        std::vector<float> output; // One run of overlap-added samples
+        std::vector<float> weight; // The summed squared windows over the same run
+    };
+
+    /** @brief Calls work(worker, unit) for every unit, spread over the workers. */
+    void runParallel(int numUnits, const std::function<void(Worker&, int)>& work);
+
+    const int fftSize;
+    const int hopSize;
+    std::vector<float> window;
+    std::vector<std::unique_ptr<Worker>> workers;
+    juce::ThreadPool pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(STFTProcessor)
+};
+
+} // namespace ml
+} // namespace undergroundBeats
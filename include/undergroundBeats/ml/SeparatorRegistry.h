@@ -0,0 +1,97 @@
+#pragma once
+
+#include "undergroundBeats/ml/AudioSourceSeparator.h"
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace undergroundBeats {
+namespace ml {
+
+class ONNXModelLoader;
+
+/**
+ * @class SeparatorRegistry
+ * @brief The separation backends the app can run, each described by what it produces and
+ *        what it costs, so a load can use the cheapest one that gives the stems it needs.
+ *
+ * A backend is a factory for an AudioSourceSeparator plus its capabilities. Most backends
+ * are ONNX models (see makeONNXBackend()); those are available only if their model file is
+ * installed, and their quantized variants are picked as ONNXSourceSeparator describes.
+ *
+ * The first backend added is the default: it is used when nothing else is asked for or
+ * nothing else is available, and its stems are what an empty request means.
+ */
+class SeparatorRegistry {
+public:
+    /** @brief What a backend produces and what running it costs. */
+    struct Capabilities {
+        std::string id;                      // Stable name; part of cache keys
+        std::vector<std::string> stemNames;  // In the order the separator returns them
+        double nativeSampleRate = 44100.0;   // Rate the model was trained at; the mix is converted to it to separate
+        int preferredChunkSamples = 0;       // Window for models that leave it dynamic; 0 keeps the separator's default
+        double latencySeconds = 0.0;         // Audio separated before the first stems are ready
+        float relativeCost = 1.0f;           // Compute per second of audio, relative to the default 4-stem model
+    };
+
+    /** @brief Makes a separator for a model variant; the variant may be ignored. */
+    using Factory = std::function<std::unique_ptr<AudioSourceSeparator>(ONNXModelLoader&, ModelVariant)>;
+
+    struct Backend {
+        Capabilities capabilities;
+        std::string modelPath; // The ONNX model the backend runs, relative to the working directory; empty if none
+        Factory create;
+    };
+
+    /** @brief What a load asks for. */
+    struct Request {
+        std::vector<std::string> stems; // Stems that must be separated; empty asks for the default backend's
+        double maxLatencySeconds = 0.0; // Longest wait for the first stems that is acceptable; 0 accepts any
+    };
+
+    /** @brief Returns a backend that runs an ONNXSourceSeparator on a model file. */
+    static Backend makeONNXBackend(Capabilities capabilities, const std::string& modelPath);
+
+    /** @brief Returns a registry holding the app's models, the 4-stem model first. */
+    static SeparatorRegistry createDefault();
+
+    /** @brief Adds a backend; the first one added is the default. */
+    void add(Backend backend);
+
+    const std::vector<Backend>& getBackends() const { return backends; }
+
+    /**
+     * @brief Returns the default backend; the built-in 4-stem model if none was added.
+     */
+    Backend getDefaultBackend() const;
+
+    /**
+     * @brief Picks the cheapest available backend that separates every stem asked for within
+     *        the latency asked for. Stem names match regardless of case; ties go to the
+     *        backend added first.
+     * @return The backend, or nothing if no available backend produces those stems.
+     */
+    std::optional<Backend> select(const Request& request) const;
+
+    //==============================================================================
+    /** @brief Returns true if the backend can run: it needs no model, or its model is installed. */
+    static bool isAvailable(const Backend& backend);
+
+    /** @brief Returns the variant that runs when one is asked for: Fast falls back to Quality if it isn't installed. */
+    static ModelVariant getAvailableVariant(const Backend& backend, ModelVariant variant);
+
+    /** @brief Returns the model file of the variant that runs, or an empty string for backends without one. */
+    static std::string getModelPath(const Backend& backend, ModelVariant variant);
+
+    /** @brief Identifies a backend and variant in cache keys; changes whenever the model file does. */
+    static juce::String getIdentity(const Backend& backend, ModelVariant variant);
+
+private:
+    std::vector<Backend> backends;
+};
+
+} // namespace ml
+} // namespace undergroundBeats
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "undergroundBeats/audio/SharedAudio.h"
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <memory>
 #include <string>
@@ -56,6 +57,16 @@ public:
         const juce::AudioBuffer<float>& inputBuffer,
         int numVariations);
     
+    /**
+     * @brief Generate variations of shared audio without copying it up front
+     * @param input The audio to generate variations from
+     * @param numVariations The number of variations to generate
+     * @return Handles to the variations; a variation that leaves the input untouched shares its audio
+     */
+    std::vector<audio::SharedAudio> generateVariations(
+        const audio::SharedAudio& input,
+        int numVariations);
+    
     /**
      * @brief Set the seed for random generation
      * @param seed The seed value
@@ -74,22 +85,28 @@ public:
      */
     void setStyleReference(const juce::AudioBuffer<float>& styleBuffer);
     
+    /**
+     * @brief Set the style reference for style transfer without copying it
+     * @param styleAudio The audio containing the style reference
+     */
+    void setStyleReference(audio::SharedAudio styleAudio);
+    
 private:
     // Variation methods
-    std::vector<juce::AudioBuffer<float>> generateAlgorithmicVariations(
-        const juce::AudioBuffer<float>& inputBuffer,
+    std::vector<audio::SharedAudio> generateAlgorithmicVariations(
+        const audio::SharedAudio& input,
         int numVariations);
     
-    std::vector<juce::AudioBuffer<float>> generateGANVariations(
-        const juce::AudioBuffer<float>& inputBuffer,
+    std::vector<audio::SharedAudio> generateGANVariations(
+        const audio::SharedAudio& input,
         int numVariations);
     
-    std::vector<juce::AudioBuffer<float>> generateVAEVariations(
-        const juce::AudioBuffer<float>& inputBuffer,
+    std::vector<audio::SharedAudio> generateVAEVariations(
+        const audio::SharedAudio& input,
         int numVariations);
     
-    std::vector<juce::AudioBuffer<float>> generateStyleTransferVariations(
-        const juce::AudioBuffer<float>& inputBuffer,
+    std::vector<audio::SharedAudio> generateStyleTransferVariations(
+        const audio::SharedAudio& input,
         int numVariations);
     
     // Internal state
@@ -99,7 +116,7 @@ private:
     VariationMethod method;
     float variationAmount;
     int seed;
-    juce::AudioBuffer<float> styleReferenceBuffer;
+    audio::SharedAudio styleReference;
     bool isInitialized;
 };
 
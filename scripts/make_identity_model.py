@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Writes the identity separation model used by the ONNXSourceSeparator tests.
+
+The model takes a [1, 2, 4096] mix and returns it unchanged as two sources, so a
+separation through it must reproduce the mix. The protobuf is encoded by hand, so
+the script needs nothing beyond the standard library.
+
+Usage: scripts/make_identity_model.py [output.onnx]
+"""
+
+import os
+import sys
+
+CHANNELS = 2
+WINDOW = 4096
+SOURCES = ("first", "second")
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def field_varint(number, value):
+    return varint(number << 3) + varint(value)
+
+
+def field_bytes(number, payload):
+    if isinstance(payload, str):
+        payload = payload.encode()
+    return varint((number << 3) | 2) + varint(len(payload)) + payload
+
+
+def tensor_info(name):
+    dims = b"".join(field_bytes(1, field_varint(1, size)) for size in (1, CHANNELS, WINDOW))
+    tensor_type = field_varint(1, 1) + field_bytes(2, dims)  # elem_type FLOAT, shape
+    return field_bytes(1, name) + field_bytes(2, field_bytes(1, tensor_type))
+
+
+def identity_node(source):
+    return field_bytes(1, "mix") + field_bytes(2, source) + field_bytes(3, "copy_" + source) + field_bytes(4, "Identity")
+
+
+def model():
+    graph = b"".join(field_bytes(1, identity_node(source)) for source in SOURCES)
+    graph += field_bytes(2, "identity_separation")
+    graph += field_bytes(11, tensor_info("mix"))
+    graph += b"".join(field_bytes(12, tensor_info(source)) for source in SOURCES)
+
+    return (field_varint(1, 7)                                    # ir_version
+            + field_bytes(2, "undergroundBeats tests")             # producer_name
+            + field_bytes(7, graph)
+            + field_bytes(8, field_bytes(1, "") + field_varint(2, 13))  # opset_import
+            + field_bytes(14, field_bytes(1, "sources") + field_bytes(2, ",".join(SOURCES))))
+
+
+if __name__ == "__main__":
+    default = os.path.join(os.path.dirname(__file__), "..", "test", "ml", "fixtures", "identity_separation.onnx")
+    path = sys.argv[1] if len(sys.argv) > 1 else default
+    with open(path, "wb") as f:
+        f.write(model())
@@ -1,10 +1,13 @@
 #include "../include/undergroundBeats/UndergroundBeatsProcessor.h"
 #include "../include/undergroundBeats/gui/MainEditor.h"
 #include "../include/undergroundBeats/ml/ONNXSourceSeparator.h"
+#include "../include/undergroundBeats/audio/PolyphaseResampler.h"
 #include <juce_audio_basics/juce_audio_basics.h> // For NormalisableRange
 
 // Include iostream for temporary debugging output (optional)
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 //==============================================================================
 // Add namespace to match the header
@@ -20,18 +23,55 @@ UndergroundBeatsProcessor::UndergroundBeatsProcessor()
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                       #endif
                         ),
-    valueTreeState(*this, &undoManager, juce::Identifier("UndergroundBeatsParams"), createParameterLayout()) // Initialize valueTreeState (NEW)
+    valueTreeState(*this, nullptr, juce::Identifier("UndergroundBeatsParams"), createParameterLayout()) // Undo is recorded per parameter move, see parameterValueChanged()
 #endif
 {
     // Constructor initialization
     // Register basic audio formats (WAV, AIFF, etc.)
     formatManager.registerBasicFormats();
+
+    cacheStemParameterRefs();
+
+    setUndoHistoryLimit(defaultUndoLimitMegabytes);
+
+    // One automation lane per parameter; listen to every parameter to record moves
+    automationEngine.initialise(getParameters().size());
+    parameterUndoValues.reset(new std::atomic<float>[(size_t) getParameters().size()]);
+    for (auto* param : getParameters())
+    {
+        parameterUndoValues[(size_t) param->getParameterIndex()] = param->getValue();
+        param->addListener(this);
+    }
+
+    initialisePresetMorph();
+
+    loadPipeline.onPublish = [this](audio::StemLoadPipeline::Result&& result) { publishLoadResult(std::move(result)); };
+    loadPipeline.setSeparationCache(&separationCache);
+    setStreamingPlayback(false);
+
+    // Loading and optimizing the model takes seconds, so it starts now rather than on the first load.
+    // The optimized graph is kept, so later startups only load it.
+    auto sessionSettings = modelLoader.getSessionSettings();
+    sessionSettings.optimizedModelDirectory = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                                                  .getChildFile("UndergroundBeats").getChildFile("OptimizedModels");
+    modelLoader.setSessionSettings(sessionSettings);
+    const auto separation = loadPipeline.getSeparationOptions();
+    modelLoader.preloadModels({ ml::SeparatorRegistry::getModelPath(separation.backend, separation.variant) });
     
     std::cout << "UndergroundBeatsProcessor created." << std::endl;
 }
 
 UndergroundBeatsProcessor::~UndergroundBeatsProcessor()
 {
+    for (auto* param : getParameters())
+        param->removeListener(this);
+
+    // Streamed stems unregister from the read-ahead thread, so they must go before it does
+    loadPipeline.cancel();
+    undoManager.clearUndoHistory();
+    stemSetsByRate.clear();
+    stemSources.clear();
+
     // Destructor
     std::cout << "UndergroundBeatsProcessor destroyed." << std::endl;
 }
@@ -45,11 +85,8 @@ const juce::String UndergroundBeatsProcessor::getName() const
 
 bool UndergroundBeatsProcessor::acceptsMidi() const
 {
-   #if JucePlugin_WantsMidiInput
+    // MIDI CCs drive learned parameters and notes trigger stem slices
     return true;
-   #else
-    return false;
-   #endif
 }
 
 bool UndergroundBeatsProcessor::producesMidi() const
@@ -105,6 +142,8 @@ void UndergroundBeatsProcessor::changeProgramName (int index, const juce::String
 //==============================================================================
 // Parameter Management Implementation (NEW)
 //==============================================================================
+const juce::String UndergroundBeatsProcessor::presetMorphParameterID { "presetMorph" };
+
 juce::String UndergroundBeatsProcessor::getStemParameterID(int stemIndex, const juce::String& paramType)
 {
     // Creates IDs like "Stem_0_Volume", "Stem_1_Gain", etc.
@@ -114,7 +153,6 @@ juce::String UndergroundBeatsProcessor::getStemParameterID(int stemIndex, const
 juce::AudioProcessorValueTreeState::ParameterLayout UndergroundBeatsProcessor::createParameterLayout()
 {
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
-    const int maxStems = 8; // Define a maximum number of stems for parameter creation
 
     for (int i = 0; i < maxStems; ++i)
     {
@@ -293,6 +331,11 @@ juce::AudioProcessorValueTreeState::ParameterLayout UndergroundBeatsProcessor::c
             true));
     }
 
+    // ===== Preset Morph =====
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        presetMorphParameterID, "Preset Morph",
+        juce::NormalisableRange<float>(0.0f, 1.0f), 0.0f));
+
     return { params.begin(), params.end() };
 }
 
@@ -306,6 +349,278 @@ std::atomic<bool>& UndergroundBeatsProcessor::getParametersChangedFlag()
     return parametersChanged;
 }
 
+void UndergroundBeatsProcessor::cacheStemParameterRefs()
+{
+    stemParameterRefs.resize(maxStems);
+    stemParameterIndices.resize(maxStems);
+
+    for (int i = 0; i < maxStems; ++i)
+    {
+        for (int p = 0; p < audio::StemRenderer::numParameters; ++p)
+        {
+            const auto parameterID = getStemParameterID(i, audio::StemRenderer::getParameterType(p));
+            auto* param = valueTreeState.getParameter(parameterID);
+
+            stemParameterRefs[i][p] = valueTreeState.getRawParameterValue(parameterID);
+            stemParameterIndices[i][p] = param != nullptr ? param->getParameterIndex() : -1;
+        }
+    }
+}
+
+audio::StemRenderer::ParameterValues UndergroundBeatsProcessor::readStemParameters(int stemIdx) const
+{
+    auto values = audio::StemRenderer::getDefaultValues();
+    const auto& refs = stemParameterRefs[stemIdx];
+
+    for (size_t p = 0; p < refs.size(); ++p)
+        if (refs[p] != nullptr)
+            values[p] = refs[p]->load();
+
+    return values;
+}
+
+//==============================================================================
+// Automation Implementation
+//==============================================================================
+void UndergroundBeatsProcessor::setAutomationRecording(bool shouldRecord)
+{
+    automationEngine.setRecording(shouldRecord);
+}
+
+bool UndergroundBeatsProcessor::isAutomationRecording() const
+{
+    return automationEngine.isRecording();
+}
+
+audio::AutomationEngine& UndergroundBeatsProcessor::getAutomationEngine()
+{
+    return automationEngine;
+}
+
+//==============================================================================
+// MIDI Control Implementation
+//==============================================================================
+int UndergroundBeatsProcessor::getParameterIndex(const juce::String& parameterID)
+{
+    if (auto* param = valueTreeState.getParameter(parameterID))
+        return param->getParameterIndex();
+
+    return audio::MidiControlMap::unmapped;
+}
+
+void UndergroundBeatsProcessor::beginMidiLearn(const juce::String& parameterID)
+{
+    const auto parameterIndex = getParameterIndex(parameterID);
+    if (parameterIndex != audio::MidiControlMap::unmapped)
+        midiControlMap.beginLearn(parameterIndex);
+}
+
+void UndergroundBeatsProcessor::clearMidiMappings(const juce::String& parameterID)
+{
+    const auto parameterIndex = getParameterIndex(parameterID);
+    if (parameterIndex != audio::MidiControlMap::unmapped)
+        midiControlMap.clearMappingsForParameter(parameterIndex);
+}
+
+void UndergroundBeatsProcessor::sliceStemToPads(int stemIndex, int numSlices)
+{
+    juce::int64 stemLength = 0;
+    {
+        const juce::SpinLock::ScopedLockType lock(stemLock);
+        if (juce::isPositiveAndBelow(stemIndex, (int) stemSources.size()) && stemSources[stemIndex] != nullptr)
+            stemLength = stemSources[stemIndex]->getLengthInSamples();
+    }
+
+    stemSlicePlayer.sliceEvenly(stemIndex, stemLength, numSlices);
+}
+
+audio::MidiControlMap& UndergroundBeatsProcessor::getMidiControlMap()
+{
+    return midiControlMap;
+}
+
+audio::StemSlicePlayer& UndergroundBeatsProcessor::getStemSlicePlayer()
+{
+    return stemSlicePlayer;
+}
+
+//==============================================================================
+// Preset Morphing Implementation
+//==============================================================================
+void UndergroundBeatsProcessor::initialisePresetMorph()
+{
+    std::vector<bool> discreteFlags;
+    discreteFlags.reserve(getParameters().size());
+
+    // Toggles and choices jump between snapshots instead of being interpolated
+    for (auto* param : getParameters())
+        discreteFlags.push_back(param->isDiscrete() || param->isBoolean());
+
+    presetMorphEngine.initialise(discreteFlags, getParameterIndex(presetMorphParameterID));
+    presetMorphAmount = valueTreeState.getRawParameterValue(presetMorphParameterID);
+}
+
+std::vector<float> UndergroundBeatsProcessor::captureParameterValues() const
+{
+    std::vector<float> values;
+    values.reserve(getParameters().size());
+
+    for (auto* param : getParameters())
+        values.push_back(param->getValue());
+
+    return values;
+}
+
+void UndergroundBeatsProcessor::storeMorphSnapshot(int slot)
+{
+    const auto values = captureParameterValues();
+
+    // Park the morph control at the stored end so the sound doesn't jump to the other snapshot
+    if (auto* morphParam = valueTreeState.getParameter(presetMorphParameterID))
+    {
+        if (slot == presetMorphEngine.getSlotA())
+            morphParam->setValueNotifyingHost(0.0f);
+        else if (slot == presetMorphEngine.getSlotB())
+            morphParam->setValueNotifyingHost(1.0f);
+    }
+
+    presetMorphEngine.storeSnapshot(slot, values);
+}
+
+bool UndergroundBeatsProcessor::loadMorphSnapshot(int slot, const juce::File& presetFile)
+{
+    auto xml = juce::XmlDocument::parse(presetFile);
+    if (xml == nullptr || !xml->hasTagName(valueTreeState.state.getType()))
+        return false;
+
+    // Start from the current values so a partial preset only moves what it contains
+    auto values = captureParameterValues();
+
+    for (auto* paramXml : xml->getChildWithTagNameIterator("PARAM"))
+    {
+        auto* param = valueTreeState.getParameter(paramXml->getStringAttribute("id"));
+        if (param == nullptr)
+            continue;
+
+        const auto value = (float) paramXml->getDoubleAttribute("value");
+        values[(size_t) param->getParameterIndex()] = param->convertTo0to1(value);
+    }
+
+    presetMorphEngine.storeSnapshot(slot, values);
+    return true;
+}
+
+void UndergroundBeatsProcessor::setMorphPair(int slotA, int slotB)
+{
+    presetMorphEngine.setMorphPair(slotA, slotB);
+}
+
+audio::PresetMorphEngine& UndergroundBeatsProcessor::getPresetMorphEngine()
+{
+    return presetMorphEngine;
+}
+
+void UndergroundBeatsProcessor::applyPresetMorph()
+{
+    if (presetMorphAmount == nullptr)
+        return;
+
+    const int numChanges = presetMorphEngine.process(presetMorphAmount->load());
+    const auto* changes = presetMorphEngine.getChanges();
+
+    for (int i = 0; i < numChanges; ++i)
+        applyParameterValue(changes[i].parameterIndex, changes[i].value);
+}
+
+void UndergroundBeatsProcessor::handleMidiEvent(const juce::MidiMessage& message)
+{
+    if (message.isController())
+    {
+        const auto parameterIndex = midiControlMap.handleController(message.getControllerNumber());
+        if (parameterIndex != audio::MidiControlMap::unmapped)
+            applyParameterValue(parameterIndex, audio::MidiControlMap::toNormalisedValue(message.getControllerValue()));
+    }
+    else if (message.isNoteOn())
+    {
+        stemSlicePlayer.noteOn(message.getNoteNumber(), message.getFloatVelocity());
+    }
+    else if (message.isNoteOff())
+    {
+        stemSlicePlayer.noteOff(message.getNoteNumber());
+    }
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+    {
+        stemSlicePlayer.allNotesOff();
+    }
+}
+
+void UndergroundBeatsProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    const float previousValue = parameterUndoValues[(size_t) parameterIndex].exchange(newValue);
+
+    // Only moves made from the UI start undo transactions or get recorded; values written by
+    // automation playback, MIDI CCs and morphing arrive on the audio thread and only update
+    // the value an undo would go back to
+    if (!juce::MessageManager::existsAndIsCurrentThread() || applyingParameterUndo)
+        return;
+
+    // A pause longer than the coalesce window ends the previous gesture, so a slider
+    // drag becomes one undo step rather than one per tick
+    const auto now = juce::Time::getMillisecondCounter();
+    if (now - lastParameterChangeTime > undoCoalesceWindowMs)
+        undoManager.beginNewTransaction();
+    lastParameterChangeTime = now;
+
+    if (previousValue != newValue)
+        undoManager.perform(new ParameterChangeAction(*this, parameterIndex, previousValue, newValue));
+
+    if (automationEngine.isRecording())
+        automationEngine.recordParameterChange(parameterIndex, newValue, publishedPlaybackPosition.load());
+}
+
+void UndergroundBeatsProcessor::parameterGestureChanged(int parameterIndex, bool gestureIsStarting)
+{
+    juce::ignoreUnused(parameterIndex);
+
+    // Hosts and attachments that report gestures get exact transaction boundaries
+    if (gestureIsStarting && juce::MessageManager::existsAndIsCurrentThread())
+    {
+        undoManager.beginNewTransaction();
+        lastParameterChangeTime = juce::Time::getMillisecondCounter();
+    }
+}
+
+//==============================================================================
+// Undo History Implementation
+//==============================================================================
+juce::UndoManager& UndergroundBeatsProcessor::getUndoManager()
+{
+    return undoManager;
+}
+
+void UndergroundBeatsProcessor::setUndoHistoryLimit(int maxMegabytes, int minTransactions)
+    // Undo units are bytes for every action: stem swaps report the stem they replaced,
+    // Undo units are bytes for every action: stem swaps report the audio only they keep alive,
+    // parameter changes their own size. The count is an int, so the budget stops short of 2 GB.
+    const int megabytes = juce::jlimit(1, std::numeric_limits<int>::max() / (1024 * 1024), maxMegabytes);
+    undoManager.setMaxNumberOfStoredUnits(megabytes * 1024 * 1024, minTransactions);
+}
+
+void UndergroundBeatsProcessor::beginUndoTransaction(const juce::String& name)
+{
+    undoManager.beginNewTransaction(name);
+    lastParameterChangeTime = juce::Time::getMillisecondCounter();
+}
+
+void UndergroundBeatsProcessor::applyParameterValue(int parameterIndex, float normalisedValue)
+{
+    auto* param = getParameters()[parameterIndex];
+    if (param == nullptr || param->getValue() == normalisedValue)
+        return;
+
+    param->setValueNotifyingHost(normalisedValue);
+}
+
 //==============================================================================
 // File Loading Method Implementation
 //==============================================================================
@@ -317,127 +632,286 @@ bool UndergroundBeatsProcessor::loadAudioFile(const juce::File& audioFile)
         std::cout << "Error: File does not exist: " << audioFile.getFullPathName() << std::endl;
         return false;
     }
-    
-    // Try to create a reader for the file
-    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
-    
-    if (reader == nullptr)
+
+    // A synchronous load supersedes any background load still running
+    loadPipeline.cancel();
+
+    DBG("Processor: loadAudioFile - Running load stages for: " + audioFile.getFullPathName());
+    auto result = audio::StemLoadPipeline::runStages(audioFile, getSampleRate(), formatManager, modelLoader,
+                                                     loadPipeline.getStreamingOptions(),
+                                                     loadPipeline.getSeparationCache(),
+                                                     loadPipeline.getSeparationOptions(),
+                                                     [] { return false; },
+                                                     [](audio::StemLoadPipeline::Stage, float) {});
+
+    if (result.error.isNotEmpty())
     {
-        std::cout << "Error: Could not create reader for file: " << audioFile.getFullPathName() << std::endl;
+        std::cout << "Error: " << result.error << std::endl;
         return false;
     }
-    
-    // File loaded successfully, store it
-    currentAudioFile = audioFile;
-    
-    // Create an audio buffer with the correct size
-    int numChannels = reader->numChannels;
-    int numSamples = static_cast<int>(reader->lengthInSamples);
-    
-    // Make sure we don't exceed reasonable limits
-    numChannels = juce::jmin(numChannels, 2); // Limit to stereo
-    
-    // Allocate the audio buffer
-    audioBuffer.setSize(numChannels, numSamples);
-    
-    // Read the entire file into the buffer
-    reader->read(&audioBuffer, 0, numSamples, 0, true, true);
-    
-    // Store the reader for later use if needed
-    currentAudioReader = std::move(reader);
-    
-    // Reset playback state
-    playing = false;
-    paused = false;
-    
-    std::cout << "Audio file loaded: " << audioFile.getFullPathName() << std::endl;
-    std::cout << "Channels: " << numChannels << ", Samples: " << numSamples << std::endl;
-    std::cout << "Sample Rate: " << currentAudioReader->sampleRate << " Hz" << std::endl;
-    DBG("Processor: loadAudioFile - Starting separation process for: " + audioFile.getFullPathName());
-    
-    // --- Run ONNX Source Separation ---
-    bool separationSuccessful = false;
-    try
+
+    publishLoadResult(std::move(result));
+    return true;
+}
+
+bool UndergroundBeatsProcessor::loadAudioFileAsync(const juce::File& audioFile)
+{
+    if (!audioFile.existsAsFile())
     {
-        DBG("Processor: Creating ONNXSourceSeparator...");
-        // Use correct namespace and constructor
-        ml::ONNXSourceSeparator separator("models/source_separation.onnx", modelLoader);
-        
-        DBG("Processor: Calling separator.loadAndSeparate...");
-        // Load and separate
-        separationSuccessful = separator.loadAndSeparate(audioFile);
-        // Convert bool to string for DBG
-        DBG("Processor: separator.loadAndSeparate returned: " + juce::String(separationSuccessful ? "true" : "false"));
+        std::cout << "Error: File does not exist: " << audioFile.getFullPathName() << std::endl;
+        return false;
+    }
 
-        if (separationSuccessful)
-        {
-            separatedStemBuffers.clear();
-            int numStems = separator.getNumberOfStems();
-            DBG("Processor: Separation successful. Number of stems: " + juce::String(numStems));
-            separatedStemBuffers.reserve(numStems); // Reserve space
-            for (int i = 0; i < numStems; ++i)
-            {
-                auto stemBuffer = separator.getStemBuffer(i);
-                DBG("  Stem " + juce::String(i) + " buffer size: " 
-                    + juce::String(stemBuffer.getNumChannels()) + " channels, " 
-                    + juce::String(stemBuffer.getNumSamples()) + " samples.");
-                separatedStemBuffers.push_back(std::move(stemBuffer)); // Use move if possible
-            }
-            DBG("Processor: Finished retrieving stem buffers.");
-        }
-        else
-        {
-            DBG("Processor: ONNX separation reported failure (loadAndSeparate returned false).");
-        }
+    DBG("Processor: loadAudioFileAsync - Queuing load for: " + audioFile.getFullPathName());
+    loadPipeline.load(audioFile, getSampleRate());
+    return true;
+}
+
+audio::StemLoadPipeline& UndergroundBeatsProcessor::getLoadPipeline()
+{
+    return loadPipeline;
+}
+
+void UndergroundBeatsProcessor::setStreamingPlayback(bool shouldStream, int ramBudgetMegabytes)
+{
+    auto options = loadPipeline.getStreamingOptions();
+    options.enabled = shouldStream;
+    options.ramBudgetBytes = (size_t) juce::jmax(1, ramBudgetMegabytes) * 1024 * 1024;
+    options.cacheDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                 .getChildFile("UndergroundBeats").getChildFile("StemCache");
+    options.readAheadThread = &readAheadThread;
+
+    if (shouldStream && !readAheadThread.isThreadRunning())
+        readAheadThread.startThread();
+
+    loadPipeline.setStreamingOptions(options);
+}
+
+bool UndergroundBeatsProcessor::isStreamingPlayback() const
+{
+    return loadPipeline.getStreamingOptions().enabled;
+}
+
+void UndergroundBeatsProcessor::setHalfPrecisionStems(bool shouldUseHalfPrecision)
+{
+    auto options = loadPipeline.getStreamingOptions();
+    options.halfPrecision = shouldUseHalfPrecision;
+    loadPipeline.setStreamingOptions(options);
+}
+
+bool UndergroundBeatsProcessor::isHalfPrecisionStems() const
+{
+    return loadPipeline.getStreamingOptions().halfPrecision;
+}
+
+void UndergroundBeatsProcessor::setSeparationVariant(ml::ModelVariant variant)
+{
+    auto separation = loadPipeline.getSeparationOptions();
+    separation.variant = variant;
+    loadPipeline.setSeparationOptions(separation);
+
+    const auto path = ml::SeparatorRegistry::getModelPath(separation.backend, variant);
+    if (!path.empty())
+        modelLoader.preloadModels({ path });
+}
+
+ml::ModelVariant UndergroundBeatsProcessor::getSeparationVariant() const
+{
+    return loadPipeline.getSeparationOptions().variant;
+}
+
+bool UndergroundBeatsProcessor::setRequestedStems(const std::vector<std::string>& stems)
+{
+    const auto backend = separatorRegistry.select({ stems });
+    if (!backend.has_value())
+    {
+        DBG("Processor: setRequestedStems - No installed separator gives the requested stems");
+        return false;
     }
-    catch (const std::exception& e)
+
+    auto separation = loadPipeline.getSeparationOptions();
+    separation.backend = *backend;
+    loadPipeline.setSeparationOptions(separation);
+
+    DBG("Processor: setRequestedStems - Separating with " + juce::String(backend->capabilities.id));
+
+    const auto path = ml::SeparatorRegistry::getModelPath(separation.backend, separation.variant);
+    if (!path.empty())
+        modelLoader.preloadModels({ path });
+
+    return true;
+}
+
+void UndergroundBeatsProcessor::importFilesInBackground(const juce::Array<juce::File>& audioFiles)
+{
+    juce::Array<juce::File> existing;
+    for (const auto& file : audioFiles)
+        if (file.existsAsFile())
+            existing.add(file);
+
+    DBG("Processor: importFilesInBackground - Queuing " + juce::String(existing.size()) + " files");
+
+    // Cached at the current rate and with the current separator, so loading one of them later is a cache hit
+    batchImport.addFiles(existing, getSampleRate(), loadPipeline.getSeparationOptions());
+}
+
+audio::BatchImportQueue& UndergroundBeatsProcessor::getBatchImportQueue()
+{
+    return batchImport;
+}
+
+bool UndergroundBeatsProcessor::startOfflineRender(const audio::OfflineRenderer::Options& options)
+{
+    if (offlineRenderer.isRendering())
+        return false;
+
+    audio::OfflineRenderer::Session session;
     {
-        DBG("Processor: ONNX separation failed with exception: " + juce::String(e.what()));
-        separationSuccessful = false;
+        const juce::SpinLock::ScopedLockType lock(stemLock);
+        session.stems = stemSources;
+        session.sampleRate = stemSampleRate > 0.0 ? stemSampleRate : getSampleRate();
     }
 
-    // Fallback: create placeholder stems if separation failed
-    if (!separationSuccessful)
+    if (session.stems.empty() || session.sampleRate <= 0.0)
+        return false;
+
+    if (session.stems.size() > (size_t) maxStems)
+        session.stems.resize(maxStems);
+
+    session.numOutputChannels = juce::jmax(1, getTotalNumOutputChannels());
+    session.stemParameters.assign(stemParameterIndices.begin(), stemParameterIndices.begin() + (int) session.stems.size());
+
+    // Raw values, as the audio thread reads them; automation replays from here
+    const auto parameters = getParameters();
+    for (auto* param : parameters)
     {
-        DBG("Processor: Falling back to placeholder stems.");
-        separatedStemBuffers.clear();
-        int numPlaceholderStems = 4;
-        separatedStemBuffers.reserve(numPlaceholderStems);
-        for (int i = 0; i < numPlaceholderStems; ++i)
-        {
-            if (audioBuffer.getNumSamples() > 0 && audioBuffer.getNumChannels() > 0)
-            {
-                DBG("  Creating placeholder stem " + juce::String(i) + " from original buffer.");
-                separatedStemBuffers.emplace_back(audioBuffer);
-            }
-            else
-            {
-                 DBG("  Creating empty placeholder stem " + juce::String(i) + " as original buffer is invalid.");
-                separatedStemBuffers.emplace_back(); // Add empty buffer if original is invalid
-            }
-        }
-        DBG("Processor: Created " + juce::String(separatedStemBuffers.size()) + " placeholder stems.");
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param);
+        auto* raw = ranged != nullptr ? valueTreeState.getRawParameterValue(ranged->paramID) : nullptr;
+        session.parameterValues.push_back(raw != nullptr ? raw->load() : param->getValue());
     }
-    
-    DBG("Processor: Final separatedStemBuffers size: " + juce::String(separatedStemBuffers.size()));
 
-    // Simply resize the vector. prepareToPlay will handle preparing the chains later.
-    stemEffectChains.resize(separatedStemBuffers.size());
-    
+    if (automationEngine.isPlaybackEnabled())
+        for (int i = 0; i < automationEngine.getNumLanes(); ++i)
+            session.automation.push_back(automationEngine.getLaneBreakpoints(i));
+
+    session.denormalise = [parameters](int parameterIndex, float normalisedValue)
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameters[parameterIndex]))
+            return ranged->convertFrom0to1(normalisedValue);
+
+        return normalisedValue;
+    };
+
+    DBG("Processor: startOfflineRender - Rendering " + juce::String((int) session.stems.size()) + " stems to "
+        + options.outputDirectory.getFullPathName());
+    return offlineRenderer.start(std::move(session), options);
+}
+
+audio::OfflineRenderer& UndergroundBeatsProcessor::getOfflineRenderer()
+{
+    return offlineRenderer;
+}
+
+void UndergroundBeatsProcessor::publishLoadResult(audio::StemLoadPipeline::Result&& result)
+{
+    std::cout << "Audio file loaded: " << result.file.getFullPathName() << std::endl;
+    if (result.mix.isValid())
+        std::cout << "Channels: " << result.mix->getNumChannels() << ", Samples: " << result.mix->getNumSamples() << std::endl;
+    std::cout << "Sample Rate: " << result.sampleRate << " Hz" << std::endl;
+    DBG("Processor: Publishing " + juce::String(result.sources.size()) + " stems"
+        + (result.isPreview ? juce::String(" (preview)")
+                            : result.separated ? juce::String() : juce::String(" (placeholders)")));
+
+    // The finished stems of a file that is already playing as a preview take over where it is
+    const bool continuesPreview = result.followsPreview && result.file == currentAudioFile;
+
+    // Reset playback state
+    if (!continuesPreview)
+    {
+        playing = false;
+        paused = false;
+    }
+
+    currentAudioFile = result.file;
+    mixBuffer = std::move(result.mix); // Empty when the stems are streamed or compact
+    stemNames = std::move(result.stemNames);
+
+    // The whole stem set changes in one step for the audio thread; the previous
+    // stems are released here on the message thread once the lock is dropped
+    {
+        const juce::SpinLock::ScopedLockType lock(stemLock);
+        stemSources.swap(result.sources);
+        stemSampleRate = result.sampleRate;
+
+        // Simply resize the vector. prepareToPlay will handle preparing the chains later.
+        stemRenderers.resize(stemSources.size());
+
+        // Reset playback position for the new stems
+        if (!continuesPreview)
+            playbackPosition = 0;
+    }
+
+    // Undo entries and converted sets refer to stems of the previous file
+    undoManager.clearUndoHistory();
+    stemSetsByRate.clear();
+
+    // The device rate may have changed while the load ran
+    conformStemsToSampleRate(getSampleRate());
+
     parametersChanged = true; // Signal UI that parameters might need refreshing (NEW)
-    // Reset playback position for the new stems
-    playbackPosition = 0; 
-    
-    return true;
+}
+
+void UndergroundBeatsProcessor::conformStemsToSampleRate(double sampleRate)
+{
+    const int currentRate = juce::roundToInt(stemSampleRate);
+    const int newRate = juce::roundToInt(sampleRate);
+
+    if (stemSources.empty() || currentRate <= 0 || newRate <= 0 || newRate == currentRate)
+        return;
+
+    std::vector<audio::StemSourcePtr> converted;
+
+    auto cached = std::find_if(stemSetsByRate.begin(), stemSetsByRate.end(),
+                               [newRate](const auto& entry) { return entry.first == newRate; });
+
+    if (cached != stemSetsByRate.end())
+    {
+        converted = std::move(cached->second);
+        stemSetsByRate.erase(cached);
+    }
+    else
+    {
+        DBG("Processor: Resampling stems from " + juce::String(currentRate) + " Hz to " + juce::String(newRate) + " Hz");
+        converted = audio::StemLoadPipeline::resampleSources(stemSources, stemSampleRate, sampleRate,
+                                                             loadPipeline.getStreamingOptions());
+    }
+
+    if (converted.empty())
+    {
+        DBG("Processor: Could not resample stems; they will play at the wrong rate");
+        return;
+    }
+
+    // The set being replaced is kept for switching back
+    stemSetsByRate.emplace_back(currentRate, stemSources);
+    if (stemSetsByRate.size() > maxCachedStemRates)
+        stemSetsByRate.erase(stemSetsByRate.begin());
+
+    {
+        const juce::SpinLock::ScopedLockType lock(stemLock);
+        stemSources.swap(converted);
+        stemSampleRate = sampleRate;
+        playbackPosition = 0;
+    }
 }
 
 
 //==============================================================================
 // Stem Access Implementation (NEW)
 //==============================================================================
-const std::vector<juce::AudioBuffer<float>>& UndergroundBeatsProcessor::getSeparatedStemBuffers() const
+const std::vector<audio::StemSourcePtr>& UndergroundBeatsProcessor::getStemSources() const
 {
-    return separatedStemBuffers;
+    return stemSources;
 }
 
 
@@ -447,86 +921,28 @@ void UndergroundBeatsProcessor::prepareToPlay (double sampleRate, int samplesPer
     DBG("Processor::prepareToPlay - Sample Rate: " + juce::String(sampleRate) + 
         ", Block Size: " + juce::String(samplesPerBlock));
 
-    const int numStems = separatedStemBuffers.size();
-    const int numOutputChannels = getTotalNumOutputChannels();
+    // Stems are converted here, before playback starts, rather than on the audio thread
+    conformStemsToSampleRate(sampleRate);
 
-    // Prepare DSP chains for each stem
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 2; // Always prepare for stereo processing regardless of input channels
+    const int numStems = stemSources.size();
+    const int numOutputChannels = getTotalNumOutputChannels();
 
-    // Resize the vector of unique_ptrs first
-    stemEffectChains.resize(numStems);
-    for (int i = 0; i < numStems; ++i)
+    // Each stem renders through its own chain, prepared for stereo
+    stemRenderers.resize(numStems);
+    for (auto& renderer : stemRenderers)
     {
-        // If the pointer at this index is null, create a new chain
-        if (stemEffectChains[i] == nullptr)
-        {
-            stemEffectChains[i] = std::make_unique<StemEffectChain>();
-            DBG("  Created new effect chain for stem " + juce::String(i));
-        }
-        
-        try {
-            // Initialize delay line - must be done before prepare
-            auto& delay = stemEffectChains[i]->get<5>();
-            delay.reset();
-            delay.setMaximumDelayInSamples(sampleRate * 2.0); // 2 seconds max delay
-            
-            // Prepare the chain (dereference the pointer)
-            stemEffectChains[i]->prepare(spec);
-            
-            // Initialize default EQ parameters - flat response curve
-            for (int band = 0; band < 3; ++band) {
-                auto coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(
-                    sampleRate, 
-                    band == 0 ? 100.0f : (band == 1 ? 1000.0f : 5000.0f), // Default frequencies
-                    1.0f, // Default Q
-                    1.0f  // Default gain (0dB)
-                );
-                
-                switch (band) {
-                    case 0: stemEffectChains[i]->get<0>().coefficients = coefficients; break;
-                    case 1: stemEffectChains[i]->get<1>().coefficients = coefficients; break;
-                    case 2: stemEffectChains[i]->get<2>().coefficients = coefficients; break;
-                }
-            }
-            
-            // Initialize compressor
-            auto& comp = stemEffectChains[i]->get<3>();
-            comp.setThreshold(-24.0f);
-            comp.setRatio(4.0f);
-            comp.setAttack(10.0f);
-            comp.setRelease(100.0f);
-            
-            // Initialize chorus
-            auto& chorus = stemEffectChains[i]->get<6>();
-            chorus.setRate(1.0f);
-            chorus.setDepth(0.25f);
-            chorus.setCentreDelay(7.0f);
-            chorus.setFeedback(0.0f);
-            chorus.setMix(0.5f);
-            
-            // Initialize saturation
-            auto& saturator = stemEffectChains[i]->get<7>();
-            saturator.functionToUse = [](float x) { return std::tanh(x); }; // Default saturation
-            
-            // Initialize final gain
-            auto& finalGain = stemEffectChains[i]->get<8>();
-            finalGain.setGainLinear(1.0f);
-            
-            // Reset the effects in the chain
-            stemEffectChains[i]->reset();
-            
-            DBG("  Successfully prepared effect chain for stem " + juce::String(i));
-        }
-        catch (const std::exception& e) {
-            DBG("  ERROR preparing effect chain for stem " + juce::String(i) + ": " + juce::String(e.what()));
-        }
+        if (renderer == nullptr)
+            renderer = std::make_unique<audio::StemRenderer>();
+
+        renderer->prepare(sampleRate, samplesPerBlock);
     }
-    
+
+    // Scratch buffer used to render each stem's sub-block without allocating
+    stemScratchBuffer.setSize(2, samplesPerBlock, false, true, false);
+
     // Reset playback state
     playbackPosition = 0;
+    publishedPlaybackPosition = 0;
     
     DBG("Processor::prepareToPlay - Successfully prepared for " + juce::String(numStems) + " stems");
 }
@@ -558,7 +974,6 @@ bool UndergroundBeatsProcessor::isBusesLayoutSupported (const BusesLayout& layou
 
 void UndergroundBeatsProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    juce::ignoreUnused(midiMessages);
     juce::ScopedNoDenormals noDenormals;
 
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -571,12 +986,20 @@ void UndergroundBeatsProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     // Always clear the output buffer at the start
     buffer.clear();
 
+    // If the stem list is being replaced right now, output silence for this block
+    const juce::SpinLock::ScopedTryLockType stemListLock(stemLock);
+    if (!stemListLock.isLocked())
+        return;
+
     // Get the number of available stems
-    const int numStems = separatedStemBuffers.size();
+    const int numStems = stemSources.size();
     
-    // If we have no stems, just return (nothing to play)
+    // If we have no stems, there is nothing to play, but MIDI CCs still drive parameters
     if (numStems == 0) {
         DBG("Processor::processBlock - No stems available to play");
+        for (const auto metadata : midiMessages)
+            handleMidiEvent(metadata.getMessage());
+        applyPresetMorph();
         return;
     }
 
@@ -585,216 +1008,68 @@ void UndergroundBeatsProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         ", Paused: " + juce::String(paused.load() ? "Yes" : "No") +
         ", Position: " + juce::String(playbackPosition));
 
-    // Only process audio if we're in playing state and not paused
-    if (playing && !paused && numStems > 0)
-    {
-        // Get buffer parameters
-        int numSamples = buffer.getNumSamples();
-        int outputChannels = buffer.getNumChannels();
+    // The timeline only plays while we're in playing state and not paused;
+    // slices triggered from MIDI notes play either way
+    const bool timelineRunning = playing && !paused;
+    int numSamples = buffer.getNumSamples();
 
-        // First, check if any stem has solo enabled
-        bool anySoloActive = false;
-        for (int stemIdx = 0; stemIdx < numStems; ++stemIdx) {
-            auto soloParamID = getStemParameterID(stemIdx, "Solo");
-            auto* soloParam = valueTreeState.getRawParameterValue(soloParamID);
-            if (soloParam && soloParam->load() > 0.5f) {
-                anySoloActive = true;
-                break;
-            }
-        }
+    const audio::AutomationEngine::BlockEvent* events = nullptr;
+    int numEvents = 0;
 
-        // Process each stem and add it to the output buffer
-        for (int stemIdx = 0; stemIdx < numStems; ++stemIdx)
-        {
-            DBG("  Processing Stem Index: " + juce::String(stemIdx));
+    if (timelineRunning)
+    {
+        publishedPlaybackPosition = playbackPosition;
+        automationEngine.prepareBlock(playbackPosition, numSamples);
+        events = automationEngine.getBlockEvents();
+        numEvents = automationEngine.getNumBlockEvents();
+    }
 
-            // Skip if effect chain not initialized
-            if (stemIdx >= stemEffectChains.size() || stemEffectChains[stemIdx] == nullptr) {
-                DBG("    Stem chain is null, skipping.");
-                continue;
-            }
-            
-            // Skip if stem buffer not available
-            if (stemIdx >= separatedStemBuffers.size() || separatedStemBuffers[stemIdx].getNumSamples() == 0) {
-                DBG("    Stem buffer invalid or empty, skipping.");
-                continue;
-            }
-            
-            // Check mute status
-            auto muteParamID = getStemParameterID(stemIdx, "Mute");
-            auto* muteParam = valueTreeState.getRawParameterValue(muteParamID);
-            bool isMuted = muteParam && muteParam->load() > 0.5f;
-            
-            // Check solo status
-            auto soloParamID = getStemParameterID(stemIdx, "Solo");
-            auto* soloParam = valueTreeState.getRawParameterValue(soloParamID);
-            bool isSoloed = soloParam && soloParam->load() > 0.5f;
-            
-            // Skip if muted or if any solo is active but this stem is not soloed
-            if (isMuted || (anySoloActive && !isSoloed)) {
-                DBG("    Stem is muted or not soloed, skipping.");
-                continue;
-            }
+    // Split the block at automation breakpoints and MIDI events. Each sub-block is
+    // rendered with the parameter values and slice voices in effect at its first sample.
+    auto midiIterator = midiMessages.cbegin();
+    const auto midiEnd = midiMessages.cend();
+    int eventIndex = 0;
+    int subBlockStart = 0;
 
-            // Get stem buffer
-            const auto& stemBuffer = separatedStemBuffers[stemIdx];
-            int stemChannels = stemBuffer.getNumChannels();
-            juce::int64 stemLength = stemBuffer.getNumSamples();
+    while (subBlockStart < numSamples)
+    {
+        while (eventIndex < numEvents && events[eventIndex].sampleOffset <= subBlockStart)
+        {
+            applyParameterValue(events[eventIndex].parameterIndex, events[eventIndex].value);
+            ++eventIndex;
+        }
 
-            DBG("    Stem Length: " + juce::String(stemLength) + ", Current Playback Pos: " + juce::String(playbackPosition));
+        while (midiIterator != midiEnd && (*midiIterator).samplePosition <= subBlockStart)
+        {
+            handleMidiEvent((*midiIterator).getMessage());
+            ++midiIterator;
+        }
 
-            // Calculate samples available from current position
-            juce::int64 samplesAvailable = stemLength - playbackPosition;
-            if (samplesAvailable <= 0) {
-                DBG("    No samples available at current position, skipping stem.");
-                continue;
-            }
+        // The morph control may just have moved through automation or a CC
+        applyPresetMorph();
 
-            // Determine how many samples to process in this block
-            int samplesToProcess = (int) juce::jmin((juce::int64)numSamples, samplesAvailable);
-            DBG("    Samples to process for this block: " + juce::String(samplesToProcess));
-
-            // Create a temporary buffer for processing this stem's block
-            // IMPORTANT: Ensure tempBuffer matches the number of channels expected by the chain (stereo)
-            int chainChannels = 2; // Assuming chains are prepared for stereo
-            juce::AudioBuffer<float> tempBuffer(chainChannels, samplesToProcess);
-
-            // Copy (and potentially up-mix mono to stereo) from stemBuffer to tempBuffer
-            for (int ch = 0; ch < chainChannels; ++ch) {
-                // If stem is mono, copy channel 0 to both L/R of temp buffer
-                // If stem is stereo, copy L->L, R->R
-                int sourceChannel = juce::jmin(ch, stemChannels - 1); 
-                tempBuffer.copyFrom(ch, 0, stemBuffer, sourceChannel, (int)playbackPosition, samplesToProcess);
-            }
-            DBG("    Copied stem data to temp buffer (handling mono->stereo).");
+        int subBlockEnd = numSamples;
+        if (eventIndex < numEvents)
+            subBlockEnd = juce::jmin(subBlockEnd, events[eventIndex].sampleOffset);
+        if (midiIterator != midiEnd)
+            subBlockEnd = juce::jmin(subBlockEnd, (*midiIterator).samplePosition);
 
-            // === Update DSP parameters ===
-            auto& chain = stemEffectChains[stemIdx];
+        renderStems(buffer, subBlockStart, subBlockEnd - subBlockStart, timelineRunning);
+        stemSlicePlayer.advance(subBlockEnd - subBlockStart);
+        subBlockStart = subBlockEnd;
+    }
 
-            // Update EQ params...
-            for (int band = 1; band <= 3; ++band)
-            {
-                auto eqEnableParamId = getStemParameterID(stemIdx, "EQ" + juce::String(band) + "_Enable");
-                auto eqFreqParamId = getStemParameterID(stemIdx, "EQ" + juce::String(band) + "_Freq");
-                auto eqGainParamId = getStemParameterID(stemIdx, "EQ" + juce::String(band) + "_Gain");
-                auto eqQParamId = getStemParameterID(stemIdx, "EQ" + juce::String(band) + "_Q");
-
-                auto* enableParam = valueTreeState.getRawParameterValue(eqEnableParamId);
-                auto* freqParam = valueTreeState.getRawParameterValue(eqFreqParamId);
-                auto* gainParam = valueTreeState.getRawParameterValue(eqGainParamId);
-                auto* qParam = valueTreeState.getRawParameterValue(eqQParamId);
-                
-                bool enable = enableParam ? enableParam->load() > 0.5f : true;
-                float freq = freqParam ? freqParam->load() : (band == 1 ? 100.0f : (band == 2 ? 1000.0f : 5000.0f));
-                float gainDb = gainParam ? gainParam->load() : 0.0f;
-                float q = qParam ? qParam->load() : 1.0f;
-
-                auto coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), freq, q, juce::Decibels::decibelsToGain(gainDb));
-                
-                switch (band)
-                {
-                    case 1: chain->get<0>().coefficients = coefficients; chain->setBypassed<0>(!enable); break;
-                    case 2: chain->get<1>().coefficients = coefficients; chain->setBypassed<1>(!enable); break;
-                    case 3: chain->get<2>().coefficients = coefficients; chain->setBypassed<2>(!enable); break;
-                }
-            }
-            
-            // Update Compressor params...
-            auto* compEnableParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Comp_Enable"));
-            auto* compThreshParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Comp_Threshold"));
-            auto* compRatioParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Comp_Ratio"));
-            auto* compAttackParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Comp_Attack"));
-            auto* compReleaseParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Comp_Release"));
-            bool compEnable = compEnableParam ? compEnableParam->load() > 0.5f : true;
-            auto& comp = chain->get<3>();
-            if(compThreshParam) comp.setThreshold(compThreshParam->load());
-            if(compRatioParam) comp.setRatio(compRatioParam->load());
-            if(compAttackParam) comp.setAttack(compAttackParam->load());
-            if(compReleaseParam) comp.setRelease(compReleaseParam->load());
-            chain->setBypassed<3>(!compEnable);
-            
-            // Update Reverb params...
-            auto* reverbEnableParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Reverb_Enable"));
-            auto* reverbRoomParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Reverb_RoomSize"));
-            auto* reverbDampParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Reverb_Damping"));
-            auto* reverbWetParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Reverb_WetLevel"));
-            auto* reverbDryParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Reverb_DryLevel"));
-            auto* reverbWidthParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Reverb_Width"));
-            auto* reverbFreezeParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Reverb_Freeze"));
-            bool reverbEnable = reverbEnableParam ? reverbEnableParam->load() > 0.5f : false;
-            auto& reverb = chain->get<4>();
-            juce::dsp::Reverb::Parameters reverbParams;
-            if(reverbRoomParam) reverbParams.roomSize = reverbRoomParam->load(); else reverbParams.roomSize = 0.5f;
-            if(reverbDampParam) reverbParams.damping = reverbDampParam->load(); else reverbParams.damping = 0.5f;
-            if(reverbWetParam) reverbParams.wetLevel = reverbWetParam->load(); else reverbParams.wetLevel = 0.33f;
-            if(reverbDryParam) reverbParams.dryLevel = reverbDryParam->load(); else reverbParams.dryLevel = 0.4f;
-            if(reverbWidthParam) reverbParams.width = reverbWidthParam->load(); else reverbParams.width = 1.0f;
-            if(reverbFreezeParam) reverbParams.freezeMode = reverbFreezeParam->load() > 0.5f ? 1.0f : 0.0f; else reverbParams.freezeMode = 0.0f;
-            reverb.setParameters(reverbParams);
-            chain->setBypassed<4>(!reverbEnable);
-            
-            // Update Delay params...
-            // Delay parameters implementation skipped to avoid compatibility issues
-
-            // Update Chorus params...
-            auto* chorusEnableParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Chorus_Enable"));
-            auto* chorusRateParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Chorus_Rate"));
-            auto* chorusDepthParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Chorus_Depth"));
-            auto* chorusCentreDelayParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Chorus_CentreDelay"));
-            auto* chorusFeedbackParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Chorus_Feedback"));
-            auto* chorusMixParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Chorus_Mix"));
-            bool chorusEnable = chorusEnableParam ? chorusEnableParam->load() > 0.5f : false;
-            auto& chorus = chain->get<6>();
-            if(chorusRateParam) chorus.setRate(chorusRateParam->load());
-            if(chorusDepthParam) chorus.setDepth(chorusDepthParam->load());
-            if(chorusCentreDelayParam) chorus.setCentreDelay(chorusCentreDelayParam->load());
-            if(chorusFeedbackParam) chorus.setFeedback(chorusFeedbackParam->load());
-            if(chorusMixParam) chorus.setMix(chorusMixParam->load());
-            chain->setBypassed<6>(!chorusEnable);
-            
-            // Update Saturation params...
-            auto* satEnableParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Saturation_Enable"));
-            auto* satAmountParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Saturation_Amount"));
-            bool satEnable = satEnableParam ? satEnableParam->load() > 0.5f : false;
-            auto& saturator = chain->get<7>();
-            float satAmount = satAmountParam ? satAmountParam->load() : 1.0f; // Default amount
-            saturator.functionToUse = [satAmount](float x) { return std::tanh(satAmount * x); };
-            chain->setBypassed<7>(!satEnable);
-
-            // Calculate Final Gain
-            auto* volumeParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Volume"));
-            auto* gainDbParam = valueTreeState.getRawParameterValue(getStemParameterID(stemIdx, "Gain"));
-            float volume = volumeParam ? volumeParam->load() : 0.8f;
-            float gainDb = gainDbParam ? gainDbParam->load() : 0.0f;
-            float linearGain = volume * juce::Decibels::decibelsToGain(gainDb);
-            
-            DBG("    Stem " + juce::String(stemIdx) + " Volume: " + juce::String(volume) + 
-                ", Gain(dB): " + juce::String(gainDb) + 
-                ", Linear Gain: " + juce::String(linearGain));
-
-            // Process the temporary buffer through the effect chain
-            juce::dsp::AudioBlock<float> block(tempBuffer);
-            juce::dsp::ProcessContextReplacing<float> context(block);
-            DBG("    Processing audio block through effect chain...");
-            chain->process(context);
-            DBG("    Processing complete.");
-
-            // Add the processed temporary buffer to the main output buffer
-            DBG("    Adding processed stem to main output buffer...");
-            for (int ch = 0; ch < outputChannels; ++ch)
-            {
-                // Ensure we read from the correct channel of the potentially stereo tempBuffer
-                int sourceChannel = juce::jmin(ch, chainChannels - 1);
-                buffer.addFrom(ch, 0, tempBuffer, sourceChannel, 0, samplesToProcess, linearGain);
-            }
-            DBG("    Stem added to output (gain: " + juce::String(linearGain) + ")");
-        }
+    // Events stamped past the end of the block still take effect for the next one
+    for (; midiIterator != midiEnd; ++midiIterator)
+        handleMidiEvent((*midiIterator).getMessage());
 
+    if (timelineRunning)
+    {
         // Update global playback position
         juce::int64 minLength = -1;
         for (int stemIdx = 0; stemIdx < numStems; ++stemIdx) {
-            if (stemIdx < separatedStemBuffers.size()) {
-                auto len = separatedStemBuffers[stemIdx].getNumSamples();
+            if (stemSources[stemIdx] != nullptr) {
+                auto len = stemSources[stemIdx]->getLengthInSamples();
                 if (minLength == -1 || len < minLength)
                     minLength = len;
             }
@@ -814,6 +1089,81 @@ void UndergroundBeatsProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     }
 }
 
+void UndergroundBeatsProcessor::renderStems(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, bool renderTimeline)
+{
+    const int numStems = juce::jmin((int) stemSources.size(), (int) stemParameterRefs.size());
+    const int outputChannels = buffer.getNumChannels();
+    const juce::int64 position = playbackPosition + startSample;
+
+    // Read every stem's parameters once; solo on any stem silences the others
+    std::array<audio::StemRenderer::ParameterValues, maxStems> stemValues;
+    bool anySoloActive = false;
+    for (int stemIdx = 0; stemIdx < numStems; ++stemIdx) {
+        stemValues[stemIdx] = readStemParameters(stemIdx);
+        anySoloActive = anySoloActive || audio::StemRenderer::isSoloed(stemValues[stemIdx]);
+    }
+
+    // Process each stem and add it to the output buffer
+    for (int stemIdx = 0; stemIdx < numStems; ++stemIdx)
+    {
+        // Skip if effect chain not initialized
+        if (stemIdx >= stemRenderers.size() || stemRenderers[stemIdx] == nullptr)
+            continue;
+        
+        // Skip if stem not available
+        if (stemSources[stemIdx] == nullptr || stemSources[stemIdx]->getLengthInSamples() == 0)
+            continue;
+        
+        // Skip if muted or if any solo is active but this stem is not soloed
+        const auto& values = stemValues[stemIdx];
+        if (!audio::StemRenderer::isAudible(values, anySoloActive))
+            continue;
+
+        // Get stem source
+        auto& stem = *stemSources[stemIdx];
+        juce::int64 stemLength = stem.getLengthInSamples();
+
+        // Calculate samples available from current position
+        juce::int64 samplesAvailable = renderTimeline ? stemLength - position : 0;
+        const bool hasSliceVoices = stemSlicePlayer.isStemActive(stemIdx);
+        if (samplesAvailable <= 0 && !hasSliceVoices)
+            continue;
+
+        // Timeline audio covers the sub-block up to the end of the stem; slices may run the full sub-block
+        int timelineSamples = (int) juce::jlimit((juce::int64) 0, (juce::int64) numSamples, samplesAvailable);
+        int samplesToProcess = hasSliceVoices ? numSamples : timelineSamples;
+
+        // Chains are prepared for stereo, so render into the stereo scratch buffer
+        int chainChannels = 2;
+        if (stemScratchBuffer.getNumSamples() < samplesToProcess)
+            stemScratchBuffer.setSize(chainChannels, samplesToProcess, false, false, true);
+
+        // Read (and potentially up-mix mono to stereo) from the stem into the scratch buffer.
+        // A streamed stem whose read-ahead hasn't caught up yields silence rather than blocking.
+        if (timelineSamples > 0)
+            stem.read(stemScratchBuffer, 0, timelineSamples, position);
+        if (timelineSamples < samplesToProcess)
+            stemScratchBuffer.clear(timelineSamples, samplesToProcess - timelineSamples);
+
+        // Mix in the slices triggered from MIDI so they go through the same chain. Slices
+        // jump around the stem, so they only play from stems that are resident in RAM.
+        if (hasSliceVoices)
+            if (auto* residentBuffer = stem.getResidentBuffer())
+                stemSlicePlayer.renderStem(stemIdx, *residentBuffer, stemScratchBuffer, samplesToProcess);
+
+        // Process the scratch buffer through the effect chain
+        stemRenderers[stemIdx]->process(stemScratchBuffer, samplesToProcess, values);
+
+        // Add the processed stem to the main output buffer
+        const float linearGain = audio::StemRenderer::getOutputGain(values);
+        for (int ch = 0; ch < outputChannels; ++ch)
+        {
+            int sourceChannel = juce::jmin(ch, chainChannels - 1);
+            buffer.addFrom(ch, startSample, stemScratchBuffer, sourceChannel, 0, samplesToProcess, linearGain);
+        }
+    }
+}
+
 //==============================================================================
 bool UndergroundBeatsProcessor::hasEditor() const
 {
@@ -835,6 +1185,12 @@ void UndergroundBeatsProcessor::getStateInformation (juce::MemoryBlock& destData
     // Save the value tree state (NEW)
     auto state = valueTreeState.copyState();
     std::unique_ptr<juce::XmlElement> xml (state.createXml());
+
+    // Automation lanes and MIDI mappings travel alongside the parameters as child elements
+    xml->addChildElement (automationEngine.createXml().release());
+    xml->addChildElement (midiControlMap.createXml().release());
+    xml->addChildElement (stemSlicePlayer.createXml().release());
+    xml->addChildElement (presetMorphEngine.createXml().release());
     copyXmlToBinary (*xml, destData);
 }
 
@@ -848,7 +1204,38 @@ void UndergroundBeatsProcessor::setStateInformation (const void* data, int sizeI
 
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName (valueTreeState.state.getType()))
-            valueTreeState.replaceState (juce::ValueTree::fromXml (*xmlState));
+        {
+            if (auto* automationXml = xmlState->getChildByName ("AUTOMATION"))
+            {
+                automationEngine.restoreFromXml (*automationXml);
+                xmlState->removeChildElement (automationXml, true);
+            }
+
+            if (auto* midiMapXml = xmlState->getChildByName ("MIDI_MAP"))
+            {
+                midiControlMap.restoreFromXml (*midiMapXml);
+                xmlState->removeChildElement (midiMapXml, true);
+            }
+
+            if (auto* slicesXml = xmlState->getChildByName ("SLICES"))
+            {
+                stemSlicePlayer.restoreFromXml (*slicesXml);
+                xmlState->removeChildElement (slicesXml, true);
+            }
+
+            if (auto* morphXml = xmlState->getChildByName ("MORPH"))
+            {
+                presetMorphEngine.restoreFromXml (*morphXml);
+                xmlState->removeChildElement (morphXml, true);
+            }
+
+            // Restored values are not undoable, and the history refers to the previous state
+            {
+                const juce::ScopedValueSetter<bool> restoring (applyingParameterUndo, true);
+                valueTreeState.replaceState (juce::ValueTree::fromXml (*xmlState));
+            }
+            undoManager.clearUndoHistory();
+        }
 
     parametersChanged = true; // Ensure UI updates after loading state
 }
@@ -914,9 +1301,134 @@ bool UndergroundBeatsProcessor::isPaused() const
     return playing.load() && paused.load();
 }
 
+juce::int64 UndergroundBeatsProcessor::getPlaybackPosition() const
+{
+    return publishedPlaybackPosition.load();
+}
+
+//==============================================================================
+// Moves one parameter between two values. Successive moves of the same parameter within
+// a transaction coalesce into one action, so a slider drag is one step.
+class UndergroundBeatsProcessor::ParameterChangeAction : public juce::UndoableAction
+{
+public:
+    ParameterChangeAction(UndergroundBeatsProcessor& owner, int index, float before, float after)
+        : processor(owner), parameterIndex(index), oldValue(before), newValue(after)
+    {
+    }
+
+    // The parameter already holds newValue when the action is first performed
+    bool perform() override
+    {
+        processor.setParameterFromUndo(parameterIndex, newValue);
+        return true;
+    }
+
+    bool undo() override
+    {
+        processor.setParameterFromUndo(parameterIndex, oldValue);
+        return true;
+    }
+
+    // In bytes, as every action in the history counts
+    int getSizeInUnits() override
+    {
+        return (int) sizeof(ParameterChangeAction);
+    }
+
+    juce::UndoableAction* createCoalescedAction(juce::UndoableAction* nextAction) override
+    {
+        auto* next = dynamic_cast<ParameterChangeAction*>(nextAction);
+        if (next == nullptr || next->parameterIndex != parameterIndex)
+            return nullptr;
+
+        return new ParameterChangeAction(processor, parameterIndex, oldValue, next->newValue);
+    }
+
+private:
+    UndergroundBeatsProcessor& processor;
+    int parameterIndex;
+    float oldValue;
+    float newValue;
+};
+
+void UndergroundBeatsProcessor::setParameterFromUndo(int parameterIndex, float normalisedValue)
+{
+    auto* param = getParameters()[parameterIndex];
+    if (param == nullptr || param->getValue() == normalisedValue)
+        return;
+
+    // Hosts and the UI follow the move, but it isn't recorded as a new one
+    const juce::ScopedValueSetter<bool> applying(applyingParameterUndo, true);
+    param->setValueNotifyingHost(normalisedValue);
+}
+
+//==============================================================================
+// Swaps a stem for another source. Both sources are held by shared reference, so
+// performing or undoing the swap never copies audio.
+class UndergroundBeatsProcessor::StemSwapAction : public juce::UndoableAction
+{
+public:
+    StemSwapAction(UndergroundBeatsProcessor& owner, int index, audio::StemSourcePtr source)
+        : processor(owner), stemIndex(index), newSource(std::move(source)), sourceRate(owner.stemSampleRate)
+    {
+        if (stemIndex < (int) processor.stemSources.size())
+            oldSource = processor.stemSources[stemIndex];
+    }
+
+    bool perform() override
+    {
+        conformToProcessorRate();
+        processor.setStemSource(stemIndex, newSource);
+        processor.parametersChanged = true;
+        return true;
+    }
+
+    bool undo() override
+    {
+        conformToProcessorRate();
+        processor.setStemSource(stemIndex, oldSource);
+        processor.parametersChanged = true;
+        return true;
+    }
+
+    // Counts (in bytes) the stem this swap replaced, which only the history keeps alive from
+    // then on. The stem it put in is counted by the swap that replaces it in turn, so a chain
+    // of swaps on one stem counts every stem once, even though neighbouring swaps share them.
+    int getSizeInUnits() override
+    {
+        const auto bytes = sizeof(StemSwapAction) + (oldSource != nullptr ? oldSource->getResidentBytes() : 0);
+        return (int) juce::jmin(bytes, (size_t) std::numeric_limits<int>::max());
+    }
+
+private:
+    // The device rate may have changed since the swap was recorded
+    void conformToProcessorRate()
+    {
+        if (juce::roundToInt(sourceRate) == juce::roundToInt(processor.stemSampleRate) || sourceRate <= 0.0)
+            return;
+
+        auto converted = audio::StemLoadPipeline::resampleSources({ newSource, oldSource }, sourceRate,
+                                                                  processor.stemSampleRate,
+                                                                  processor.loadPipeline.getStreamingOptions());
+        if (converted.size() == 2)
+        {
+            newSource = std::move(converted[0]);
+            oldSource = std::move(converted[1]);
+            sourceRate = processor.stemSampleRate;
+        }
+    }
+
+    UndergroundBeatsProcessor& processor;
+    int stemIndex;
+    audio::StemSourcePtr newSource;
+    audio::StemSourcePtr oldSource;
+    double sourceRate; // Rate both sources were recorded at
+};
+
 bool UndergroundBeatsProcessor::loadAndSwapStem(int stemIndex, const juce::File& file)
 {
-    if (!file.existsAsFile())
+    if (!file.existsAsFile() || stemIndex < 0)
         return false;
 
     std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
@@ -926,19 +1438,43 @@ bool UndergroundBeatsProcessor::loadAndSwapStem(int stemIndex, const juce::File&
     int numChannels = juce::jmin(static_cast<int>(reader->numChannels), 2);
     int numSamples = static_cast<int>(reader->lengthInSamples);
 
-    juce::AudioBuffer<float> newBuffer;
-    newBuffer.setSize(numChannels, numSamples);
+    juce::AudioBuffer<float> newBuffer(numChannels, numSamples);
     reader->read(&newBuffer, 0, numSamples, 0, true, true);
 
-    if (stemIndex >= separatedStemBuffers.size())
-        separatedStemBuffers.resize(stemIndex + 1);
+    // The replacement plays at the rate of the other stems
+    const double targetRate = stemSampleRate > 0.0 ? stemSampleRate : getSampleRate();
+    auto newAudio = audio::PolyphaseResampler::resample(audio::SharedAudio(std::move(newBuffer)), reader->sampleRate, targetRate);
 
-    separatedStemBuffers[stemIndex] = std::move(newBuffer);
+    // The swap is its own undo step; the action holds both stems by reference
+    undoManager.beginNewTransaction("Swap Stem " + juce::String(stemIndex + 1));
+    undoManager.perform(new StemSwapAction(*this, stemIndex, std::make_shared<audio::MemoryStemSource>(std::move(newAudio))));
+    undoManager.beginNewTransaction();
 
     parametersChanged = true;
     return true;
 }
 
+void UndergroundBeatsProcessor::setStemSource(int stemIndex, audio::StemSourcePtr newSource)
+{
+    // Swap under the lock, but let the previous source go after releasing it
+    audio::StemSourcePtr previousSource;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(stemLock);
+
+        if (stemIndex >= (int) stemSources.size())
+        {
+            stemSources.resize(stemIndex + 1);
+            stemRenderers.resize(stemSources.size());
+        }
+
+        previousSource = std::exchange(stemSources[stemIndex], std::move(newSource));
+    }
+
+    // Converted sets still hold the stem that was replaced
+    stemSetsByRate.clear();
+}
+
 } // namespace undergroundBeats
 
 // This creates new instances of the plugin. Must be outside the namespace to be found by the JUCE plugin loader
@@ -0,0 +1,316 @@
+#include "undergroundBeats/audio/AutomationEngine.h"
+#include <algorithm>
+
+namespace undergroundBeats {
+namespace audio {
+
+namespace {
+
+bool isEarlier(const AutomationBreakpoint& a, const AutomationBreakpoint& b)
+{
+    return a.samplePosition < b.samplePosition;
+}
+
+} // namespace
+
+//==============================================================================
+// AutomationLane
+//==============================================================================
+void AutomationLane::mergeTake(const std::vector<AutomationBreakpoint>& take)
+{
+    if (take.empty())
+        return;
+
+    // Overwrite everything the take covers, keep what lies before and after it
+    const auto takeStart = take.front().samplePosition;
+    const auto takeEnd = take.back().samplePosition;
+
+    auto firstReplaced = std::lower_bound(breakpoints.begin(), breakpoints.end(),
+                                          AutomationBreakpoint { takeStart, 0.0f }, isEarlier);
+    auto firstKept = std::upper_bound(firstReplaced, breakpoints.end(),
+                                      AutomationBreakpoint { takeEnd, 0.0f }, isEarlier);
+
+    firstReplaced = breakpoints.erase(firstReplaced, firstKept);
+    breakpoints.insert(firstReplaced, take.begin(), take.end());
+    cursor = 0;
+}
+
+void AutomationLane::setBreakpoints(std::vector<AutomationBreakpoint> newBreakpoints)
+{
+    if (!std::is_sorted(newBreakpoints.begin(), newBreakpoints.end(), isEarlier))
+        std::stable_sort(newBreakpoints.begin(), newBreakpoints.end(), isEarlier);
+
+    breakpoints = std::move(newBreakpoints);
+    cursor = 0;
+}
+
+void AutomationLane::clear()
+{
+    breakpoints.clear();
+    cursor = 0;
+}
+
+float AutomationLane::getValueAt(juce::int64 samplePosition) const
+{
+    auto next = std::upper_bound(breakpoints.begin(), breakpoints.end(),
+                                 AutomationBreakpoint { samplePosition, 0.0f }, isEarlier);
+
+    if (next == breakpoints.begin())
+        return -1.0f;
+
+    return std::prev(next)->value;
+}
+
+void AutomationLane::seek(juce::int64 samplePosition)
+{
+    auto it = std::lower_bound(breakpoints.begin(), breakpoints.end(),
+                               AutomationBreakpoint { samplePosition, 0.0f }, isEarlier);
+    cursor = static_cast<size_t>(std::distance(breakpoints.begin(), it));
+}
+
+const AutomationBreakpoint* AutomationLane::peek() const
+{
+    return cursor < breakpoints.size() ? &breakpoints[cursor] : nullptr;
+}
+
+//==============================================================================
+// AutomationEngine
+//==============================================================================
+AutomationEngine::AutomationEngine()
+{
+    blockEvents.resize(maxEventsPerBlock);
+}
+
+AutomationEngine::~AutomationEngine() = default;
+
+void AutomationEngine::initialise(int numParameters)
+{
+    const juce::SpinLock::ScopedLockType lock(laneLock);
+    lanes.clear();
+    lanes.resize(static_cast<size_t>(numParameters));
+    pendingTakes.clear();
+    pendingTakes.resize(static_cast<size_t>(numParameters));
+    activeLanes.clear();
+    activeLanes.reserve(static_cast<size_t>(numParameters));
+    expectedBlockStart = -1;
+}
+
+void AutomationEngine::setRecording(bool shouldRecord)
+{
+    const bool wasRecording = recording.exchange(shouldRecord);
+
+    if (wasRecording && !shouldRecord)
+        commitRecording();
+}
+
+void AutomationEngine::recordParameterChange(int parameterIndex, float normalisedValue, juce::int64 samplePosition)
+{
+    if (!recording.load() || !juce::isPositiveAndBelow(parameterIndex, static_cast<int>(pendingTakes.size())))
+        return;
+
+    auto& take = pendingTakes[static_cast<size_t>(parameterIndex)];
+
+    // Several moves inside the same block collapse into the latest value
+    if (!take.empty() && take.back().samplePosition >= samplePosition)
+    {
+        if (take.back().samplePosition == samplePosition)
+        {
+            take.back().value = normalisedValue;
+            return;
+        }
+
+        // The transport wrapped around: commit what we have and start a new take
+        commitRecording();
+    }
+
+    take.push_back({ samplePosition, normalisedValue });
+}
+
+void AutomationEngine::commitRecording()
+{
+    const juce::SpinLock::ScopedLockType lock(laneLock);
+
+    for (size_t i = 0; i < pendingTakes.size(); ++i)
+    {
+        if (pendingTakes[i].empty())
+            continue;
+
+        lanes[i].mergeTake(pendingTakes[i]);
+        pendingTakes[i].clear();
+    }
+
+    rebuildActiveLanes();
+    expectedBlockStart = -1; // Forces a reseek on the next block
+}
+
+void AutomationEngine::clearLane(int parameterIndex)
+{
+    if (!juce::isPositiveAndBelow(parameterIndex, getNumLanes()))
+        return;
+
+    const juce::SpinLock::ScopedLockType lock(laneLock);
+    lanes[static_cast<size_t>(parameterIndex)].clear();
+    rebuildActiveLanes();
+}
+
+void AutomationEngine::clearAll()
+{
+    const juce::SpinLock::ScopedLockType lock(laneLock);
+
+    for (auto& lane : lanes)
+        lane.clear();
+
+    for (auto& take : pendingTakes)
+        take.clear();
+
+    rebuildActiveLanes();
+}
+
+std::vector<AutomationBreakpoint> AutomationEngine::getLaneBreakpoints(int parameterIndex) const
+{
+    if (!juce::isPositiveAndBelow(parameterIndex, getNumLanes()))
+        return {};
+
+    const juce::SpinLock::ScopedLockType lock(laneLock);
+    return lanes[static_cast<size_t>(parameterIndex)].getBreakpoints();
+}
+
+void AutomationEngine::setLaneBreakpoints(int parameterIndex, std::vector<AutomationBreakpoint> newBreakpoints)
+{
+    if (!juce::isPositiveAndBelow(parameterIndex, getNumLanes()))
+        return;
+
+    const juce::SpinLock::ScopedLockType lock(laneLock);
+    lanes[static_cast<size_t>(parameterIndex)].setBreakpoints(std::move(newBreakpoints));
+    rebuildActiveLanes();
+    expectedBlockStart = -1;
+}
+
+std::unique_ptr<juce::XmlElement> AutomationEngine::createXml() const
+{
+    auto xml = std::make_unique<juce::XmlElement>("AUTOMATION");
+    const juce::SpinLock::ScopedLockType lock(laneLock);
+
+    for (auto laneIndex : activeLanes)
+    {
+        const auto& points = lanes[static_cast<size_t>(laneIndex)].getBreakpoints();
+
+        // Breakpoints are packed as (int64 position, float value) little-endian pairs
+        juce::MemoryOutputStream stream;
+        for (const auto& point : points)
+        {
+            stream.writeInt64(point.samplePosition);
+            stream.writeFloat(point.value);
+        }
+
+        auto* laneXml = xml->createNewChildElement("LANE");
+        laneXml->setAttribute("index", laneIndex);
+        laneXml->setAttribute("data", stream.getMemoryBlock().toBase64Encoding());
+    }
+
+    return xml;
+}
+
+void AutomationEngine::restoreFromXml(const juce::XmlElement& xml)
+{
+    clearAll();
+
+    for (auto* laneXml : xml.getChildWithTagNameIterator("LANE"))
+    {
+        juce::MemoryBlock data;
+        if (!data.fromBase64Encoding(laneXml->getStringAttribute("data")))
+            continue;
+
+        juce::MemoryInputStream stream(data, false);
+        std::vector<AutomationBreakpoint> points;
+        points.reserve(data.getSize() / 12);
+
+        while (stream.getNumBytesRemaining() >= 12)
+        {
+            AutomationBreakpoint point;
+            point.samplePosition = stream.readInt64();
+            point.value = stream.readFloat();
+            points.push_back(point);
+        }
+
+        setLaneBreakpoints(laneXml->getIntAttribute("index", -1), std::move(points));
+    }
+}
+
+//==============================================================================
+bool AutomationEngine::prepareBlock(juce::int64 blockStart, int numSamples)
+{
+    numBlockEvents = 0;
+
+    // Recording is in write mode: the user's moves win over the existing lanes
+    if (!playbackEnabled.load() || recording.load())
+    {
+        expectedBlockStart = -1;
+        return false;
+    }
+
+    const juce::SpinLock::ScopedTryLockType lock(laneLock);
+    if (!lock.isLocked() || activeLanes.empty())
+        return false;
+
+    const bool isContinuous = (blockStart == expectedBlockStart);
+    expectedBlockStart = blockStart + numSamples;
+
+    if (!isContinuous)
+        seekAllLanes(blockStart);
+
+    const auto blockEnd = blockStart + numSamples;
+
+    for (auto laneIndex : activeLanes)
+    {
+        auto& lane = lanes[static_cast<size_t>(laneIndex)];
+
+        while (const auto* point = lane.peek())
+        {
+            if (point->samplePosition >= blockEnd || numBlockEvents >= maxEventsPerBlock)
+                break;
+
+            auto& event = blockEvents[static_cast<size_t>(numBlockEvents++)];
+            event.sampleOffset = static_cast<int>(juce::jmax<juce::int64>(0, point->samplePosition - blockStart));
+            event.parameterIndex = laneIndex;
+            event.value = point->value;
+            lane.advance();
+        }
+    }
+
+    std::sort(blockEvents.begin(), blockEvents.begin() + numBlockEvents,
+              [](const BlockEvent& a, const BlockEvent& b) { return a.sampleOffset < b.sampleOffset; });
+
+    return numBlockEvents > 0;
+}
+
+void AutomationEngine::seekAllLanes(juce::int64 samplePosition)
+{
+    for (auto laneIndex : activeLanes)
+    {
+        auto& lane = lanes[static_cast<size_t>(laneIndex)];
+        lane.seek(samplePosition);
+
+        // Chase the value in effect at the new position so the parameter doesn't keep
+        // whatever it had before the seek. A breakpoint exactly at the position is
+        // emitted by the normal pass.
+        if (const auto* next = lane.peek(); next != nullptr && next->samplePosition == samplePosition)
+            continue;
+
+        const auto chasedValue = lane.getValueAt(samplePosition - 1);
+        if (chasedValue >= 0.0f && numBlockEvents < maxEventsPerBlock)
+            blockEvents[static_cast<size_t>(numBlockEvents++)] = { 0, laneIndex, chasedValue };
+    }
+}
+
+void AutomationEngine::rebuildActiveLanes()
+{
+    activeLanes.clear();
+
+    for (size_t i = 0; i < lanes.size(); ++i)
+        if (!lanes[i].isEmpty())
+            activeLanes.push_back(static_cast<int>(i));
+}
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,320 @@
+#include "undergroundBeats/audio/BatchImportQueue.h"
+#include <algorithm>
+
+namespace undergroundBeats {
+namespace audio {
+
+namespace {
+
+// At the target rate an import holds the resampled mix, four stems and about two
+// copies the separator works in
+constexpr int copiesAtTargetRate = 7;
+
+bool isActive(BatchImportQueue::JobState state)
+{
+    return state == BatchImportQueue::JobState::WaitingForMemory || state == BatchImportQueue::JobState::Running;
+}
+
+bool isDone(BatchImportQueue::JobState state)
+{
+    return state == BatchImportQueue::JobState::Finished || state == BatchImportQueue::JobState::Failed
+           || state == BatchImportQueue::JobState::Cancelled;
+}
+
+} // namespace
+
+//==============================================================================
+struct BatchImportQueue::Job
+{
+    Job(const juce::File& fileToImport, double rate, const StemLoadPipeline::SeparationOptions& options)
+        : file(fileToImport), targetSampleRate(rate), separation(options) {}
+
+    const juce::File file;
+    const double targetSampleRate;
+    const StemLoadPipeline::SeparationOptions separation;
+
+    std::atomic<JobState> state { JobState::Queued };
+    std::atomic<StemLoadPipeline::Stage> stage { StemLoadPipeline::Stage::Idle };
+    std::atomic<float> progress { 0.0f };
+    std::atomic<bool> cancelled { false };
+
+    // Written once by the worker, under the queue's lock, as it finishes
+    bool wasCached = false;
+    juce::String error;
+};
+
+//==============================================================================
+class BatchImportQueue::Worker : public juce::ThreadPoolJob
+{
+public:
+    Worker(BatchImportQueue& owner, Job& jobToRun)
+        : juce::ThreadPoolJob("BatchImport"), queue(owner), job(jobToRun)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        auto shouldStop = [this] { return shouldExit() || job.cancelled.load(); };
+
+        std::unique_ptr<juce::AudioFormatReader> reader(queue.formatManager.createReaderFor(job.file));
+        if (reader == nullptr)
+        {
+            finish(JobState::Failed, "Could not create reader for file: " + job.file.getFullPathName());
+            return jobHasFinished;
+        }
+
+        const double fileRate = reader->sampleRate;
+        const double playbackRate = job.targetSampleRate > 0.0 ? job.targetSampleRate : fileRate;
+        const auto bytes = estimateMemory(reader->lengthInSamples, fileRate, playbackRate,
+                                          juce::jmin((int) reader->numChannels, 2));
+        reader.reset();
+
+        // Tracks imported before cost a hash of the file and nothing else
+        const auto key = SeparationCache::makeKey(job.file, StemLoadPipeline::getModelIdentity(job.separation),
+                                                  playbackRate);
+        if (queue.separationCache.contains(key))
+        {
+            finish(JobState::Finished, {}, true);
+            return jobHasFinished;
+        }
+
+        if (!queue.reserveMemory(bytes, shouldStop))
+        {
+            finish(JobState::Cancelled, {});
+            return jobHasFinished;
+        }
+
+        job.state = JobState::Running;
+        queue.jobStateChanged();
+
+        auto result = StemLoadPipeline::runStages(job.file, job.targetSampleRate, queue.formatManager, queue.modelLoader,
+                                                  StemLoadPipeline::StreamingOptions(), &queue.separationCache,
+                                                  job.separation, shouldStop,
+                                                  [this](StemLoadPipeline::Stage stage, float progress)
+                                                  {
+                                                      job.stage = stage;
+                                                      job.progress = progress;
+                                                  });
+
+        // Stems are stored by runStages; the result itself is not needed
+        const bool separated = result.separated;
+        const auto error = result.error;
+        result = {};
+        queue.releaseMemory(bytes);
+
+        if (shouldStop())
+            finish(JobState::Cancelled, {});
+        else if (error.isNotEmpty())
+            finish(JobState::Failed, error);
+        else if (!separated)
+            finish(JobState::Failed, "Separation failed");
+        else
+            finish(JobState::Finished, {});
+
+        return jobHasFinished;
+    }
+
+private:
+    void finish(JobState state, const juce::String& error, bool wasCached = false)
+    {
+        {
+            const juce::ScopedLock sl(queue.lock);
+            job.error = error;
+            job.wasCached = wasCached;
+            job.state = state;
+        }
+
+        // The job may be cleared from the list as soon as its state is final; it isn't touched again
+        queue.jobStateChanged();
+    }
+
+    BatchImportQueue& queue;
+    Job& job;
+};
+
+//==============================================================================
+BatchImportQueue::BatchImportQueue(juce::AudioFormatManager& formats, ml::ONNXModelLoader& loader,
+                                   SeparationCache& cache)
+    : formatManager(formats), modelLoader(loader), separationCache(cache)
+{
+}
+
+BatchImportQueue::~BatchImportQueue()
+{
+    cancelAll();
+    pool.removeAllJobs(true, -1);
+    cancelPendingUpdate();
+}
+
+void BatchImportQueue::addFiles(const juce::Array<juce::File>& files, double targetSampleRate,
+                                const StemLoadPipeline::SeparationOptions& separation)
+{
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (const auto& file : files)
+        {
+            // Dropping a folder twice shouldn't import its tracks twice
+            const bool alreadyPending = std::any_of(jobs.begin(), jobs.end(), [&](const std::unique_ptr<Job>& job)
+            {
+                return job->file == file && job->targetSampleRate == targetSampleRate
+                       && job->separation.backend.capabilities.id == separation.backend.capabilities.id
+                       && job->separation.variant == separation.variant && !isDone(job->state.load());
+            });
+
+            if (!alreadyPending)
+                jobs.push_back(std::make_unique<Job>(file, targetSampleRate, separation));
+        }
+    }
+
+    startReadyJobs();
+    listeners.call([](Listener& l) { l.batchImportChanged(); });
+}
+
+void BatchImportQueue::setLimits(const Limits& newLimits)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        limits = newLimits;
+        limits.maxConcurrentJobs = juce::jmax(1, limits.maxConcurrentJobs);
+    }
+
+    memoryReleased.signal();
+    triggerAsyncUpdate();
+}
+
+BatchImportQueue::Limits BatchImportQueue::getLimits() const
+{
+    const juce::ScopedLock sl(lock);
+    return limits;
+}
+
+void BatchImportQueue::cancelAll()
+{
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (auto& job : jobs)
+        {
+            // Queued jobs have no worker yet; running ones finish as Cancelled at their next check
+            if (job->state.load() == JobState::Queued)
+                job->state = JobState::Cancelled;
+            else if (isActive(job->state.load()))
+                job->cancelled = true;
+        }
+    }
+
+    memoryReleased.signal();
+    triggerAsyncUpdate();
+}
+
+void BatchImportQueue::clearFinished()
+{
+    {
+        const juce::ScopedLock sl(lock);
+        jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+                                  [](const std::unique_ptr<Job>& job) { return isDone(job->state.load()); }),
+                   jobs.end());
+    }
+
+    listeners.call([](Listener& l) { l.batchImportChanged(); });
+}
+
+std::vector<BatchImportQueue::JobInfo> BatchImportQueue::getJobs() const
+{
+    const juce::ScopedLock sl(lock);
+
+    std::vector<JobInfo> snapshot;
+    snapshot.reserve(jobs.size());
+
+    for (const auto& job : jobs)
+        snapshot.push_back({ job->file, job->state.load(), job->stage.load(), job->progress.load(),
+                             job->wasCached, job->error });
+
+    return snapshot;
+}
+
+bool BatchImportQueue::isBusy() const
+{
+    const juce::ScopedLock sl(lock);
+    return std::any_of(jobs.begin(), jobs.end(),
+                       [](const std::unique_ptr<Job>& job) { return !isDone(job->state.load()); });
+}
+
+size_t BatchImportQueue::estimateMemory(juce::int64 lengthInSamples, double fileSampleRate, double targetSampleRate,
+                                        int numChannels)
+{
+    const double ratio = fileSampleRate > 0.0 && targetSampleRate > 0.0 ? targetSampleRate / fileSampleRate : 1.0;
+    const auto bytesPerFrame = (double) juce::jmax(1, numChannels) * sizeof(float);
+    const auto length = (double) juce::jmax((juce::int64) 0, lengthInSamples);
+
+    return (size_t) (length * bytesPerFrame * (1.0 + ratio * copiesAtTargetRate));
+}
+
+//==============================================================================
+void BatchImportQueue::handleAsyncUpdate()
+{
+    startReadyJobs();
+    listeners.call([](Listener& l) { l.batchImportChanged(); });
+}
+
+void BatchImportQueue::startReadyJobs()
+{
+    const juce::ScopedLock sl(lock);
+
+    int numActive = (int) std::count_if(jobs.begin(), jobs.end(),
+                                        [](const std::unique_ptr<Job>& job) { return isActive(job->state.load()); });
+
+    for (auto& job : jobs)
+    {
+        if (numActive >= limits.maxConcurrentJobs)
+            break;
+
+        if (job->state.load() != JobState::Queued)
+            continue;
+
+        job->state = JobState::WaitingForMemory;
+        pool.addJob(new Worker(*this, *job), true);
+        ++numActive;
+    }
+}
+
+bool BatchImportQueue::reserveMemory(size_t bytes, const std::function<bool()>& shouldExit)
+{
+    for (;;)
+    {
+        {
+            const juce::ScopedLock sl(lock);
+
+            // A job that doesn't fit on its own still runs, once it has the machine to itself
+            if (reservedBytes == 0 || reservedBytes + bytes <= limits.memoryBudgetBytes)
+            {
+                reservedBytes += bytes;
+                return true;
+            }
+        }
+
+        if (shouldExit())
+            return false;
+
+        memoryReleased.wait(50);
+    }
+}
+
+void BatchImportQueue::releaseMemory(size_t bytes)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        reservedBytes -= juce::jmin(bytes, reservedBytes);
+    }
+
+    memoryReleased.signal();
+}
+
+void BatchImportQueue::jobStateChanged()
+{
+    triggerAsyncUpdate();
+}
+
+} // namespace audio
+} // namespace undergroundBeats
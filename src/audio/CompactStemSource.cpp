@@ -0,0 +1,60 @@
+#include "undergroundBeats/audio/CompactStemSource.h"
+#include "undergroundBeats/audio/HalfFloat.h"
+
+namespace undergroundBeats {
+namespace audio {
+
+CompactStemSource::CompactStemSource(const juce::AudioBuffer<float>& stem)
+    : lengthInSamples(stem.getNumSamples()),
+      channels((size_t) stem.getNumChannels()),
+      overview(makeStemOverview(stem))
+{
+    for (int ch = 0; ch < stem.getNumChannels(); ++ch)
+    {
+        auto& samples = channels[(size_t) ch];
+        samples.resize((size_t) lengthInSamples);
+        convertFloatToHalf(stem.getReadPointer(ch), samples.data(), lengthInSamples);
+    }
+}
+
+bool CompactStemSource::read(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+                             juce::int64 sourceStartSample)
+{
+    const juce::int64 available = juce::jlimit((juce::int64) 0, (juce::int64) numSamples,
+                                               (juce::int64) lengthInSamples - sourceStartSample);
+    const int numToConvert = sourceStartSample < 0 || channels.empty() ? 0 : (int) available;
+
+    for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+    {
+        auto* output = destination.getWritePointer(ch, destStartSample);
+
+        // Mono sources are up-mixed by converting the one channel into every output
+        if (numToConvert > 0)
+            convertHalfToFloat(channels[(size_t) juce::jmin(ch, (int) channels.size() - 1)].data() + sourceStartSample,
+                               output, numToConvert);
+
+        if (numToConvert < numSamples)
+            juce::FloatVectorOperations::clear(output + numToConvert, numSamples - numToConvert);
+    }
+
+    return numToConvert == numSamples;
+}
+
+size_t CompactStemSource::getResidentBytes() const
+{
+    return channels.size() * ((size_t) lengthInSamples * sizeof(juce::uint16)
+                              + (size_t) overview.getNumSamples() * sizeof(float));
+}
+
+SharedAudio CompactStemSource::readEntireStem() const
+{
+    juce::AudioBuffer<float> stem((int) channels.size(), lengthInSamples);
+
+    for (int ch = 0; ch < stem.getNumChannels(); ++ch)
+        convertHalfToFloat(channels[(size_t) ch].data(), stem.getWritePointer(ch), lengthInSamples);
+
+    return SharedAudio(std::move(stem));
+}
+
+} // namespace audio
+} // namespace undergroundBeats
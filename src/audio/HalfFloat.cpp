@@ -0,0 +1,161 @@
+#include "undergroundBeats/audio/HalfFloat.h"
+#include <cstring>
+
+// F16C is used directly when the build targets it. Builds for plain x86-64 (the default)
+// compile the F16C loops for that target alone and choose them at run time from CPUID.
+#if defined(__F16C__)
+ #include <immintrin.h>
+ #define UNDERGROUNDBEATS_F16C_HALF 1
+ #define UNDERGROUNDBEATS_F16C_TARGET
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+ #include <immintrin.h>
+ #include <cpuid.h>
+ #define UNDERGROUNDBEATS_F16C_HALF 1
+ #define UNDERGROUNDBEATS_F16C_DISPATCH 1
+ #define UNDERGROUNDBEATS_F16C_TARGET __attribute__((target("avx,f16c")))
+#elif defined(__aarch64__) || defined(_M_ARM64)
+ #include <arm_neon.h>
+ #define UNDERGROUNDBEATS_NEON_HALF 1
+#endif
+
+namespace undergroundBeats {
+namespace audio {
+
+namespace {
+
+inline juce::uint32 toBits(float value)
+{
+    juce::uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float fromBits(juce::uint32 bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Round-to-nearest-even conversion; subnormals are rounded by letting the FPU add a magic number
+inline juce::uint16 floatToHalf(float value)
+{
+    constexpr juce::uint32 infinity = 255u << 23;
+    constexpr juce::uint32 halfOverflow = (127u + 16u) << 23;
+    constexpr juce::uint32 smallestNormal = 113u << 23;
+    constexpr juce::uint32 subnormalMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    auto bits = toBits(value);
+    const auto sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    juce::uint16 half;
+
+    if (bits >= halfOverflow)
+    {
+        half = bits > infinity ? 0x7e00 : 0x7c00;
+    }
+    else if (bits < smallestNormal)
+    {
+        half = (juce::uint16) (toBits(fromBits(bits) + fromBits(subnormalMagic)) - subnormalMagic);
+    }
+    else
+    {
+        const auto oddMantissa = (bits >> 13) & 1u;
+        bits += ((juce::uint32) (15 - 127) << 23) + 0xfffu + oddMantissa;
+        half = (juce::uint16) (bits >> 13);
+    }
+
+    return (juce::uint16) (half | (sign >> 16));
+}
+
+inline float halfToFloat(juce::uint16 half)
+{
+    constexpr juce::uint32 exponentMask = 0x7c00u << 13;
+
+    auto bits = (juce::uint32) (half & 0x7fff) << 13;
+    const auto exponent = bits & exponentMask;
+    bits += (127u - 15u) << 23;
+
+    if (exponent == exponentMask)
+        bits += (128u - 16u) << 23; // Infinity or NaN
+    else if (exponent == 0)
+        bits = toBits(fromBits(bits + (1u << 23)) - fromBits(113u << 23)); // Subnormal
+
+    return fromBits(bits | ((juce::uint32) (half & 0x8000) << 16));
+}
+
+#if UNDERGROUNDBEATS_F16C_HALF
+bool hasF16C()
+{
+   #if UNDERGROUNDBEATS_F16C_DISPATCH
+    // The 256-bit forms need the OS to save AVX state, which hasAVX() checks
+    static const bool supported = []
+    {
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        return juce::SystemStats::hasAVX() && __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0 && (ecx & bit_F16C) != 0;
+    }();
+
+    return supported;
+   #else
+    return true;
+   #endif
+}
+
+// Each converts whole groups of eight and returns how many samples it converted
+UNDERGROUNDBEATS_F16C_TARGET int convertFloatToHalfF16C(const float* source, juce::uint16* destination, int numSamples)
+{
+    int i = 0;
+    for (; i + 8 <= numSamples; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i),
+                         _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT));
+    return i;
+}
+
+UNDERGROUNDBEATS_F16C_TARGET int convertHalfToFloatF16C(const juce::uint16* source, float* destination, int numSamples)
+{
+    int i = 0;
+    for (; i + 8 <= numSamples; i += 8)
+        _mm256_storeu_ps(destination + i,
+                         _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))));
+    return i;
+}
+#endif
+
+} // namespace
+
+//==============================================================================
+void convertFloatToHalf(const float* source, juce::uint16* destination, int numSamples)
+{
+    int i = 0;
+
+   #if UNDERGROUNDBEATS_F16C_HALF
+    if (hasF16C())
+        i = convertFloatToHalfF16C(source, destination, numSamples);
+   #elif UNDERGROUNDBEATS_NEON_HALF
+    for (; i + 4 <= numSamples; i += 4)
+        vst1_u16(destination + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(source + i))));
+   #endif
+
+    for (; i < numSamples; ++i)
+        destination[i] = floatToHalf(source[i]);
+}
+
+void convertHalfToFloat(const juce::uint16* source, float* destination, int numSamples)
+{
+    int i = 0;
+
+   #if UNDERGROUNDBEATS_F16C_HALF
+    if (hasF16C())
+        i = convertHalfToFloatF16C(source, destination, numSamples);
+   #elif UNDERGROUNDBEATS_NEON_HALF
+    for (; i + 4 <= numSamples; i += 4)
+        vst1q_f32(destination + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(source + i))));
+   #endif
+
+    for (; i < numSamples; ++i)
+        destination[i] = halfToFloat(source[i]);
+}
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,93 @@
+#include "undergroundBeats/audio/MidiControlMap.h"
+
+namespace undergroundBeats {
+namespace audio {
+
+MidiControlMap::MidiControlMap()
+{
+    for (auto& entry : table)
+        entry.store(unmapped);
+}
+
+void MidiControlMap::setMapping(int controllerNumber, int parameterIndex)
+{
+    if (juce::isPositiveAndBelow(controllerNumber, numControllers))
+        table[static_cast<size_t>(controllerNumber)].store(parameterIndex);
+}
+
+void MidiControlMap::clearMapping(int controllerNumber)
+{
+    setMapping(controllerNumber, unmapped);
+}
+
+void MidiControlMap::clearMappingsForParameter(int parameterIndex)
+{
+    for (auto& entry : table)
+    {
+        auto expected = parameterIndex;
+        entry.compare_exchange_strong(expected, unmapped);
+    }
+}
+
+void MidiControlMap::clearAll()
+{
+    cancelLearn();
+
+    for (auto& entry : table)
+        entry.store(unmapped);
+}
+
+int MidiControlMap::getMapping(int controllerNumber) const
+{
+    if (!juce::isPositiveAndBelow(controllerNumber, numControllers))
+        return unmapped;
+
+    return table[static_cast<size_t>(controllerNumber)].load();
+}
+
+std::unique_ptr<juce::XmlElement> MidiControlMap::createXml() const
+{
+    auto xml = std::make_unique<juce::XmlElement>("MIDI_MAP");
+
+    for (int cc = 0; cc < numControllers; ++cc)
+    {
+        const auto parameterIndex = getMapping(cc);
+        if (parameterIndex == unmapped)
+            continue;
+
+        auto* mappingXml = xml->createNewChildElement("CC");
+        mappingXml->setAttribute("number", cc);
+        mappingXml->setAttribute("parameter", parameterIndex);
+    }
+
+    return xml;
+}
+
+void MidiControlMap::restoreFromXml(const juce::XmlElement& xml)
+{
+    clearAll();
+
+    for (auto* mappingXml : xml.getChildWithTagNameIterator("CC"))
+        setMapping(mappingXml->getIntAttribute("number", -1), mappingXml->getIntAttribute("parameter", unmapped));
+}
+
+int MidiControlMap::handleController(int controllerNumber)
+{
+    if (!juce::isPositiveAndBelow(controllerNumber, numControllers))
+        return unmapped;
+
+    auto& entry = table[static_cast<size_t>(controllerNumber)];
+
+    // Only one controller completes a learn, even if several arrive in the same block
+    if (learnTarget.load() != unmapped)
+    {
+        const auto target = learnTarget.exchange(unmapped);
+        if (target != unmapped)
+            entry.store(target);
+    }
+
+    return entry.load();
+}
+
+} // namespace audio
+} // namespace undergroundBeats
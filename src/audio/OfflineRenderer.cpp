@@ -0,0 +1,414 @@
+#include "undergroundBeats/audio/OfflineRenderer.h"
+#include "undergroundBeats/audio/StreamingStemSource.h"
+#include <memory>
+
+namespace undergroundBeats {
+namespace audio {
+
+namespace {
+
+// Samples each writer's FIFO holds; two batches, so rendering never waits on the disk
+constexpr int writerFifoSamples = 2 * OfflineRenderer::blockSize * OfflineRenderer::blocksPerBatch;
+
+// A stretch of the timeline with constant parameters; the values are snapshots for every stem
+struct SubBlock
+{
+    int start = 0;  // Offset from the start of the batch
+    int length = 0;
+    bool anySoloActive = false;
+    std::vector<StemRenderer::ParameterValues> stemValues;
+};
+
+// One output file, written from a FIFO by the writer thread
+class OutputFile
+{
+public:
+    explicit OutputFile(const juce::File& fileToWrite) : file(fileToWrite) {}
+
+    ~OutputFile() { close(); }
+
+    bool open(const OfflineRenderer::Options& options, double sampleRate, int numChannels,
+              juce::TimeSliceThread& writerThread)
+    {
+        std::unique_ptr<juce::AudioFormat> format;
+        if (options.fileFormat == OfflineRenderer::FileFormat::Flac)
+            format = std::make_unique<juce::FlacAudioFormat>();
+        else
+            format = std::make_unique<juce::WavAudioFormat>();
+
+        // The WAV writer stores 32-bit samples as IEEE floats
+        const bool asFloat = options.sampleFormat == OfflineRenderer::SampleFormat::Float32
+                             && options.fileFormat == OfflineRenderer::FileFormat::Wav;
+
+        file.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+        if (stream == nullptr)
+            return false;
+
+        std::unique_ptr<juce::AudioFormatWriter> formatWriter(
+            format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels, asFloat ? 32 : 24, {}, 0));
+        if (formatWriter == nullptr)
+            return false;
+
+        stream.release(); // Now owned by the format writer
+        writer = std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(formatWriter.release(), writerThread,
+                                                                           writerFifoSamples);
+        return true;
+    }
+
+    // Queues samples for the writer thread, waiting while its FIFO is full
+    bool write(const juce::AudioBuffer<float>& audio, int numSamples, const std::function<bool()>& shouldExit)
+    {
+        while (!writer->write(audio.getArrayOfReadPointers(), numSamples))
+        {
+            if (shouldExit())
+                return false;
+
+            juce::Thread::sleep(1);
+        }
+
+        return true;
+    }
+
+    // Flushes the FIFO and finishes the file
+    void close() { writer.reset(); }
+
+    const juce::File file;
+
+private:
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> writer;
+};
+
+} // namespace
+
+//==============================================================================
+class OfflineRenderer::RenderJob : public juce::ThreadPoolJob
+{
+public:
+    RenderJob(OfflineRenderer& owner, Session sessionToRender, const Options& renderOptions)
+        : juce::ThreadPoolJob("OfflineRender"), renderer(owner), session(std::move(sessionToRender)),
+          options(renderOptions)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        auto result = render(session, options, [this] { return shouldExit(); },
+                             [this](float fraction) { renderer.progress = fraction; });
+
+        // The stems are released here, on the render thread, rather than on the message thread
+        session = {};
+
+        {
+            const juce::ScopedLock lock(renderer.resultLock);
+            renderer.finishedResult = result;
+            renderer.hasFinishedResult = true;
+        }
+
+        renderer.rendering = false;
+        renderer.triggerAsyncUpdate();
+        return jobHasFinished;
+    }
+
+private:
+    OfflineRenderer& renderer;
+    Session session;
+    const Options options;
+};
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer() = default;
+
+OfflineRenderer::~OfflineRenderer()
+{
+    pool.removeAllJobs(true, -1);
+    cancelPendingUpdate();
+}
+
+bool OfflineRenderer::start(Session session, const Options& options)
+{
+    if (rendering.exchange(true))
+        return false;
+
+    progress = 0.0f;
+    pool.addJob(new RenderJob(*this, std::move(session), options), true);
+    return true;
+}
+
+void OfflineRenderer::cancel()
+{
+    // The job stops at its next batch and reports the cancellation through onFinished
+    pool.removeAllJobs(true, 0);
+}
+
+void OfflineRenderer::handleAsyncUpdate()
+{
+    juce::Result result = juce::Result::ok();
+    {
+        const juce::ScopedLock lock(resultLock);
+        if (!hasFinishedResult)
+            return;
+
+        result = finishedResult;
+        hasFinishedResult = false;
+    }
+
+    if (onFinished)
+        onFinished(result);
+}
+
+juce::File OfflineRenderer::getOutputFile(const Options& options, int stemIndex)
+{
+    const auto extension = options.fileFormat == FileFormat::Flac ? ".flac" : ".wav";
+    const auto name = stemIndex < 0 ? options.baseName : options.baseName + "_Stem" + juce::String(stemIndex + 1);
+    return options.outputDirectory.getChildFile(juce::File::createLegalFileName(name) + extension);
+}
+
+//==============================================================================
+juce::Result OfflineRenderer::render(const Session& session, const Options& options,
+                                     const std::function<bool()>& shouldExit,
+                                     const std::function<void(float)>& reportProgress)
+{
+    const int numStems = (int) session.stems.size();
+    const int numChannels = juce::jmax(1, session.numOutputChannels);
+
+    if (!options.includeMix && !options.includeStems)
+        return juce::Result::fail("Nothing to render: neither the mix nor the stems were selected");
+
+    if (numStems == 0 || session.sampleRate <= 0.0 || (int) session.stemParameters.size() != numStems)
+        return juce::Result::fail("Nothing to render: no stems are loaded");
+
+    // Playback loops at the end of the shortest stem, so that is where the timeline ends
+    juce::int64 length = -1;
+    for (const auto& stem : session.stems)
+        if (stem != nullptr && stem->getLengthInSamples() > 0)
+            length = length < 0 ? stem->getLengthInSamples() : juce::jmin(length, stem->getLengthInSamples());
+
+    if (length <= 0)
+        return juce::Result::fail("Nothing to render: the stems are empty");
+
+    // A streamed stem's read-ahead follows the audio thread, so the render streams the cache
+    // file through a reader of its own, a batch at a time, rather than loading the whole stem
+    std::vector<StemSourcePtr> sources;
+    for (int i = 0; i < numStems; ++i)
+    {
+        auto source = session.stems[(size_t) i];
+
+        if (auto* streamed = dynamic_cast<const StreamingStemSource*>(source.get()))
+        {
+            source = streamed->createFileReader();
+            if (source == nullptr)
+                return juce::Result::fail("Could not read stem " + juce::String(i + 1));
+        }
+
+        sources.push_back(std::move(source));
+    }
+
+    // Chains of their own, so playback carries on undisturbed
+    std::vector<std::unique_ptr<StemRenderer>> renderers;
+    for (int i = 0; i < numStems; ++i)
+    {
+        renderers.push_back(std::make_unique<StemRenderer>());
+        renderers.back()->prepare(session.sampleRate, blockSize);
+    }
+
+    // A private copy of the automation, walked exactly as the audio thread walks the live one
+    const int numParameters = (int) session.parameterValues.size();
+    auto parameterValues = session.parameterValues;
+
+    AutomationEngine automation;
+    automation.initialise(numParameters);
+    for (int i = 0; i < juce::jmin(numParameters, (int) session.automation.size()); ++i)
+        if (!session.automation[(size_t) i].empty())
+            automation.setLaneBreakpoints(i, session.automation[(size_t) i]);
+
+    auto readStemValues = [&](int stem)
+    {
+        auto values = StemRenderer::getDefaultValues();
+        const auto& indices = session.stemParameters[(size_t) stem];
+
+        for (int p = 0; p < StemRenderer::numParameters; ++p)
+            if (juce::isPositiveAndBelow(indices[(size_t) p], numParameters))
+                values[(size_t) p] = parameterValues[(size_t) indices[(size_t) p]];
+
+        return values;
+    };
+
+    // --- Output files ---
+    if (!options.outputDirectory.createDirectory().wasOk())
+        return juce::Result::fail("Could not create " + options.outputDirectory.getFullPathName());
+
+    juce::TimeSliceThread writerThread("Render Writer");
+    writerThread.startThread();
+
+    std::unique_ptr<OutputFile> mixFile;
+    std::vector<std::unique_ptr<OutputFile>> stemFiles;
+
+    auto deleteOutput = [&]
+    {
+        if (mixFile != nullptr)
+        {
+            mixFile->close();
+            mixFile->file.deleteFile();
+        }
+
+        for (auto& stemFile : stemFiles)
+        {
+            stemFile->close();
+            stemFile->file.deleteFile();
+        }
+    };
+
+    auto fail = [&](const juce::String& message)
+    {
+        deleteOutput();
+        writerThread.stopThread(1000);
+        return juce::Result::fail(message);
+    };
+
+    if (options.includeMix)
+    {
+        mixFile = std::make_unique<OutputFile>(getOutputFile(options, -1));
+        if (!mixFile->open(options, session.sampleRate, numChannels, writerThread))
+            return fail("Could not write " + mixFile->file.getFullPathName());
+    }
+
+    if (options.includeStems)
+    {
+        for (int i = 0; i < numStems; ++i)
+        {
+            stemFiles.push_back(std::make_unique<OutputFile>(getOutputFile(options, i)));
+            if (!stemFiles.back()->open(options, session.sampleRate, numChannels, writerThread))
+                return fail("Could not write " + stemFiles.back()->file.getFullPathName());
+        }
+    }
+
+    // --- Render ---
+    const int batchLength = blockSize * blocksPerBatch;
+    std::vector<juce::AudioBuffer<float>> stemOutputs((size_t) numStems);
+    std::vector<juce::AudioBuffer<float>> scratchBuffers((size_t) numStems);
+    for (int i = 0; i < numStems; ++i)
+    {
+        stemOutputs[(size_t) i].setSize(numChannels, batchLength);
+        scratchBuffers[(size_t) i].setSize(2, blockSize); // Chains are stereo, as in playback
+    }
+
+    juce::AudioBuffer<float> mix(numChannels, batchLength);
+    std::vector<SubBlock> subBlocks;
+
+    const int maxThreads = options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+    juce::ThreadPool workers(juce::jlimit(1, numStems, maxThreads));
+
+    for (juce::int64 batchStart = 0; batchStart < length; batchStart += batchLength)
+    {
+        if (shouldExit())
+            return fail("Cancelled");
+
+        const int batchSamples = (int) juce::jmin((juce::int64) batchLength, length - batchStart);
+
+        // Automation and solo state are walked once here; the stems only read the snapshots.
+        // Blocks are split at breakpoints exactly as processBlock splits them.
+        subBlocks.clear();
+        for (int blockStart = 0; blockStart < batchSamples; blockStart += blockSize)
+        {
+            const int blockSamples = juce::jmin(blockSize, batchSamples - blockStart);
+            automation.prepareBlock(batchStart + blockStart, blockSamples);
+            const auto* events = automation.getBlockEvents();
+            const int numEvents = automation.getNumBlockEvents();
+
+            int eventIndex = 0;
+            int subBlockStart = 0;
+
+            while (subBlockStart < blockSamples)
+            {
+                while (eventIndex < numEvents && events[eventIndex].sampleOffset <= subBlockStart)
+                {
+                    const auto& event = events[eventIndex++];
+                    if (juce::isPositiveAndBelow(event.parameterIndex, numParameters) && session.denormalise)
+                        parameterValues[(size_t) event.parameterIndex] = session.denormalise(event.parameterIndex, event.value);
+                }
+
+                int subBlockEnd = blockSamples;
+                if (eventIndex < numEvents)
+                    subBlockEnd = juce::jmin(subBlockEnd, events[eventIndex].sampleOffset);
+
+                SubBlock subBlock;
+                subBlock.start = blockStart + subBlockStart;
+                subBlock.length = subBlockEnd - subBlockStart;
+
+                for (int i = 0; i < numStems; ++i)
+                {
+                    subBlock.stemValues.push_back(readStemValues(i));
+                    subBlock.anySoloActive = subBlock.anySoloActive || StemRenderer::isSoloed(subBlock.stemValues.back());
+                }
+
+                subBlocks.push_back(std::move(subBlock));
+                subBlockStart = subBlockEnd;
+            }
+        }
+
+        // Every stem renders the batch on its own thread
+        std::atomic<int> stemsRemaining { numStems };
+        juce::WaitableEvent stemsFinished;
+
+        for (int i = 0; i < numStems; ++i)
+        {
+            workers.addJob([&, i]
+            {
+                auto& output = stemOutputs[(size_t) i];
+                auto& scratch = scratchBuffers[(size_t) i];
+                auto* source = sources[(size_t) i].get();
+                output.clear(0, batchSamples);
+
+                if (source != nullptr && source->getLengthInSamples() > 0)
+                {
+                    for (const auto& subBlock : subBlocks)
+                    {
+                        const auto& values = subBlock.stemValues[(size_t) i];
+                        if (!StemRenderer::isAudible(values, subBlock.anySoloActive))
+                            continue;
+
+                        source->read(scratch, 0, subBlock.length, batchStart + subBlock.start);
+                        renderers[(size_t) i]->process(scratch, subBlock.length, values);
+
+                        const float gain = StemRenderer::getOutputGain(values);
+                        for (int ch = 0; ch < numChannels; ++ch)
+                            output.addFrom(ch, subBlock.start, scratch, juce::jmin(ch, 1), 0, subBlock.length, gain);
+                    }
+                }
+
+                if (--stemsRemaining == 0)
+                    stemsFinished.signal();
+            });
+        }
+
+        stemsFinished.wait(-1);
+
+        // Summed in stem order, as the audio thread sums them, so the result is bit-identical
+        if (mixFile != nullptr)
+        {
+            mix.clear();
+            for (const auto& output : stemOutputs)
+                for (int ch = 0; ch < numChannels; ++ch)
+                    mix.addFrom(ch, 0, output, ch, 0, batchSamples);
+
+            if (!mixFile->write(mix, batchSamples, shouldExit))
+                return fail("Cancelled");
+        }
+
+        for (int i = 0; i < (int) stemFiles.size(); ++i)
+            if (!stemFiles[(size_t) i]->write(stemOutputs[(size_t) i], batchSamples, shouldExit))
+                return fail("Cancelled");
+
+        reportProgress((float) (batchStart + batchSamples) / (float) length);
+    }
+
+    // Closing flushes what is still queued and finishes each file
+    mixFile.reset();
+    stemFiles.clear();
+    writerThread.stopThread(1000);
+    return juce::Result::ok();
+}
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,138 @@
+#include "undergroundBeats/audio/ParallelAudioDecoder.h"
+#include <atomic>
+
+namespace undergroundBeats {
+namespace audio {
+
+namespace {
+
+// Shared by the workers of one decode; outlives them
+struct DecodeState
+{
+    std::atomic<bool> stop { false };
+    std::atomic<bool> failed { false };
+    std::atomic<juce::int64> samplesDecoded { 0 };
+    juce::WaitableEvent segmentFinished;
+};
+
+// Decodes [start, end) of a reader into the same range of the destination, in chunks
+void decodeRange(juce::AudioFormatReader& reader, juce::AudioBuffer<float>& destination,
+                 int start, int end, DecodeState& state)
+{
+    for (int position = start; position < end && !state.stop.load(); position += ParallelAudioDecoder::chunkSize)
+    {
+        const int count = juce::jmin(ParallelAudioDecoder::chunkSize, end - position);
+        reader.read(&destination, position, count, position, true, true);
+        state.samplesDecoded += count;
+    }
+}
+
+class SegmentJob : public juce::ThreadPoolJob
+{
+public:
+    SegmentJob(const juce::File& fileToDecode, juce::AudioFormatManager& formats,
+               juce::AudioBuffer<float>& destinationBuffer, int segmentStart, int segmentEnd, DecodeState& decodeState)
+        : juce::ThreadPoolJob("DecodeSegment"), file(fileToDecode), formatManager(formats),
+          destination(destinationBuffer), start(segmentStart), end(segmentEnd), state(decodeState)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        decodeSegment();
+        state.segmentFinished.signal();
+        return jobHasFinished;
+    }
+
+private:
+    void decodeSegment()
+    {
+        // Readers keep decoder state, so every segment needs its own
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr)
+        {
+            state.failed = true;
+            state.stop = true;
+            return;
+        }
+
+        // Warm the decoder up on the samples before the segment; the result is discarded
+        if (start > 0)
+        {
+            const int preroll = juce::jmin(ParallelAudioDecoder::prerollSamples, start);
+            juce::AudioBuffer<float> discard(destination.getNumChannels(), preroll);
+            reader->read(&discard, 0, preroll, start - preroll, true, true);
+        }
+
+        decodeRange(*reader, destination, start, end, state);
+    }
+
+    const juce::File file;
+    juce::AudioFormatManager& formatManager;
+    juce::AudioBuffer<float>& destination;
+    const int start;
+    const int end;
+    DecodeState& state;
+};
+
+} // namespace
+
+//==============================================================================
+bool ParallelAudioDecoder::decode(const juce::File& file, juce::AudioFormatManager& formatManager,
+                                  juce::AudioBuffer<float>& destination, int numThreads,
+                                  const std::function<bool()>& shouldExit,
+                                  const std::function<void(float)>& reportProgress)
+{
+    const int length = destination.getNumSamples();
+    const int maxThreads = numThreads > 0 ? numThreads : juce::SystemStats::getNumCpus();
+    const int numSegments = juce::jlimit(1, juce::jmax(1, maxThreads), length / minSamplesPerSegment);
+
+    DecodeState state;
+
+    if (shouldExit())
+        return false;
+
+    if (numSegments == 1)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr)
+            return false;
+
+        for (int start = 0; start < length; start += chunkSize)
+        {
+            if (shouldExit())
+                return false;
+
+            decodeRange(*reader, destination, start, juce::jmin(start + chunkSize, length), state);
+            reportProgress((float) state.samplesDecoded.load() / (float) length);
+        }
+
+        return true;
+    }
+
+    // Equal segments, rounded up so every start but the first falls on a frame boundary
+    const int segmentLength = ((length + numSegments - 1) / numSegments + segmentAlignment - 1)
+                              / segmentAlignment * segmentAlignment;
+
+    juce::ThreadPool pool(numSegments);
+
+    for (int start = 0; start < length; start += segmentLength)
+        pool.addJob(new SegmentJob(file, formatManager, destination, start,
+                                   juce::jmin(start + segmentLength, length), state), true);
+
+    // The workers never touch shouldExit or reportProgress; this thread relays both
+    while (pool.getNumJobs() > 0)
+    {
+        state.segmentFinished.wait(20);
+
+        if (!state.stop.load() && shouldExit())
+            state.stop = true;
+
+        reportProgress((float) state.samplesDecoded.load() / (float) length);
+    }
+
+    return !state.stop.load() && !state.failed.load();
+}
+
+} // namespace audio
+} // namespace undergroundBeats
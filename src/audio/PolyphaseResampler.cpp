@@ -0,0 +1,190 @@
+#include "undergroundBeats/audio/PolyphaseResampler.h"
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace undergroundBeats {
+namespace audio {
+
+namespace {
+
+// Stopband attenuation of roughly 90 dB
+constexpr double kaiserBeta = 9.0;
+
+// Passband edge as a fraction of the lower Nyquist frequency
+constexpr double rolloff = 0.95;
+
+// Longest filter used when downsampling by a large factor, in multiples of tapsPerPhase
+constexpr int maxLengthening = 8;
+
+double besselI0(double x)
+{
+    const double quarterSquare = x * x * 0.25;
+    double sum = 1.0;
+    double term = 1.0;
+
+    for (int k = 1; k < 64; ++k)
+    {
+        term *= quarterSquare / ((double) k * (double) k);
+        sum += term;
+
+        if (term < sum * 1.0e-12)
+            break;
+    }
+
+    return sum;
+}
+
+// Best ratio up/down for targetOverSource whose numerator fits the filter bank, by continued fractions
+void approximateRatio(double targetOverSource, int maxUp, int& up, int& down)
+{
+    juce::int64 upPrevious = 0, upCurrent = 1;
+    juce::int64 downPrevious = 1, downCurrent = 0;
+    double remainder = targetOverSource;
+
+    for (int term = 0; term < 32; ++term)
+    {
+        const auto whole = (juce::int64) std::floor(remainder);
+        const auto upNext = whole * upCurrent + upPrevious;
+        const auto downNext = whole * downCurrent + downPrevious;
+
+        if (upNext > maxUp)
+            break;
+
+        upPrevious = std::exchange(upCurrent, upNext);
+        downPrevious = std::exchange(downCurrent, downNext);
+
+        const double fraction = remainder - (double) whole;
+        if (fraction < 1.0e-12)
+            break;
+
+        remainder = 1.0 / fraction;
+    }
+
+    up = (int) juce::jmax((juce::int64) 1, upCurrent);
+    down = (int) juce::jmax((juce::int64) 1, downCurrent);
+}
+
+// Four independent sums, so the loop maps onto one SSE/NEON register
+inline float dotProduct(const float* a, const float* b, int length)
+{
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+
+    for (int i = 0; i < length; i += 4)
+    {
+        sum0 += a[i] * b[i];
+        sum1 += a[i + 1] * b[i + 1];
+        sum2 += a[i + 2] * b[i + 2];
+        sum3 += a[i + 3] * b[i + 3];
+    }
+
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+} // namespace
+
+//==============================================================================
+PolyphaseResampler::PolyphaseResampler(double sourceRate, double targetRate, int tapsPerPhase)
+{
+    const int sourceHz = juce::jmax(1, juce::roundToInt(sourceRate));
+    const int targetHz = juce::jmax(1, juce::roundToInt(targetRate));
+    const int divisor = std::gcd(sourceHz, targetHz);
+
+    upFactor = targetHz / divisor;
+    downFactor = sourceHz / divisor;
+
+    if (upFactor > maxPhases)
+        approximateRatio((double) targetHz / (double) sourceHz, maxPhases, upFactor, downFactor);
+
+    // When downsampling the cutoff follows the output rate down, so the filter grows
+    // to keep the same transition width; taps stays a multiple of the dot product's lanes
+    const int lengthening = juce::jlimit(1, maxLengthening, (downFactor + upFactor - 1) / upFactor);
+    taps = ((juce::jmax(4, tapsPerPhase) * lengthening + 3) / 4) * 4;
+
+    // The prototype runs at the upsampled rate and is centred on an exact sample, so the
+    // output lines up with the input without a fractional delay
+    const int length = taps * upFactor;
+    centreDelay = length / 2;
+
+    const double cutoff = rolloff * 0.5 / (double) juce::jmax(upFactor, downFactor);
+    const double windowNorm = 1.0 / besselI0(kaiserBeta);
+
+    std::vector<double> prototype((size_t) length);
+    for (int n = 0; n < length; ++n)
+    {
+        const double offset = (double) (n - centreDelay);
+        const double x = 2.0 * cutoff * offset;
+        const double sinc = offset == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x)
+                                                      / (juce::MathConstants<double>::pi * x);
+        const double position = offset / (double) centreDelay;
+        const double window = besselI0(kaiserBeta * std::sqrt(juce::jmax(0.0, 1.0 - position * position))) * windowNorm;
+
+        prototype[(size_t) n] = sinc * window;
+    }
+
+    // Split into phases, reversed so each row runs forward over the input; every row is
+    // normalised to unity gain at DC, which also undoes the zero-stuffing loss
+    phases.resize((size_t) length);
+    for (int phase = 0; phase < upFactor; ++phase)
+    {
+        auto* row = phases.data() + (size_t) phase * (size_t) taps;
+        double sum = 0.0;
+
+        for (int i = 0; i < taps; ++i)
+            sum += prototype[(size_t) (phase + (taps - 1 - i) * upFactor)];
+
+        const double gain = std::abs(sum) > 1.0e-9 ? 1.0 / sum : 0.0;
+        for (int i = 0; i < taps; ++i)
+            row[i] = (float) (prototype[(size_t) (phase + (taps - 1 - i) * upFactor)] * gain);
+    }
+}
+
+int PolyphaseResampler::getOutputLength(int inputLength) const
+{
+    return (int) (((juce::int64) inputLength * upFactor + downFactor - 1) / downFactor);
+}
+
+juce::AudioBuffer<float> PolyphaseResampler::process(const juce::AudioBuffer<float>& input) const
+{
+    const int inputLength = input.getNumSamples();
+    const int outputLength = getOutputLength(inputLength);
+    juce::AudioBuffer<float> output(input.getNumChannels(), outputLength);
+
+    std::vector<float> padded;
+    for (int ch = 0; ch < input.getNumChannels(); ++ch)
+        processChannel(input.getReadPointer(ch), inputLength, output.getWritePointer(ch), outputLength, padded);
+
+    return output;
+}
+
+void PolyphaseResampler::processChannel(const float* input, int inputLength, float* output, int outputLength,
+                                        std::vector<float>& padded) const
+{
+    // Silence on both sides lets every output sample read a full row of input
+    padded.assign((size_t) inputLength + 2 * (size_t) taps, 0.0f);
+    std::copy(input, input + inputLength, padded.begin() + taps);
+
+    // The row for an output sample starts at input sample base - taps + 1, which is padded index base + 1
+    const float* paddedStart = padded.data() + 1;
+
+    for (int j = 0; j < outputLength; ++j)
+    {
+        const juce::int64 upsampledIndex = (juce::int64) j * downFactor + centreDelay;
+        const auto base = upsampledIndex / upFactor;
+        const auto phase = (int) (upsampledIndex - base * upFactor);
+
+        output[j] = dotProduct(phases.data() + (size_t) phase * (size_t) taps, paddedStart + base, taps);
+    }
+}
+
+SharedAudio PolyphaseResampler::resample(const SharedAudio& input, double sourceRate, double targetRate)
+{
+    if (!input.isValid() || sourceRate <= 0.0 || targetRate <= 0.0
+        || juce::roundToInt(sourceRate) == juce::roundToInt(targetRate))
+        return input;
+
+    return SharedAudio(PolyphaseResampler(sourceRate, targetRate).process(*input));
+}
+
+} // namespace audio
+} // namespace undergroundBeats
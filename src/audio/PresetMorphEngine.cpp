@@ -0,0 +1,179 @@
+#include "undergroundBeats/audio/PresetMorphEngine.h"
+
+namespace undergroundBeats {
+namespace audio {
+
+PresetMorphEngine::PresetMorphEngine() = default;
+
+PresetMorphEngine::~PresetMorphEngine() = default;
+
+void PresetMorphEngine::initialise(const std::vector<bool>& discreteFlags, int excludedParameter)
+{
+    const juce::SpinLock::ScopedLockType lock(morphLock);
+
+    numParameters = static_cast<int>(discreteFlags.size());
+    excluded = excludedParameter;
+    discrete = discreteFlags;
+
+    slots.assign(numSlots, std::vector<float>(static_cast<size_t>(numParameters), 0.0f));
+    slotFilled.assign(numSlots, false);
+
+    // Worst case every parameter differs; reserving now keeps rebuilds and process() allocation-free
+    differences.clear();
+    differences.reserve(static_cast<size_t>(numParameters));
+    changes.resize(static_cast<size_t>(numParameters));
+    lastAmount = -1.0f;
+}
+
+//==============================================================================
+void PresetMorphEngine::storeSnapshot(int slot, const std::vector<float>& values)
+{
+    if (!juce::isPositiveAndBelow(slot, numSlots) || static_cast<int>(values.size()) != numParameters)
+        return;
+
+    const juce::SpinLock::ScopedLockType lock(morphLock);
+    std::copy(values.begin(), values.end(), slots[static_cast<size_t>(slot)].begin());
+    slotFilled[static_cast<size_t>(slot)] = true;
+
+    if (slot == slotA || slot == slotB)
+        rebuildDifferences();
+}
+
+void PresetMorphEngine::clearSnapshot(int slot)
+{
+    if (!juce::isPositiveAndBelow(slot, numSlots))
+        return;
+
+    const juce::SpinLock::ScopedLockType lock(morphLock);
+    slotFilled[static_cast<size_t>(slot)] = false;
+
+    if (slot == slotA || slot == slotB)
+        rebuildDifferences();
+}
+
+bool PresetMorphEngine::hasSnapshot(int slot) const
+{
+    if (!juce::isPositiveAndBelow(slot, numSlots))
+        return false;
+
+    const juce::SpinLock::ScopedLockType lock(morphLock);
+    return slotFilled[static_cast<size_t>(slot)];
+}
+
+std::vector<float> PresetMorphEngine::getSnapshot(int slot) const
+{
+    if (!hasSnapshot(slot))
+        return {};
+
+    const juce::SpinLock::ScopedLockType lock(morphLock);
+    return slots[static_cast<size_t>(slot)];
+}
+
+void PresetMorphEngine::setMorphPair(int newSlotA, int newSlotB)
+{
+    if (!juce::isPositiveAndBelow(newSlotA, numSlots) || !juce::isPositiveAndBelow(newSlotB, numSlots))
+        return;
+
+    const juce::SpinLock::ScopedLockType lock(morphLock);
+    slotA = newSlotA;
+    slotB = newSlotB;
+    rebuildDifferences();
+}
+
+void PresetMorphEngine::rebuildDifferences()
+{
+    // Called with morphLock held; capacity was reserved in initialise()
+    differences.clear();
+    differencesChanged = true;
+
+    if (slots.empty() || !slotFilled[static_cast<size_t>(slotA)] || !slotFilled[static_cast<size_t>(slotB)])
+        return;
+
+    const auto& a = slots[static_cast<size_t>(slotA)];
+    const auto& b = slots[static_cast<size_t>(slotB)];
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        if (i == excluded || a[static_cast<size_t>(i)] == b[static_cast<size_t>(i)])
+            continue;
+
+        differences.push_back({ i, a[static_cast<size_t>(i)], b[static_cast<size_t>(i)], discrete[static_cast<size_t>(i)] });
+    }
+}
+
+std::unique_ptr<juce::XmlElement> PresetMorphEngine::createXml() const
+{
+    auto xml = std::make_unique<juce::XmlElement>("MORPH");
+    const juce::SpinLock::ScopedLockType lock(morphLock);
+
+    xml->setAttribute("slotA", slotA);
+    xml->setAttribute("slotB", slotB);
+
+    for (int slot = 0; slot < static_cast<int>(slots.size()); ++slot)
+    {
+        if (!slotFilled[static_cast<size_t>(slot)])
+            continue;
+
+        const auto& values = slots[static_cast<size_t>(slot)];
+        juce::MemoryBlock data(values.data(), values.size() * sizeof(float));
+
+        auto* slotXml = xml->createNewChildElement("SNAPSHOT");
+        slotXml->setAttribute("slot", slot);
+        slotXml->setAttribute("data", data.toBase64Encoding());
+    }
+
+    return xml;
+}
+
+void PresetMorphEngine::restoreFromXml(const juce::XmlElement& xml)
+{
+    for (int slot = 0; slot < numSlots; ++slot)
+        clearSnapshot(slot);
+
+    for (auto* slotXml : xml.getChildWithTagNameIterator("SNAPSHOT"))
+    {
+        juce::MemoryBlock data;
+        if (!data.fromBase64Encoding(slotXml->getStringAttribute("data")))
+            continue;
+
+        // Snapshots saved with a different parameter count are ignored
+        if (data.getSize() != static_cast<size_t>(numParameters) * sizeof(float))
+            continue;
+
+        const auto* first = static_cast<const float*>(data.getData());
+        storeSnapshot(slotXml->getIntAttribute("slot", -1), std::vector<float>(first, first + numParameters));
+    }
+
+    setMorphPair(xml.getIntAttribute("slotA", 0), xml.getIntAttribute("slotB", 1));
+}
+
+//==============================================================================
+int PresetMorphEngine::process(float morphAmount)
+{
+    const juce::SpinLock::ScopedTryLockType lock(morphLock);
+    if (!lock.isLocked())
+        return 0;
+
+    morphAmount = juce::jlimit(0.0f, 1.0f, morphAmount);
+    if (morphAmount == lastAmount && !differencesChanged)
+        return 0;
+
+    lastAmount = morphAmount;
+    differencesChanged = false;
+
+    const bool switchedToB = morphAmount >= switchThreshold;
+    int numChanges = 0;
+
+    for (const auto& difference : differences)
+    {
+        auto& change = changes[static_cast<size_t>(numChanges++)];
+        change.parameterIndex = difference.parameterIndex;
+        change.value = difference.discrete ? (switchedToB ? difference.valueB : difference.valueA)
+                                           : difference.valueA + (difference.valueB - difference.valueA) * morphAmount;
+    }
+
+    return numChanges;
+}
+
+} // namespace audio
+} // namespace undergroundBeats
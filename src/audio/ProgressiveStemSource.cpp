@@ -0,0 +1,280 @@
+#include "undergroundBeats/audio/ProgressiveStemSource.h"
+#include "undergroundBeats/audio/PolyphaseResampler.h"
+#include <cmath>
+
+namespace undergroundBeats {
+namespace audio {
+
+ProgressiveSeparation::ProgressiveSeparation(SharedAudio mixToPlay, int numStems, int samplesPerSegment,
+                                             double rateOfMix, double rateOfPlayback)
+    : mix(std::move(mixToPlay)),
+      segmentLength(juce::jmax(1, samplesPerSegment)),
+      numSegments(juce::jmax(1, (mix->getNumSamples() + segmentLength - 1) / segmentLength)),
+      mixRate(rateOfMix),
+      playbackRate(rateOfPlayback),
+      resampled(rateOfMix > 0.0 && rateOfPlayback > 0.0 && juce::roundToInt(rateOfMix) != juce::roundToInt(rateOfPlayback)),
+      step(resampled ? rateOfMix / rateOfPlayback : 1.0),
+      playbackLength(resampled ? (juce::int64) std::floor((double) mix->getNumSamples() / step) : mix->getNumSamples()),
+      finished(new std::atomic<bool>[(size_t) numSegments])
+{
+    jassert(mix.isValid());
+
+    for (int i = 0; i < numSegments; ++i)
+        finished[(size_t) i].store(false);
+
+    for (int i = 0; i < numStems; ++i)
+    {
+        juce::AudioBuffer<float> stem(mix->getNumChannels(), mix->getNumSamples());
+        stem.clear();
+
+        // Marks the buffer as holding data before it is shared; readers never change it again
+        stem.getArrayOfWritePointers();
+        stems.emplace_back(std::move(stem));
+    }
+}
+
+std::vector<StemSourcePtr> ProgressiveSeparation::createSources(const std::shared_ptr<ProgressiveSeparation>& separation)
+{
+    std::vector<StemSourcePtr> sources;
+    for (int i = 0; i < separation->getNumStems(); ++i)
+        sources.push_back(std::make_shared<ProgressiveStemSource>(separation, i));
+
+    return sources;
+}
+
+std::vector<juce::AudioBuffer<float>> ProgressiveSeparation::getWriteViews()
+{
+    std::vector<juce::AudioBuffer<float>> views;
+
+    // The stems are shared with the sources, so the separator writes through the channel
+    // pointers rather than SharedAudio::write(), which would copy them
+    for (const auto& stem : stems)
+        views.emplace_back(const_cast<float* const*>(stem->getArrayOfReadPointers()),
+                           stem->getNumChannels(), stem->getNumSamples());
+
+    return views;
+}
+
+void ProgressiveSeparation::markSegmentFinished(int segment)
+{
+    jassert(juce::isPositiveAndBelow(segment, numSegments));
+
+    // Release: the samples written to the segment are visible to whoever sees the flag
+    if (!finished[(size_t) segment].exchange(true, std::memory_order_acq_rel))
+        numFinished.fetch_add(1, std::memory_order_release);
+}
+
+int ProgressiveSeparation::getSegment(juce::int64 position) const
+{
+    return (int) juce::jlimit((juce::int64) 0, (juce::int64) numSegments - 1, position / segmentLength);
+}
+
+juce::int64 ProgressiveSeparation::getSegmentEnd(int segment) const
+{
+    if (segment >= numSegments - 1)
+        return mix->getNumSamples();
+
+    return (juce::int64) (segment + 1) * segmentLength;
+}
+
+//==============================================================================
+ProgressiveStemSource::ProgressiveStemSource(std::shared_ptr<ProgressiveSeparation> separationToPlay, int index)
+    : separation(std::move(separationToPlay)), stemIndex(index),
+      mixGain(1.0f / (float) juce::jmax(1, separation->getNumStems())),
+      drawnSegments((size_t) separation->getNumSegments(), false)
+{
+    // Until its segments finish, the overview shows the stem's share of the mix
+    const auto& mix = *separation->getMix();
+    overview.setSize(mix.getNumChannels(), (mix.getNumSamples() + overviewDecimation - 1) / overviewDecimation);
+    drawOverview(0, mix.getNumSamples());
+}
+
+int ProgressiveStemSource::getNumChannels() const
+{
+    return separation->getMix()->getNumChannels();
+}
+
+juce::int64 ProgressiveStemSource::getLengthInSamples() const
+{
+    return separation->getPlaybackLength();
+}
+
+bool ProgressiveStemSource::read(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+                                 juce::int64 sourceStartSample)
+{
+    separation->notePlaybackPosition(sourceStartSample);
+
+    const auto& stem = *separation->getStems()[(size_t) stemIndex];
+    const auto& mix = *separation->getMix();
+    const auto length = getLengthInSamples();
+
+    // Outside the track there is nothing to play
+    if (sourceStartSample < 0 || sourceStartSample + numSamples > length)
+    {
+        const auto first = juce::jlimit((juce::int64) 0, (juce::int64) numSamples, -sourceStartSample);
+        const auto last = juce::jlimit((juce::int64) 0, (juce::int64) numSamples, length - sourceStartSample);
+
+        destination.clear(destStartSample, (int) first);
+        destination.clear(destStartSample + (int) juce::jmax(first, last), numSamples - (int) juce::jmax(first, last));
+
+        if (last > first)
+            read(destination, destStartSample + (int) first, (int) (last - first), sourceStartSample + first);
+
+        return false;
+    }
+
+    if (separation->isResampled())
+        return readResampled(destination, destStartSample, numSamples, sourceStartSample);
+
+    // Segment by segment: the stem where it is finished, its share of the mix elsewhere
+    for (int done = 0; done < numSamples;)
+    {
+        const auto position = sourceStartSample + done;
+        const int segment = separation->getSegment(position);
+        const int run = (int) juce::jmin((juce::int64) (numSamples - done), separation->getSegmentEnd(segment) - position);
+
+        if (separation->isSegmentFinished(segment))
+        {
+            copyStemSamples(stem, position, destination, destStartSample + done, run);
+        }
+        else
+        {
+            copyStemSamples(mix, position, destination, destStartSample + done, run);
+            destination.applyGain(destStartSample + done, run, mixGain);
+        }
+
+        done += run;
+    }
+
+    return true;
+}
+
+bool ProgressiveStemSource::readResampled(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+                                         juce::int64 sourceStartSample)
+{
+    const auto& stem = *separation->getStems()[(size_t) stemIndex];
+    const auto& mix = *separation->getMix();
+    const int mixLength = mix.getNumSamples();
+    const int mixChannels = mix.getNumChannels();
+    const double step = separation->getStep();
+
+    // A read touches a segment or two; its state is looked up once per segment it meets
+    int lastSegment = -1;
+    bool lastFinished = false;
+
+    const auto sampleAt = [&](int channel, juce::int64 position)
+    {
+        const int index = (int) juce::jlimit((juce::int64) 0, (juce::int64) mixLength - 1, position);
+        const int segment = separation->getSegment(index);
+
+        if (segment != lastSegment)
+        {
+            lastSegment = segment;
+            lastFinished = separation->isSegmentFinished(segment);
+        }
+
+        return lastFinished ? stem.getSample(channel, index) : mix.getSample(channel, index) * mixGain;
+    };
+
+    for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+    {
+        const int channel = juce::jmin(ch, mixChannels - 1);
+        auto* dest = destination.getWritePointer(ch, destStartSample);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double position = (double) (sourceStartSample + i) * step;
+            const auto index = (juce::int64) position;
+            const auto t = (float) (position - (double) index);
+
+            const float y0 = sampleAt(channel, index - 1);
+            const float y1 = sampleAt(channel, index);
+            const float y2 = sampleAt(channel, index + 1);
+            const float y3 = sampleAt(channel, index + 2);
+
+            dest[i] = y0 * (-t * (t - 1.0f) * (t - 2.0f) / 6.0f)
+                    + y1 * ((t + 1.0f) * (t - 1.0f) * (t - 2.0f) / 2.0f)
+                    + y2 * (-(t + 1.0f) * t * (t - 2.0f) / 2.0f)
+                    + y3 * ((t + 1.0f) * t * (t - 1.0f) / 6.0f);
+        }
+    }
+
+    return true;
+}
+
+const juce::AudioBuffer<float>* ProgressiveStemSource::getDisplayBuffer() const
+{
+    for (int segment = 0; segment < separation->getNumSegments(); ++segment)
+    {
+        // Acquire: the separator's writes to a finished segment are visible from here on
+        if (drawnSegments[(size_t) segment] || !separation->isSegmentFinished(segment))
+            continue;
+
+        drawnSegments[(size_t) segment] = true;
+        drawOverview(segment > 0 ? separation->getSegmentEnd(segment - 1) : 0, separation->getSegmentEnd(segment));
+    }
+
+    return &overview;
+}
+
+void ProgressiveStemSource::drawOverview(juce::int64 startSample, juce::int64 endSample) const
+{
+    const auto& stem = *separation->getStems()[(size_t) stemIndex];
+    const auto& mix = *separation->getMix();
+    const int length = mix.getNumSamples();
+
+    // Every point touching the range is redrawn whole; a point can straddle two segments
+    const int firstPoint = (int) (startSample / overviewDecimation);
+    const int endPoint = (int) juce::jmin((juce::int64) overview.getNumSamples(),
+                                          (endSample + overviewDecimation - 1) / overviewDecimation);
+
+    for (int ch = 0; ch < overview.getNumChannels(); ++ch)
+    {
+        auto* points = overview.getWritePointer(ch);
+
+        for (int point = firstPoint; point < endPoint; ++point)
+        {
+            const int end = juce::jmin(length, (point + 1) * overviewDecimation);
+            float loudest = 0.0f;
+
+            for (int i = point * overviewDecimation; i < end;)
+            {
+                const int segment = separation->getSegment(i);
+                const int runEnd = (int) juce::jmin((juce::int64) end, separation->getSegmentEnd(segment));
+                const bool drawn = drawnSegments[(size_t) segment];
+                const float* samples = drawn ? stem.getReadPointer(ch) : mix.getReadPointer(ch);
+                const float gain = drawn ? 1.0f : mixGain;
+
+                for (; i < runEnd; ++i)
+                    if (std::abs(samples[i] * gain) > std::abs(loudest))
+                        loudest = samples[i] * gain;
+            }
+
+            points[point] = loudest;
+        }
+    }
+}
+
+size_t ProgressiveStemSource::getResidentBytes() const
+{
+    return separation->getStems()[(size_t) stemIndex].getSizeInBytes()
+           + (size_t) overview.getNumChannels() * (size_t) overview.getNumSamples() * sizeof(float);
+}
+
+SharedAudio ProgressiveStemSource::readEntireStem() const
+{
+    if (!separation->isComplete())
+        return {};
+
+    const auto& stem = separation->getStems()[(size_t) stemIndex];
+    if (!separation->isResampled())
+        return stem;
+
+    auto converted = PolyphaseResampler::resample(stem, separation->getMixRate(), separation->getPlaybackRate());
+    auto& buffer = converted.write();
+    buffer.setSize(buffer.getNumChannels(), (int) separation->getPlaybackLength(), true, true);
+    return converted;
+}
+
+} // namespace audio
+} // namespace undergroundBeats
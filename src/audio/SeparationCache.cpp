@@ -0,0 +1,301 @@
+#include "undergroundBeats/audio/SeparationCache.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace undergroundBeats {
+namespace audio {
+
+namespace {
+
+constexpr int formatVersion = 1;
+constexpr int headerSize = 64;
+constexpr juce::uint32 pcmMagic = 0x43504255; // "UBPC"
+constexpr int maxChannels = 64;
+
+const char* const manifestName = "entry.xml";
+const char* const partialSuffix = ".part";
+
+juce::File getMixFile(const juce::File& entryDirectory) { return entryDirectory.getChildFile("mix.pcm"); }
+
+juce::File getStemFile(const juce::File& entryDirectory, int index)
+{
+    return entryDirectory.getChildFile("stem_" + juce::String(index) + ".pcm");
+}
+
+// FNV-1a over 64-bit words; fast enough to check hundreds of megabytes on every read
+juce::uint64 updateChecksum(juce::uint64 hash, const void* data, size_t numBytes)
+{
+    constexpr juce::uint64 prime = 1099511628211ull;
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+    size_t i = 0;
+
+    for (; i + 8 <= numBytes; i += 8)
+    {
+        juce::uint64 word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+
+    for (; i < numBytes; ++i)
+        hash = (hash ^ bytes[i]) * prime;
+
+    return hash;
+}
+
+juce::uint64 checksumChannels(const float* const* channels, int numChannels, juce::int64 numSamples)
+{
+    juce::uint64 hash = 14695981039346656037ull;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        hash = updateChecksum(hash, channels[ch], (size_t) numSamples * sizeof(float));
+
+    return hash;
+}
+
+juce::int64 getDirectorySize(const juce::File& directory)
+{
+    juce::int64 size = 0;
+    for (const auto& file : directory.findChildFiles(juce::File::findFiles, false))
+        size += file.getSize();
+    return size;
+}
+
+} // namespace
+
+//==============================================================================
+SeparationCache::SeparationCache(const juce::File& cacheDirectory, juce::int64 maxSizeBytes)
+    : directory(cacheDirectory), maxSize(maxSizeBytes)
+{
+}
+
+juce::String SeparationCache::makeKey(const juce::File& sourceFile, const juce::String& modelIdentity, double sampleRate)
+{
+    const auto contentHash = juce::SHA256(sourceFile).toHexString();
+    const auto description = contentHash + "|" + modelIdentity + "|" + juce::String(juce::roundToInt(sampleRate));
+    return juce::SHA256(description.toUTF8()).toHexString();
+}
+
+std::optional<SeparationCache::Entry> SeparationCache::lookup(const juce::String& key)
+{
+    const juce::ScopedLock sl(lock);
+
+    const auto entryDirectory = directory.getChildFile(key);
+    if (!entryDirectory.isDirectory())
+        return std::nullopt;
+
+    const auto manifestFile = entryDirectory.getChildFile(manifestName);
+    auto manifest = juce::parseXML(manifestFile);
+
+    Entry entry;
+    bool intact = manifest != nullptr && manifest->hasTagName("SEPARATION_CACHE_ENTRY")
+                  && manifest->getIntAttribute("version") == formatVersion;
+
+    if (intact)
+    {
+        entry.modelVariant = manifest->getStringAttribute("variant");
+        entry.mix = readPcmFile(getMixFile(entryDirectory), entry.sampleRate);
+        intact = entry.mix.isValid();
+
+        const int numStems = manifest->getIntAttribute("stems");
+        for (int i = 0; i < numStems && intact; ++i)
+        {
+            double stemRate = 0.0;
+            entry.stems.push_back(readPcmFile(getStemFile(entryDirectory, i), stemRate));
+            intact = entry.stems.back().isValid() && stemRate == entry.sampleRate;
+        }
+
+        intact = intact && numStems > 0;
+    }
+
+    if (!intact)
+    {
+        DBG("SeparationCache: Discarding damaged entry " + key);
+        entryDirectory.deleteRecursively();
+        return std::nullopt;
+    }
+
+    // The manifest's time is the entry's last use
+    manifestFile.setLastModificationTime(juce::Time::getCurrentTime());
+    return entry;
+}
+
+bool SeparationCache::contains(const juce::String& key) const
+{
+    const juce::ScopedLock sl(lock);
+    return directory.getChildFile(key).getChildFile(manifestName).existsAsFile();
+}
+
+bool SeparationCache::store(const juce::String& key, const Entry& entry)
+{
+    if (!entry.mix.isValid() || entry.stems.empty())
+        return false;
+
+    const juce::ScopedLock sl(lock);
+
+    // Written under another name and renamed, so a crash never leaves a readable half entry
+    const auto partial = directory.getChildFile(key + partialSuffix);
+    partial.deleteRecursively();
+
+    bool written = partial.createDirectory().wasOk()
+                   && writePcmFile(getMixFile(partial), *entry.mix, entry.sampleRate);
+
+    for (size_t i = 0; i < entry.stems.size() && written; ++i)
+        written = entry.stems[i].isValid() && writePcmFile(getStemFile(partial, (int) i), *entry.stems[i], entry.sampleRate);
+
+    if (written)
+    {
+        juce::XmlElement manifest("SEPARATION_CACHE_ENTRY");
+        manifest.setAttribute("version", formatVersion);
+        manifest.setAttribute("stems", (int) entry.stems.size());
+        manifest.setAttribute("sampleRate", entry.sampleRate);
+        manifest.setAttribute("variant", entry.modelVariant);
+        written = manifest.writeTo(partial.getChildFile(manifestName));
+    }
+
+    const auto entryDirectory = directory.getChildFile(key);
+    entryDirectory.deleteRecursively();
+
+    if (!written || !partial.moveFileTo(entryDirectory))
+    {
+        partial.deleteRecursively();
+        return false;
+    }
+
+    trimToSize();
+    return true;
+}
+
+void SeparationCache::setMaxSize(juce::int64 maxSizeBytes)
+{
+    const juce::ScopedLock sl(lock);
+    maxSize = maxSizeBytes;
+    trimToSize();
+}
+
+juce::int64 SeparationCache::getSizeOnDisk() const
+{
+    const juce::ScopedLock sl(lock);
+
+    juce::int64 total = 0;
+    for (const auto& entryDirectory : directory.findChildFiles(juce::File::findDirectories, false))
+        total += getDirectorySize(entryDirectory);
+
+    return total;
+}
+
+void SeparationCache::clear()
+{
+    const juce::ScopedLock sl(lock);
+
+    for (const auto& entryDirectory : directory.findChildFiles(juce::File::findDirectories, false))
+        entryDirectory.deleteRecursively();
+}
+
+void SeparationCache::trimToSize()
+{
+    struct StoredEntry
+    {
+        juce::File directory;
+        juce::Time lastUsed;
+        juce::int64 size;
+    };
+
+    std::vector<StoredEntry> entries;
+    juce::int64 total = 0;
+
+    for (const auto& entryDirectory : directory.findChildFiles(juce::File::findDirectories, false))
+    {
+        // Only a crashed store leaves one of these behind, since stores hold the lock
+        if (entryDirectory.getFileName().endsWith(partialSuffix))
+        {
+            entryDirectory.deleteRecursively();
+            continue;
+        }
+
+        const auto size = getDirectorySize(entryDirectory);
+        entries.push_back({ entryDirectory, entryDirectory.getChildFile(manifestName).getLastModificationTime(), size });
+        total += size;
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const StoredEntry& a, const StoredEntry& b) { return a.lastUsed < b.lastUsed; });
+
+    for (auto it = entries.begin(); it != entries.end() && total > maxSize; ++it)
+    {
+        it->directory.deleteRecursively();
+        total -= it->size;
+    }
+}
+
+//==============================================================================
+bool SeparationCache::writePcmFile(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate)
+{
+    juce::FileOutputStream stream(file);
+    if (!stream.openedOk())
+        return false;
+
+    stream.setPosition(0);
+    stream.truncate();
+
+    const auto numSamples = (juce::int64) audio.getNumSamples();
+    juce::int64 sampleRateBits;
+    std::memcpy(&sampleRateBits, &sampleRate, sizeof(sampleRateBits));
+
+    stream.writeInt((int) pcmMagic);
+    stream.writeInt(formatVersion);
+    stream.writeInt(audio.getNumChannels());
+    stream.writeInt(0);
+    stream.writeInt64(numSamples);
+    stream.writeInt64(sampleRateBits);
+    stream.writeInt64((juce::int64) checksumChannels(audio.getArrayOfReadPointers(), audio.getNumChannels(), numSamples));
+    stream.writeRepeatedByte(0, (size_t) (headerSize - stream.getPosition()));
+
+    // Samples go out in native order, which is little-endian on every supported platform
+    for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+        if (!stream.write(audio.getReadPointer(ch), (size_t) numSamples * sizeof(float)))
+            return false;
+
+    stream.flush();
+    return stream.getStatus().wasOk();
+}
+
+SharedAudio SeparationCache::readPcmFile(const juce::File& file, double& sampleRate)
+{
+    juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const char*>(mapped.getData());
+    const auto size = (juce::int64) mapped.getSize();
+
+    if (data == nullptr || size < headerSize)
+        return {};
+
+    const auto magic = juce::ByteOrder::littleEndianInt(data);
+    const auto version = (int) juce::ByteOrder::littleEndianInt(data + 4);
+    const auto numChannels = (int) juce::ByteOrder::littleEndianInt(data + 8);
+    const auto numSamples = (juce::int64) juce::ByteOrder::littleEndianInt64(data + 16);
+    const auto sampleRateBits = juce::ByteOrder::littleEndianInt64(data + 24);
+    const auto checksum = juce::ByteOrder::littleEndianInt64(data + 32);
+
+    if (magic != pcmMagic || version != formatVersion || numChannels < 1 || numChannels > maxChannels
+        || numSamples < 0 || numSamples > std::numeric_limits<int>::max()
+        || size != headerSize + (juce::int64) numChannels * numSamples * (juce::int64) sizeof(float))
+        return {};
+
+    // The map is page-aligned and the header is 64 bytes, so the samples are float-aligned
+    std::vector<const float*> channels((size_t) numChannels);
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels[(size_t) ch] = reinterpret_cast<const float*>(data + headerSize) + (size_t) ch * (size_t) numSamples;
+
+    if (checksumChannels(channels.data(), numChannels, numSamples) != checksum)
+        return {};
+
+    juce::AudioBuffer<float> audio(numChannels, (int) numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        juce::FloatVectorOperations::copy(audio.getWritePointer(ch), channels[(size_t) ch], (int) numSamples);
+
+    std::memcpy(&sampleRate, &sampleRateBits, sizeof(sampleRate));
+    return SharedAudio(std::move(audio));
+}
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,48 @@
+#include "undergroundBeats/audio/SharedAudio.h"
+#include <utility>
+
+namespace undergroundBeats {
+namespace audio {
+
+SharedAudio::SharedAudio(juce::AudioBuffer<float>&& buffer)
+    : data(std::make_shared<juce::AudioBuffer<float>>(std::move(buffer)))
+{
+}
+
+SharedAudio SharedAudio::copyOf(const juce::AudioBuffer<float>& buffer)
+{
+    return SharedAudio(juce::AudioBuffer<float>(buffer));
+}
+
+juce::AudioBuffer<float>& SharedAudio::write()
+{
+    jassert(data != nullptr);
+
+    if (data.use_count() > 1)
+        data = std::make_shared<juce::AudioBuffer<float>>(*data);
+
+    return *data;
+}
+
+size_t SharedAudio::getSizeInBytes() const
+{
+    if (data == nullptr)
+        return 0;
+
+    return (size_t) data->getNumChannels() * (size_t) data->getNumSamples() * sizeof(float);
+}
+
+juce::AudioBuffer<float> SharedAudio::release()
+{
+    if (data == nullptr)
+        return {};
+
+    auto owned = std::exchange(data, nullptr);
+    if (owned.use_count() == 1)
+        return std::move(*owned);
+
+    return *owned;
+}
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,594 @@
+#include "undergroundBeats/audio/StemLoadPipeline.h"
+#include "undergroundBeats/audio/CompactStemSource.h"
+#include "undergroundBeats/audio/ParallelAudioDecoder.h"
+#include "undergroundBeats/audio/PolyphaseResampler.h"
+#include "undergroundBeats/audio/ProgressiveStemSource.h"
+#include "undergroundBeats/audio/StreamingStemSource.h"
+#include "undergroundBeats/ml/ONNXSourceSeparator.h"
+#include <cmath>
+
+namespace undergroundBeats {
+namespace audio {
+
+namespace {
+
+
+// Makes the playback source for one stem: streamed from a cache file when the options
+// allow it, otherwise (or if the file can't be written, e.g. disk full) held in RAM,
+// as float16 if asked to
+StemSourcePtr createSource(const SharedAudio& stem, double sampleRate, const StemLoadPipeline::StreamingOptions& streaming,
+                           const juce::String& cacheName, size_t ramBudgetBytes)
+{
+    StemSourcePtr source;
+
+    if (streaming.enabled && streaming.readAheadThread != nullptr)
+        source = StreamingStemSource::create(*stem, sampleRate, streaming.cacheDirectory.getChildFile(cacheName + ".wav"),
+                                             ramBudgetBytes, *streaming.readAheadThread);
+
+    if (source == nullptr && streaming.halfPrecision)
+        source = std::make_shared<CompactStemSource>(*stem);
+
+    if (source == nullptr)
+        source = std::make_shared<MemoryStemSource>(stem);
+
+    return source;
+}
+
+} // namespace
+
+//==============================================================================
+class StemLoadPipeline::LoadJob : public juce::ThreadPoolJob
+{
+public:
+    LoadJob(StemLoadPipeline& owner, juce::File fileToLoad, double rate, StreamingOptions options,
+            SeparationCache* cache, SeparationOptions separationOptions, int jobGeneration)
+        : juce::ThreadPoolJob("StemLoad"), pipeline(owner), file(std::move(fileToLoad)),
+          targetSampleRate(rate), streaming(std::move(options)), separationCache(cache),
+          separation(std::move(separationOptions)),
+          generation(jobGeneration)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        auto isStale = [this] { return shouldExit() || pipeline.generation.load() != generation; };
+
+        auto result = runStages(file, targetSampleRate, pipeline.formatManager, pipeline.modelLoader, streaming,
+                                separationCache, separation, isStale,
+                                [this](Stage stage, float progress)
+                                {
+                                    if (pipeline.generation.load() == generation)
+                                        pipeline.setProgress(stage, progress);
+                                },
+                                [this](Result&& preview)
+                                {
+                                    if (pipeline.generation.load() == generation)
+                                        pipeline.publishPreview(generation, std::move(preview));
+                                });
+
+        pipeline.finishJob(generation, std::move(result), isStale());
+        return jobHasFinished;
+    }
+
+private:
+    StemLoadPipeline& pipeline;
+    const juce::File file;
+    const double targetSampleRate;
+    const StreamingOptions streaming;
+    SeparationCache* const separationCache;
+    const SeparationOptions separation;
+    const int generation;
+};
+
+//==============================================================================
+juce::String StemLoadPipeline::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+        case Stage::Idle:      return "Idle";
+        case Stage::Decode:    return "Decoding";
+        case Stage::Resample:  return "Resampling";
+        case Stage::Separate:  return "Separating";
+        case Stage::Analyze:   return "Analyzing";
+        case Stage::Cache:     return "Caching";
+        case Stage::Publish:   return "Publishing";
+        case Stage::Finished:  return "Finished";
+        case Stage::Failed:    return "Failed";
+        case Stage::Cancelled: return "Cancelled";
+    }
+
+    return {};
+}
+
+StemLoadPipeline::StemLoadPipeline(juce::AudioFormatManager& formats, ml::ONNXModelLoader& loader)
+    : formatManager(formats), modelLoader(loader)
+{
+}
+
+StemLoadPipeline::~StemLoadPipeline()
+{
+    cancelPendingUpdate();
+    ++generation;
+    pool.removeAllJobs(true, 10000);
+}
+
+void StemLoadPipeline::load(const juce::File& file, double targetSampleRate)
+{
+    cancel();
+
+    setProgress(Stage::Decode, 0.0f);
+    pool.addJob(new LoadJob(*this, file, targetSampleRate, getStreamingOptions(), getSeparationCache(),
+                            getSeparationOptions(), generation.load()), true);
+}
+
+void StemLoadPipeline::setStreamingOptions(const StreamingOptions& options)
+{
+    const juce::ScopedLock lock(resultLock);
+    streamingOptions = options;
+}
+
+StemLoadPipeline::StreamingOptions StemLoadPipeline::getStreamingOptions() const
+{
+    const juce::ScopedLock lock(resultLock);
+    return streamingOptions;
+}
+
+void StemLoadPipeline::setSeparationCache(SeparationCache* cache)
+{
+    const juce::ScopedLock lock(resultLock);
+    separationCache = cache;
+}
+
+SeparationCache* StemLoadPipeline::getSeparationCache() const
+{
+    const juce::ScopedLock lock(resultLock);
+    return separationCache;
+}
+
+void StemLoadPipeline::setSeparationOptions(const SeparationOptions& options)
+{
+    const juce::ScopedLock lock(resultLock);
+    separationOptions = options;
+}
+
+StemLoadPipeline::SeparationOptions StemLoadPipeline::getSeparationOptions() const
+{
+    const juce::ScopedLock lock(resultLock);
+    return separationOptions;
+}
+
+juce::String StemLoadPipeline::getModelIdentity(const SeparationOptions& separation)
+{
+    return ml::SeparatorRegistry::getIdentity(separation.backend, separation.variant);
+}
+
+void StemLoadPipeline::cancel()
+{
+    if (isLoading())
+        setProgress(Stage::Cancelled, 0.0f);
+
+    // Bumping the generation makes a running job stale; its result is dropped on arrival
+    ++generation;
+    pool.removeAllJobs(true, 0);
+
+    const juce::ScopedLock lock(resultLock);
+    pendingResult.reset();
+}
+
+bool StemLoadPipeline::isLoading() const
+{
+    const auto stage = currentStage.load();
+    return stage != Stage::Idle && stage != Stage::Finished && stage != Stage::Failed && stage != Stage::Cancelled;
+}
+
+void StemLoadPipeline::setProgress(Stage stage, float progress)
+{
+    currentStage = stage;
+    currentProgress = progress;
+    triggerAsyncUpdate();
+}
+
+void StemLoadPipeline::finishJob(int jobGeneration, Result&& result, bool cancelled)
+{
+    if (cancelled)
+        return;
+
+    {
+        const juce::ScopedLock lock(resultLock);
+        pendingResult = std::make_unique<Result>(std::move(result));
+        pendingGeneration = jobGeneration;
+    }
+
+    setProgress(Stage::Publish, 0.0f);
+}
+
+void StemLoadPipeline::publishPreview(int jobGeneration, Result&& preview)
+{
+    // Taken by the next async update; if the final result overtakes it, the preview is skipped
+    {
+        const juce::ScopedLock lock(resultLock);
+        pendingResult = std::make_unique<Result>(std::move(preview));
+        pendingGeneration = jobGeneration;
+    }
+
+    triggerAsyncUpdate();
+}
+
+void StemLoadPipeline::handleAsyncUpdate()
+{
+    std::unique_ptr<Result> result;
+    {
+        const juce::ScopedLock lock(resultLock);
+        if (pendingResult != nullptr && pendingGeneration == generation.load())
+            result = std::move(pendingResult);
+    }
+
+    if (result != nullptr)
+    {
+        const bool succeeded = result->error.isEmpty();
+
+        const bool isPreview = result->isPreview;
+
+        if (succeeded && onPublish)
+            onPublish(std::move(*result));
+
+        // A preview is published while the load goes on
+        if (!isPreview)
+        {
+            currentStage = succeeded ? Stage::Finished : Stage::Failed;
+            currentProgress = 1.0f;
+        }
+    }
+
+    const auto stage = currentStage.load();
+    const auto progress = currentProgress.load();
+    listeners.call([stage, progress](Listener& l) { l.loadProgressChanged(stage, progress); });
+}
+
+//==============================================================================
+StemLoadPipeline::Result StemLoadPipeline::runStages(const juce::File& file, double targetSampleRate,
+                                                     juce::AudioFormatManager& formatManager,
+                                                     ml::ONNXModelLoader& modelLoader,
+                                                     const StreamingOptions& streaming,
+                                                     SeparationCache* separationCache,
+                                                     const SeparationOptions& separation,
+                                                     const std::function<bool()>& shouldExit,
+                                                     const std::function<void(Stage, float)>& reportProgress,
+                                                     const std::function<void(Result&&)>& publishPreview)
+{
+    Result result;
+    result.file = file;
+
+    auto cancelled = [&]
+    {
+        if (!shouldExit())
+            return false;
+
+        result.error = "Cancelled";
+        return true;
+    };
+
+    // --- Decode ---
+    reportProgress(Stage::Decode, 0.0f);
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr)
+    {
+        result.error = "Could not create reader for file: " + file.getFullPathName();
+        return result;
+    }
+
+    const int numChannels = juce::jmin(static_cast<int>(reader->numChannels), 2); // Limit to stereo
+    const int numSamples = static_cast<int>(reader->lengthInSamples);
+    result.sampleRate = reader->sampleRate;
+
+    reader.reset(); // The decoder opens a reader per segment
+
+    // --- Separation cache ---
+    // A track separated before at this rate skips Decode, Resample and Separate
+    const double playbackRate = targetSampleRate > 0.0 ? targetSampleRate : result.sampleRate;
+    juce::String cacheKey;
+
+    if (separationCache != nullptr)
+    {
+        cacheKey = SeparationCache::makeKey(file, getModelIdentity(separation), playbackRate);
+
+        if (auto entry = separationCache->lookup(cacheKey))
+        {
+            DBG("StemLoadPipeline: Using cached separation for " + file.getFileName());
+            result.sampleRate = entry->sampleRate;
+            result.mix = std::move(entry->mix);
+            result.stems = std::move(entry->stems);
+            result.modelVariant = entry->modelVariant;
+            result.separated = true;
+        }
+    }
+
+    if (!result.separated)
+    {
+        SharedAudio mix(juce::AudioBuffer<float>(numChannels, numSamples));
+        auto& decoded = mix.write(); // Unshared, so this doesn't copy
+
+        // Segments decode in parallel into the buffer; a new file interrupts them between chunks
+        const bool decodedAll = ParallelAudioDecoder::decode(file, formatManager, decoded, 0, shouldExit,
+                                                             [&](float progress) { reportProgress(Stage::Decode, progress); });
+        if (cancelled())
+            return result;
+
+        if (!decodedAll)
+        {
+            result.error = "Could not decode file: " + file.getFullPathName();
+            return result;
+        }
+
+        // --- Resample ---
+        reportProgress(Stage::Resample, 0.0f);
+        if (cancelled())
+            return result;
+
+        // Converted once here, so playback never resamples; a later device rate is handled by resampleSources()
+        if (targetSampleRate > 0.0)
+        {
+            mix = PolyphaseResampler::resample(mix, result.sampleRate, targetSampleRate);
+            result.sampleRate = targetSampleRate;
+        }
+
+        result.mix = mix;
+        reportProgress(Stage::Resample, 1.0f);
+
+        // --- Separate ---
+        reportProgress(Stage::Separate, 0.0f);
+        if (cancelled())
+            return result;
+
+        try
+        {
+            // The fast variant is used if it is installed; the cache key above already says which runs
+            const auto availableVariant = ml::SeparatorRegistry::getAvailableVariant(separation.backend, separation.variant);
+            auto backendSeparator = separation.backend.create(modelLoader, separation.variant);
+            auto* onnxSeparator = dynamic_cast<ml::ONNXSourceSeparator*>(backendSeparator.get());
+            const auto reportSeparation = [&](float progress) { reportProgress(Stage::Separate, progress); };
+
+            // The model sees the mix at the rate it was trained at; its stems are converted back below
+            const double modelRate = separation.backend.capabilities.nativeSampleRate > 0.0
+                                         ? separation.backend.capabilities.nativeSampleRate
+                                         : result.sampleRate;
+            const SharedAudio modelMix = PolyphaseResampler::resample(result.mix, result.sampleRate, modelRate);
+            const bool convertsRate = !modelMix.sharesDataWith(result.mix);
+
+            if (backendSeparator == nullptr || !backendSeparator->isReady())
+            {
+                DBG("StemLoadPipeline: separator backend " + juce::String(separation.backend.capabilities.id) + " is not ready.");
+            }
+            // ONNX backends separate window by window, so they can be previewed and interrupted
+            else if (onnxSeparator != nullptr)
+            {
+                auto& separator = *onnxSeparator;
+
+                if (publishPreview && result.mix->getNumSamples() > 0)
+                {
+                    // The stems are published before they are separated and fill in segment by
+                    // segment, starting wherever the preview is being played. They are written at
+                    // the model's rate; the preview converts them as it plays.
+                    auto progressive = std::make_shared<ProgressiveSeparation>(modelMix, (int) separator.getSourceNames().size(),
+                                                                               separator.getWindowHop(), modelRate,
+                                                                               result.sampleRate);
+                    auto stemViews = progressive->getWriteViews();
+
+                    Result preview;
+                    preview.file = file;
+                    preview.sampleRate = result.sampleRate;
+                    preview.mix = result.mix;
+                    preview.sources = ProgressiveSeparation::createSources(progressive);
+                    preview.stemNames = separator.getSourceNames();
+                    preview.isPreview = true;
+                    publishPreview(std::move(preview));
+                    result.followsPreview = true;
+
+                    ml::ONNXSourceSeparator::WindowCallbacks callbacks;
+                    callbacks.shouldExit = shouldExit;
+                    callbacks.reportProgress = reportSeparation;
+                    callbacks.getPriorityPosition = [&progressive] { return progressive->getPriorityPosition(); };
+                    callbacks.segmentFinished = [&progressive](int segment) { progressive->markSegmentFinished(segment); };
+
+                    if (separator.separateInto(*modelMix, stemViews, callbacks))
+                    {
+                        result.stems = progressive->getStems();
+                        result.separated = true;
+                    }
+                    else
+                    {
+                        DBG("StemLoadPipeline: separation reported failure.");
+                    }
+                }
+                // Separate the mix decoded above; the stems are moved out.
+                // The model runs window by window, so a new file interrupts it between windows.
+                else if (separator.separate(*modelMix, modelRate, shouldExit, reportSeparation))
+                {
+                    result.stems = separator.takeStems();
+                    result.separated = !result.stems.empty();
+                }
+                else
+                {
+                    DBG("StemLoadPipeline: separation reported failure.");
+                }
+            }
+            else
+            {
+                // Other backends take the whole mix at once; their stems come back by name
+                auto separated = backendSeparator->process(*modelMix);
+
+                for (const auto& name : backendSeparator->getSourceNames())
+                {
+                    const auto stem = separated.find(name);
+                    if (stem == separated.end())
+                        break;
+
+                    result.stems.emplace_back(std::move(stem->second));
+                }
+
+                result.separated = !result.stems.empty() && result.stems.size() == backendSeparator->getSourceNames().size();
+                if (!result.separated)
+                    result.stems.clear();
+            }
+
+            if (result.separated && convertsRate)
+            {
+                for (auto& stem : result.stems)
+                {
+                    stem = PolyphaseResampler::resample(stem, modelRate, result.sampleRate);
+
+                    // Rounding in the two conversions can leave a stem a sample off the mix
+                    auto& buffer = stem.write();
+                    buffer.setSize(buffer.getNumChannels(), result.mix->getNumSamples(), true, true);
+                }
+            }
+
+            if (result.separated)
+            {
+                result.modelVariant = ml::ONNXSourceSeparator::getVariantName(availableVariant);
+                result.stemNames = backendSeparator->getSourceNames();
+            }
+        }
+        catch (const std::exception& e)
+        {
+            DBG("StemLoadPipeline: separation failed with exception: " + juce::String(e.what()));
+        }
+
+        if (cancelled())
+            return result;
+
+        // Only real separations are kept; a failed one should be retried next time
+        if (separationCache != nullptr && result.separated)
+            separationCache->store(cacheKey, { result.sampleRate, result.mix, result.stems, result.modelVariant });
+    }
+
+    // Fallback: the mix stands in for every stem the backend would have made. The handles share one buffer.
+    if (!result.separated)
+    {
+        result.stems.clear();
+        result.stems.assign(juce::jmax((size_t) 1, separation.backend.capabilities.stemNames.size()), result.mix);
+    }
+
+    // Cached and placeholder stems are named by the backend; a separator that made more stems than it declared
+    // gets generic names for the rest
+    if (result.stemNames.empty())
+        result.stemNames = separation.backend.capabilities.stemNames;
+
+    result.stemNames.resize(result.stems.size());
+    for (size_t i = 0; i < result.stemNames.size(); ++i)
+        if (result.stemNames[i].empty())
+            result.stemNames[i] = "stem " + std::to_string(i + 1);
+
+    reportProgress(Stage::Separate, 1.0f);
+
+    // --- Analyze ---
+    reportProgress(Stage::Analyze, 0.0f);
+
+    for (size_t i = 0; i < result.stems.size(); ++i)
+    {
+        if (cancelled())
+            return result;
+
+        const auto& stem = *result.stems[i];
+        float peak = 0.0f;
+        double sumOfSquares = 0.0;
+
+        for (int ch = 0; ch < stem.getNumChannels(); ++ch)
+        {
+            peak = juce::jmax(peak, stem.getMagnitude(ch, 0, stem.getNumSamples()));
+            const auto rms = stem.getRMSLevel(ch, 0, stem.getNumSamples());
+            sumOfSquares += static_cast<double>(rms) * rms;
+        }
+
+        result.stemPeaks.push_back(peak);
+        result.stemRms.push_back(stem.getNumChannels() > 0
+                                     ? static_cast<float>(std::sqrt(sumOfSquares / stem.getNumChannels()))
+                                     : 0.0f);
+        reportProgress(Stage::Analyze, static_cast<float>(i + 1) / static_cast<float>(result.stems.size()));
+    }
+
+    // --- Cache ---
+    reportProgress(Stage::Cache, 0.0f);
+
+    const bool stream = streaming.enabled && streaming.readAheadThread != nullptr;
+    const size_t budgetPerStem = streaming.ramBudgetBytes / juce::jmax((size_t) 1, result.stems.size());
+
+    // A streamed stem can't use less than its smallest read-ahead window; say so rather than overrun quietly
+    if (stream && !result.stems.empty())
+    {
+        const auto& first = *result.stems.front();
+        const auto minimumBudget = StreamingStemSource::getMinimumRamBudget(first.getNumChannels(), first.getNumSamples());
+        if (budgetPerStem < minimumBudget)
+            juce::Logger::writeToLog("StemLoadPipeline: the RAM budget leaves " + juce::String((juce::int64) budgetPerStem)
+                                     + " bytes per stem; streaming needs at least " + juce::String((juce::int64) minimumBudget));
+    }
+
+    const auto cacheName = juce::String::toHexString(juce::Time::getHighResolutionTicks());
+
+    for (size_t i = 0; i < result.stems.size(); ++i)
+    {
+        if (cancelled())
+            return result;
+
+        // Stems that share a buffer (the placeholders) share one source and one cache file
+        StemSourcePtr source;
+        for (size_t j = 0; j < i && source == nullptr; ++j)
+            if (result.stems[j].sharesDataWith(result.stems[i]))
+                source = result.sources[j];
+
+        if (source == nullptr)
+            source = createSource(result.stems[i], result.sampleRate, streaming,
+                                  cacheName + "_" + juce::String((int) i), budgetPerStem);
+
+        result.sources.push_back(std::move(source));
+        reportProgress(Stage::Cache, static_cast<float>(i + 1) / static_cast<float>(result.stems.size()));
+    }
+
+    // Streamed and compact stems no longer need their decoded copies; dropping them here frees the RAM
+    if (stream || streaming.halfPrecision)
+    {
+        result.stems.clear();
+        result.mix.reset();
+    }
+
+    return result;
+}
+
+std::vector<StemSourcePtr> StemLoadPipeline::resampleSources(const std::vector<StemSourcePtr>& sources,
+                                                             double sourceRate, double targetRate,
+                                                             const StreamingOptions& streaming)
+{
+    std::vector<StemSourcePtr> resampled;
+    resampled.reserve(sources.size());
+
+    const size_t budgetPerStem = streaming.ramBudgetBytes / juce::jmax((size_t) 1, sources.size());
+    const auto cacheName = juce::String::toHexString(juce::Time::getHighResolutionTicks())
+                           + "_" + juce::String(juce::roundToInt(targetRate));
+
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        StemSourcePtr source;
+
+        // A source used by several stems (the placeholders) is converted once
+        for (size_t j = 0; j < i && source == nullptr; ++j)
+            if (sources[j] == sources[i])
+                source = resampled[j];
+
+        if (source == nullptr && sources[i] != nullptr)
+        {
+            const auto audio = PolyphaseResampler::resample(sources[i]->readEntireStem(), sourceRate, targetRate);
+            if (!audio.isValid())
+                return {};
+
+            source = createSource(audio, targetRate, streaming, cacheName + "_" + juce::String((int) i), budgetPerStem);
+        }
+
+        resampled.push_back(std::move(source));
+    }
+
+    return resampled;
+}
+
+} // namespace audio
+} // namespace undergroundBeats
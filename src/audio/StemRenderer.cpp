@@ -0,0 +1,197 @@
+#include "undergroundBeats/audio/StemRenderer.h"
+#include <cmath>
+
+namespace undergroundBeats {
+namespace audio {
+
+namespace {
+
+constexpr float defaultEqFrequencies[] = { 100.0f, 1000.0f, 5000.0f };
+
+StemRenderer::ParameterValues makeDefaultValues()
+{
+    StemRenderer::ParameterValues values {};
+
+    values[StemRenderer::volume] = 0.8f;
+
+    for (int band = 0; band < 3; ++band)
+    {
+        const int first = StemRenderer::eq1Enable + band * (StemRenderer::eq2Enable - StemRenderer::eq1Enable);
+        values[(size_t) first] = 1.0f;                                 // Enable
+        values[(size_t) first + 1] = defaultEqFrequencies[band];       // Freq
+        values[(size_t) first + 3] = 1.0f;                             // Q
+    }
+
+    values[StemRenderer::compEnable] = 1.0f;
+    values[StemRenderer::compThreshold] = -24.0f;
+    values[StemRenderer::compRatio] = 4.0f;
+    values[StemRenderer::compAttack] = 10.0f;
+    values[StemRenderer::compRelease] = 100.0f;
+
+    values[StemRenderer::reverbRoomSize] = 0.5f;
+    values[StemRenderer::reverbDamping] = 0.5f;
+    values[StemRenderer::reverbWetLevel] = 0.33f;
+    values[StemRenderer::reverbDryLevel] = 0.4f;
+    values[StemRenderer::reverbWidth] = 1.0f;
+
+    values[StemRenderer::chorusRate] = 1.0f;
+    values[StemRenderer::chorusDepth] = 0.25f;
+    values[StemRenderer::chorusCentreDelay] = 7.0f;
+    values[StemRenderer::chorusMix] = 0.5f;
+
+    values[StemRenderer::saturationAmount] = 1.0f;
+    return values;
+}
+
+} // namespace
+
+//==============================================================================
+juce::String StemRenderer::getParameterType(int parameter)
+{
+    static const char* const types[numParameters] = {
+        "Volume", "Gain", "Mute", "Solo",
+        "EQ1_Enable", "EQ1_Freq", "EQ1_Gain", "EQ1_Q",
+        "EQ2_Enable", "EQ2_Freq", "EQ2_Gain", "EQ2_Q",
+        "EQ3_Enable", "EQ3_Freq", "EQ3_Gain", "EQ3_Q",
+        "Comp_Enable", "Comp_Threshold", "Comp_Ratio", "Comp_Attack", "Comp_Release",
+        "Reverb_Enable", "Reverb_RoomSize", "Reverb_Damping", "Reverb_WetLevel", "Reverb_DryLevel", "Reverb_Width", "Reverb_Freeze",
+        "Chorus_Enable", "Chorus_Rate", "Chorus_Depth", "Chorus_CentreDelay", "Chorus_Feedback", "Chorus_Mix",
+        "Saturation_Enable", "Saturation_Amount"
+    };
+
+    return juce::isPositiveAndBelow(parameter, (int) numParameters) ? juce::String(types[parameter]) : juce::String();
+}
+
+const StemRenderer::ParameterValues& StemRenderer::getDefaultValues()
+{
+    static const ParameterValues defaults = makeDefaultValues();
+    return defaults;
+}
+
+bool StemRenderer::isAudible(const ParameterValues& values, bool anySoloActive)
+{
+    const bool isMuted = values[mute] > 0.5f;
+    return !isMuted && (!anySoloActive || isSoloed(values));
+}
+
+float StemRenderer::getOutputGain(const ParameterValues& values)
+{
+    return values[volume] * juce::Decibels::decibelsToGain(values[gain]);
+}
+
+//==============================================================================
+StemRenderer::StemRenderer() = default;
+
+void StemRenderer::prepare(double sampleRate, int maximumBlockSize)
+{
+    currentSampleRate = sampleRate;
+
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = (juce::uint32) maximumBlockSize;
+    spec.numChannels = 2; // Always prepare for stereo processing regardless of input channels
+
+    // Initialize delay line - must be done before prepare
+    auto& delay = chain.get<5>();
+    delay.reset();
+    delay.setMaximumDelayInSamples((int) (sampleRate * 2.0)); // 2 seconds max delay
+
+    chain.prepare(spec);
+
+    // Give each EQ band its own coefficient object up front; applyParameters() only
+    // overwrites their contents. The sample rate may have changed, so rebuild everything.
+    chain.get<0>().coefficients = new juce::dsp::IIR::Coefficients<float>(1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+    chain.get<1>().coefficients = new juce::dsp::IIR::Coefficients<float>(1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+    chain.get<2>().coefficients = new juce::dsp::IIR::Coefficients<float>(1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+    hasAppliedValues = false;
+
+    // Start from the defaults; process() applies the stem's own values before every block
+    applyParameters(getDefaultValues());
+    chain.get<8>().setGainLinear(1.0f);
+
+    chain.reset();
+}
+
+void StemRenderer::process(juce::AudioBuffer<float>& stereo, int numSamples, const ParameterValues& values)
+{
+    applyParameters(values);
+
+    juce::dsp::AudioBlock<float> block(stereo);
+    auto subBlock = block.getSubBlock(0, (size_t) numSamples);
+    juce::dsp::ProcessContextReplacing<float> context(subBlock);
+    chain.process(context);
+}
+
+void StemRenderer::applyParameters(const ParameterValues& values)
+{
+    // EQ: the filters share coefficient objects created in prepare(), which are rewritten in
+    // place so the audio thread never allocates; unchanged bands are skipped entirely.
+    for (int band = 0; band < 3; ++band)
+    {
+        const size_t first = (size_t) (eq1Enable + band * (eq2Enable - eq1Enable));
+        const bool enable = values[first] > 0.5f;
+        const float freq = values[first + 1];
+        const float gainDb = values[first + 2];
+        const float q = values[first + 3];
+
+        const bool changed = !hasAppliedValues
+                          || appliedValues[first + 1] != freq
+                          || appliedValues[first + 2] != gainDb
+                          || appliedValues[first + 3] != q;
+
+        juce::dsp::IIR::Coefficients<float>* coefficients = nullptr;
+
+        switch (band)
+        {
+            case 0: coefficients = chain.get<0>().coefficients.get(); chain.setBypassed<0>(!enable); break;
+            case 1: coefficients = chain.get<1>().coefficients.get(); chain.setBypassed<1>(!enable); break;
+            case 2: coefficients = chain.get<2>().coefficients.get(); chain.setBypassed<2>(!enable); break;
+        }
+
+        if (changed && coefficients != nullptr)
+            *coefficients = juce::dsp::IIR::ArrayCoefficients<float>::makePeakFilter(currentSampleRate, freq, q,
+                                                                                       juce::Decibels::decibelsToGain(gainDb));
+    }
+
+    // Compressor
+    auto& comp = chain.get<3>();
+    comp.setThreshold(values[compThreshold]);
+    comp.setRatio(values[compRatio]);
+    comp.setAttack(values[compAttack]);
+    comp.setRelease(values[compRelease]);
+    chain.setBypassed<3>(values[compEnable] <= 0.5f);
+
+    // Reverb
+    juce::dsp::Reverb::Parameters reverbParams;
+    reverbParams.roomSize = values[reverbRoomSize];
+    reverbParams.damping = values[reverbDamping];
+    reverbParams.wetLevel = values[reverbWetLevel];
+    reverbParams.dryLevel = values[reverbDryLevel];
+    reverbParams.width = values[reverbWidth];
+    reverbParams.freezeMode = values[reverbFreeze] > 0.5f ? 1.0f : 0.0f;
+    chain.get<4>().setParameters(reverbParams);
+    chain.setBypassed<4>(values[reverbEnable] <= 0.5f);
+
+    // Delay parameters implementation skipped to avoid compatibility issues
+
+    // Chorus
+    auto& chorus = chain.get<6>();
+    chorus.setRate(values[chorusRate]);
+    chorus.setDepth(values[chorusDepth]);
+    chorus.setCentreDelay(values[chorusCentreDelay]);
+    chorus.setFeedback(values[chorusFeedback]);
+    chorus.setMix(values[chorusMix]);
+    chain.setBypassed<6>(values[chorusEnable] <= 0.5f);
+
+    // Saturation
+    const float satAmount = values[saturationAmount];
+    if (!hasAppliedValues || appliedValues[saturationAmount] != satAmount)
+        chain.get<7>().functionToUse = [satAmount](float x) { return std::tanh(satAmount * x); };
+    chain.setBypassed<7>(values[saturationEnable] <= 0.5f);
+
+    appliedValues = values;
+    hasAppliedValues = true;
+}
+
+} // namespace audio
+} // namespace undergroundBeats
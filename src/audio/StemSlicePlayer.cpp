@@ -0,0 +1,229 @@
+#include "undergroundBeats/audio/StemSlicePlayer.h"
+
+namespace undergroundBeats {
+namespace audio {
+
+StemSlicePlayer::StemSlicePlayer() = default;
+
+//==============================================================================
+void StemSlicePlayer::setSlice(int noteNumber, const StemSlice& slice)
+{
+    if (!juce::isPositiveAndBelow(noteNumber, numNotes))
+        return;
+
+    const juce::SpinLock::ScopedLockType lock(sliceLock);
+    slices[static_cast<size_t>(noteNumber)] = slice;
+}
+
+StemSlice StemSlicePlayer::getSlice(int noteNumber) const
+{
+    if (!juce::isPositiveAndBelow(noteNumber, numNotes))
+        return {};
+
+    const juce::SpinLock::ScopedLockType lock(sliceLock);
+    return slices[static_cast<size_t>(noteNumber)];
+}
+
+void StemSlicePlayer::clearSlices()
+{
+    const juce::SpinLock::ScopedLockType lock(sliceLock);
+    slices.fill({});
+}
+
+void StemSlicePlayer::sliceEvenly(int stemIndex, juce::int64 stemLength, int numSlices, int firstNote)
+{
+    if (stemIndex < 0 || stemLength <= 0 || numSlices <= 0)
+        return;
+
+    const juce::SpinLock::ScopedLockType lock(sliceLock);
+
+    for (int i = 0; i < numSlices; ++i)
+    {
+        const int note = firstNote + i;
+        if (!juce::isPositiveAndBelow(note, numNotes))
+            break;
+
+        const auto start = stemLength * i / numSlices;
+        const auto end = stemLength * (i + 1) / numSlices;
+        slices[static_cast<size_t>(note)] = { stemIndex, start, static_cast<int>(end - start), true };
+    }
+}
+
+std::unique_ptr<juce::XmlElement> StemSlicePlayer::createXml() const
+{
+    auto xml = std::make_unique<juce::XmlElement>("SLICES");
+    const juce::SpinLock::ScopedLockType lock(sliceLock);
+
+    for (int note = 0; note < numNotes; ++note)
+    {
+        const auto& slice = slices[static_cast<size_t>(note)];
+        if (slice.stemIndex < 0)
+            continue;
+
+        auto* sliceXml = xml->createNewChildElement("SLICE");
+        sliceXml->setAttribute("note", note);
+        sliceXml->setAttribute("stem", slice.stemIndex);
+        sliceXml->setAttribute("start", juce::String(slice.startSample));
+        sliceXml->setAttribute("length", slice.numSamples);
+        sliceXml->setAttribute("oneShot", slice.oneShot);
+    }
+
+    return xml;
+}
+
+void StemSlicePlayer::restoreFromXml(const juce::XmlElement& xml)
+{
+    clearSlices();
+
+    for (auto* sliceXml : xml.getChildWithTagNameIterator("SLICE"))
+    {
+        StemSlice slice;
+        slice.stemIndex = sliceXml->getIntAttribute("stem", -1);
+        slice.startSample = sliceXml->getStringAttribute("start").getLargeIntValue();
+        slice.numSamples = sliceXml->getIntAttribute("length");
+        slice.oneShot = sliceXml->getBoolAttribute("oneShot", true);
+        setSlice(sliceXml->getIntAttribute("note", -1), slice);
+    }
+}
+
+//==============================================================================
+void StemSlicePlayer::noteOn(int noteNumber, float velocity)
+{
+    if (!juce::isPositiveAndBelow(noteNumber, numNotes))
+        return;
+
+    StemSlice slice;
+    {
+        // If the message thread is editing slices, this note is dropped rather than blocking
+        const juce::SpinLock::ScopedTryLockType lock(sliceLock);
+        if (!lock.isLocked())
+            return;
+
+        slice = slices[static_cast<size_t>(noteNumber)];
+    }
+
+    if (slice.stemIndex < 0 || slice.numSamples <= 0)
+        return;
+
+    // Retrigger the note's own voice first, then a free voice, then steal the oldest
+    Voice* target = nullptr;
+    for (auto& voice : voices)
+        if (voice.active && voice.noteNumber == noteNumber) { target = &voice; break; }
+
+    if (target == nullptr)
+        for (auto& voice : voices)
+            if (!voice.active) { target = &voice; break; }
+
+    if (target == nullptr)
+    {
+        target = &voices[0];
+        for (auto& voice : voices)
+            if (voice.age < target->age)
+                target = &voice;
+    }
+
+    if (!target->active)
+        ++numActiveVoices;
+
+    target->active = true;
+    target->noteNumber = noteNumber;
+    target->slice = slice;
+    target->position = 0;
+    target->endPosition = slice.numSamples;
+    target->gain = juce::jlimit(0.0f, 1.0f, velocity);
+    target->age = ++voiceCounter;
+}
+
+void StemSlicePlayer::noteOff(int noteNumber)
+{
+    for (auto& voice : voices)
+    {
+        if (!voice.active || voice.noteNumber != noteNumber || voice.slice.oneShot)
+            continue;
+
+        // Fade out from the current position instead of cutting
+        voice.endPosition = juce::jmin(voice.endPosition, voice.position + fadeSamples);
+    }
+}
+
+void StemSlicePlayer::allNotesOff()
+{
+    for (auto& voice : voices)
+        voice.active = false;
+
+    numActiveVoices = 0;
+}
+
+bool StemSlicePlayer::isStemActive(int stemIndex) const
+{
+    if (numActiveVoices == 0)
+        return false;
+
+    for (const auto& voice : voices)
+        if (voice.active && voice.slice.stemIndex == stemIndex)
+            return true;
+
+    return false;
+}
+
+void StemSlicePlayer::renderStem(int stemIndex, const juce::AudioBuffer<float>& stemBuffer,
+                                 juce::AudioBuffer<float>& destination, int numSamples) const
+{
+    if (numActiveVoices == 0)
+        return;
+
+    const int stemChannels = stemBuffer.getNumChannels();
+    const auto stemLength = static_cast<juce::int64>(stemBuffer.getNumSamples());
+    if (stemChannels == 0)
+        return;
+
+    for (const auto& voice : voices)
+    {
+        if (!voice.active || voice.slice.stemIndex != stemIndex)
+            continue;
+
+        // The stem may have been swapped for a shorter one since the slice was defined
+        const auto sourceStart = voice.slice.startSample + voice.position;
+        const auto available = juce::jmin(static_cast<juce::int64>(voice.endPosition - voice.position),
+                                          stemLength - sourceStart);
+        const int samplesToRender = static_cast<int>(juce::jmin(static_cast<juce::int64>(numSamples), available));
+        if (samplesToRender <= 0)
+            continue;
+
+        for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+        {
+            const auto* source = stemBuffer.getReadPointer(juce::jmin(ch, stemChannels - 1), static_cast<int>(sourceStart));
+            auto* dest = destination.getWritePointer(ch);
+
+            for (int i = 0; i < samplesToRender; ++i)
+            {
+                const int position = voice.position + i;
+                const int distanceToEdge = juce::jmin(position, voice.endPosition - position);
+                const float envelope = distanceToEdge < fadeSamples ? distanceToEdge / static_cast<float>(fadeSamples) : 1.0f;
+                dest[i] += source[i] * voice.gain * envelope;
+            }
+        }
+    }
+}
+
+void StemSlicePlayer::advance(int numSamples)
+{
+    if (numActiveVoices == 0)
+        return;
+
+    for (auto& voice : voices)
+    {
+        if (!voice.active)
+            continue;
+
+        voice.position += numSamples;
+        if (voice.position >= voice.endPosition)
+        {
+            voice.active = false;
+            --numActiveVoices;
+        }
+    }
+}
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,85 @@
+#include "undergroundBeats/audio/StemSource.h"
+#include <cmath>
+
+namespace undergroundBeats {
+namespace audio {
+
+int copyStemSamples(const juce::AudioBuffer<float>& source, juce::int64 sourceStartSample,
+                    juce::AudioBuffer<float>& destination, int destStartSample, int numSamples)
+{
+    const juce::int64 available = juce::jlimit((juce::int64) 0, (juce::int64) numSamples,
+                                               (juce::int64) source.getNumSamples() - sourceStartSample);
+    const int numToCopy = sourceStartSample < 0 ? 0 : (int) available;
+    const int sourceChannels = source.getNumChannels();
+
+    for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+    {
+        if (numToCopy > 0 && sourceChannels > 0)
+            destination.copyFrom(ch, destStartSample, source, juce::jmin(ch, sourceChannels - 1),
+                                 (int) sourceStartSample, numToCopy);
+
+        if (numToCopy < numSamples)
+            destination.clear(ch, destStartSample + numToCopy, numSamples - numToCopy);
+    }
+
+    return numToCopy;
+}
+
+juce::AudioBuffer<float> makeStemOverview(const juce::AudioBuffer<float>& stem)
+{
+    const int decimation = StemSource::overviewDecimation;
+    const int overviewLength = (stem.getNumSamples() + decimation - 1) / decimation;
+    juce::AudioBuffer<float> overview(stem.getNumChannels(), overviewLength);
+
+    for (int ch = 0; ch < stem.getNumChannels(); ++ch)
+    {
+        const auto* samples = stem.getReadPointer(ch);
+        auto* points = overview.getWritePointer(ch);
+
+        for (int bin = 0; bin < overviewLength; ++bin)
+        {
+            const int start = bin * decimation;
+            const int end = juce::jmin(start + decimation, stem.getNumSamples());
+            float loudest = 0.0f;
+
+            for (int i = start; i < end; ++i)
+                if (std::abs(samples[i]) > std::abs(loudest))
+                    loudest = samples[i];
+
+            points[bin] = loudest;
+        }
+    }
+
+    return overview;
+}
+
+//==============================================================================
+MemoryStemSource::MemoryStemSource(SharedAudio audioToUse)
+    : audio(std::move(audioToUse))
+{
+    jassert(audio.isValid());
+}
+
+int MemoryStemSource::getNumChannels() const
+{
+    return audio->getNumChannels();
+}
+
+juce::int64 MemoryStemSource::getLengthInSamples() const
+{
+    return audio->getNumSamples();
+}
+
+bool MemoryStemSource::read(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+                            juce::int64 sourceStartSample)
+{
+    return copyStemSamples(*audio, sourceStartSample, destination, destStartSample, numSamples) == numSamples;
+}
+
+size_t MemoryStemSource::getResidentBytes() const
+{
+    return audio.getSizeInBytes();
+}
+
+} // namespace audio
+} // namespace undergroundBeats
@@ -0,0 +1,228 @@
+#include "undergroundBeats/audio/StreamingStemSource.h"
+#include <limits>
+
+namespace undergroundBeats {
+namespace audio {
+
+namespace {
+
+bool writeCacheFile(const juce::AudioBuffer<float>& stem, double sampleRate, const juce::File& file)
+{
+    file.deleteFile();
+
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if (!stream->openedOk())
+        return false;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(
+        wav.createWriterFor(stream.get(), sampleRate, (unsigned int) stem.getNumChannels(), 32, {}, 0));
+
+    if (writer == nullptr)
+        return false;
+
+    stream.release(); // Now owned by the writer
+    return writer->writeFromAudioSampleBuffer(stem, 0, stem.getNumSamples());
+}
+
+std::unique_ptr<juce::AudioFormatReader> openCacheFile(const juce::File& file)
+{
+    auto stream = std::make_unique<juce::FileInputStream>(file);
+    if (!stream->openedOk())
+        return nullptr;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> fileReader(wav.createReaderFor(stream.get(), true));
+    if (fileReader != nullptr)
+        stream.release(); // Now owned by the file reader
+
+    return fileReader;
+}
+
+// Reads the cache file on the calling thread, with no read-ahead to miss
+class CacheFileStemSource : public StemSource
+{
+public:
+    explicit CacheFileStemSource(std::unique_ptr<juce::AudioFormatReader> readerToUse)
+        : reader(std::move(readerToUse))
+    {
+    }
+
+    int getNumChannels() const override { return (int) reader->numChannels; }
+    juce::int64 getLengthInSamples() const override { return reader->lengthInSamples; }
+
+    bool read(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+              juce::int64 sourceStartSample) override
+    {
+        // The reader fills both of the first two channels from a mono file and pads past the end with silence
+        reader->read(&destination, destStartSample, numSamples, sourceStartSample, true, true);
+
+        for (int ch = 2; ch < destination.getNumChannels(); ++ch)
+            destination.copyFrom(ch, destStartSample, destination, 0, destStartSample, numSamples);
+
+        return sourceStartSample >= 0 && sourceStartSample + numSamples <= reader->lengthInSamples;
+    }
+
+    const juce::AudioBuffer<float>* getResidentBuffer() const override { return nullptr; }
+    const juce::AudioBuffer<float>* getDisplayBuffer() const override { return nullptr; }
+    size_t getResidentBytes() const override { return 0; }
+
+    SharedAudio readEntireStem() const override
+    {
+        juce::AudioBuffer<float> stem(getNumChannels(), (int) getLengthInSamples());
+        if (!reader->read(&stem, 0, stem.getNumSamples(), 0, true, true))
+            return {};
+
+        return SharedAudio(std::move(stem));
+    }
+
+private:
+    const std::unique_ptr<juce::AudioFormatReader> reader;
+};
+
+} // namespace
+
+//==============================================================================
+std::shared_ptr<StreamingStemSource> StreamingStemSource::create(const juce::AudioBuffer<float>& stem, double sampleRate,
+                                                                 const juce::File& cacheFile, size_t ramBudgetBytes,
+                                                                 juce::TimeSliceThread& readAheadThread)
+{
+    if (stem.getNumChannels() == 0 || stem.getNumSamples() == 0)
+        return nullptr;
+
+    if (!cacheFile.getParentDirectory().createDirectory() || !writeCacheFile(stem, sampleRate, cacheFile))
+    {
+        cacheFile.deleteFile();
+        return nullptr;
+    }
+
+    // The overview is always resident; the rest of the budget is split between the head and
+    // the read-ahead blocks. The minimum blocks come out of the budget first, so a small
+    // budget shrinks the head instead of being overrun by them.
+    const auto bytesPerFrame = (size_t) stem.getNumChannels() * sizeof(float);
+    const auto overviewSamples = (juce::int64) (stem.getNumSamples() + overviewDecimation - 1) / overviewDecimation;
+    const auto budgetFrames = (juce::int64) (ramBudgetBytes / bytesPerFrame) - overviewSamples;
+    const auto minimumReadAhead = (juce::int64) minimumReadAheadBlocks * readAheadBlockSamples;
+
+    const auto headLimit = juce::jmin((juce::int64) stem.getNumSamples(),
+                                      juce::jmax((juce::int64) 0, budgetFrames - minimumReadAhead));
+    const auto headSamples = (int) juce::jlimit((juce::int64) 0, headLimit,
+                                                (juce::int64) ((double) budgetFrames * headFraction));
+
+    // Only whole blocks fit; the window holds as many as the rest of the budget pays for
+    const auto maxBlocks = (juce::int64) std::numeric_limits<int>::max() / readAheadBlockSamples;
+    const auto readAheadBlocks = juce::jlimit((juce::int64) minimumReadAheadBlocks, maxBlocks,
+                                              (budgetFrames - headSamples) / readAheadBlockSamples);
+    const auto readAheadSamples = (int) (readAheadBlocks * readAheadBlockSamples);
+
+    std::shared_ptr<StreamingStemSource> source(new StreamingStemSource(stem, cacheFile, headSamples, readAheadSamples));
+    if (!source->openReader(readAheadThread))
+        return nullptr;
+
+    return source;
+}
+
+StreamingStemSource::StreamingStemSource(const juce::AudioBuffer<float>& stem, const juce::File& file,
+                                         int headSamples, int readAheadSize)
+    : cacheFile(file),
+      numChannels(stem.getNumChannels()),
+      lengthInSamples(stem.getNumSamples()),
+      readAheadSamples(readAheadSize),
+      head(stem.getNumChannels(), headSamples),
+      overview(makeStemOverview(stem))
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+        head.copyFrom(ch, 0, stem, ch, 0, headSamples);
+}
+
+StreamingStemSource::~StreamingStemSource()
+{
+    // Stop the read-ahead before the file goes away
+    reader.reset();
+    cacheFile.deleteFile();
+}
+
+bool StreamingStemSource::openReader(juce::TimeSliceThread& readAheadThread)
+{
+    auto stream = std::make_unique<juce::FileInputStream>(cacheFile);
+    if (!stream->openedOk())
+        return false;
+
+    juce::WavAudioFormat wav;
+    auto* fileReader = wav.createReaderFor(stream.get(), true);
+    if (fileReader == nullptr)
+        return false;
+
+    stream.release(); // Now owned by the file reader
+
+    // BufferingAudioReader keeps one block more than samplesToBuffer / readAheadBlockSamples,
+    // so asking for a block less holds exactly readAheadSamples
+    reader = std::make_unique<juce::BufferingAudioReader>(fileReader, readAheadThread,
+                                                          readAheadSamples - readAheadBlockSamples);
+
+    // The audio thread must never wait: missing blocks come back as silence
+    reader->setReadTimeout(0);
+    return true;
+}
+
+bool StreamingStemSource::read(juce::AudioBuffer<float>& destination, int destStartSample, int numSamples,
+                               juce::int64 sourceStartSample)
+{
+    // Whatever falls inside the resident head comes straight from memory
+    int fromHead = 0;
+    if (sourceStartSample < head.getNumSamples())
+    {
+        fromHead = (int) juce::jmin((juce::int64) numSamples, (juce::int64) head.getNumSamples() - sourceStartSample);
+        copyStemSamples(head, sourceStartSample, destination, destStartSample, fromHead);
+    }
+
+    const int remaining = numSamples - fromHead;
+    if (remaining <= 0)
+        return true;
+
+    // The cache file holds float samples, so the reader fills float channels directly
+    float* channels[2] = {};
+    const int numDestChannels = juce::jmin(2, destination.getNumChannels());
+    for (int ch = 0; ch < numDestChannels; ++ch)
+        channels[ch] = destination.getWritePointer(ch, destStartSample + fromHead);
+
+    const bool complete = reader->read(reinterpret_cast<int* const*>(channels), numDestChannels,
+                                       sourceStartSample + fromHead, remaining, true);
+
+    for (int ch = numDestChannels; ch < destination.getNumChannels(); ++ch)
+        destination.copyFrom(ch, destStartSample + fromHead, destination, 0, destStartSample + fromHead, remaining);
+
+    return complete;
+}
+
+size_t StreamingStemSource::getResidentBytes() const
+{
+    const auto samples = (size_t) head.getNumSamples() + (size_t) overview.getNumSamples() + (size_t) readAheadSamples;
+    return samples * (size_t) numChannels * sizeof(float);
+}
+
+SharedAudio StreamingStemSource::readEntireStem() const
+{
+    // A reader of its own, so the playback read-ahead is left alone
+    auto fileReader = openCacheFile(cacheFile);
+    if (fileReader == nullptr)
+        return {};
+
+    juce::AudioBuffer<float> stem(numChannels, (int) lengthInSamples);
+    if (!fileReader->read(&stem, 0, stem.getNumSamples(), 0, true, true))
+        return {};
+
+    return SharedAudio(std::move(stem));
+}
+
+StemSourcePtr StreamingStemSource::createFileReader() const
+{
+    auto fileReader = openCacheFile(cacheFile);
+    if (fileReader == nullptr)
+        return nullptr;
+
+    return std::make_shared<CacheFileStemSource>(std::move(fileReader));
+}
+
+} // namespace audio
+} // namespace undergroundBeats
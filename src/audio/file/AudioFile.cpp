@@ -152,7 +152,7 @@ void AudioFile::clear()
 
 void AudioFile::initializeFormatManager()
 {
-    formatManager.registerBasicFormats();  // Register basic formats like wav, aiff
+    formatManager.registerBasicFormats();  // WAV, AIFF, FLAC, Ogg Vorbis and (with JUCE_USE_MP3AUDIOFORMAT) MP3
 }
 
 } // namespace file
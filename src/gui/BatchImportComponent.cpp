@@ -0,0 +1,133 @@
+#include "../../include/undergroundBeats/gui/BatchImportComponent.h"
+
+namespace undergroundBeats {
+
+//==============================================================================
+BatchImportComponent::BatchImportComponent(audio::BatchImportQueue& queue)
+    : importQueue(queue)
+{
+    titleLabel.setFont(juce::Font(14.0f, juce::Font::bold));
+    addAndMakeVisible(titleLabel);
+
+    jobList.setRowHeight(34);
+    jobList.setColour(juce::ListBox::backgroundColourId, juce::Colours::transparentBlack);
+    addAndMakeVisible(jobList);
+
+    cancelButton.setTooltip("Cancel every queued and running import");
+    cancelButton.onClick = [this] { importQueue.cancelAll(); };
+    addAndMakeVisible(cancelButton);
+
+    clearButton.setTooltip("Remove finished imports from the list");
+    clearButton.onClick = [this] { importQueue.clearFinished(); };
+    addAndMakeVisible(clearButton);
+
+    importQueue.addListener(this);
+    batchImportChanged();
+}
+
+BatchImportComponent::~BatchImportComponent()
+{
+    importQueue.removeListener(this);
+    stopTimer();
+}
+
+void BatchImportComponent::resized()
+{
+    auto bounds = getLocalBounds().reduced(4);
+
+    auto header = bounds.removeFromTop(24);
+    clearButton.setBounds(header.removeFromRight(50).reduced(2));
+    cancelButton.setBounds(header.removeFromRight(56).reduced(2));
+    titleLabel.setBounds(header);
+
+    jobList.setBounds(bounds);
+}
+
+void BatchImportComponent::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::darkgrey.darker(0.6f));
+    g.setColour(juce::Colours::grey);
+    g.drawHorizontalLine(0, 0.0f, (float) getWidth());
+}
+
+//==============================================================================
+int BatchImportComponent::getNumRows()
+{
+    return (int) jobs.size();
+}
+
+void BatchImportComponent::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool)
+{
+    if (rowNumber < 0 || rowNumber >= (int) jobs.size())
+        return;
+
+    const auto& job = jobs[(size_t) rowNumber];
+    auto bounds = juce::Rectangle<int>(0, 0, width, height).reduced(2, 1);
+
+    g.setColour(juce::Colours::white);
+    g.setFont(12.0f);
+    g.drawFittedText(job.file.getFileName(), bounds.removeFromTop(height / 2), juce::Justification::centredLeft, 1);
+
+    // The bar shows the current stage's progress; finished jobs show a full bar
+    using State = audio::BatchImportQueue::JobState;
+    const bool done = job.state == State::Finished || job.state == State::Failed || job.state == State::Cancelled;
+    const float fraction = done ? 1.0f : job.state == State::Running ? job.progress : 0.0f;
+
+    const auto barColour = job.state == State::Failed      ? juce::Colours::indianred
+                           : job.state == State::Cancelled ? juce::Colours::grey
+                           : job.state == State::Finished  ? juce::Colours::seagreen
+                                                           : juce::Colours::steelblue;
+
+    auto bar = bounds.reduced(0, 1);
+    g.setColour(juce::Colours::black.withAlpha(0.4f));
+    g.fillRect(bar);
+    g.setColour(barColour);
+    g.fillRect(bar.withWidth(juce::roundToInt((float) bar.getWidth() * juce::jlimit(0.0f, 1.0f, fraction))));
+
+    g.setColour(juce::Colours::white);
+    g.setFont(11.0f);
+    g.drawFittedText(describe(job), bar.reduced(3, 0), juce::Justification::centredLeft, 1);
+}
+
+//==============================================================================
+void BatchImportComponent::batchImportChanged()
+{
+    const bool hadJobs = !jobs.empty();
+    jobs = importQueue.getJobs();
+
+    jobList.updateContent();
+    jobList.repaint();
+
+    if (importQueue.isBusy())
+        startTimerHz(10);
+    else
+        stopTimer();
+
+    if (hadJobs != !jobs.empty() && onHasJobsChanged)
+        onHasJobsChanged(!jobs.empty());
+}
+
+void BatchImportComponent::timerCallback()
+{
+    jobs = importQueue.getJobs();
+    jobList.repaint();
+}
+
+juce::String BatchImportComponent::describe(const audio::BatchImportQueue::JobInfo& job)
+{
+    using State = audio::BatchImportQueue::JobState;
+
+    switch (job.state)
+    {
+        case State::Queued:           return "Queued";
+        case State::WaitingForMemory: return "Waiting for memory";
+        case State::Running:          return audio::StemLoadPipeline::getStageName(job.stage);
+        case State::Finished:         return job.wasCached ? "Already cached" : "Done";
+        case State::Failed:           return "Failed: " + job.error;
+        case State::Cancelled:        return "Cancelled";
+    }
+
+    return {};
+}
+
+} // namespace undergroundBeats
@@ -17,6 +17,7 @@
 #include "../../include/undergroundBeats/gui/EffectIconBarComponent.h"
 #include "../../include/undergroundBeats/gui/SampleBrowserComponent.h"
 #include "../../include/undergroundBeats/gui/StemControlPanel.h"
+#include "../../include/undergroundBeats/gui/BatchImportComponent.h"
 #include "../../include/undergroundBeats/UndergroundBeatsProcessor.h"
 
 namespace undergroundBeats
@@ -103,15 +104,30 @@ MainEditor::MainEditor(UndergroundBeatsProcessor& processor)
         sidebar->getSampleBrowser()->onSampleDropped = [this](const juce::File& file) 
         {
             DBG("MainEditor: Sample dropped, triggering processor load for: " + file.getFileName());
-            processorRef.loadAudioFile(file);
+            processorRef.loadAudioFileAsync(file);
         };
         sidebar->getSampleBrowser()->onFileChosenForProcessing = [this](const juce::File& file) 
         {
              DBG("MainEditor: File chosen in browser, triggering processor load for: " + file.getFileName());
-             processorRef.loadAudioFile(file);
+             processorRef.loadAudioFileAsync(file);
+        };
+        sidebar->getSampleBrowser()->onFilesDroppedForBatch = [this](const juce::Array<juce::File>& files)
+        {
+            DBG("MainEditor: " + juce::String(files.size()) + " files dropped, queuing background import");
+            processorRef.importFilesInBackground(files);
         };
     }
 
+    // The import list only takes space while it has jobs
+    batchImportPanel = std::make_unique<BatchImportComponent>(processorRef.getBatchImportQueue());
+    batchImportPanel->onHasJobsChanged = [this](bool hasJobs)
+    {
+        batchImportPanel->setVisible(hasJobs);
+        resized();
+    };
+    addChildComponent(batchImportPanel.get());
+    batchImportPanel->setVisible(!processorRef.getBatchImportQueue().getJobs().empty());
+
     // Connect effect buttons to toggle functions
     effectIconBar->eqButton.onClick = [this] { toggleEQPanel(); };
     effectIconBar->compButton.onClick = [this] { toggleCompressorPanel(); };
@@ -121,12 +137,18 @@ MainEditor::MainEditor(UndergroundBeatsProcessor& processor)
     effectIconBar->saturationButton.onClick = [this] { toggleSaturationPanel(); };
     effectIconBar->styleButton.onClick = [this] { toggleStyleTransferPanel(); };
     
+    // Load progress is only shown while a file is being loaded
+    addChildComponent(loadProgressBar);
+    processorRef.getLoadPipeline().addListener(this);
+
     // Start timer to check for processor updates
     startTimerHz(10); // Check 10 times per second
 }
 
 MainEditor::~MainEditor()
 {
+    processorRef.getLoadPipeline().removeListener(this);
+
     // Stop timer
     stopTimer();
     
@@ -157,24 +179,24 @@ void MainEditor::timerCallback()
 
 void MainEditor::updateStemDisplays()
 {
-    // Get the separated stem buffers from the processor
-    const auto& stemBuffers = processorRef.getSeparatedStemBuffers();
+    // Get the stems from the processor
+    const auto& stemSources = processorRef.getStemSources();
     
     // If no stems, clear any existing displays
-    if (stemBuffers.empty())
+    if (stemSources.empty())
     {
         stemPanels.clear();
         resized(); // Trigger layout update
         return;
     }
     
-    // Names and colors for the different stems
-    const juce::String stemNames[] = { "Drums", "Bass", "Vocals", "Other" };
+    // Colors for the different stems; names come from the separator that made them
+    const auto& stemNames = processorRef.getStemNames();
     const juce::Colour stemColors[] = { juce::Colours::red, juce::Colours::blue, 
                                        juce::Colours::green, juce::Colours::yellow };
     
     // Resize the panel vector to match the number of stems
-    int numStems = static_cast<int>(stemBuffers.size());
+    int numStems = static_cast<int>(stemSources.size());
     
     // Remove excess panels if needed
     while (stemPanels.size() > numStems)
@@ -186,18 +208,20 @@ void MainEditor::updateStemDisplays()
     while (stemPanels.size() < numStems)
     {
         int idx = static_cast<int>(stemPanels.size());
-        juce::String name = (idx < 4) ? stemNames[idx] : "Stem " + juce::String(idx + 1);
         juce::Colour color = (idx < 4) ? stemColors[idx] : juce::Colours::white;
         
-        auto panel = std::make_unique<StemControlPanel>(name, color);
+        auto panel = std::make_unique<StemControlPanel>("Stem " + juce::String(idx + 1), color);
         stemContainer->addAndMakeVisible(panel.get());
         stemPanels.push_back(std::move(panel));
     }
     
-    // Update each panel with its corresponding buffer and connect to processor
+    // Update each panel with its stem's waveform (an overview for streamed stems) and connect to processor
     for (int i = 0; i < numStems; ++i)
     {
-        stemPanels[i]->setAudioBuffer(&stemBuffers[i]);
+        const juce::String name = (i < (int) stemNames.size()) ? juce::String(stemNames[(size_t) i]) : juce::String();
+        stemPanels[i]->setStemName(name.isNotEmpty() ? name.substring(0, 1).toUpperCase() + name.substring(1)
+                                                     : "Stem " + juce::String(i + 1));
+        stemPanels[i]->setAudioBuffer(stemSources[i] != nullptr ? stemSources[i]->getDisplayBuffer() : nullptr);
         stemPanels[i]->setProcessorAndStem(&processorRef, i); // Connect to processor
     }
     
@@ -206,6 +230,28 @@ void MainEditor::updateStemDisplays()
     DBG("MainEditor: Updated " + juce::String(stemPanels.size()) + " stem panels");
 }
 
+void MainEditor::loadProgressChanged(audio::StemLoadPipeline::Stage stage, float progress)
+{
+    using Stage = audio::StemLoadPipeline::Stage;
+
+    const bool active = stage != Stage::Idle && stage != Stage::Finished && stage != Stage::Cancelled;
+    loadProgress = (stage == Stage::Failed) ? 1.0 : (double) progress;
+    loadProgressBar.setTextToDisplay(audio::StemLoadPipeline::getStageName(stage));
+    loadProgressBar.setVisible(active);
+
+    if (active)
+        loadProgressBar.toFront(false);
+
+    // A preview's waveforms fill in as each segment is separated; fetching the display
+    // buffers again draws the segments finished since the last update
+    if (stage == Stage::Separate)
+    {
+        const auto& stemSources = processorRef.getStemSources();
+        for (size_t i = 0; i < stemPanels.size() && i < stemSources.size(); ++i)
+            stemPanels[i]->setAudioBuffer(stemSources[i] != nullptr ? stemSources[i]->getDisplayBuffer() : nullptr);
+    }
+}
+
 void MainEditor::paint(juce::Graphics& g)
 {
     // (Our component is opaque, so we must fill the background with a solid colour)
@@ -223,15 +269,20 @@ void MainEditor::resized()
     int topBarHeight = 50;
     int transportHeight = 80;
     int iconBarHeight = 40;
+    int batchImportHeight = 200;
 
     // Layout main areas - requires full definitions
     topBar->setBounds(bounds.removeFromTop(topBarHeight));
-    sidebar->setBounds(bounds.removeFromLeft(sidebarWidth));
+    auto sidebarArea = bounds.removeFromLeft(sidebarWidth);
+    if (batchImportPanel->isVisible())
+        batchImportPanel->setBounds(sidebarArea.removeFromBottom(batchImportHeight));
+    sidebar->setBounds(sidebarArea);
     transportControls->setBounds(bounds.removeFromBottom(transportHeight));
     effectIconBar->setBounds(bounds.removeFromTop(iconBarHeight));
 
     // Main content area now contains stems and effect panels
     stemContainer->setBounds(bounds);
+    loadProgressBar.setBounds(stemContainer->getBounds().removeFromTop(24).reduced(4, 2));
     
     // Layout the stem panels vertically with proper spacing
     int numStems = static_cast<int>(stemPanels.size());
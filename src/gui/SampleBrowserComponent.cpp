@@ -1,5 +1,6 @@
 #include "../../include/undergroundBeats/gui/SampleBrowserComponent.h"
 #include "JuceHeader.h"
+#include <algorithm>
 
 namespace undergroundBeats {
 
@@ -163,16 +164,64 @@ bool SampleBrowserComponent::isInterestedInFileDrag(const juce::StringArray& fil
         {
             return true;
         }
+
+        // Folders are imported as a batch
+        if (onFilesDroppedForBatch && file.isDirectory())
+        {
+            return true;
+        }
     }
     return false;
 }
 
+juce::Array<juce::File> SampleBrowserComponent::findSuitableFiles(const juce::StringArray& paths) const
+{
+    juce::Array<juce::File> suitable;
+
+    for (const auto& path : paths)
+    {
+        juce::File file(path);
+
+        if (file.isDirectory())
+        {
+            auto children = file.findChildFiles(juce::File::findFiles, true);
+            children.sort();
+
+            for (const auto& child : children)
+                if (fileFilter.isFileSuitable(child))
+                    suitable.add(child);
+        }
+        else if (fileFilter.isFileSuitable(file))
+        {
+            suitable.add(file);
+        }
+    }
+
+    return suitable;
+}
+
 void SampleBrowserComponent::filesDropped(const juce::StringArray& files, int x, int y)
 {
     DBG("SampleBrowserComponent: filesDropped");
     isShowingDragHighlight = false;
     repaint();
 
+    // Several files or a folder go to the background import instead of replacing the current track
+    if (onFilesDroppedForBatch)
+    {
+        const bool droppedFolder = std::any_of(files.begin(), files.end(),
+                                               [](const juce::String& path) { return juce::File(path).isDirectory(); });
+        const auto suitableFiles = findSuitableFiles(files);
+
+        if (droppedFolder || suitableFiles.size() > 1)
+        {
+            DBG("Batch of " + juce::String(suitableFiles.size()) + " files dropped");
+            if (!suitableFiles.isEmpty())
+                onFilesDroppedForBatch(suitableFiles);
+            return;
+        }
+    }
+
     for (const auto& file : files)
     {
         juce::File droppedFile(file);
@@ -21,8 +21,48 @@ TopBarComponent::TopBarComponent(UndergroundBeatsProcessor& processor, SidebarCo
     loadButton.addListener(this);
     loadButton.setEnabled(false); // Initially disabled
 
+    addAndMakeVisible(undoButton);
+    undoButton.addListener(this);
+
+    addAndMakeVisible(redoButton);
+    redoButton.addListener(this);
+
+    storeMorphAButton.setTooltip("Store the current sound as morph snapshot A");
+    addAndMakeVisible(storeMorphAButton);
+    storeMorphAButton.addListener(this);
+
+    storeMorphBButton.setTooltip("Store the current sound as morph snapshot B");
+    addAndMakeVisible(storeMorphBButton);
+    storeMorphBButton.addListener(this);
+
+    morphSlider.setTooltip("Morph between snapshots A and B");
+    addAndMakeVisible(morphSlider);
+    morphAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        processorRef.getValueTreeState(), UndergroundBeatsProcessor::presetMorphParameterID, morphSlider);
+
     addAndMakeVisible(saveButton);
     saveButton.addListener(this);
+
+    exportButton.setTooltip("Render the mix or the processed stems to audio files");
+    addAndMakeVisible(exportButton);
+    exportButton.addListener(this);
+
+    processorRef.getOfflineRenderer().onFinished = [this](const juce::Result& result)
+    {
+        stopTimer();
+        exportButton.setButtonText("Export");
+
+        if (result.failed() && result.getErrorMessage() != "Cancelled")
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export failed",
+                                                   result.getErrorMessage());
+    };
+
+    // The editor may be reopened while a render runs
+    if (processorRef.getOfflineRenderer().isRendering())
+    {
+        timerCallback();
+        startTimerHz(10);
+    }
     
     addAndMakeVisible(settingsButton);
     settingsButton.addListener(this);
@@ -44,6 +84,9 @@ TopBarComponent::TopBarComponent(UndergroundBeatsProcessor& processor, SidebarCo
 
 TopBarComponent::~TopBarComponent()
 {
+    stopTimer();
+    processorRef.getOfflineRenderer().onFinished = nullptr;
+
     // Stop listening
     // Check if pointer is valid before removing listener
     if (auto* browser = sidebarRef.getSampleBrowser())
@@ -78,7 +121,13 @@ void TopBarComponent::resized()
     area.removeFromRight(spacing);
     saveButton.setBounds(area.removeFromRight(buttonWidth));
     area.removeFromRight(spacing);
+    exportButton.setBounds(area.removeFromRight(buttonWidth));
+    area.removeFromRight(spacing);
     loadButton.setBounds(area.removeFromRight(buttonWidth));
+    area.removeFromRight(spacing);
+    redoButton.setBounds(area.removeFromRight(buttonWidth));
+    area.removeFromRight(spacing);
+    undoButton.setBounds(area.removeFromRight(buttonWidth));
 
     // Save status indicator (small circle) to left of project name
     auto leftArea = area.removeFromLeft(200);
@@ -86,6 +135,13 @@ void TopBarComponent::resized()
     saveStatusIndicator.setBounds(leftArea.removeFromLeft(indicatorSize).reduced(2));
 
     projectNameLabel.setBounds(leftArea);
+
+    // Morph controls take the space between the project name and the buttons
+    const int morphButtonWidth = 30;
+    area.removeFromLeft(spacing);
+    storeMorphAButton.setBounds(area.removeFromLeft(morphButtonWidth));
+    storeMorphBButton.setBounds(area.removeFromRight(morphButtonWidth));
+    morphSlider.setBounds(area.reduced(spacing, 0));
 }
 
 void TopBarComponent::buttonClicked(juce::Button* button)
@@ -96,13 +152,36 @@ void TopBarComponent::buttonClicked(juce::Button* button)
         if (currentlySelectedFile.existsAsFile())
         {
              DBG("TopBar: Loading selected file: " + currentlySelectedFile.getFullPathName());
-             processorRef.loadAudioFile(currentlySelectedFile);
+             processorRef.loadAudioFileAsync(currentlySelectedFile);
         }
         else
         {
             DBG("TopBar: No valid file selected to load.");
         }
     }
+    else if (button == &undoButton)
+    {
+        // Close the open transaction first so the step being undone is complete
+        processorRef.beginUndoTransaction();
+        processorRef.getUndoManager().undo();
+    }
+    else if (button == &redoButton)
+    {
+        processorRef.getUndoManager().redo();
+    }
+    else if (button == &storeMorphAButton || button == &storeMorphBButton)
+    {
+        processorRef.setMorphPair(0, 1);
+        processorRef.storeMorphSnapshot(button == &storeMorphAButton ? 0 : 1);
+    }
+    else if (button == &exportButton)
+    {
+        // While rendering, the button cancels
+        if (processorRef.getOfflineRenderer().isRendering())
+            processorRef.getOfflineRenderer().cancel();
+        else
+            showExportMenu();
+    }
     else if (button == &saveButton)
     {
         DBG("TopBar: Save button clicked - Not implemented.");
@@ -117,6 +196,64 @@ void TopBarComponent::buttonClicked(juce::Button* button)
     }
 }
 
+void TopBarComponent::timerCallback()
+{
+    const auto percent = juce::roundToInt(processorRef.getOfflineRenderer().getProgress() * 100.0f);
+    exportButton.setButtonText("Cancel " + juce::String(percent) + "%");
+}
+
+void TopBarComponent::showExportMenu()
+{
+    juce::PopupMenu menu;
+    menu.addItem(1, "Mix (24-bit)");
+    menu.addItem(2, "Mix and stems (24-bit)");
+    menu.addItem(3, "Mix and stems (32-bit float, WAV)");
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&exportButton),
+                       [safeThis = juce::Component::SafePointer<TopBarComponent>(this)](int choice)
+                       {
+                           if (safeThis != nullptr && choice > 0)
+                               safeThis->chooseExportFile(choice >= 2, choice == 3);
+                       });
+}
+
+void TopBarComponent::chooseExportFile(bool includeStems, bool asFloat)
+{
+    exportChooser = std::make_unique<juce::FileChooser>(
+        "Export mix", juce::File::getSpecialLocation(juce::File::userMusicDirectory).getChildFile("Mix.wav"),
+        "*.wav;*.flac");
+
+    const auto flags = juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles
+                       | juce::FileBrowserComponent::warnAboutOverwriting;
+
+    exportChooser->launchAsync(flags, [this, includeStems, asFloat](const juce::FileChooser& chooser)
+    {
+        const auto file = chooser.getResult();
+        if (file == juce::File())
+            return;
+
+        // Stems are written next to the mix, named after it
+        audio::OfflineRenderer::Options options;
+        options.outputDirectory = file.getParentDirectory();
+        options.baseName = file.getFileNameWithoutExtension();
+        options.includeStems = includeStems;
+        options.fileFormat = file.hasFileExtension(".flac") ? audio::OfflineRenderer::FileFormat::Flac
+                                                            : audio::OfflineRenderer::FileFormat::Wav;
+        options.sampleFormat = asFloat ? audio::OfflineRenderer::SampleFormat::Float32
+                                       : audio::OfflineRenderer::SampleFormat::Int24;
+
+        if (processorRef.startOfflineRender(options))
+        {
+            timerCallback();
+            startTimerHz(10);
+        }
+        else
+        {
+            DBG("TopBar: Export not started - no stems loaded or a render is running.");
+        }
+    });
+}
+
 void TopBarComponent::changeListenerCallback(juce::ChangeBroadcaster* source)
 {
     // Check if the change came from the sample browser we are listening to
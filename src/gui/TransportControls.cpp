@@ -21,15 +21,23 @@ TransportControls::TransportControls()
     stopButton.setColour(juce::TextButton::buttonColourId, juce::Colours::darkred);
     stopButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::red);
     
+    recordButton.setButtonText("Rec");
+    recordButton.setTooltip("Record automation");
+    recordButton.setClickingTogglesState(true);
+    recordButton.setColour(juce::TextButton::buttonColourId, juce::Colours::darkgrey);
+    recordButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::red);
+    
     // Add buttons to the component
     addAndMakeVisible(playButton);
     addAndMakeVisible(pauseButton);
     addAndMakeVisible(stopButton);
+    addAndMakeVisible(recordButton);
     
     // Set up listeners
     playButton.addListener(this);
     pauseButton.addListener(this);
     stopButton.addListener(this);
+    recordButton.addListener(this);
     
     // Enable buttons - we'll handle processor state in the callbacks
     playButton.setEnabled(true);
@@ -55,15 +63,23 @@ TransportControls::TransportControls(UndergroundBeatsProcessor& processor)
     stopButton.setColour(juce::TextButton::buttonColourId, juce::Colours::darkred);
     stopButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::red);
     
+    recordButton.setButtonText("Rec");
+    recordButton.setTooltip("Record automation");
+    recordButton.setClickingTogglesState(true);
+    recordButton.setColour(juce::TextButton::buttonColourId, juce::Colours::darkgrey);
+    recordButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::red);
+    
     // Add buttons to the component
     addAndMakeVisible(playButton);
     addAndMakeVisible(pauseButton);
     addAndMakeVisible(stopButton);
+    addAndMakeVisible(recordButton);
     
     // Set up listeners
     playButton.addListener(this);
     pauseButton.addListener(this);
     stopButton.addListener(this);
+    recordButton.addListener(this);
     
     // Enable buttons
     playButton.setEnabled(true);
@@ -80,6 +96,7 @@ TransportControls::~TransportControls()
     playButton.removeListener(this);
     pauseButton.removeListener(this);
     stopButton.removeListener(this);
+    recordButton.removeListener(this);
 }
 
 //==============================================================================
@@ -96,11 +113,12 @@ void TransportControls::paint(juce::Graphics& g)
 void TransportControls::resized()
 {
     auto bounds = getLocalBounds().reduced(4);
-    int buttonWidth = bounds.getWidth() / 3;
+    int buttonWidth = bounds.getWidth() / 4;
     
     playButton.setBounds(bounds.removeFromLeft(buttonWidth).reduced(4));
     pauseButton.setBounds(bounds.removeFromLeft(buttonWidth).reduced(4));
-    stopButton.setBounds(bounds.reduced(4));
+    stopButton.setBounds(bounds.removeFromLeft(buttonWidth).reduced(4));
+    recordButton.setBounds(bounds.reduced(4));
 }
 
 //==============================================================================
@@ -115,6 +133,15 @@ void TransportControls::buttonClicked(juce::Button* button)
 {
     DBG("TransportControls::buttonClicked called");
     
+    // The record button is a toggle and keeps its own colour
+    if (button == &recordButton)
+    {
+        DBG("Transport: Automation record " << (recordButton.getToggleState() ? "armed" : "disarmed"));
+        if (audioProcessor != nullptr)
+            audioProcessor->setAutomationRecording(recordButton.getToggleState());
+        return;
+    }
+    
     // First, provide visual feedback
     button->setColour(juce::TextButton::buttonColourId, juce::Colours::white);
     startTimer(200); // Start a timer to reset the color after a short delay
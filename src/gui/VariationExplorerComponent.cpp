@@ -109,10 +109,10 @@ void VariationExplorerComponent::clearVariations()
 
 void VariationExplorerComponent::addVariation(
     const std::string& variationId,
-    const juce::AudioBuffer<float>& audioBuffer,
+    const audio::SharedAudio& variationAudio,
     const std::string& componentName) // Added componentName
 {
-    if (audioBuffer.getNumSamples() == 0) {
+    if (!variationAudio.isValid() || variationAudio->getNumChannels() == 0 || variationAudio->getNumSamples() == 0) {
         DBG("VariationExplorerComponent::addVariation: Skipping empty buffer for ID " + variationId);
         return;
     }
@@ -120,20 +120,15 @@ void VariationExplorerComponent::addVariation(
     VariationInfo info;
     info.id = variationId;
     info.componentName = componentName; // Store component name
+    info.sharedAudio = variationAudio;
 
     info.thumbnailComponent = std::make_unique<VariationThumbnailComponent>(
         variationId, componentName, formatManager, thumbnailCache, this); // Pass componentName
 
     // --- Create Thumbnail Source (similar to MainEditor::createComponentUI) ---
-    auto numChannels = juce::jmax(1, audioBuffer.getNumChannels());
-    auto bufferToUse = std::make_unique<juce::AudioBuffer<float>>(numChannels, audioBuffer.getNumSamples());
-    for (int ch = 0; ch < numChannels; ++ch) {
-        if (ch < audioBuffer.getNumChannels()) {
-            bufferToUse->copyFrom(ch, 0, audioBuffer, ch, 0, audioBuffer.getNumSamples());
-        } else {
-            bufferToUse->clear(ch, 0, audioBuffer.getNumSamples());
-        }
-    }
+    // The writer reads the shared audio directly, so no copy is made for the thumbnail
+    const auto& audioBuffer = *variationAudio;
+    auto numChannels = audioBuffer.getNumChannels();
 
     juce::MemoryOutputStream memoryStream;
     std::unique_ptr<juce::AudioFormatWriter> writer(
@@ -141,7 +136,7 @@ void VariationExplorerComponent::addVariation(
                                                                          44100.0, // Assume SR or get from controller if possible
                                                                          numChannels, 16, {}, 0));
     if (writer) {
-        writer->writeFromAudioSampleBuffer(*bufferToUse, 0, bufferToUse->getNumSamples());
+        writer->writeFromAudioSampleBuffer(audioBuffer, 0, audioBuffer.getNumSamples());
         writer = nullptr; // Flush
         auto inputSource = std::make_unique<juce::MemoryInputSource>(memoryStream.getData(), memoryStream.getDataSize(), false);
         info.thumbnailComponent->setSource(std::move(inputSource));
@@ -158,6 +153,16 @@ void VariationExplorerComponent::addVariation(
     resized();
 }
 
+audio::SharedAudio VariationExplorerComponent::getVariationAudio(const std::string& variationId) const
+{
+    for (const auto& info : variations) {
+        if (info.id == variationId) {
+            return info.sharedAudio;
+        }
+    }
+    return {};
+}
+
 
 void VariationExplorerComponent::paint(juce::Graphics& g)
 {
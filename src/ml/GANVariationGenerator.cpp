@@ -55,18 +55,37 @@ std::vector<juce::AudioBuffer<float>> GANVariationGenerator::generateVariations(
     int numVariations,
     float creativityFactor) {
     
+    auto sharedVariations = generateVariations(audio::SharedAudio::copyOf(inputBuffer), numVariations, creativityFactor);
+    
     std::vector<juce::AudioBuffer<float>> variations;
+    variations.reserve(sharedVariations.size());
+    
+    for (auto& variation : sharedVariations) {
+        variations.push_back(variation.release());
+    }
+    
+    return variations;
+}
+
+std::vector<audio::SharedAudio> GANVariationGenerator::generateVariations(
+    const audio::SharedAudio& input,
+    int numVariations,
+    float creativityFactor) {
+    
+    std::vector<audio::SharedAudio> variations;
     
     if (!isInitialized) {
         juce::Logger::writeToLog("GANVariationGenerator: Not initialized");
         return variations;
     }
     
-    if (inputBuffer.getNumSamples() == 0) {
+    if (!input.isValid() || input->getNumSamples() == 0) {
         juce::Logger::writeToLog("GANVariationGenerator: Empty input buffer");
         return variations;
     }
     
+    const auto& inputBuffer = *input;
+    
     // Preprocess the input audio
     std::vector<float> preprocessedInput = preprocessAudio(inputBuffer);
     
@@ -108,11 +127,8 @@ std::vector<juce::AudioBuffer<float>> GANVariationGenerator::generateVariations(
         // Get the output data
         auto& outputData = modelOutputs[outputNames[0]];
         
-        // Postprocess the output
-        auto variationBuffer = postprocessOutput(outputData, inputBuffer);
-        
-        // Add to variations
-        variations.push_back(std::move(variationBuffer));
+        // Postprocess the output and take ownership of it without a copy
+        variations.emplace_back(postprocessOutput(outputData, inputBuffer));
     }
     
     // If we failed to generate variations with the model, fall back to simulated variations
@@ -121,12 +137,8 @@ std::vector<juce::AudioBuffer<float>> GANVariationGenerator::generateVariations(
         
         // Generate simulated variations by applying different processing to the input
         for (int i = 0; i < numVariations; ++i) {
-            juce::AudioBuffer<float> variation(inputBuffer.getNumChannels(), inputBuffer.getNumSamples());
-            
-            // Copy the original audio
-            for (int channel = 0; channel < inputBuffer.getNumChannels(); ++channel) {
-                variation.copyFrom(channel, 0, inputBuffer, channel, 0, inputBuffer.getNumSamples());
-            }
+            // Start as a handle to the input; the audio is only copied by the first write
+            audio::SharedAudio variation = input;
             
             // Apply variation based on index
             float variationAmount = creativityFactor * 0.5f;
@@ -157,7 +169,7 @@ std::vector<juce::AudioBuffer<float>> GANVariationGenerator::generateVariations(
                         }
                         
                         // Process with the filter
-                        juce::dsp::AudioBlock<float> block(variation);
+                        juce::dsp::AudioBlock<float> block(variation.write());
                         juce::dsp::ProcessContextReplacing<float> context(block);
                         filter.process(context);
                     }
@@ -166,13 +178,13 @@ std::vector<juce::AudioBuffer<float>> GANVariationGenerator::generateVariations(
                 case 1:
                     // Temporal variation - simulate timing changes
                     {
-                        // Create a temporary buffer
-                        juce::AudioBuffer<float> tempBuffer(variation.getNumChannels(), variation.getNumSamples());
+                        // Render into a new buffer straight from the input
+                        juce::AudioBuffer<float> tempBuffer(inputBuffer.getNumChannels(), inputBuffer.getNumSamples());
                         tempBuffer.clear();
                         
                         // Apply slight time stretching/compression in segments
                         const int numSegments = 8;
-                        const int segmentSize = variation.getNumSamples() / numSegments;
+                        const int segmentSize = inputBuffer.getNumSamples() / numSegments;
                         
                         for (int segment = 0; segment < numSegments; ++segment) {
                             // Randomize time stretch factor per segment
@@ -193,8 +205,8 @@ std::vector<juce::AudioBuffer<float>> GANVariationGenerator::generateVariations(
                             }
                             
                             // Simple resampling
-                            for (int channel = 0; channel < variation.getNumChannels(); ++channel) {
-                                const float* sourceData = variation.getReadPointer(channel, sourceStart);
+                            for (int channel = 0; channel < inputBuffer.getNumChannels(); ++channel) {
+                                const float* sourceData = inputBuffer.getReadPointer(channel, sourceStart);
                                 float* destData = tempBuffer.getWritePointer(channel, destStart);
                                 
                                 for (int destSample = 0; destSample < destLength; ++destSample) {
@@ -212,10 +224,8 @@ std::vector<juce::AudioBuffer<float>> GANVariationGenerator::generateVariations(
                             }
                         }
                         
-                        // Copy back to variation buffer
-                        for (int channel = 0; channel < variation.getNumChannels(); ++channel) {
-                            variation.copyFrom(channel, 0, tempBuffer, channel, 0, variation.getNumSamples());
-                        }
+                        // The new buffer becomes the variation; nothing is copied back
+                        variation = audio::SharedAudio(std::move(tempBuffer));
                     }
                     break;
                     
@@ -233,12 +243,12 @@ std::vector<juce::AudioBuffer<float>> GANVariationGenerator::generateVariations(
                         }
                         
                         // Apply envelope to audio
-                        const int pointDistance = variation.getNumSamples() / (numEnvelopePoints - 1);
+                        const int pointDistance = variation->getNumSamples() / (numEnvelopePoints - 1);
                         
-                        for (int channel = 0; channel < variation.getNumChannels(); ++channel) {
-                            float* data = variation.getWritePointer(channel);
+                        for (int channel = 0; channel < variation->getNumChannels(); ++channel) {
+                            float* data = variation.write().getWritePointer(channel);
                             
-                            for (int sample = 0; sample < variation.getNumSamples(); ++sample) {
+                            for (int sample = 0; sample < variation->getNumSamples(); ++sample) {
                                 int pointIndex = sample / pointDistance;
                                 float alpha = static_cast<float>(sample % pointDistance) / pointDistance;
                                 
@@ -262,10 +272,10 @@ std::vector<juce::AudioBuffer<float>> GANVariationGenerator::generateVariations(
                         drive = juce::jlimit(0.1f, 2.0f, drive);
                         
                         // Apply waveshaping
-                        for (int channel = 0; channel < variation.getNumChannels(); ++channel) {
-                            float* data = variation.getWritePointer(channel);
+                        for (int channel = 0; channel < variation->getNumChannels(); ++channel) {
+                            float* data = variation.write().getWritePointer(channel);
                             
-                            for (int sample = 0; sample < variation.getNumSamples(); ++sample) {
+                            for (int sample = 0; sample < variation->getNumSamples(); ++sample) {
                                 // Simple waveshaping formula
                                 data[sample] = std::tanh(data[sample] * drive) / std::tanh(drive);
                             }
@@ -282,7 +292,7 @@ std::vector<juce::AudioBuffer<float>> GANVariationGenerator::generateVariations(
                         *filter.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(
                             sampleRate, frequency, q, juce::Decibels::decibelsToGain(gain));
                         
-                        juce::dsp::AudioBlock<float> block(variation);
+                        juce::dsp::AudioBlock<float> block(variation.write());
                         juce::dsp::ProcessContextReplacing<float> context(block);
                         filter.process(context);
                     }
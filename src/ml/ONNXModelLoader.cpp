@@ -1,26 +1,329 @@
 // ONNXModelLoader.cpp
 
 #include "../../include/undergroundBeats/ml/ONNXModelLoader.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 namespace undergroundBeats {
 namespace ml {
 
-// Constructor: Initializes the ONNX Runtime environment.
-// We don't load the model here anymore, just create the environment.
+namespace {
+
+// Sizes given to dynamic dimensions when warming up: the first (batch) dimension gets 1 and
+// the second (channels) 2; the rest share warmUpElements between them, none above warmUpDimension
+constexpr int64_t warmUpDimension = 4096;
+constexpr int64_t warmUpElements = int64_t { 1 } << 20;
+
+std::mutex environmentLock;
+std::unique_ptr<Ort::Env> sharedEnvironment;
+ONNXModelLoader::ThreadingSettings threadingSettings;
+
+} // namespace
+
+bool ONNXModelLoader::configureThreading(const ThreadingSettings& settings)
+{
+    std::lock_guard<std::mutex> lock(environmentLock);
+    if (sharedEnvironment != nullptr)
+        return false;
+
+    threadingSettings = settings;
+    return true;
+}
+
+Ort::Env& ONNXModelLoader::getSharedEnvironment()
+{
+    std::lock_guard<std::mutex> lock(environmentLock);
+
+    if (sharedEnvironment == nullptr) {
+        Ort::ThreadingOptions threading;
+        threading.SetGlobalIntraOpNumThreads(threadingSettings.intraOpThreads);
+        threading.SetGlobalInterOpNumThreads(threadingSettings.interOpThreads);
+
+        // Idle workers sleep rather than spin, so they don't take cores from the audio thread
+        threading.SetGlobalSpinControl(0);
+
+        sharedEnvironment = std::make_unique<Ort::Env>(threading, ORT_LOGGING_LEVEL_WARNING, "UndergroundBeats");
+    }
+
+    return *sharedEnvironment;
+}
+
+std::string ONNXModelLoader::SessionSettings::describe() const
+{
+    static const char* const modeNames[] = { "sequential", "parallel" };
+    static const char* const optimizationNames[] = { "disabled", "basic", "extended", "all" };
+    static const char* const providerNames[] = { "cpu", "xnnpack", "onednn" };
+
+    std::string description = useSharedThreadPools
+        ? std::string("shared pools")
+        : "intra " + std::to_string(intraOpThreads) + ", inter " + std::to_string(interOpThreads);
+
+    return description + ", " + modeNames[static_cast<int>(executionMode)]
+           + ", " + optimizationNames[static_cast<int>(optimization)]
+           + ", " + providerNames[static_cast<int>(provider)];
+}
+
+bool ONNXModelLoader::isProviderAvailable(SessionSettings::Provider provider)
+{
+    const char* name = provider == SessionSettings::Provider::Xnnpack ? "XnnpackExecutionProvider"
+                     : provider == SessionSettings::Provider::OneDnn  ? "DnnlExecutionProvider"
+                                                                      : "CPUExecutionProvider";
+
+    for (const auto& available : Ort::GetAvailableProviders())
+        if (available == name)
+            return true;
+
+    return false;
+}
+
+// Constructor: Every loader shares the process-wide environment and its thread pools.
 ONNXModelLoader::ONNXModelLoader()
-    : env(ORT_LOGGING_LEVEL_WARNING, "ONNXModelLoaderEnv")
+    : env(getSharedEnvironment())
 {
-    // Initialization, potentially setup OrtEnv options
 }
 
-// Destructor: Handles any necessary cleanup.
+// Destructor: A session that is still loading can't be interrupted, so wait for it.
 ONNXModelLoader::~ONNXModelLoader()
 {
-    // Destructor logic if needed (OrtEnv handles its own cleanup).
+    preloadPool.removeAllJobs(true, -1);
+}
+
+void ONNXModelLoader::setSessionSettings(const SessionSettings& newSettings)
+{
+    std::lock_guard<std::mutex> lock(sessionLock);
+    settings = newSettings;
+}
+
+ONNXModelLoader::SessionSettings ONNXModelLoader::getSessionSettings() const
+{
+    std::lock_guard<std::mutex> lock(sessionLock);
+    return settings;
+}
+
+Ort::SessionOptions ONNXModelLoader::makeSessionOptions(const SessionSettings& sessionSettings)
+{
+    Ort::SessionOptions options;
+
+    if (sessionSettings.useSharedThreadPools) {
+        options.DisablePerSessionThreads();
+    } else {
+        options.SetIntraOpNumThreads(sessionSettings.intraOpThreads);
+        options.SetInterOpNumThreads(sessionSettings.interOpThreads);
+    }
+
+    options.SetExecutionMode(sessionSettings.executionMode == SessionSettings::ExecutionMode::Parallel
+                                 ? ExecutionMode::ORT_PARALLEL
+                                 : ExecutionMode::ORT_SEQUENTIAL);
+
+    static const GraphOptimizationLevel levels[] = { GraphOptimizationLevel::ORT_DISABLE_ALL,
+                                                     GraphOptimizationLevel::ORT_ENABLE_BASIC,
+                                                     GraphOptimizationLevel::ORT_ENABLE_EXTENDED,
+                                                     GraphOptimizationLevel::ORT_ENABLE_ALL };
+    options.SetGraphOptimizationLevel(levels[static_cast<int>(sessionSettings.optimization)]);
+
+    if (sessionSettings.provider != SessionSettings::Provider::Default) {
+        if (!isProviderAvailable(sessionSettings.provider)) {
+            juce::Logger::writeToLog("ONNXModelLoader: execution provider not available, using the default");
+        } else if (sessionSettings.provider == SessionSettings::Provider::Xnnpack) {
+            options.AppendExecutionProvider("XNNPACK", { { "intra_op_num_threads",
+                                                           std::to_string(sessionSettings.intraOpThreads) } });
+        } else {
+            const auto& api = Ort::GetApi();
+            OrtDnnlProviderOptions* dnnlOptions = nullptr;
+            Ort::ThrowOnError(api.CreateDnnlProviderOptions(&dnnlOptions));
+            auto* status = api.SessionOptionsAppendExecutionProvider_Dnnl(options, dnnlOptions);
+            api.ReleaseDnnlProviderOptions(dnnlOptions);
+            Ort::ThrowOnError(status);
+        }
+    }
+
+    return options;
+}
+
+// Creates a session for the model, or returns nullptr if it is missing or invalid.
+std::unique_ptr<Ort::Session> ONNXModelLoader::loadModel(const std::string& modelPath)
+{
+    return loadModel(modelPath, getSessionSettings());
+}
+
+std::unique_ptr<Ort::Session> ONNXModelLoader::loadModel(const std::string& modelPath, const SessionSettings& sessionSettings)
+{
+    // Relative paths are resolved against the working directory, as ONNX Runtime would
+    auto modelFile = juce::File::getCurrentWorkingDirectory().getChildFile(modelPath);
+    if (!modelFile.existsAsFile())
+        return nullptr;
+
+    const auto createSession = [this](const juce::File& file, const Ort::SessionOptions& options) {
+#ifdef _WIN32
+        const std::wstring path = file.getFullPathName().toWideCharPointer();
+#else
+        const std::string path = file.getFullPathName().toStdString();
+#endif
+        return std::make_unique<Ort::Session>(env, path.c_str(), options);
+    };
+
+    try {
+        auto options = makeSessionOptions(sessionSettings);
+
+        // A graph optimized by an earlier session with the same settings is loaded as it is;
+        // otherwise this session saves the graph it optimizes for the next one
+        if (sessionSettings.optimizedModelDirectory != juce::File()
+            && sessionSettings.provider == SessionSettings::Provider::Default
+            && sessionSettings.optimization != SessionSettings::Optimization::Disabled) {
+            const auto key = juce::String(makeSessionKey(modelPath, sessionSettings));
+            const auto optimizedFile = sessionSettings.optimizedModelDirectory.getChildFile(
+                modelFile.getFileNameWithoutExtension() + "_" + juce::String::toHexString(key.hashCode64()) + ".onnx");
+
+            if (optimizedFile.existsAsFile()) {
+                try {
+                    auto cachedOptions = makeSessionOptions(sessionSettings);
+                    cachedOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+                    return createSession(optimizedFile, cachedOptions);
+                } catch (const Ort::Exception& e) {
+                    // A truncated or stale file, or one from another runtime: optimize the model afresh
+                    juce::Logger::writeToLog("ONNXModelLoader: discarding optimized graph " + optimizedFile.getFullPathName()
+                                             + ": " + e.what());
+                    optimizedFile.deleteFile();
+                }
+            }
+
+            if (sessionSettings.optimizedModelDirectory.createDirectory().wasOk()) {
+#ifdef _WIN32
+                options.SetOptimizedModelFilePath(optimizedFile.getFullPathName().toWideCharPointer());
+#else
+                options.SetOptimizedModelFilePath(optimizedFile.getFullPathName().toRawUTF8());
+#endif
+            }
+        }
+
+        return createSession(modelFile, options);
+    } catch (const Ort::Exception& e) {
+        juce::Logger::writeToLog("ONNXModelLoader: failed to load " + modelFile.getFullPathName() + ": " + e.what());
+        return nullptr;
+    }
+}
+
+std::shared_ptr<Ort::Session> ONNXModelLoader::getSession(const std::string& modelPath)
+{
+    std::promise<std::shared_ptr<Ort::Session>> promise;
+    SessionFuture existing;
+    SessionSettings sessionSettings;
+
+    {
+        std::lock_guard<std::mutex> lock(sessionLock);
+        sessionSettings = settings;
+
+        const auto key = makeSessionKey(modelPath, sessionSettings);
+        const auto entry = sessions.find(key);
+        if (entry != sessions.end())
+            existing = entry->second;
+        else
+            sessions.emplace(key, promise.get_future().share());
+    }
+
+    if (existing.valid())
+        return existing.get();
+
+    // Loaded outside the lock; other callers for this model wait on the future instead
+    std::shared_ptr<Ort::Session> session = loadModel(modelPath, sessionSettings);
+    if (session != nullptr) {
+        try {
+            warmUp(*session);
+        } catch (const std::exception& e) {
+            // The session is cached either way; it just meets its lazy allocations on first use
+            juce::Logger::writeToLog("ONNXModelLoader: warm-up of " + juce::String(modelPath) + " failed: " + e.what());
+        }
+    }
+
+    promise.set_value(session);
+    return session;
+}
+
+void ONNXModelLoader::preloadModels(const std::vector<std::string>& modelPaths)
+{
+    preloadPool.addJob([this, modelPaths] {
+        for (const auto& modelPath : modelPaths)
+            getSession(modelPath);
+    });
+}
+
+void ONNXModelLoader::clearSessions()
+{
+    std::lock_guard<std::mutex> lock(sessionLock);
+    sessions.clear();
+}
+
+std::string ONNXModelLoader::makeSessionKey(const std::string& modelPath, const SessionSettings& sessionSettings)
+{
+    // A replaced model file gets a new session, and so do new settings
+    const auto modelFile = juce::File::getCurrentWorkingDirectory().getChildFile(modelPath);
+    return (modelFile.getFullPathName() + "|" + juce::String(modelFile.getSize())
+            + "|" + juce::String(modelFile.getLastModificationTime().toMilliseconds())).toStdString()
+           + "|" + sessionSettings.describe();
+}
+
+void ONNXModelLoader::warmUp(Ort::Session& session)
+{
+    Ort::AllocatorWithDefaultOptions allocator;
+    const auto memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+
+    std::vector<std::string> inputNames, outputNames;
+    std::vector<std::vector<float>> inputData;
+    std::vector<Ort::Value> inputs;
+    inputData.reserve(session.GetInputCount());
+
+    for (size_t i = 0; i < session.GetInputCount(); ++i) {
+        const auto info = session.GetInputTypeInfo(i).GetTensorTypeAndShapeInfo();
+        if (info.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
+            return; // Only float models are warmed up
+
+        auto shape = info.GetShape();
+        int64_t fixedElements = 1;
+        int numFree = 0;
+        for (size_t d = 0; d < shape.size(); ++d) {
+            if (shape[d] <= 0 && d < 2)
+                shape[d] = d == 0 ? 1 : 2;
+
+            if (shape[d] > 0)
+                fixedElements *= shape[d];
+            else
+                ++numFree;
+        }
+
+        // A model like [1, -1, -1, -1] must not get warmUpDimension cubed
+        const auto budget = static_cast<double>(std::max<int64_t>(1, warmUpElements / fixedElements));
+        const auto freeDimension = std::clamp(static_cast<int64_t>(std::pow(budget, 1.0 / std::max(1, numFree))),
+                                              int64_t { 1 }, warmUpDimension);
+        for (auto& dimension : shape)
+            if (dimension <= 0)
+                dimension = freeDimension;
+
+        size_t numElements = 1;
+        for (auto dimension : shape)
+            numElements *= static_cast<size_t>(dimension);
+
+        inputNames.push_back(session.GetInputNameAllocated(i, allocator).get());
+        inputData.emplace_back(numElements, 0.0f);
+        inputs.push_back(Ort::Value::CreateTensor<float>(memoryInfo, inputData.back().data(), numElements,
+                                                         shape.data(), shape.size()));
+    }
+
+    for (size_t i = 0; i < session.GetOutputCount(); ++i)
+        outputNames.push_back(session.GetOutputNameAllocated(i, allocator).get());
+
+    std::vector<const char*> inputNamePtrs, outputNamePtrs;
+    for (const auto& name : inputNames)
+        inputNamePtrs.push_back(name.c_str());
+    for (const auto& name : outputNames)
+        outputNamePtrs.push_back(name.c_str());
+
+    session.Run(Ort::RunOptions { nullptr }, inputNamePtrs.data(), inputs.data(), inputs.size(),
+                outputNamePtrs.data(), outputNamePtrs.size());
 }
 
-// Returns the ONNX Runtime environment.
+// Returns the shared ONNX Runtime environment.
 Ort::Env& ONNXModelLoader::getEnvironment()
 {
     return env;
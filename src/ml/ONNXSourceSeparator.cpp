@@ -3,13 +3,47 @@
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_core/juce_core.h>
 #include <onnxruntime_cxx_api.h>
+#include <cmath>
+#include <deque>
+#include <mutex>
 #include <vector>
 #include <memory>
 #include <stdexcept>
+#include <utility>
 
 namespace undergroundBeats {
 namespace ml {
 
+namespace {
+
+// Used when the model doesn't name its sources
+const std::vector<std::string> defaultSourceNames { "drums", "bass", "vocals", "other" };
+
+// Spectrogram models without "stft_fft_size" metadata
+constexpr int defaultFFTSize = 4096;
+
+// Keeps magnitude models' masks finite in silent bins
+constexpr float magnitudeFloor = 1.0e-8f;
+
+} // namespace
+
+std::string ONNXSourceSeparator::getVariantPath(const std::string& modelPath, ModelVariant variant)
+{
+    if (variant == ModelVariant::Quality)
+        return modelPath;
+
+    auto dot = modelPath.find_last_of('.');
+    if (dot == std::string::npos || modelPath.find_first_of("/\\", dot) != std::string::npos)
+        dot = modelPath.size();
+
+    return modelPath.substr(0, dot) + "_int8" + modelPath.substr(dot);
+}
+
+const char* ONNXSourceSeparator::getVariantName(ModelVariant variant)
+{
+    return variant == ModelVariant::Fast ? "fast" : "quality";
+}
+
 // Default constructor implementation
 ONNXSourceSeparator::ONNXSourceSeparator()
     : loader(*new ONNXModelLoader()) // Note: This creates a memory leak, proper initialization would use shared ownership
@@ -17,29 +51,115 @@ ONNXSourceSeparator::ONNXSourceSeparator()
     ready = false;
 }
 
-ONNXSourceSeparator::ONNXSourceSeparator(const std::string& modelPath, ONNXModelLoader& modelLoader)
+ONNXSourceSeparator::ONNXSourceSeparator(const std::string& modelPath, ONNXModelLoader& modelLoader, int preferredChunkSamples)
     : loader(modelLoader)
 {
+    if (preferredChunkSamples > 0)
+        chunkSamples = preferredChunkSamples;
+
     try {
-        // Initialize model session (implementation depends on ONNXModelLoader)
-        // session = loader.createSession(modelPath); // Commented out until implemented
-        
-        // Set placeholder input and output names
-        inputNames = {"input"}; 
-        outputNames = {"output"}; 
-        
-        // Convert to char* for Ort API
-        for (const auto& name : inputNames) {
-            inputNamesCharPtr.push_back(name.c_str());
+        session = loader.getSession(modelPath);
+        if (session == nullptr) {
+            juce::Logger::writeToLog("ONNXSourceSeparator: could not load model " + juce::String(modelPath));
+            return;
         }
-        
-        for (const auto& name : outputNames) {
-            outputNamesCharPtr.push_back(name.c_str());
+
+        for (size_t i = 0; i < session->GetInputCount(); ++i)
+            inputNames.push_back(session->GetInputNameAllocated(i, allocator).get());
+
+        for (size_t i = 0; i < session->GetOutputCount(); ++i)
+            outputNames.push_back(session->GetOutputNameAllocated(i, allocator).get());
+
+        if (inputNames.size() != 1 || outputNames.empty())
+            throw std::runtime_error("expected one input and at least one output");
+
+        // Fixed dimensions of the input decide the window; dynamic ones (-1) keep the defaults
+        // (or the window the caller preferred)
+        const auto dims = session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        if (dims.size() != 3 && dims.size() != 4)
+            throw std::runtime_error("expected a [batch, channels, samples] or [batch, channels, bins, frames] input");
+
+        if (dims[1] > 0)
+            modelChannels = static_cast<int>(dims[1]);
+
+        if (dims.size() == 4) {
+            configureSpectrogramInput(dims);
+        } else {
+            if (dims[2] > 0)
+                chunkSamples = static_cast<int>(dims[2]);
+
+            inputShape = { 1, modelChannels, chunkSamples };
         }
-        
-        // Initialize source names (placeholder values)
-        sourceNames = {"drums", "bass", "vocals", "other"};
-        
+
+        overlapSamples = static_cast<int>(static_cast<float>(chunkSamples) * chunkOverlap);
+        fadeInCurve.resize(static_cast<size_t>(overlapSamples));
+        for (int i = 0; i < overlapSamples; ++i) {
+            // sin^2 rises to 1 while the previous window's 1 - sin^2 falls, so they sum to one
+            const auto s = std::sin(juce::MathConstants<double>::halfPi * (i + 0.5) / overlapSamples);
+            fadeInCurve[static_cast<size_t>(i)] = static_cast<float>(s * s);
+        }
+
+        // One stacked output holds every source; otherwise each output is a source. Spectrogram
+        // models' outputs have bins and frames where the others have samples.
+        const auto outputDims = session->GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        const size_t sourceRank = spectrogramInput ? 4 : 3;
+        stackedOutput = outputNames.size() == 1 && outputDims.size() == sourceRank + 1;
+        if (!stackedOutput && outputDims.size() != sourceRank)
+            throw std::runtime_error(spectrogramInput
+                                         ? "expected [batch, sources, channels, bins, frames] or [batch, channels, bins, frames] outputs"
+                                         : "expected [batch, sources, channels, samples] or [batch, channels, samples] outputs");
+
+        size_t numSources = outputNames.size();
+        if (stackedOutput)
+            numSources = outputDims[1] > 0 ? static_cast<size_t>(outputDims[1]) : defaultSourceNames.size();
+
+        auto metadata = session->GetModelMetadata();
+        if (auto names = metadata.LookupCustomMetadataMapAllocated("sources", allocator)) {
+            juce::StringArray tokens;
+            tokens.addTokens(names.get(), ",", "");
+            tokens.trim();
+            for (const auto& name : tokens)
+                sourceNames.push_back(name.toStdString());
+        } else {
+            sourceNames = defaultSourceNames;
+        }
+
+        sourceNames.resize(numSources);
+        for (size_t i = 0; i < sourceNames.size(); ++i)
+            if (sourceNames[i].empty())
+                sourceNames[i] = "source " + std::to_string(i + 1);
+
+        // Dynamic output dimensions are taken to follow the input: its channels and window length
+        // (or bins and frames)
+        const auto channelDim = outputDims[outputDims.size() - sourceRank + 1];
+        outputChannels = channelDim > 0 ? static_cast<int>(channelDim) : modelChannels;
+        std::vector<int64_t> sourceShape { outputChannels };
+
+        if (spectrogramInput) {
+            for (size_t d = 2; d < 4; ++d) {
+                const auto dimension = outputDims[outputDims.size() - 4 + d];
+                if (dimension > 0 && dimension != inputShape[d])
+                    throw std::runtime_error("model masks don't match its input spectrogram");
+                sourceShape.push_back(inputShape[d]);
+            }
+        } else {
+            outputSamples = outputDims.back() > 0 ? static_cast<int>(outputDims.back()) : chunkSamples;
+            if (outputSamples < chunkSamples)
+                throw std::runtime_error("model output is shorter than its input");
+            sourceShape.push_back(outputSamples);
+        }
+
+        for (size_t i = 0; i < outputNames.size(); ++i) {
+            std::vector<int64_t> shape { 1 };
+            if (stackedOutput)
+                shape.push_back(static_cast<int64_t>(numSources));
+            shape.insert(shape.end(), sourceShape.begin(), sourceShape.end());
+            outputShapes.push_back(shape);
+        }
+
+        // The first lane is made now, so a model whose tensors can't be bound is never ready
+        lanes.push_back(createLane());
+
         ready = true;
     } catch (const std::exception& e) {
         juce::Logger::writeToLog("Error initializing ONNXSourceSeparator: " + juce::String(e.what()));
@@ -49,17 +169,19 @@ ONNXSourceSeparator::ONNXSourceSeparator(const std::string& modelPath, ONNXModel
 
 std::map<std::string, juce::AudioBuffer<float>> ONNXSourceSeparator::process(const juce::AudioBuffer<float>& inputBuffer)
 {
-    // Placeholder implementation
     std::map<std::string, juce::AudioBuffer<float>> result;
-    
-    // Create a dummy buffer for each source
-    for (const auto& sourceName : sourceNames) {
-        juce::AudioBuffer<float> sourceBuffer(1, inputBuffer.getNumSamples());
-        // Just copy the input for now
-        sourceBuffer.copyFrom(0, 0, inputBuffer, 0, 0, inputBuffer.getNumSamples());
-        result[sourceName] = sourceBuffer;
-    }
-    
+
+    try {
+        auto stems = createStems(inputBuffer);
+        if (!separateInChunks(inputBuffer, stems, {}))
+            return result;
+
+        for (size_t i = 0; i < stems.size(); ++i)
+            result.emplace(sourceNames[i], std::move(stems[i]));
+    } catch (const std::exception& e) {
+        juce::Logger::writeToLog("Error in process: " + juce::String(e.what()));
+    }
+
     return result;
 }
 
@@ -92,9 +214,6 @@ bool ONNXSourceSeparator::loadAndSeparate(const juce::File& audioFile)
             return false;
         }
         
-        // Store the sample rate
-        stemSampleRate = reader->sampleRate;
-        
         // Load the audio into a buffer
         juce::AudioBuffer<float> inputBuffer(
             static_cast<int>(reader->numChannels),
@@ -102,37 +221,68 @@ bool ONNXSourceSeparator::loadAndSeparate(const juce::File& audioFile)
         );
         reader->read(&inputBuffer, 0, static_cast<int>(reader->lengthInSamples), 0, true, true);
         
-        // Process the buffer (actual separation would happen here)
-        auto separatedSources = process(inputBuffer);
+        return separate(inputBuffer, reader->sampleRate);
+    } catch (const std::exception& e) {
+        juce::Logger::writeToLog("Error in loadAndSeparate: " + juce::String(e.what()));
+        return false;
+    }
+}
+
+bool ONNXSourceSeparator::separate(const juce::AudioBuffer<float>& mix, double sampleRate,
+                                   const std::function<bool()>& shouldExit,
+                                   const std::function<void(float)>& reportProgress)
+{
+    try {
+        auto separatedSources = createStems(mix);
+        if (!separateInChunks(mix, separatedSources, { shouldExit, reportProgress, {}, {} }))
+            return false;
         
         // Clear any existing stems
         stemBuffers.clear();
         stemNames.clear();
+        stemSampleRate = sampleRate;
         
-        // Store the separated stems
-        for (const auto& sourcePair : separatedSources) {
-            stemNames.push_back(sourcePair.first);
-            stemBuffers.push_back(sourcePair.second);
+        // Move the separated stems out, in source order; the audio itself is never copied again
+        for (size_t i = 0; i < separatedSources.size(); ++i) {
+            stemNames.push_back(sourceNames[i]);
+            stemBuffers.emplace_back(std::move(separatedSources[i]));
         }
         
         return true;
     } catch (const std::exception& e) {
-        juce::Logger::writeToLog("Error in loadAndSeparate: " + juce::String(e.what()));
+        juce::Logger::writeToLog("Error in separate: " + juce::String(e.what()));
         return false;
     }
 }
 
+bool ONNXSourceSeparator::separateInto(const juce::AudioBuffer<float>& mix, std::vector<juce::AudioBuffer<float>>& stems,
+                                       const WindowCallbacks& callbacks)
+{
+    try {
+        return separateInChunks(mix, stems, callbacks);
+    } catch (const std::exception& e) {
+        juce::Logger::writeToLog("Error in separateInto: " + juce::String(e.what()));
+        return false;
+    }
+}
+
+std::vector<audio::SharedAudio> ONNXSourceSeparator::takeStems()
+{
+    stemNames.clear();
+    return std::exchange(stemBuffers, {});
+}
+
 int ONNXSourceSeparator::getNumberOfStems() const
 {
     return static_cast<int>(stemBuffers.size());
 }
 
-juce::AudioBuffer<float> ONNXSourceSeparator::getStemBuffer(int stemIndex) const
+const juce::AudioBuffer<float>& ONNXSourceSeparator::getStemBuffer(int stemIndex) const
 {
     if (stemIndex >= 0 && stemIndex < static_cast<int>(stemBuffers.size())) {
-        return stemBuffers[stemIndex];
+        return *stemBuffers[stemIndex];
     }
-    return juce::AudioBuffer<float>(); // Return empty buffer if index out of range
+    throw std::out_of_range("ONNXSourceSeparator: no stem at index " + std::to_string(stemIndex));
 }
 
 double ONNXSourceSeparator::getStemSampleRate(int stemIndex) const
@@ -146,35 +296,395 @@ double ONNXSourceSeparator::getStemSampleRate(int stemIndex) const
 bool ONNXSourceSeparator::replaceStemBuffer(int stemIndex, const juce::AudioBuffer<float>& newBuffer)
 {
     if (stemIndex >= 0 && stemIndex < static_cast<int>(stemBuffers.size())) {
-        stemBuffers[stemIndex] = newBuffer;
+        stemBuffers[stemIndex] = audio::SharedAudio::copyOf(newBuffer);
         return true;
     }
     return false;
 }
 
-std::vector<Ort::Value> ONNXSourceSeparator::preprocess(const juce::AudioBuffer<float>& inputBuffer)
+std::vector<juce::AudioBuffer<float>> ONNXSourceSeparator::createStems(const juce::AudioBuffer<float>& mix) const
+{
+    // Written straight into their final buffers; only one window of input and output exists at a time
+    std::vector<juce::AudioBuffer<float>> stems;
+    for (size_t i = 0; i < sourceNames.size(); ++i) {
+        stems.emplace_back(mix.getNumChannels(), mix.getNumSamples());
+        stems.back().clear();
+    }
+
+    return stems;
+}
+
+void ONNXSourceSeparator::setParallelWindows(int numWindows)
+{
+    parallelWindows = juce::jmax(0, numWindows);
+}
+
+int ONNXSourceSeparator::getParallelWindows() const
+{
+    if (parallelWindows > 0)
+        return parallelWindows;
+
+    return juce::jlimit(1, maxAutoParallelWindows, juce::SystemStats::getNumPhysicalCpus() / 2);
+}
+
+bool ONNXSourceSeparator::separateInChunks(const juce::AudioBuffer<float>& mix, std::vector<juce::AudioBuffer<float>>& stems,
+                                           const WindowCallbacks& callbacks)
+{
+    const int numSamples = mix.getNumSamples();
+    timings = {};
+    if (!ready || numSamples == 0 || mix.getNumChannels() == 0 || stems.size() != sourceNames.size())
+        return false;
+
+    const int hop = getWindowHop();
+    const int numWindows = numSamples <= chunkSamples ? 1 : 1 + (numSamples - chunkSamples + hop - 1) / hop;
+    const int numSegments = (numSamples + hop - 1) / hop;
+    std::vector<bool> windowStarted(static_cast<size_t>(numWindows), false);
+    std::vector<bool> windowDone(static_cast<size_t>(numWindows), false);
+    int windowsDone = 0;
+
+    // Segment s is covered by windows s - 1 (its start) and s (the rest), where they exist
+    const auto isSegmentFinished = [&](int segment) {
+        return (segment == 0 || windowDone[static_cast<size_t>(segment - 1)])
+               && (segment >= numWindows || windowDone[static_cast<size_t>(segment)]);
+    };
+
+    // Start one window before the one being played, so its segment finishes first, and
+    // work forwards from there; the windows before it follow once the end is reached
+    const auto startNextWindow = [&](WindowLane& lane) {
+        int window = 0;
+        if (callbacks.getPriorityPosition) {
+            const auto position = juce::jmax(static_cast<juce::int64>(0), callbacks.getPriorityPosition());
+            window = juce::jmax(0, static_cast<int>(juce::jmin(static_cast<juce::int64>(numWindows - 1), position / hop)) - 1);
+        }
+
+        while (windowStarted[static_cast<size_t>(window)])
+            window = (window + 1) % numWindows;
+
+        windowStarted[static_cast<size_t>(window)] = true;
+        lane.window = window;
+        return window * hop;
+    };
+
+    const auto getLength = [&](int start) { return juce::jmin(chunkSamples, numSamples - start); };
+
+    // Windows are added on this thread, in the order they were started
+    const auto finishWindow = [&](const WindowLane& lane) {
+        const int window = lane.window;
+        const int start = window * hop;
+
+        const auto addStart = juce::Time::getHighResolutionTicks();
+        postprocess(lane, start, getLength(start), window > 0, window < numWindows - 1, stems);
+
+        timings.preprocessSeconds += lane.windowTimings.preprocessSeconds;
+        timings.inferenceSeconds += lane.windowTimings.inferenceSeconds;
+        timings.postprocessSeconds += lane.windowTimings.postprocessSeconds
+                                      + juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - addStart);
+        ++timings.numWindows;
+        windowDone[static_cast<size_t>(window)] = true;
+        ++windowsDone;
+
+        if (callbacks.segmentFinished)
+            for (int segment = window; segment <= window + 1 && segment < numSegments; ++segment)
+                if (isSegmentFinished(segment))
+                    callbacks.segmentFinished(segment);
+
+        if (callbacks.reportProgress)
+            callbacks.reportProgress(static_cast<float>(windowsDone) / static_cast<float>(numWindows));
+    };
+
+    const int numLanes = juce::jmin(getParallelWindows(), numWindows);
+    prepareLanes(numLanes);
+
+    if (numLanes == 1) {
+        auto& lane = *lanes.front();
+
+        while (windowsDone < numWindows) {
+            if (callbacks.shouldExit && callbacks.shouldExit())
+                return false;
+
+            const int start = startNextWindow(lane);
+            processWindow(lane, mix, start, getLength(start));
+            finishWindow(lane);
+        }
+
+        return true;
+    }
+
+    // Each lane separates a window on the pool and is handed back here when it is done. Started
+    // windows are added strictly in order, so the stems and callbacks are those of one lane.
+    std::mutex finishedLock;
+    std::vector<WindowLane*> finished;
+    juce::WaitableEvent laneFinished;
+
+    std::vector<WindowLane*> idle;
+    for (int i = 0; i < numLanes; ++i)
+        idle.push_back(lanes[static_cast<size_t>(i)].get());
+
+    std::deque<std::pair<WindowLane*, bool>> inFlight; // In start order, with whether each has finished
+    bool cancelled = false;
+    std::exception_ptr error;
+
+    while (true) {
+        if (!cancelled && callbacks.shouldExit && callbacks.shouldExit())
+            cancelled = true;
+
+        // Every idle lane gets the next window, until the last one has started
+        while (!cancelled && error == nullptr && !idle.empty() && windowsDone + static_cast<int>(inFlight.size()) < numWindows) {
+            WindowLane* lane = idle.back();
+            idle.pop_back();
+
+            const int start = startNextWindow(*lane);
+            const int length = getLength(start);
+            inFlight.emplace_back(lane, false);
+
+            lanePool->addJob([this, lane, &mix, start, length, &finishedLock, &finished, &laneFinished] {
+                lane->error = nullptr;
+                try {
+                    processWindow(*lane, mix, start, length);
+                } catch (...) {
+                    lane->error = std::current_exception();
+                }
+
+                // Signalled under the lock, so the event can't be gone by the time it is signalled
+                const std::lock_guard<std::mutex> lock(finishedLock);
+                finished.push_back(lane);
+                laneFinished.signal();
+            });
+        }
+
+        // A lane still running holds references to the mix, so nothing returns before they all finish
+        if (inFlight.empty())
+            break;
+
+        laneFinished.wait();
+
+        std::vector<WindowLane*> done;
+        {
+            const std::lock_guard<std::mutex> lock(finishedLock);
+            done.swap(finished);
+        }
+
+        for (auto* lane : done) {
+            for (auto& entry : inFlight)
+                if (entry.first == lane)
+                    entry.second = true;
+
+            if (lane->error != nullptr && error == nullptr)
+                error = lane->error;
+        }
+
+        while (!inFlight.empty() && inFlight.front().second) {
+            WindowLane* lane = inFlight.front().first;
+            inFlight.pop_front();
+
+            if (!cancelled && error == nullptr)
+                finishWindow(*lane);
+            idle.push_back(lane);
+        }
+    }
+
+    if (error != nullptr)
+        std::rethrow_exception(error);
+
+    return !cancelled && windowsDone == numWindows;
+}
+
+std::unique_ptr<ONNXSourceSeparator::WindowLane> ONNXSourceSeparator::createLane() const
+{
+    auto lane = std::make_unique<WindowLane>();
+
+    size_t inputSize = 1;
+    for (auto dimension : inputShape)
+        inputSize *= static_cast<size_t>(dimension);
+    lane->inputData.resize(inputSize);
+
+    if (spectrogramInput) {
+        // Lanes transform side by side, so they share the cores between them
+        auto settings = stftSettings;
+        settings.numThreads = juce::jmax(1, juce::SystemStats::getNumCpus() / getParallelWindows());
+        lane->stft = std::make_unique<STFTProcessor>(settings);
+        lane->windowAudio.setSize(modelChannels, chunkSamples);
+
+        for (size_t i = 0; i < sourceNames.size(); ++i)
+            lane->sourceWindows.emplace_back(modelChannels, chunkSamples);
+    }
+
+    // The tensors are created once over buffers owned by the lane and stay bound; every window is
+    // written into the input in place, and ONNX Runtime writes the outputs straight into the lane's
+    lane->binding = std::make_unique<Ort::IoBinding>(*session);
+    lane->boundTensors.reserve(1 + outputNames.size());
+    lane->outputData.reserve(outputNames.size());
+
+    lane->boundTensors.push_back(Ort::Value::CreateTensor<float>(memoryInfo, lane->inputData.data(), lane->inputData.size(),
+                                                                 inputShape.data(), inputShape.size()));
+    lane->binding->BindInput(inputNames[0].c_str(), lane->boundTensors.back());
+
+    for (size_t i = 0; i < outputNames.size(); ++i) {
+        const auto& shape = outputShapes[i];
+        size_t numElements = 1;
+        for (auto dimension : shape)
+            numElements *= static_cast<size_t>(dimension);
+
+        lane->outputData.emplace_back(numElements, 0.0f);
+        lane->boundTensors.push_back(Ort::Value::CreateTensor<float>(memoryInfo, lane->outputData.back().data(), numElements,
+                                                                     shape.data(), shape.size()));
+        lane->binding->BindOutput(outputNames[i].c_str(), lane->boundTensors.back());
+    }
+
+    return lane;
+}
+
+void ONNXSourceSeparator::prepareLanes(int numLanes)
 {
-    // Placeholder implementation
-    std::vector<Ort::Value> dummyResult;
-    // Real implementation would convert audio to ONNX tensors
-    return dummyResult;
+    while (static_cast<int>(lanes.size()) < numLanes)
+        lanes.push_back(createLane());
+
+    if (numLanes > 1 && (lanePool == nullptr || lanePool->getNumThreads() < numLanes))
+        lanePool = std::make_unique<juce::ThreadPool>(numLanes);
 }
 
-std::vector<Ort::Value> ONNXSourceSeparator::runInference(std::vector<Ort::Value>& inputTensors)
+void ONNXSourceSeparator::processWindow(WindowLane& lane, const juce::AudioBuffer<float>& mix, int start, int length) const
 {
-    // Placeholder implementation
-    std::vector<Ort::Value> dummyResult;
-    // Real implementation would run the ONNX model
-    return dummyResult;
+    const auto preprocessStart = juce::Time::getHighResolutionTicks();
+    preprocess(lane, mix, start, length);
+    const auto inferenceStart = juce::Time::getHighResolutionTicks();
+    runInference(lane);
+    const auto reconstructStart = juce::Time::getHighResolutionTicks();
+    if (spectrogramInput)
+        reconstructSources(lane);
+    const auto windowEnd = juce::Time::getHighResolutionTicks();
+
+    lane.windowTimings = {};
+    lane.windowTimings.preprocessSeconds = juce::Time::highResolutionTicksToSeconds(inferenceStart - preprocessStart);
+    lane.windowTimings.inferenceSeconds = juce::Time::highResolutionTicksToSeconds(reconstructStart - inferenceStart);
+    lane.windowTimings.postprocessSeconds = juce::Time::highResolutionTicksToSeconds(windowEnd - reconstructStart);
+    lane.windowTimings.numWindows = 1;
 }
 
-std::map<std::string, juce::AudioBuffer<float>> ONNXSourceSeparator::postprocess(std::vector<Ort::Value>& outputTensors)
+void ONNXSourceSeparator::configureSpectrogramInput(const std::vector<int64_t>& dims)
 {
-    // Placeholder implementation
-    std::map<std::string, juce::AudioBuffer<float>> dummyResult;
-    // Real implementation would convert ONNX tensors back to audio
-    return dummyResult;
+    auto metadata = session->GetModelMetadata();
+    const auto lookup = [&](const char* key) {
+        auto value = metadata.LookupCustomMetadataMapAllocated(key, allocator);
+        return value != nullptr ? juce::String(value.get()).trim() : juce::String();
+    };
+
+    const int fftSize = juce::jmax(0, lookup("stft_fft_size").getIntValue());
+    const int hopSize = juce::jmax(0, lookup("stft_hop").getIntValue());
+
+    STFTProcessor::Settings settings;
+    settings.fftOrder = juce::roundToInt(std::log2(fftSize > 0 ? fftSize : defaultFFTSize));
+    settings.hopSize = hopSize > 0 ? hopSize : (1 << settings.fftOrder) / 4;
+    if ((fftSize > 0 && fftSize != 1 << settings.fftOrder) || settings.fftOrder < 4)
+        throw std::runtime_error("stft_fft_size must be a power of two");
+
+    // Only asked for its shapes; every lane makes a transform of its own
+    auto shapeSettings = settings;
+    shapeSettings.numThreads = 1;
+    const STFTProcessor stft(shapeSettings);
+    spectrogramInput = true;
+    stftSettings = settings;
+
+    if (dims[2] > 0 && dims[2] != stft.getNumBins())
+        throw std::runtime_error("model input has " + std::to_string(dims[2]) + " bins, but stft_fft_size gives "
+                                 + std::to_string(stft.getNumBins()));
+
+    // A fixed number of frames fixes the window: the first and last frames are centred on its ends
+    if (dims[3] > 0)
+        chunkSamples = static_cast<int>(dims[3] - 1) * stft.getHopSize();
+    if (chunkSamples <= 0)
+        throw std::runtime_error("model input needs at least two frames");
+
+    outputsMagnitudes = lookup("spectrogram_output").equalsIgnoreCase("magnitude");
+
+    inputShape = { 1, modelChannels, stft.getNumBins(), stft.getNumFrames(chunkSamples) };
+}
+
+void ONNXSourceSeparator::preprocess(WindowLane& lane, const juce::AudioBuffer<float>& inputBuffer, int start, int length) const
+{
+    // Mono mixes feed every model channel; extra mix channels are dropped
+    for (int ch = 0; ch < modelChannels; ++ch) {
+        auto* dest = spectrogramInput ? lane.windowAudio.getWritePointer(ch)
+                                      : lane.inputData.data() + static_cast<size_t>(ch) * static_cast<size_t>(chunkSamples);
+        const int sourceChannel = juce::jmin(ch, inputBuffer.getNumChannels() - 1);
+
+        juce::FloatVectorOperations::copy(dest, inputBuffer.getReadPointer(sourceChannel, start), length);
+        juce::FloatVectorOperations::clear(dest + length, chunkSamples - length);
+    }
+
+    // The complex spectrogram is kept for the masks; the model only sees its magnitudes
+    if (spectrogramInput) {
+        lane.stft->forward(lane.windowAudio, 0, chunkSamples, lane.mixSpectrogram);
+        STFTProcessor::getMagnitudes(lane.mixSpectrogram, lane.inputData.data());
+    }
+}
+
+void ONNXSourceSeparator::runInference(WindowLane& lane) const
+{
+    // Run may be called on one session from several threads, each with its own binding
+    session->Run(Ort::RunOptions { nullptr }, *lane.binding);
+}
+
+void ONNXSourceSeparator::reconstructSources(WindowLane& lane) const
+{
+    const size_t maskSize = static_cast<size_t>(outputChannels) * static_cast<size_t>(inputShape[2])
+                            * static_cast<size_t>(inputShape[3]);
+
+    for (size_t source = 0; source < lane.sourceWindows.size(); ++source) {
+        float* mask = stackedOutput ? lane.outputData[0].data() + source * maskSize : lane.outputData[source].data();
+
+        // An estimated magnitude becomes the fraction of the mix's magnitude it keeps
+        if (outputsMagnitudes) {
+            const size_t channelSize = maskSize / static_cast<size_t>(outputChannels);
+            for (size_t i = 0; i < maskSize; ++i) {
+                const size_t inputChannel = static_cast<size_t>(juce::jmin(static_cast<int>(i / channelSize), modelChannels - 1));
+                mask[i] /= juce::jmax(lane.inputData[inputChannel * channelSize + i % channelSize], magnitudeFloor);
+            }
+        }
+
+        STFTProcessor::applyMask(lane.mixSpectrogram, mask, outputChannels, lane.sourceSpectrogram);
+        lane.stft->inverse(lane.sourceSpectrogram, lane.sourceWindows[source], 0, chunkSamples);
+    }
+}
+
+const float* ONNXSourceSeparator::getWindowOutput(const WindowLane& lane, size_t source, int channel) const
+{
+    if (spectrogramInput) {
+        const auto& audio = lane.sourceWindows[source];
+        return audio.getReadPointer(juce::jmin(channel, audio.getNumChannels() - 1));
+    }
+
+    // Read where ONNX Runtime wrote it: [batch, sources, channels, samples] or one [batch, channels, samples] each
+    const size_t sourceSize = static_cast<size_t>(outputChannels) * static_cast<size_t>(outputSamples);
+    const float* data = stackedOutput ? lane.outputData[0].data() + source * sourceSize : lane.outputData[source].data();
+    return data + static_cast<size_t>(juce::jmin(channel, outputChannels - 1)) * static_cast<size_t>(outputSamples);
+}
+
+void ONNXSourceSeparator::postprocess(const WindowLane& lane, int start, int length, bool fadeIn, bool fadeOut,
+                                      std::vector<juce::AudioBuffer<float>>& stems) const
+{
+    const int hop = chunkSamples - overlapSamples;
+
+    for (size_t source = 0; source < stems.size(); ++source) {
+        auto& stem = stems[source];
+        for (int ch = 0; ch < stem.getNumChannels(); ++ch) {
+            const float* output = getWindowOutput(lane, source, ch);
+            float* dest = stem.getWritePointer(ch, start);
+
+            // Crossfade the overlaps; the part in between is added as it is
+            const int fadeInEnd = fadeIn ? juce::jmin(overlapSamples, length) : 0;
+            const int fadeOutStart = fadeOut ? hop : length;
+
+            for (int i = 0; i < fadeInEnd; ++i)
+                dest[i] += fadeInCurve[static_cast<size_t>(i)] * output[i];
+
+            juce::FloatVectorOperations::add(dest + fadeInEnd, output + fadeInEnd, fadeOutStart - fadeInEnd);
+
+            for (int i = fadeOutStart; i < length; ++i)
+                dest[i] += (1.0f - fadeInCurve[static_cast<size_t>(i - hop)]) * output[i];
+        }
+    }
 }
 
 } // namespace ml
-} // namespace undergroundBeats
\ No newline at end of file
+} // namespace undergroundBeats
@@ -0,0 +1,204 @@
+#include "undergroundBeats/ml/STFTProcessor.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace undergroundBeats {
+namespace ml {
+
+namespace {
+
+// Frames per unit of work; enough that handing out units costs nothing next to the FFTs
+constexpr int framesPerUnit = 32;
+
+// Below this the summed windows are treated as zero (only possible at the very edges)
+constexpr float minWindowWeight = 1.0e-6f;
+
+int resolveThreads(const STFTProcessor::Settings& settings)
+{
+    return juce::jmax(1, settings.numThreads > 0 ? settings.numThreads : juce::SystemStats::getNumCpus());
+}
+
+} // namespace
+
+void STFTProcessor::Spectrogram::setSize(int channels, int frames, int binsPerFrame)
+{
+    numChannels = channels;
+    numFrames = frames;
+    numBins = binsPerFrame;
+    bins.resize(static_cast<size_t>(channels) * static_cast<size_t>(frames) * static_cast<size_t>(binsPerFrame));
+}
+
+STFTProcessor::STFTProcessor(const Settings& settings)
+    : fftSize(1 << settings.fftOrder),
+      hopSize(juce::jlimit(1, (1 << settings.fftOrder) / 2, settings.hopSize)),
+      pool(juce::jmax(1, resolveThreads(settings) - 1))
+{
+    // Periodic rather than symmetric, so shifted copies overlap evenly
+    window.resize(static_cast<size_t>(fftSize));
+    for (int i = 0; i < fftSize; ++i)
+        window[static_cast<size_t>(i)] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * i / fftSize);
+
+    for (int i = 0; i < resolveThreads(settings); ++i) {
+        auto worker = std::make_unique<Worker>(settings.fftOrder);
+        worker->frame.resize(2 * static_cast<size_t>(fftSize));
+        workers.push_back(std::move(worker));
+    }
+}
+
+STFTProcessor::~STFTProcessor()
+{
+    pool.removeAllJobs(true, -1);
+}
+
+void STFTProcessor::forward(const juce::AudioBuffer<float>& audio, int start, int length, Spectrogram& spectrogram)
+{
+    const int numChannels = audio.getNumChannels();
+    const int numFrames = getNumFrames(length);
+    const int numBins = getNumBins();
+    const int unitsPerChannel = (numFrames + framesPerUnit - 1) / framesPerUnit;
+
+    spectrogram.setSize(numChannels, numFrames, numBins);
+
+    runParallel(numChannels * unitsPerChannel, [&](Worker& worker, int unit) {
+        const int channel = unit / unitsPerChannel;
+        const int firstFrame = (unit % unitsPerChannel) * framesPerUnit;
+        const int lastFrame = juce::jmin(numFrames, firstFrame + framesPerUnit);
+        const float* samples = audio.getReadPointer(channel, start);
+        float* frame = worker.frame.data();
+
+        for (int f = firstFrame; f < lastFrame; ++f) {
+            // The frame is centred on f * hop; whatever lies outside [0, length) is silence
+            const int frameStart = f * hopSize - fftSize / 2;
+            const int from = juce::jmax(0, -frameStart);
+            const int to = juce::jmin(fftSize, length - frameStart);
+
+            juce::FloatVectorOperations::clear(frame, 2 * fftSize);
+            if (to > from)
+                juce::FloatVectorOperations::multiply(frame + from, samples + frameStart + from, window.data() + from, to - from);
+
+            worker.fft.performRealOnlyForwardTransform(frame, true);
+            std::memcpy(spectrogram.getFrame(channel, f), frame, sizeof(std::complex<float>) * static_cast<size_t>(numBins));
+        }
+    });
+}
+
+void STFTProcessor::inverse(const Spectrogram& spectrogram, juce::AudioBuffer<float>& destination, int destStart, int length)
+{
+    jassert(spectrogram.numBins == getNumBins());
+
+    const int numChannels = juce::jmin(spectrogram.numChannels, destination.getNumChannels());
+    const int runLength = framesPerUnit * hopSize;
+    const int runsPerChannel = (length + runLength - 1) / runLength;
+
+    runParallel(numChannels * runsPerChannel, [&](Worker& worker, int unit) {
+        const int channel = unit / runsPerChannel;
+        const int runStart = (unit % runsPerChannel) * runLength;
+        const int runEnd = juce::jmin(length, runStart + runLength);
+        const int numSamples = runEnd - runStart;
+
+        worker.output.assign(static_cast<size_t>(numSamples), 0.0f);
+        worker.weight.assign(static_cast<size_t>(numSamples), 0.0f);
+        float* frame = worker.frame.data();
+
+        // Every frame that reaches into the run, including those shared with the neighbouring runs
+        const int firstFrame = juce::jmax(0, (runStart - fftSize / 2) / hopSize);
+        const int lastFrame = juce::jmin(spectrogram.numFrames - 1, (runEnd + fftSize / 2 - 1) / hopSize);
+
+        for (int f = firstFrame; f <= lastFrame; ++f) {
+            const int frameStart = f * hopSize - fftSize / 2;
+            const int from = juce::jmax(runStart, frameStart);
+            const int to = juce::jmin(runEnd, frameStart + fftSize);
+            if (to <= from)
+                continue;
+
+            std::memcpy(frame, spectrogram.getFrame(channel, f), sizeof(std::complex<float>) * static_cast<size_t>(spectrogram.numBins));
+            worker.fft.performRealOnlyInverseTransform(frame);
+
+            const float* frameWindow = window.data() + (from - frameStart);
+            float* output = worker.output.data() + (from - runStart);
+            float* weight = worker.weight.data() + (from - runStart);
+
+            juce::FloatVectorOperations::multiply(frame + (from - frameStart), frameWindow, to - from);
+            juce::FloatVectorOperations::add(output, frame + (from - frameStart), to - from);
+
+            for (int i = 0; i < to - from; ++i)
+                weight[i] += frameWindow[i] * frameWindow[i];
+        }
+
+        float* dest = destination.getWritePointer(channel, destStart + runStart);
+        for (int i = 0; i < numSamples; ++i) {
+            const float w = worker.weight[static_cast<size_t>(i)];
+            dest[i] = w > minWindowWeight ? worker.output[static_cast<size_t>(i)] / w : 0.0f;
+        }
+    });
+}
+
+void STFTProcessor::getMagnitudes(const Spectrogram& spectrogram, float* destination)
+{
+    const size_t numFrames = static_cast<size_t>(spectrogram.numFrames);
+
+    for (int ch = 0; ch < spectrogram.numChannels; ++ch) {
+        for (int f = 0; f < spectrogram.numFrames; ++f) {
+            const auto* bins = spectrogram.getFrame(ch, f);
+            float* column = destination + static_cast<size_t>(ch) * spectrogram.numBins * numFrames + static_cast<size_t>(f);
+
+            for (int b = 0; b < spectrogram.numBins; ++b)
+                column[static_cast<size_t>(b) * numFrames] = std::abs(bins[b]);
+        }
+    }
+}
+
+void STFTProcessor::applyMask(const Spectrogram& source, const float* mask, int maskChannels, Spectrogram& result)
+{
+    const size_t numFrames = static_cast<size_t>(source.numFrames);
+    result.setSize(source.numChannels, source.numFrames, source.numBins);
+
+    for (int ch = 0; ch < source.numChannels; ++ch) {
+        const float* channelMask = mask + static_cast<size_t>(juce::jmin(ch, maskChannels - 1)) * source.numBins * numFrames;
+
+        for (int f = 0; f < source.numFrames; ++f) {
+            const auto* bins = source.getFrame(ch, f);
+            auto* masked = result.getFrame(ch, f);
+
+            for (int b = 0; b < source.numBins; ++b)
+                masked[b] = bins[b] * channelMask[static_cast<size_t>(b) * numFrames + static_cast<size_t>(f)];
+        }
+    }
+}
+
+void STFTProcessor::runParallel(int numUnits, const std::function<void(Worker&, int)>& work)
+{
+    const int numWorkers = juce::jmin(static_cast<int>(workers.size()), numUnits);
+
+    if (numWorkers <= 1) {
+        for (int unit = 0; unit < numUnits; ++unit)
+            work(*workers[0], unit);
+        return;
+    }
+
+    // Units are handed out one at a time, so a slow thread doesn't hold the others up;
+    // the calling thread is one of the workers
+    std::atomic<int> nextUnit { 0 };
+    std::atomic<int> running { numWorkers - 1 };
+    juce::WaitableEvent finished;
+
+    const auto drain = [&](Worker& worker) {
+        for (int unit = nextUnit++; unit < numUnits; unit = nextUnit++)
+            work(worker, unit);
+    };
+
+    for (int i = 1; i < numWorkers; ++i) {
+        pool.addJob([&, i] {
+            drain(*workers[static_cast<size_t>(i)]);
+            if (--running == 0)
+                finished.signal();
+        });
+    }
+
+    drain(*workers[0]);
+    finished.wait();
+}
+
+} // namespace ml
+} // namespace undergroundBeats
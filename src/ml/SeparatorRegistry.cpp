@@ -0,0 +1,129 @@
+#include "undergroundBeats/ml/SeparatorRegistry.h"
+#include "undergroundBeats/ml/ONNXSourceSeparator.h"
+#include <algorithm>
+
+namespace undergroundBeats {
+namespace ml {
+
+namespace {
+
+constexpr double defaultRate = 44100.0;
+constexpr int defaultChunk = ONNXSourceSeparator::defaultChunkSamples;
+
+juce::File resolve(const std::string& path)
+{
+    return juce::File::getCurrentWorkingDirectory().getChildFile(path);
+}
+
+bool sameName(const std::string& a, const std::string& b)
+{
+    return juce::String(a).equalsIgnoreCase(juce::String(b));
+}
+
+} // namespace
+
+SeparatorRegistry::Backend SeparatorRegistry::makeONNXBackend(Capabilities capabilities, const std::string& modelPath)
+{
+    Backend backend;
+    backend.capabilities = std::move(capabilities);
+    backend.modelPath = modelPath;
+    backend.create = [modelPath, chunk = backend.capabilities.preferredChunkSamples](ONNXModelLoader& loader, ModelVariant variant)
+        -> std::unique_ptr<AudioSourceSeparator> {
+        Backend target;
+        target.modelPath = modelPath;
+        return std::make_unique<ONNXSourceSeparator>(getModelPath(target, variant), loader, chunk);
+    };
+
+    return backend;
+}
+
+SeparatorRegistry SeparatorRegistry::createDefault()
+{
+    // Costs are measured against the 4-stem model; the 2-stem models are about a third of its size
+    const double windowSeconds = defaultChunk / defaultRate;
+    SeparatorRegistry registry;
+
+    registry.add(makeONNXBackend({ "4stem", { "drums", "bass", "vocals", "other" }, defaultRate, defaultChunk, windowSeconds, 1.0f },
+                                 "models/source_separation.onnx"));
+    registry.add(makeONNXBackend({ "drums", { "drums", "rest" }, defaultRate, defaultChunk, windowSeconds, 0.35f },
+                                 "models/drums_separation.onnx"));
+    registry.add(makeONNXBackend({ "vocals", { "vocals", "accompaniment" }, defaultRate, defaultChunk, windowSeconds, 0.35f },
+                                 "models/vocals_separation.onnx"));
+
+    return registry;
+}
+
+void SeparatorRegistry::add(Backend backend)
+{
+    backends.push_back(std::move(backend));
+}
+
+SeparatorRegistry::Backend SeparatorRegistry::getDefaultBackend() const
+{
+    if (!backends.empty())
+        return backends.front();
+
+    return createDefault().backends.front();
+}
+
+std::optional<SeparatorRegistry::Backend> SeparatorRegistry::select(const Request& request) const
+{
+    const auto wanted = request.stems.empty() ? getDefaultBackend().capabilities.stemNames : request.stems;
+    const Backend* best = nullptr;
+
+    for (const auto& backend : backends) {
+        const auto& names = backend.capabilities.stemNames;
+        const bool producesAll = std::all_of(wanted.begin(), wanted.end(), [&](const std::string& stem) {
+            return std::any_of(names.begin(), names.end(), [&](const std::string& name) { return sameName(name, stem); });
+        });
+
+        const bool fastEnough = request.maxLatencySeconds <= 0.0
+                                || backend.capabilities.latencySeconds <= request.maxLatencySeconds;
+
+        if (producesAll && fastEnough && isAvailable(backend)
+            && (best == nullptr || backend.capabilities.relativeCost < best->capabilities.relativeCost))
+            best = &backend;
+    }
+
+    if (best == nullptr)
+        return std::nullopt;
+
+    return *best;
+}
+
+bool SeparatorRegistry::isAvailable(const Backend& backend)
+{
+    return backend.create != nullptr && (backend.modelPath.empty() || resolve(backend.modelPath).existsAsFile());
+}
+
+ModelVariant SeparatorRegistry::getAvailableVariant(const Backend& backend, ModelVariant variant)
+{
+    if (backend.modelPath.empty())
+        return variant;
+
+    const auto path = ONNXSourceSeparator::getVariantPath(backend.modelPath, variant);
+    return resolve(path).existsAsFile() ? variant : ModelVariant::Quality;
+}
+
+std::string SeparatorRegistry::getModelPath(const Backend& backend, ModelVariant variant)
+{
+    if (backend.modelPath.empty())
+        return {};
+
+    return ONNXSourceSeparator::getVariantPath(backend.modelPath, getAvailableVariant(backend, variant));
+}
+
+juce::String SeparatorRegistry::getIdentity(const Backend& backend, ModelVariant variant)
+{
+    if (backend.modelPath.empty())
+        return juce::String(backend.capabilities.id) + "|" + ONNXSourceSeparator::getVariantName(variant);
+
+    // A replaced model file changes size or time, which retires every cached separation;
+    // each backend and variant is a file of its own, so their stems are cached apart
+    const auto model = resolve(getModelPath(backend, variant));
+    return model.getFullPathName() + "|" + juce::String(model.getSize())
+           + "|" + juce::String(model.getLastModificationTime().toMilliseconds());
+}
+
+} // namespace ml
+} // namespace undergroundBeats
@@ -69,23 +69,39 @@ std::vector<juce::AudioBuffer<float>> VariationGenerator::generateVariations(
     const juce::AudioBuffer<float>& inputBuffer,
     int numVariations) {
     
-    if (!isInitialized) {
+    auto sharedVariations = generateVariations(audio::SharedAudio::copyOf(inputBuffer), numVariations);
+    
+    std::vector<juce::AudioBuffer<float>> variations;
+    variations.reserve(sharedVariations.size());
+    
+    for (auto& variation : sharedVariations) {
+        variations.push_back(variation.release());
+    }
+    
+    return variations;
+}
+
+std::vector<audio::SharedAudio> VariationGenerator::generateVariations(
+    const audio::SharedAudio& input,
+    int numVariations) {
+    
+    if (!isInitialized || !input.isValid()) {
         juce::Logger::writeToLog("VariationGenerator not initialized");
         return {};
     }
     
     switch (method) {
         case VariationMethod::ALGORITHMIC:
-            return generateAlgorithmicVariations(inputBuffer, numVariations);
+            return generateAlgorithmicVariations(input, numVariations);
             
         case VariationMethod::GAN:
-            return generateGANVariations(inputBuffer, numVariations);
+            return generateGANVariations(input, numVariations);
             
         case VariationMethod::VAE:
-            return generateVAEVariations(inputBuffer, numVariations);
+            return generateVAEVariations(input, numVariations);
             
         case VariationMethod::STYLE_TRANSFER:
-            return generateStyleTransferVariations(inputBuffer, numVariations);
+            return generateStyleTransferVariations(input, numVariations);
             
         default:
             return {};
@@ -102,27 +118,27 @@ void VariationGenerator::setVariationAmount(float amount) {
 }
 
 void VariationGenerator::setStyleReference(const juce::AudioBuffer<float>& styleBuffer) {
-    styleReferenceBuffer = styleBuffer;
+    styleReference = audio::SharedAudio::copyOf(styleBuffer);
 }
 
-std::vector<juce::AudioBuffer<float>> VariationGenerator::generateAlgorithmicVariations(
-    const juce::AudioBuffer<float>& inputBuffer,
+void VariationGenerator::setStyleReference(audio::SharedAudio styleAudio) {
+    styleReference = std::move(styleAudio);
+}
+
+std::vector<audio::SharedAudio> VariationGenerator::generateAlgorithmicVariations(
+    const audio::SharedAudio& input,
     int numVariations) {
     
-    std::vector<juce::AudioBuffer<float>> variations;
+    std::vector<audio::SharedAudio> variations;
     variations.reserve(numVariations);
     
+    const auto& inputBuffer = *input;
     const int numChannels = inputBuffer.getNumChannels();
     const int numSamples = inputBuffer.getNumSamples();
     
     for (int i = 0; i < numVariations; ++i) {
-        // Create a new buffer for this variation
-        juce::AudioBuffer<float> variation(numChannels, numSamples);
-        
-        // Copy the original buffer
-        for (int channel = 0; channel < numChannels; ++channel) {
-            variation.copyFrom(channel, 0, inputBuffer, channel, 0, numSamples);
-        }
+        // Start as a handle to the input; the audio is only copied by the first write
+        audio::SharedAudio variation = input;
         
         // Apply different algorithmic variations based on the variation index
         switch (i % 4) {
@@ -133,8 +149,6 @@ std::vector<juce::AudioBuffer<float>> VariationGenerator::generateAlgorithmicVar
                     const int sectionSize = numSamples / 16;
                     
                     for (int channel = 0; channel < numChannels; ++channel) {
-                        float* data = variation.getWritePointer(channel);
-                        
                         for (int section = 0; section < 16; ++section) {
                             const int start = section * sectionSize;
                             const int end = (section + 1) * sectionSize;
@@ -145,6 +159,8 @@ std::vector<juce::AudioBuffer<float>> VariationGenerator::generateAlgorithmicVar
                                 static_cast<int>(variationAmount * sectionSize * 0.25f));
                             
                             if (shift != 0) {
+                                float* data = variation.write().getWritePointer(channel);
+                                
                                 // Create a temporary copy of this section
                                 juce::HeapBlock<float> sectionData(sectionSize);
                                 std::memcpy(sectionData, data + start, sectionSize * sizeof(float));
@@ -167,7 +183,7 @@ std::vector<juce::AudioBuffer<float>> VariationGenerator::generateAlgorithmicVar
                 // Dynamic variation - adjust volume curve
                 {
                     for (int channel = 0; channel < numChannels; ++channel) {
-                        float* data = variation.getWritePointer(channel);
+                        float* data = variation.write().getWritePointer(channel);
                         
                         // Create a few random control points for volume adjustment
                         constexpr int numControlPoints = 8;
@@ -216,7 +232,7 @@ std::vector<juce::AudioBuffer<float>> VariationGenerator::generateAlgorithmicVar
                     const float highFreqEmphasis = 1.0f + impl->getRandomFloat(-variationAmount, variationAmount);
                     
                     for (int channel = 0; channel < numChannels; ++channel) {
-                        float* data = variation.getWritePointer(channel);
+                        float* data = variation.write().getWritePointer(channel);
                         
                         for (int blockStart = 0; blockStart < numSamples; blockStart += blockSize) {
                             const int currentBlockSize = std::min(blockSize, numSamples - blockStart);
@@ -281,22 +297,21 @@ std::vector<juce::AudioBuffer<float>> VariationGenerator::generateAlgorithmicVar
                         }
                     }
                     
-                    // Create a temporary copy of the buffer
-                    juce::AudioBuffer<float> tempBuffer(numChannels, numSamples);
-                    for (int channel = 0; channel < numChannels; ++channel) {
-                        tempBuffer.copyFrom(channel, 0, variation, channel, 0, numSamples);
-                    }
-                    
-                    // Rearrange segments
+                    // Rearrange segments, reading from the untouched input instead of a temporary copy
                     for (int seg = 0; seg < numSegments; ++seg) {
                         const int sourceSegment = segmentOrder[seg];
+                        if (sourceSegment == seg) {
+                            continue;
+                        }
+                        
                         const int start = seg * segmentSize;
                         const int sourceStart = sourceSegment * segmentSize;
+                        auto& output = variation.write();
                         
                         for (int channel = 0; channel < numChannels; ++channel) {
-                            variation.copyFrom(
+                            output.copyFrom(
                                 channel, start,
-                                tempBuffer, channel, sourceStart,
+                                inputBuffer, channel, sourceStart,
                                 segmentSize);
                         }
                     }
@@ -310,39 +325,39 @@ std::vector<juce::AudioBuffer<float>> VariationGenerator::generateAlgorithmicVar
     return variations;
 }
 
-std::vector<juce::AudioBuffer<float>> VariationGenerator::generateGANVariations(
-    const juce::AudioBuffer<float>& inputBuffer,
+std::vector<audio::SharedAudio> VariationGenerator::generateGANVariations(
+    const audio::SharedAudio& input,
     int numVariations) {
     
     // TODO: Implement GAN-based variation generation
     // For now, fall back to algorithmic variations
     juce::Logger::writeToLog("GAN variations not implemented yet, using algorithmic fallback");
-    return generateAlgorithmicVariations(inputBuffer, numVariations);
+    return generateAlgorithmicVariations(input, numVariations);
 }
 
-std::vector<juce::AudioBuffer<float>> VariationGenerator::generateVAEVariations(
-    const juce::AudioBuffer<float>& inputBuffer,
+std::vector<audio::SharedAudio> VariationGenerator::generateVAEVariations(
+    const audio::SharedAudio& input,
     int numVariations) {
     
     // TODO: Implement VAE-based variation generation
     // For now, fall back to algorithmic variations
     juce::Logger::writeToLog("VAE variations not implemented yet, using algorithmic fallback");
-    return generateAlgorithmicVariations(inputBuffer, numVariations);
+    return generateAlgorithmicVariations(input, numVariations);
 }
 
-std::vector<juce::AudioBuffer<float>> VariationGenerator::generateStyleTransferVariations(
-    const juce::AudioBuffer<float>& inputBuffer,
+std::vector<audio::SharedAudio> VariationGenerator::generateStyleTransferVariations(
+    const audio::SharedAudio& input,
     int numVariations) {
     
-    if (styleReferenceBuffer.getNumSamples() == 0) {
+    if (!styleReference.isValid() || styleReference->getNumSamples() == 0) {
         juce::Logger::writeToLog("Style transfer requires a style reference buffer");
-        return generateAlgorithmicVariations(inputBuffer, numVariations);
+        return generateAlgorithmicVariations(input, numVariations);
     }
     
     // TODO: Implement style transfer variation generation
     // For now, fall back to algorithmic variations
     juce::Logger::writeToLog("Style transfer variations not implemented yet, using algorithmic fallback");
-    return generateAlgorithmicVariations(inputBuffer, numVariations);
+    return generateAlgorithmicVariations(input, numVariations);
 }
 
 } // namespace ml
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cmath>
+
+namespace undergroundBeats {
+namespace test {
+
+/** @brief Uniform white noise in [-amplitude, amplitude); the same seed gives the same noise. */
+inline juce::AudioBuffer<float> makeNoise(int numChannels, int numSamples, int seed = 7, float amplitude = 1.0f)
+{
+    juce::AudioBuffer<float> buffer(numChannels, numSamples);
+    juce::Random random(seed);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            buffer.setSample(ch, i, (random.nextFloat() * 2.0f - 1.0f) * amplitude);
+
+    return buffer;
+}
+
+/** @brief A mono ramp whose sample i is i / numSamples. */
+inline juce::AudioBuffer<float> makeRamp(int numSamples)
+{
+    juce::AudioBuffer<float> buffer(1, numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        buffer.setSample(0, i, (float) i / (float) numSamples);
+
+    return buffer;
+}
+
+/** @brief Every sample of every channel set to value. */
+inline juce::AudioBuffer<float> makeConstant(int numChannels, int numSamples, float value)
+{
+    juce::AudioBuffer<float> buffer(numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        juce::FloatVectorOperations::fill(buffer.getWritePointer(ch), value, numSamples);
+
+    return buffer;
+}
+
+/** @brief A mono full-scale sine starting at phase zero. */
+inline juce::AudioBuffer<float> makeSine(double frequency, double sampleRate, int numSamples)
+{
+    juce::AudioBuffer<float> buffer(1, numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        buffer.setSample(0, i, (float) std::sin(juce::MathConstants<double>::twoPi * frequency * i / sampleRate));
+
+    return buffer;
+}
+
+} // namespace test
+} // namespace undergroundBeats
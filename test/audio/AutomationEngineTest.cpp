@@ -0,0 +1,78 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/AutomationEngine.h"
+
+using undergroundBeats::audio::AutomationBreakpoint;
+using undergroundBeats::audio::AutomationEngine;
+using undergroundBeats::audio::AutomationLane;
+
+TEST_CASE("AutomationLane merges takes in place", "[audio][automation]") {
+    AutomationLane lane;
+    lane.setBreakpoints({ { 0, 0.1f }, { 100, 0.2f }, { 200, 0.3f }, { 300, 0.4f } });
+
+    SECTION("Take replaces only the region it covers") {
+        lane.mergeTake({ { 90, 0.9f }, { 210, 0.8f } });
+
+        const auto& points = lane.getBreakpoints();
+        REQUIRE(points.size() == 4);
+        REQUIRE(points[0].samplePosition == 0);
+        REQUIRE(points[1].samplePosition == 90);
+        REQUIRE(points[2].samplePosition == 210);
+        REQUIRE(points[3].samplePosition == 300);
+    }
+
+    SECTION("Values hold between breakpoints") {
+        REQUIRE(lane.getValueAt(-1) < 0.0f);
+        REQUIRE(lane.getValueAt(150) == Approx(0.2f));
+        REQUIRE(lane.getValueAt(1000) == Approx(0.4f));
+    }
+}
+
+TEST_CASE("AutomationEngine renders breakpoints per block", "[audio][automation]") {
+    AutomationEngine engine;
+    engine.initialise(4);
+    engine.setLaneBreakpoints(1, { { 10, 0.5f }, { 600, 0.7f } });
+    engine.setLaneBreakpoints(3, { { 5, 0.25f } });
+
+    SECTION("Events inside the block are sorted by offset") {
+        REQUIRE(engine.prepareBlock(0, 512));
+        REQUIRE(engine.getNumBlockEvents() == 2);
+        REQUIRE(engine.getBlockEvents()[0].parameterIndex == 3);
+        REQUIRE(engine.getBlockEvents()[0].sampleOffset == 5);
+        REQUIRE(engine.getBlockEvents()[1].parameterIndex == 1);
+        REQUIRE(engine.getBlockEvents()[1].sampleOffset == 10);
+
+        // The next contiguous block only sees the breakpoint that falls inside it
+        REQUIRE(engine.prepareBlock(512, 512));
+        REQUIRE(engine.getNumBlockEvents() == 1);
+        REQUIRE(engine.getBlockEvents()[0].sampleOffset == 88);
+    }
+
+    SECTION("A seek chases the value in effect") {
+        REQUIRE(engine.prepareBlock(300, 64));
+        REQUIRE(engine.getNumBlockEvents() == 2);
+        REQUIRE(engine.getBlockEvents()[0].sampleOffset == 0);
+        REQUIRE(engine.getBlockEvents()[1].sampleOffset == 0);
+    }
+
+    SECTION("Recording commits takes and suspends playback while armed") {
+        engine.setRecording(true);
+        engine.recordParameterChange(2, 0.1f, 100);
+        engine.recordParameterChange(2, 0.2f, 100);
+        engine.recordParameterChange(2, 0.3f, 200);
+        REQUIRE_FALSE(engine.prepareBlock(0, 512));
+
+        engine.setRecording(false);
+        const auto points = engine.getLaneBreakpoints(2);
+        REQUIRE(points.size() == 2);
+        REQUIRE(points[0].value == Approx(0.2f));
+    }
+
+    SECTION("Lanes survive an XML round trip") {
+        auto xml = engine.createXml();
+        AutomationEngine restored;
+        restored.initialise(4);
+        restored.restoreFromXml(*xml);
+        REQUIRE(restored.getLaneBreakpoints(1).size() == 2);
+        REQUIRE(restored.getLaneBreakpoints(3)[0].value == Approx(0.25f));
+    }
+}
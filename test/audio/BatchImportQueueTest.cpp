@@ -0,0 +1,134 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/BatchImportQueue.h"
+#include "undergroundBeats/ml/ONNXModelLoader.h"
+#include "TestSignals.h"
+#include <algorithm>
+
+using undergroundBeats::audio::BatchImportQueue;
+using undergroundBeats::audio::SeparationCache;
+using undergroundBeats::audio::StemLoadPipeline;
+using undergroundBeats::ml::ONNXModelLoader;
+using undergroundBeats::ml::SeparatorRegistry;
+using undergroundBeats::test::makeNoise;
+
+// Jobs are started and reported on the message thread, which is this one
+static juce::ScopedJuceInitialiser_GUI guiInitialiser;
+
+namespace {
+
+using JobState = BatchImportQueue::JobState;
+
+// A backend whose two stems are the mix it is given; see scripts/make_identity_model.py
+StemLoadPipeline::SeparationOptions makeIdentitySeparation()
+{
+    const auto modelPath = juce::File(UNDERGROUNDBEATS_TEST_DIR).getChildFile("ml/fixtures/identity_separation.onnx");
+
+    StemLoadPipeline::SeparationOptions separation;
+    separation.backend = SeparatorRegistry::makeONNXBackend({ "identity", { "first", "second" }, 44100.0, 0, 0.1, 0.1f },
+                                                            modelPath.getFullPathName().toStdString());
+    return separation;
+}
+
+juce::Array<juce::File> writeTracks(int numTracks, int numSeconds)
+{
+    juce::Array<juce::File> files;
+    juce::WavAudioFormat wav;
+
+    for (int i = 0; i < numTracks; ++i)
+    {
+        const auto audio = makeNoise(2, numSeconds * 44100, i + 1, 0.5f);
+        auto file = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("batch", ".wav");
+        std::unique_ptr<juce::AudioFormatWriter> writer(
+            wav.createWriterFor(new juce::FileOutputStream(file), 44100.0, 2, 32, {}, 0));
+        writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+        files.add(file);
+    }
+
+    return files;
+}
+
+int countActive(const std::vector<BatchImportQueue::JobInfo>& jobs)
+{
+    return (int) std::count_if(jobs.begin(), jobs.end(), [](const BatchImportQueue::JobInfo& job)
+    {
+        return job.state == JobState::WaitingForMemory || job.state == JobState::Running;
+    });
+}
+
+// Runs the queue's updates on this thread until it is idle; returns the most jobs seen active at once
+int runUntilIdle(BatchImportQueue& queue)
+{
+    int mostActive = 0;
+    for (int waited = 0; queue.isBusy(); waited += 5)
+    {
+        REQUIRE(waited < 120000);
+        queue.dispatchPendingUpdates();
+        mostActive = juce::jmax(mostActive, countActive(queue.getJobs()));
+        juce::Thread::sleep(5);
+    }
+
+    queue.dispatchPendingUpdates();
+    return mostActive;
+}
+
+} // namespace
+
+TEST_CASE("BatchImportQueue runs one job at a time and lets each past a budget it exceeds", "[audio][batch]") {
+    const auto cacheDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("batch_cache", "");
+    const auto files = writeTracks(3, 5);
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    ONNXModelLoader loader;
+    SeparationCache cache(cacheDirectory, (juce::int64) 1 << 30);
+
+    // Every track needs far more than the budget, so it only runs with the machine to itself
+    BatchImportQueue queue(formatManager, loader, cache);
+    queue.setLimits({ 1, 1024 });
+    REQUIRE(BatchImportQueue::estimateMemory(5 * 44100, 44100.0, 44100.0, 2) > 1024);
+
+    queue.addFiles(files, 44100.0, makeIdentitySeparation());
+    REQUIRE(countActive(queue.getJobs()) == 1);
+
+    REQUIRE(runUntilIdle(queue) == 1);
+    for (const auto& job : queue.getJobs())
+    {
+        REQUIRE(job.state == JobState::Finished);
+        REQUIRE_FALSE(job.wasCached);
+    }
+
+    for (const auto& file : files)
+        file.deleteFile();
+    cacheDirectory.deleteRecursively();
+}
+
+TEST_CASE("BatchImportQueue cancels queued and running jobs", "[audio][batch]") {
+    const auto cacheDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("batch_cache", "");
+    const auto files = writeTracks(3, 120);
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    ONNXModelLoader loader;
+    SeparationCache cache(cacheDirectory, (juce::int64) 1 << 30);
+
+    BatchImportQueue queue(formatManager, loader, cache);
+    queue.setLimits({ 1, 1024 });
+    queue.addFiles(files, 44100.0, makeIdentitySeparation());
+
+    // Cancel once the first track is being imported and the others wait their turn
+    for (int waited = 0; queue.getJobs().front().state != JobState::Running; ++waited)
+    {
+        REQUIRE(waited < 30000);
+        juce::Thread::sleep(1);
+    }
+
+    queue.cancelAll();
+    REQUIRE(runUntilIdle(queue) <= 1);
+
+    for (const auto& job : queue.getJobs())
+        REQUIRE(job.state == JobState::Cancelled);
+
+    for (const auto& file : files)
+        file.deleteFile();
+    cacheDirectory.deleteRecursively();
+}
@@ -0,0 +1,80 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/MidiControlMap.h"
+#include "undergroundBeats/audio/StemSlicePlayer.h"
+
+using undergroundBeats::audio::MidiControlMap;
+using undergroundBeats::audio::StemSlice;
+using undergroundBeats::audio::StemSlicePlayer;
+
+TEST_CASE("MidiControlMap resolves and learns controllers", "[audio][midi]") {
+    MidiControlMap map;
+    REQUIRE(map.handleController(7) == MidiControlMap::unmapped);
+
+    SECTION("Learn binds the next controller only") {
+        map.beginLearn(42);
+        REQUIRE(map.handleController(7) == 42);
+        REQUIRE(map.getLearnTarget() == MidiControlMap::unmapped);
+        REQUIRE(map.handleController(8) == MidiControlMap::unmapped);
+    }
+
+    SECTION("Clearing a parameter removes all of its controllers") {
+        map.setMapping(1, 5);
+        map.setMapping(2, 5);
+        map.setMapping(3, 6);
+        map.clearMappingsForParameter(5);
+        REQUIRE(map.getMapping(1) == MidiControlMap::unmapped);
+        REQUIRE(map.getMapping(2) == MidiControlMap::unmapped);
+        REQUIRE(map.getMapping(3) == 6);
+    }
+
+    SECTION("Mappings survive an XML round trip") {
+        map.setMapping(74, 12);
+        auto xml = map.createXml();
+        MidiControlMap restored;
+        restored.restoreFromXml(*xml);
+        REQUIRE(restored.getMapping(74) == 12);
+    }
+
+    REQUIRE(MidiControlMap::toNormalisedValue(127) == Approx(1.0f));
+}
+
+TEST_CASE("StemSlicePlayer plays slices from notes", "[audio][midi]") {
+    juce::AudioBuffer<float> stem(1, 1000);
+    for (int i = 0; i < stem.getNumSamples(); ++i)
+        stem.setSample(0, i, 1.0f);
+
+    StemSlicePlayer player;
+    player.sliceEvenly(0, stem.getNumSamples(), 4);
+    REQUIRE(player.getSlice(36).numSamples == 250);
+    REQUIRE(player.getSlice(39).startSample == 750);
+
+    juce::AudioBuffer<float> output(2, 512);
+    output.clear();
+
+    SECTION("A note renders its region with a fade-in, then the voice ends") {
+        player.noteOn(36, 1.0f);
+        REQUIRE(player.isStemActive(0));
+        REQUIRE_FALSE(player.isStemActive(1));
+
+        player.renderStem(0, stem, output, 512);
+        REQUIRE(output.getSample(0, 0) == Approx(0.0f));
+        REQUIRE(output.getSample(1, 100) == Approx(1.0f));
+        REQUIRE(output.getSample(0, 300) == Approx(0.0f));
+
+        player.advance(512);
+        REQUIRE_FALSE(player.isStemActive(0));
+    }
+
+    SECTION("Gated slices stop on note-off, one-shots do not") {
+        player.setSlice(60, { 0, 0, 1000, false });
+        player.noteOn(60, 1.0f);
+        player.noteOn(36, 1.0f);
+        player.advance(100);
+
+        player.noteOff(60);
+        player.noteOff(36);
+        player.advance(StemSlicePlayer::fadeSamples);
+        player.renderStem(0, stem, output, 16);
+        REQUIRE(output.getSample(0, 0) == Approx(1.0f).margin(0.01f)); // Only the one-shot is left
+    }
+}
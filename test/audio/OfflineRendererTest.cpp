@@ -0,0 +1,116 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/OfflineRenderer.h"
+#include "TestSignals.h"
+
+using undergroundBeats::audio::MemoryStemSource;
+using undergroundBeats::audio::OfflineRenderer;
+using undergroundBeats::audio::SharedAudio;
+using undergroundBeats::audio::StemRenderer;
+using undergroundBeats::test::makeNoise;
+
+namespace {
+
+juce::AudioBuffer<float> readFile(const juce::File& file)
+{
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(file.createInputStream().release(), true));
+    REQUIRE(reader != nullptr);
+
+    juce::AudioBuffer<float> audio((int) reader->numChannels, (int) reader->lengthInSamples);
+    reader->read(&audio, 0, audio.getNumSamples(), 0, true, true);
+    return audio;
+}
+
+} // namespace
+
+TEST_CASE("OfflineRenderer matches block-by-block playback and its stems add up to the mix", "[audio][render]") {
+    constexpr double sampleRate = 48000.0;
+    constexpr int length = OfflineRenderer::blockSize * OfflineRenderer::blocksPerBatch + 3000;
+
+    const std::vector<SharedAudio> stems { SharedAudio(makeNoise(2, length, 1, 0.5f)), SharedAudio(makeNoise(2, length + 500, 2, 0.5f)) };
+
+    OfflineRenderer::Session session;
+    session.sampleRate = sampleRate;
+    session.parameterValues = { 1.0f, 0.5f }; // Reverb on for stem 1, volume 0.5 for stem 2
+
+    for (size_t i = 0; i < stems.size(); ++i)
+    {
+        session.stems.push_back(std::make_shared<MemoryStemSource>(stems[i]));
+        StemRenderer::ParameterIndices indices;
+        indices.fill(-1);
+        session.stemParameters.push_back(indices);
+    }
+
+    session.stemParameters[0][StemRenderer::reverbEnable] = 0;
+    session.stemParameters[1][StemRenderer::volume] = 1;
+
+    auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("render", "");
+
+    OfflineRenderer::Options options;
+    options.outputDirectory = directory;
+    options.includeStems = true;
+    options.sampleFormat = OfflineRenderer::SampleFormat::Float32;
+
+    const auto result = OfflineRenderer::render(session, options, [] { return false; }, [](float) {});
+    REQUIRE(result.wasOk());
+
+    const auto mix = readFile(OfflineRenderer::getOutputFile(options, -1));
+    const auto stem1 = readFile(OfflineRenderer::getOutputFile(options, 0));
+    const auto stem2 = readFile(OfflineRenderer::getOutputFile(options, 1));
+    REQUIRE(mix.getNumSamples() == length); // The timeline ends with the shortest stem
+
+    // What playback produces with small device blocks
+    std::vector<StemRenderer::ParameterValues> values(2, StemRenderer::getDefaultValues());
+    values[0][StemRenderer::reverbEnable] = 1.0f;
+    values[1][StemRenderer::volume] = 0.5f;
+
+    StemRenderer renderers[2];
+    juce::AudioBuffer<float> expected(2, length);
+    juce::AudioBuffer<float> scratch(2, 512);
+    expected.clear();
+
+    for (int i = 0; i < 2; ++i)
+        renderers[i].prepare(sampleRate, 512);
+
+    for (int start = 0; start < length; start += 512)
+    {
+        const int numSamples = juce::jmin(512, length - start);
+        for (int i = 0; i < 2; ++i)
+        {
+            MemoryStemSource(stems[(size_t) i]).read(scratch, 0, numSamples, start);
+            renderers[i].process(scratch, numSamples, values[(size_t) i]);
+            for (int ch = 0; ch < 2; ++ch)
+                expected.addFrom(ch, start, scratch, ch, 0, numSamples, StemRenderer::getOutputGain(values[(size_t) i]));
+        }
+    }
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int i = 0; i < length; i += 97)
+        {
+            REQUIRE(mix.getSample(ch, i) == expected.getSample(ch, i));
+            REQUIRE(mix.getSample(ch, i) == stem1.getSample(ch, i) + stem2.getSample(ch, i));
+        }
+    }
+
+    directory.deleteRecursively();
+}
+
+TEST_CASE("OfflineRenderer deletes its files when cancelled", "[audio][render]") {
+    OfflineRenderer::Session session;
+    session.sampleRate = 44100.0;
+    session.stems.push_back(std::make_shared<MemoryStemSource>(SharedAudio(makeNoise(2, 1000, 3, 0.5f))));
+    StemRenderer::ParameterIndices indices;
+    indices.fill(-1);
+    session.stemParameters.push_back(indices);
+
+    auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("render", "");
+    OfflineRenderer::Options options;
+    options.outputDirectory = directory;
+
+    const auto result = OfflineRenderer::render(session, options, [] { return true; }, [](float) {});
+    REQUIRE(result.failed());
+    REQUIRE_FALSE(OfflineRenderer::getOutputFile(options, -1).exists());
+
+    directory.deleteRecursively();
+}
@@ -0,0 +1,145 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/ParallelAudioDecoder.h"
+#include "TestSignals.h"
+
+using undergroundBeats::audio::ParallelAudioDecoder;
+using undergroundBeats::test::makeNoise;
+
+namespace {
+
+// Decodes the start of a file on four threads and with a single reader
+std::pair<juce::AudioBuffer<float>, juce::AudioBuffer<float>> decodeBothWays(const juce::File& file, int length)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    juce::AudioBuffer<float> parallel(2, length), single(2, length);
+    const auto keepGoing = [] { return false; };
+    REQUIRE(ParallelAudioDecoder::decode(file, formatManager, parallel, 4, keepGoing, [](float) {}));
+    REQUIRE(ParallelAudioDecoder::decode(file, formatManager, single, 1, keepGoing, [](float) {}));
+    return { std::move(parallel), std::move(single) };
+}
+
+// Where decode() starts its segments for this length on four threads
+std::vector<int> getSegmentStarts(int length)
+{
+    const int numSegments = juce::jmin(4, length / ParallelAudioDecoder::minSamplesPerSegment);
+    const int alignment = ParallelAudioDecoder::segmentAlignment;
+    const int segmentLength = ((length + numSegments - 1) / numSegments + alignment - 1) / alignment * alignment;
+
+    std::vector<int> starts;
+    for (int start = segmentLength; start < length; start += segmentLength)
+        starts.push_back(start);
+    return starts;
+}
+
+// Lossy decoders are exact once the pre-roll has rebuilt their state. That is done well within
+// the first segmentAlignment samples of a segment, where a sample may be off by boundaryTolerance.
+void requireSameDecode(const juce::AudioBuffer<float>& parallel, const juce::AudioBuffer<float>& single,
+                       float boundaryTolerance)
+{
+    const int length = single.getNumSamples();
+    const auto starts = getSegmentStarts(length);
+    REQUIRE(starts.size() == 3);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        size_t next = 0;
+        for (int i = 0; i < length; ++i)
+        {
+            while (next < starts.size() && i >= starts[next] + ParallelAudioDecoder::segmentAlignment)
+                ++next;
+
+            const bool nearStart = next < starts.size() && i >= starts[next];
+            if (nearStart)
+                REQUIRE(parallel.getSample(ch, i) == Approx(single.getSample(ch, i)).margin(boundaryTolerance));
+            else if (parallel.getSample(ch, i) != single.getSample(ch, i))
+                FAIL("channel " << ch << ", sample " << i << " differs away from a segment start");
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("ParallelAudioDecoder matches a single sequential read", "[audio][decode]") {
+    // Long enough for several segments
+    const int length = 4 * ParallelAudioDecoder::minSamplesPerSegment + 1234;
+    const auto original = makeNoise(2, length, 42);
+
+    auto file = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("decode", ".wav");
+    {
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(
+            wav.createWriterFor(new juce::FileOutputStream(file), 44100.0, 2, 32, {}, 0));
+        REQUIRE(writer != nullptr);
+        REQUIRE(writer->writeFromAudioSampleBuffer(original, 0, length));
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    juce::AudioBuffer<float> decoded(2, length);
+    float lastProgress = 0.0f;
+    REQUIRE(ParallelAudioDecoder::decode(file, formatManager, decoded, 4,
+                                         [] { return false; },
+                                         [&](float progress) { lastProgress = progress; }));
+    REQUIRE(lastProgress == Approx(1.0f));
+
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < length; i += 997)
+            REQUIRE(decoded.getSample(ch, i) == original.getSample(ch, i));
+
+    SECTION("Stopping abandons the decode") {
+        REQUIRE_FALSE(ParallelAudioDecoder::decode(file, formatManager, decoded, 4,
+                                                   [] { return true; }, [](float) {}));
+    }
+
+    file.deleteFile();
+}
+
+TEST_CASE("ParallelAudioDecoder decodes compressed formats as a single reader does", "[audio][decode]") {
+    // Four segments and a bit
+    const int length = 4 * ParallelAudioDecoder::minSamplesPerSegment + 1234;
+
+    SECTION("FLAC is lossless, so every sample matches") {
+        const auto original = makeNoise(2, length, 5, 0.5f);
+        auto file = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("decode", ".flac");
+        {
+            juce::FlacAudioFormat flac;
+            std::unique_ptr<juce::AudioFormatWriter> writer(
+                flac.createWriterFor(new juce::FileOutputStream(file), 44100.0, 2, 24, {}, 5));
+            REQUIRE(writer != nullptr);
+            REQUIRE(writer->writeFromAudioSampleBuffer(original, 0, length));
+        }
+
+        const auto [parallel, single] = decodeBothWays(file, length);
+        requireSameDecode(parallel, single, 0.0f);
+        file.deleteFile();
+    }
+
+    SECTION("Ogg Vorbis matches away from segment starts") {
+        const auto original = makeNoise(2, length, 6, 0.5f);
+        auto file = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("decode", ".ogg");
+        {
+            juce::OggVorbisAudioFormat ogg;
+            std::unique_ptr<juce::AudioFormatWriter> writer(
+                ogg.createWriterFor(new juce::FileOutputStream(file), 44100.0, 2, 16, {}, 5));
+            REQUIRE(writer != nullptr);
+            REQUIRE(writer->writeFromAudioSampleBuffer(original, 0, length));
+        }
+
+        const auto [parallel, single] = decodeBothWays(file, length);
+        requireSameDecode(parallel, single, 1.0e-3f);
+        file.deleteFile();
+    }
+
+    SECTION("MP3 matches away from segment starts") {
+        // Any of the bundled beats; each is longer than the part decoded
+        const auto beats = juce::File(UNDERGROUNDBEATS_TEST_DIR).getSiblingFile("beats")
+                               .findChildFiles(juce::File::findFiles, false, "*.mp3");
+        REQUIRE_FALSE(beats.isEmpty());
+
+        const auto [parallel, single] = decodeBothWays(beats[0], length);
+        requireSameDecode(parallel, single, 1.0e-3f);
+    }
+}
@@ -0,0 +1,65 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/PolyphaseResampler.h"
+#include "TestSignals.h"
+#include <cmath>
+
+using undergroundBeats::audio::PolyphaseResampler;
+using undergroundBeats::audio::SharedAudio;
+using undergroundBeats::test::makeSine;
+
+namespace {
+
+// Largest deviation from the ideal sine over the middle half, away from the edges
+float maxErrorAgainstSine(const juce::AudioBuffer<float>& buffer, double frequency, double sampleRate)
+{
+    const int length = buffer.getNumSamples();
+    float maxError = 0.0f;
+
+    for (int i = length / 4; i < 3 * length / 4; ++i)
+    {
+        const auto expected = (float) std::sin(juce::MathConstants<double>::twoPi * frequency * i / sampleRate);
+        maxError = juce::jmax(maxError, std::abs(buffer.getSample(0, i) - expected));
+    }
+
+    return maxError;
+}
+
+} // namespace
+
+TEST_CASE("PolyphaseResampler reduces common rate pairs exactly", "[audio][resampler]") {
+    PolyphaseResampler up(44100.0, 48000.0);
+    REQUIRE(up.getUpsamplingFactor() == 160);
+    REQUIRE(up.getDownsamplingFactor() == 147);
+    REQUIRE(up.getOutputLength(44100) == 48000);
+
+    PolyphaseResampler down(96000.0, 44100.0);
+    REQUIRE(down.getUpsamplingFactor() == 147);
+    REQUIRE(down.getDownsamplingFactor() == 320);
+    REQUIRE(down.getOutputLength(96000) == 44100);
+}
+
+TEST_CASE("PolyphaseResampler keeps a tone's pitch, level and phase", "[audio][resampler]") {
+    SECTION("Upsampling") {
+        auto output = PolyphaseResampler(44100.0, 48000.0).process(makeSine(1000.0, 44100.0, 44100));
+        REQUIRE(output.getNumSamples() == 48000);
+        REQUIRE(maxErrorAgainstSine(output, 1000.0, 48000.0) < 1.0e-3f);
+    }
+
+    SECTION("Downsampling") {
+        auto output = PolyphaseResampler(48000.0, 44100.0).process(makeSine(5000.0, 48000.0, 48000));
+        REQUIRE(output.getNumSamples() == 44100);
+        REQUIRE(maxErrorAgainstSine(output, 5000.0, 44100.0) < 1.0e-3f);
+    }
+}
+
+TEST_CASE("PolyphaseResampler removes content above the new Nyquist frequency", "[audio][resampler]") {
+    // 30 kHz would alias to 14.1 kHz at 44.1 kHz
+    auto output = PolyphaseResampler(96000.0, 44100.0).process(makeSine(30000.0, 96000.0, 96000));
+    REQUIRE(output.getMagnitude(0, 11025, 22050) < 1.0e-3f);
+}
+
+TEST_CASE("PolyphaseResampler shares the input when the rates already match", "[audio][resampler]") {
+    SharedAudio input(makeSine(440.0, 48000.0, 1000));
+    auto output = PolyphaseResampler::resample(input, 48000.0, 48000.0);
+    REQUIRE(output.sharesDataWith(input));
+}
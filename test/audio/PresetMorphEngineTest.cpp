@@ -0,0 +1,42 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/PresetMorphEngine.h"
+
+using undergroundBeats::audio::PresetMorphEngine;
+
+TEST_CASE("PresetMorphEngine morphs only differing parameters", "[audio][morph]") {
+    // Parameter 1 is a toggle, parameter 3 is the morph control itself
+    PresetMorphEngine engine;
+    engine.initialise({ false, true, false, false }, 3);
+    engine.storeSnapshot(0, { 0.0f, 0.0f, 0.5f, 0.0f });
+    engine.storeSnapshot(1, { 1.0f, 1.0f, 0.5f, 1.0f });
+    engine.setMorphPair(0, 1);
+
+    SECTION("Continuous values interpolate, toggles switch at the threshold") {
+        REQUIRE(engine.process(0.25f) == 2);
+        REQUIRE(engine.getChanges()[0].parameterIndex == 0);
+        REQUIRE(engine.getChanges()[0].value == Approx(0.25f));
+        REQUIRE(engine.getChanges()[1].value == Approx(0.0f));
+
+        REQUIRE(engine.process(0.75f) == 2);
+        REQUIRE(engine.getChanges()[1].value == Approx(1.0f));
+    }
+
+    SECTION("Nothing is produced while the amount is unchanged") {
+        REQUIRE(engine.process(0.5f) == 2);
+        REQUIRE(engine.process(0.5f) == 0);
+    }
+
+    SECTION("Morphing stays off until both slots are filled") {
+        engine.clearSnapshot(1);
+        REQUIRE(engine.process(0.5f) == 0);
+    }
+
+    SECTION("Snapshots survive an XML round trip") {
+        auto xml = engine.createXml();
+        PresetMorphEngine restored;
+        restored.initialise({ false, true, false, false }, 3);
+        restored.restoreFromXml(*xml);
+        REQUIRE(restored.hasSnapshot(1));
+        REQUIRE(restored.process(1.0f) == 2);
+    }
+}
@@ -0,0 +1,100 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/ProgressiveStemSource.h"
+#include "TestSignals.h"
+
+using undergroundBeats::audio::ProgressiveSeparation;
+using undergroundBeats::audio::SharedAudio;
+using undergroundBeats::test::makeConstant;
+
+TEST_CASE("ProgressiveStemSource plays finished segments and a share of the mix elsewhere", "[audio][stems]") {
+    // Three segments of 100 samples and a last one of 50
+    auto separation = std::make_shared<ProgressiveSeparation>(SharedAudio(makeConstant(2, 350, 0.8f)), 4, 100);
+    REQUIRE(separation->getNumSegments() == 4);
+
+    auto views = separation->getWriteViews();
+    auto sources = ProgressiveSeparation::createSources(separation);
+    REQUIRE(sources.size() == 4);
+    REQUIRE(sources[0]->getResidentBuffer() == nullptr);
+    REQUIRE_FALSE(sources[0]->readEntireStem().isValid());
+
+    for (int ch = 0; ch < 2; ++ch)
+        juce::FloatVectorOperations::fill(views[0].getWritePointer(ch, 100), 0.5f, 100);
+    separation->markSegmentFinished(1);
+
+    juce::AudioBuffer<float> output(2, 150);
+    REQUIRE(sources[0]->read(output, 0, 150, 50));
+    REQUIRE(output.getSample(0, 0) == Approx(0.2f));   // Segment 0: a quarter of the mix
+    REQUIRE(output.getSample(1, 50) == Approx(0.5f));  // Segment 1: the separated stem
+    REQUIRE(output.getSample(0, 149) == Approx(0.5f));
+
+    // The separator works from wherever playback last read
+    REQUIRE(separation->getPriorityPosition() == 50);
+
+    REQUIRE_FALSE(sources[0]->read(output, 0, 100, 300));
+    REQUIRE(output.getSample(0, 49) == Approx(0.2f));
+    REQUIRE(output.getSample(0, 50) == 0.0f);
+
+    for (int segment : { 0, 2, 3 })
+        separation->markSegmentFinished(segment);
+
+    REQUIRE(separation->isComplete());
+    REQUIRE(sources[0]->readEntireStem().sharesDataWith(separation->getStems()[0]));
+}
+
+TEST_CASE("ProgressiveStemSource draws its waveform only from finished segments", "[audio][stems]") {
+    // Segments of 300 samples, so overview points of 256 samples straddle them
+    auto separation = std::make_shared<ProgressiveSeparation>(SharedAudio(makeConstant(2, 1000, 0.8f)), 4, 300);
+    auto views = separation->getWriteViews();
+    auto sources = ProgressiveSeparation::createSources(separation);
+
+    for (int ch = 0; ch < 2; ++ch)
+        juce::FloatVectorOperations::fill(views[0].getWritePointer(ch, 300), 0.5f, 300);
+
+    // Written but not finished: still drawn as a share of the mix
+    const auto* overview = sources[0]->getDisplayBuffer();
+    REQUIRE(overview->getNumSamples() == 4);
+    REQUIRE(overview->getSample(0, 1) == Approx(0.2f));
+
+    separation->markSegmentFinished(1);
+    REQUIRE(sources[0]->getDisplayBuffer() == overview);
+    REQUIRE(overview->getSample(0, 0) == Approx(0.2f));
+    REQUIRE(overview->getSample(0, 1) == Approx(0.5f));
+    REQUIRE(overview->getSample(1, 2) == Approx(0.5f));
+    REQUIRE(overview->getSample(1, 3) == Approx(0.2f));
+}
+
+TEST_CASE("ProgressiveStemSource plays a separation at another rate at the playback rate", "[audio][stems]") {
+    // Separated at 44.1 kHz, played at twice that
+    auto separation = std::make_shared<ProgressiveSeparation>(SharedAudio(makeConstant(2, 350, 0.8f)), 4, 100,
+                                                              44100.0, 88200.0);
+    REQUIRE(separation->isResampled());
+    REQUIRE(separation->getPlaybackLength() == 700);
+
+    auto views = separation->getWriteViews();
+    auto sources = ProgressiveSeparation::createSources(separation);
+    REQUIRE(sources[0]->getLengthInSamples() == 700);
+
+    for (int ch = 0; ch < 2; ++ch)
+        juce::FloatVectorOperations::fill(views[0].getWritePointer(ch, 100), 0.5f, 100);
+    separation->markSegmentFinished(1);
+
+    // Well inside each segment, away from the taps that reach into its neighbours
+    juce::AudioBuffer<float> output(2, 300);
+    REQUIRE(sources[0]->read(output, 0, 300, 100));
+    REQUIRE(output.getSample(0, 10) == Approx(0.2f));
+    REQUIRE(output.getSample(1, 200) == Approx(0.5f));
+
+    // The separator is told where playback is in its own samples
+    REQUIRE(separation->getPriorityPosition() == 50);
+
+    REQUIRE_FALSE(sources[0]->read(output, 0, 100, 650));
+    REQUIRE(output.getSample(0, 49) == Approx(0.2f));
+    REQUIRE(output.getSample(0, 50) == 0.0f);
+
+    for (int segment : { 0, 2, 3 })
+        separation->markSegmentFinished(segment);
+
+    const auto entire = sources[0]->readEntireStem();
+    REQUIRE(entire.isValid());
+    REQUIRE(entire->getNumSamples() == 700);
+}
@@ -0,0 +1,67 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/SeparationCache.h"
+#include "TestSignals.h"
+
+using undergroundBeats::audio::SeparationCache;
+using undergroundBeats::audio::SharedAudio;
+using undergroundBeats::test::makeNoise;
+
+namespace {
+
+SeparationCache::Entry makeEntry(int seed)
+{
+    return { 48000.0, SharedAudio(makeNoise(2, 1000, seed)),
+             { SharedAudio(makeNoise(2, 1000, seed + 1)), SharedAudio(makeNoise(1, 1000, seed + 2)) }, "fast" };
+}
+
+} // namespace
+
+TEST_CASE("SeparationCache returns what was stored", "[audio][cache]") {
+    auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("separation", "");
+    SeparationCache cache(directory, 1 << 20);
+
+    REQUIRE_FALSE(cache.lookup("missing").has_value());
+    REQUIRE_FALSE(cache.contains("track"));
+
+    const auto stored = makeEntry(1);
+    REQUIRE(cache.store("track", stored));
+    REQUIRE(cache.contains("track"));
+
+    auto entry = cache.lookup("track");
+    REQUIRE(entry.has_value());
+    REQUIRE(entry->sampleRate == 48000.0);
+    REQUIRE(entry->modelVariant == "fast");
+    REQUIRE(entry->stems.size() == 2);
+    REQUIRE(entry->stems[1]->getNumChannels() == 1);
+    REQUIRE(entry->mix->getSample(1, 999) == stored.mix->getSample(1, 999));
+    REQUIRE(entry->stems[0]->getSample(0, 500) == stored.stems[0]->getSample(0, 500));
+
+    SECTION("A damaged entry is a miss and is removed") {
+        auto stemFile = directory.getChildFile("track").getChildFile("stem_0.pcm");
+        juce::FileOutputStream stream(stemFile);
+        stream.setPosition(200);
+        stream.writeFloat(123.0f);
+        stream.flush();
+
+        REQUIRE_FALSE(cache.lookup("track").has_value());
+        REQUIRE_FALSE(directory.getChildFile("track").exists());
+    }
+
+    SECTION("The least recently used entry goes first") {
+        // Each entry is about 20 KB; leave room for two
+        cache.setMaxSize(45 * 1024);
+        juce::Thread::sleep(1100); // File times can have one-second resolution
+        REQUIRE(cache.store("second", makeEntry(10)));
+        juce::Thread::sleep(1100);
+        REQUIRE(cache.lookup("track").has_value()); // Now newer than "second"
+        juce::Thread::sleep(1100);
+        REQUIRE(cache.store("third", makeEntry(20)));
+
+        REQUIRE(cache.lookup("track").has_value());
+        REQUIRE_FALSE(cache.lookup("second").has_value());
+        REQUIRE(cache.lookup("third").has_value());
+        REQUIRE(cache.getSizeOnDisk() <= 45 * 1024);
+    }
+
+    directory.deleteRecursively();
+}
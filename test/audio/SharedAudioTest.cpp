@@ -0,0 +1,40 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/SharedAudio.h"
+
+using undergroundBeats::audio::SharedAudio;
+
+TEST_CASE("SharedAudio copies only on write to shared data", "[audio][shared]") {
+    juce::AudioBuffer<float> buffer(2, 64);
+    buffer.clear();
+    buffer.setSample(0, 0, 0.5f);
+
+    SharedAudio original(std::move(buffer));
+    REQUIRE(original.isUnique());
+
+    SECTION("Copies share the audio") {
+        SharedAudio copy = original;
+        REQUIRE(copy.sharesDataWith(original));
+        REQUIRE(&copy.read() == &original.read());
+    }
+
+    SECTION("Writing to a shared handle detaches it") {
+        SharedAudio copy = original;
+        copy.write().setSample(0, 0, 1.0f);
+
+        REQUIRE_FALSE(copy.sharesDataWith(original));
+        REQUIRE(original->getSample(0, 0) == 0.5f);
+        REQUIRE(copy->getSample(0, 0) == 1.0f);
+    }
+
+    SECTION("Writing to a unique handle edits in place") {
+        const auto* before = original.get();
+        original.write().setSample(1, 0, 0.25f);
+        REQUIRE(original.get() == before);
+    }
+
+    SECTION("Releasing a unique handle moves the audio out") {
+        auto released = original.release();
+        REQUIRE_FALSE(original.isValid());
+        REQUIRE(released.getSample(0, 0) == 0.5f);
+    }
+}
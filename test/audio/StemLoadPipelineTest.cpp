@@ -0,0 +1,130 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/StemLoadPipeline.h"
+#include "undergroundBeats/ml/ONNXModelLoader.h"
+#include "TestSignals.h"
+
+using undergroundBeats::audio::StemLoadPipeline;
+using undergroundBeats::ml::ModelVariant;
+using undergroundBeats::ml::ONNXModelLoader;
+using undergroundBeats::ml::SeparatorRegistry;
+using undergroundBeats::test::makeNoise;
+using undergroundBeats::test::makeSine;
+
+// Publishing happens on the message thread, which is this one
+static juce::ScopedJuceInitialiser_GUI guiInitialiser;
+
+namespace {
+
+// A backend whose two stems are the mix it is given, separated at 44.1 kHz; see scripts/make_identity_model.py
+StemLoadPipeline::SeparationOptions makeIdentitySeparation()
+{
+    const auto modelPath = juce::File(UNDERGROUNDBEATS_TEST_DIR).getChildFile("ml/fixtures/identity_separation.onnx");
+
+    StemLoadPipeline::SeparationOptions separation;
+    separation.backend = SeparatorRegistry::makeONNXBackend({ "identity", { "first", "second" }, 44100.0, 0, 0.1, 0.1f },
+                                                            modelPath.getFullPathName().toStdString());
+    separation.variant = ModelVariant::Quality;
+    return separation;
+}
+
+juce::File writeWav(const juce::AudioBuffer<float>& audio, double sampleRate)
+{
+    auto file = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("pipeline", ".wav");
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(
+        wav.createWriterFor(new juce::FileOutputStream(file), sampleRate, (unsigned int) audio.getNumChannels(), 32, {}, 0));
+    writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+    return file;
+}
+
+} // namespace
+
+TEST_CASE("StemLoadPipeline previews a track played at a rate other than the model's", "[audio][pipeline]") {
+    // A second of a low tone at 48 kHz, which the identity model separates at 44.1 kHz
+    const int length = 48000;
+    const auto tone = makeSine(110.0, 48000.0, length);
+    juce::AudioBuffer<float> mix(2, length);
+    for (int ch = 0; ch < 2; ++ch)
+        mix.copyFrom(ch, 0, tone, 0, 0, length);
+
+    const auto file = writeWav(mix, 48000.0);
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    ONNXModelLoader loader;
+
+    std::vector<StemLoadPipeline::Result> previews;
+    auto result = StemLoadPipeline::runStages(file, 48000.0, formatManager, loader, {}, nullptr, makeIdentitySeparation(),
+                                              [] { return false; }, [](StemLoadPipeline::Stage, float) {},
+                                              [&](StemLoadPipeline::Result&& preview) { previews.push_back(std::move(preview)); });
+    file.deleteFile();
+
+    REQUIRE(result.error.isEmpty());
+    REQUIRE(result.separated);
+    REQUIRE(result.followsPreview);
+    REQUIRE(result.sampleRate == 48000.0);
+
+    REQUIRE(previews.size() == 1);
+    const auto& preview = previews.front();
+    REQUIRE(preview.isPreview);
+    REQUIRE(preview.sampleRate == 48000.0);
+    REQUIRE(preview.sources.size() == 2);
+
+    // The preview plays at 48 kHz: about as long as the mix, and the tone at its pitch
+    auto& source = *preview.sources.front();
+    REQUIRE(std::abs(source.getLengthInSamples() - length) <= 1);
+
+    juce::AudioBuffer<float> played(2, 4800);
+    REQUIRE(source.read(played, 0, 4800, 24000));
+    for (int i = 0; i < 4800; i += 97)
+        REQUIRE(played.getSample(0, i) == Approx(mix.getSample(0, 24000 + i)).margin(0.01));
+
+    // The final stems are converted back to the mix's rate
+    REQUIRE(result.stems.size() == 2);
+    for (const auto& stem : result.stems)
+        REQUIRE(stem->getNumSamples() == length);
+}
+
+TEST_CASE("StemLoadPipeline never publishes a load that a newer one cancelled", "[audio][pipeline]") {
+    // A long first track, so it is still separating when the second is loaded
+    const auto first = writeWav(makeNoise(2, 120 * 44100, 1, 0.5f), 44100.0);
+    const auto second = writeWav(makeNoise(2, 44100, 2, 0.5f), 44100.0);
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    ONNXModelLoader loader;
+
+    StemLoadPipeline pipeline(formatManager, loader);
+    pipeline.setSeparationOptions(makeIdentitySeparation());
+
+    std::vector<StemLoadPipeline::Result> published;
+    pipeline.onPublish = [&](StemLoadPipeline::Result&& result) { published.push_back(std::move(result)); };
+
+    // Nothing is published while this thread only waits: the first load gets as far as
+    // separating, and has a preview waiting, before the second replaces it
+    using Stage = StemLoadPipeline::Stage;
+    pipeline.load(first, 44100.0);
+    for (int waited = 0; pipeline.getStage() == Stage::Decode || pipeline.getStage() == Stage::Resample; ++waited)
+    {
+        REQUIRE(waited < 30000);
+        juce::Thread::sleep(1);
+    }
+
+    pipeline.load(second, 44100.0);
+    for (int waited = 0; pipeline.isLoading(); waited += 10)
+    {
+        REQUIRE(waited < 60000);
+        pipeline.dispatchPendingUpdates();
+        juce::Thread::sleep(10);
+    }
+    pipeline.dispatchPendingUpdates();
+
+    REQUIRE(pipeline.getStage() == Stage::Finished);
+    REQUIRE_FALSE(published.empty());
+    for (const auto& result : published)
+        REQUIRE(result.file == second);
+    REQUIRE_FALSE(published.back().isPreview);
+    REQUIRE(published.back().mix->getNumSamples() == 44100);
+
+    first.deleteFile();
+    second.deleteFile();
+}
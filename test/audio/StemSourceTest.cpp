@@ -0,0 +1,115 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/audio/CompactStemSource.h"
+#include "undergroundBeats/audio/StemSource.h"
+#include "undergroundBeats/audio/StreamingStemSource.h"
+#include "TestSignals.h"
+
+using undergroundBeats::audio::CompactStemSource;
+using undergroundBeats::audio::MemoryStemSource;
+using undergroundBeats::audio::SharedAudio;
+using undergroundBeats::audio::StreamingStemSource;
+using undergroundBeats::test::makeRamp;
+
+TEST_CASE("MemoryStemSource up-mixes and pads with silence", "[audio][stems]") {
+    MemoryStemSource source(SharedAudio(makeRamp(100)));
+    juce::AudioBuffer<float> output(2, 20);
+
+    REQUIRE(source.read(output, 0, 20, 10));
+    REQUIRE(output.getSample(1, 0) == Approx(0.1f));
+
+    REQUIRE_FALSE(source.read(output, 0, 20, 90));
+    REQUIRE(output.getSample(1, 9) == Approx(0.99f));
+    REQUIRE(output.getSample(0, 10) == 0.0f);
+}
+
+TEST_CASE("CompactStemSource halves the memory and reads back within half precision", "[audio][stems]") {
+    const SharedAudio ramp(makeRamp(1000));
+    CompactStemSource source(*ramp);
+    REQUIRE(source.getResidentBytes() < ramp.getSizeInBytes() / 2 + 64);
+    REQUIRE(source.getResidentBuffer() == nullptr);
+
+    juce::AudioBuffer<float> output(2, 20);
+    REQUIRE(source.read(output, 0, 20, 500));
+    REQUIRE(output.getSample(0, 0) == Approx(0.5f).epsilon(1.0e-3));
+    REQUIRE(output.getSample(1, 19) == Approx(0.519f).epsilon(1.0e-3));
+
+    REQUIRE_FALSE(source.read(output, 0, 20, 990));
+    REQUIRE(output.getSample(0, 10) == 0.0f);
+
+    auto restored = source.readEntireStem();
+    REQUIRE(restored->getNumSamples() == 1000);
+    REQUIRE(restored->getSample(0, 250) == Approx(0.25f).epsilon(1.0e-3));
+}
+
+TEST_CASE("StreamingStemSource serves the head at once and the rest from read-ahead", "[audio][stems]") {
+    juce::TimeSliceThread thread("Test Read-Ahead");
+    thread.startThread();
+
+    const int length = 200000;
+    const SharedAudio ramp(makeRamp(length));
+    auto cacheFile = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("stem", ".wav");
+
+    // 600 KB budget: 782 overview points, a 38,204-sample head and three blocks read ahead
+    auto source = StreamingStemSource::create(*ramp, 44100.0, cacheFile, 600 * 1024, thread);
+    REQUIRE(source != nullptr);
+    REQUIRE(source->getResidentBytes() == (782 + 38204 + 3 * 32768) * sizeof(float));
+    REQUIRE(source->getLengthInSamples() == length);
+    REQUIRE(source->getResidentBuffer() == nullptr);
+    REQUIRE(source->getDisplayBuffer()->getNumSamples() == (length + 255) / 256);
+
+    juce::AudioBuffer<float> output(2, 512);
+    REQUIRE(source->read(output, 0, 512, 0));
+    REQUIRE(output.getSample(1, 100) == Approx(ramp->getSample(0, 100)));
+
+    // Give the read-ahead thread time to fill the window past the head
+    bool complete = false;
+    for (int attempt = 0; attempt < 200 && !complete; ++attempt)
+    {
+        complete = source->read(output, 0, 512, 60000);
+        if (!complete)
+            juce::Thread::sleep(10);
+    }
+
+    REQUIRE(complete);
+    REQUIRE(output.getSample(0, 0) == Approx(ramp->getSample(0, 60000)));
+
+    // A file reader of its own waits for the disk, so any position is complete at once
+    auto fileReader = source->createFileReader();
+    REQUIRE(fileReader != nullptr);
+    REQUIRE(fileReader->getResidentBytes() == 0);
+    REQUIRE(fileReader->read(output, 0, 512, 150000));
+    REQUIRE(output.getSample(1, 511) == Approx(ramp->getSample(0, 150511)));
+    REQUIRE_FALSE(fileReader->read(output, 0, 512, length - 256));
+    REQUIRE(output.getSample(0, 256) == 0.0f);
+    fileReader.reset();
+
+    source.reset();
+    REQUIRE_FALSE(cacheFile.exists());
+}
+
+TEST_CASE("StreamingStemSource gives up its head before overrunning a small budget", "[audio][stems]") {
+    juce::TimeSliceThread thread("Test Read-Ahead");
+    thread.startThread();
+
+    const int length = 200000;
+    const SharedAudio ramp(makeRamp(length));
+    auto cacheFile = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("stem", ".wav");
+
+    // Room for 80,000 mono samples: after the overview and two blocks, 13,682 are left for the head
+    const size_t budget = 80000 * sizeof(float);
+    auto source = StreamingStemSource::create(*ramp, 44100.0, cacheFile, budget, thread);
+    REQUIRE(source != nullptr);
+    REQUIRE(source->getResidentBytes() == budget);
+
+    // Below the minimum there is no head, and the source costs exactly the minimum
+    const auto minimum = StreamingStemSource::getMinimumRamBudget(1, length);
+    REQUIRE(minimum == (2 * 32768 + 782) * sizeof(float));
+
+    auto cacheFile2 = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("stem", ".wav");
+    auto tiny = StreamingStemSource::create(*ramp, 44100.0, cacheFile2, 10000 * sizeof(float), thread);
+    REQUIRE(tiny != nullptr);
+    REQUIRE(tiny->getResidentBytes() == minimum);
+
+    tiny.reset();
+    source.reset();
+}
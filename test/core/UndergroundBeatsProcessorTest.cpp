@@ -71,8 +71,8 @@ TEST_CASE("UndergroundBeatsProcessor Tests", "[core][processor]") {
         juce::File nonExistentFile = juce::File::getNonexistentFile();
         REQUIRE_FALSE(processor.loadAudioFile(nonExistentFile));
         // Check state after failed load (should be unchanged or reset)
-        // Assuming getSeparatedStemBuffers() exists and returns a const ref
-        REQUIRE(processor.getSeparatedStemBuffers().empty()); // Assuming it resets/clears on fail
+        // Assuming getStemSources() exists and returns a const ref
+        REQUIRE(processor.getStemSources().empty()); // Assuming it resets/clears on fail
 
         // TODO: Test successful load
         // This requires either:
@@ -87,7 +87,7 @@ TEST_CASE("UndergroundBeatsProcessor Tests", "[core][processor]") {
         // REQUIRE(processor.loadAudioFile(dummyFile));
         // // Check if stems were populated (even dummy ones if separation is mocked/simulated)
         // // This depends heavily on loadAudioFile's actual implementation regarding separation
-        // // REQUIRE_FALSE(processor.getSeparatedStemBuffers().empty());
+        // // REQUIRE_FALSE(processor.getStemSources().empty());
     }
 
     SECTION("Parameter Creation") {
@@ -200,4 +200,113 @@ TEST_CASE("UndergroundBeatsProcessor Tests", "[core][processor]") {
 
     // Release resources at the end of the test case
     processor.releaseResources();
-}
\ No newline at end of file
+}
+namespace {
+
+// Writes a constant stereo WAV at 44.1 kHz, the rate the processors below are prepared at
+juce::File writeConstantWav(int numSamples, float value)
+{
+    juce::AudioBuffer<float> audio(2, numSamples);
+    for (int ch = 0; ch < 2; ++ch)
+        juce::FloatVectorOperations::fill(audio.getWritePointer(ch), value, numSamples);
+
+    auto file = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("stem", ".wav");
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(
+        wav.createWriterFor(new juce::FileOutputStream(file), 44100.0, 2, 32, {}, 0));
+    writer->writeFromAudioSampleBuffer(audio, 0, numSamples);
+    return file;
+}
+
+} // namespace
+
+TEST_CASE("UndergroundBeatsProcessor undoes a slider gesture in one step", "[core][processor][undo]") {
+    undergroundBeats::UndergroundBeatsProcessor processor;
+    processor.prepareToPlay(44100.0, 512);
+    auto& undoManager = processor.getUndoManager();
+    undoManager.clearUndoHistory();
+
+    auto* volume = processor.getValueTreeState().getParameter(
+        undergroundBeats::UndergroundBeatsProcessor::getStemParameterID(0, "Volume"));
+    REQUIRE(volume != nullptr);
+    const float initial = volume->getValue();
+
+    // Two drags straight after each other; only the gestures separate them
+    volume->beginChangeGesture();
+    for (float value : { 0.6f, 0.5f, 0.4f, 0.3f })
+        volume->setValueNotifyingHost(value);
+    volume->endChangeGesture();
+
+    volume->beginChangeGesture();
+    for (float value : { 0.2f, 0.1f })
+        volume->setValueNotifyingHost(value);
+    volume->endChangeGesture();
+
+    REQUIRE(undoManager.undo());
+    REQUIRE(volume->getValue() == Approx(0.3f));
+
+    REQUIRE(undoManager.undo());
+    REQUIRE(volume->getValue() == Approx(initial));
+    REQUIRE_FALSE(undoManager.canUndo());
+
+    REQUIRE(undoManager.redo());
+    REQUIRE(volume->getValue() == Approx(0.3f));
+}
+
+TEST_CASE("UndergroundBeatsProcessor undoes a stem swap without copying audio", "[core][processor][undo]") {
+    undergroundBeats::UndergroundBeatsProcessor processor;
+    processor.prepareToPlay(44100.0, 512);
+    auto& undoManager = processor.getUndoManager();
+    undoManager.clearUndoHistory();
+
+    const auto first = writeConstantWav(1000, 0.25f);
+    const auto second = writeConstantWav(1000, 0.5f);
+
+    REQUIRE(processor.loadAndSwapStem(0, first));
+    const auto firstSource = processor.getStemSources()[0];
+    const auto firstAudio = firstSource->readEntireStem();
+
+    REQUIRE(processor.loadAndSwapStem(0, second));
+    REQUIRE(processor.getStemSources()[0]->readEntireStem()->getSample(0, 0) == 0.5f);
+
+    // The same source comes back, holding the very same buffer
+    REQUIRE(undoManager.undo());
+    REQUIRE(processor.getStemSources()[0] == firstSource);
+    REQUIRE(processor.getStemSources()[0]->readEntireStem().sharesDataWith(firstAudio));
+
+    first.deleteFile();
+    second.deleteFile();
+}
+
+TEST_CASE("UndergroundBeatsProcessor drops the oldest undo steps past its byte cap", "[core][processor][undo]") {
+    undergroundBeats::UndergroundBeatsProcessor processor;
+    processor.prepareToPlay(44100.0, 512);
+    auto& undoManager = processor.getUndoManager();
+    undoManager.clearUndoHistory();
+
+    // Each stem is 1 MB; a replaced stem is kept alive only by the swap that replaced it
+    processor.setUndoHistoryLimit(1, 1);
+    const int numSamples = 1024 * 1024 / (2 * (int) sizeof(float));
+    std::vector<juce::File> files;
+    for (int i = 0; i < 4; ++i)
+        files.push_back(writeConstantWav(numSamples, 0.1f * (float) (i + 1)));
+
+    REQUIRE(processor.loadAndSwapStem(0, files[0]));
+    std::weak_ptr<undergroundBeats::audio::StemSource> firstSource = processor.getStemSources()[0];
+
+    for (int i = 1; i < 4; ++i)
+        REQUIRE(processor.loadAndSwapStem(0, files[(size_t) i]));
+
+    // Three replaced stems would hold 3 MB: only the latest swap is left, and the audio
+    // the dropped swaps held is freed
+    REQUIRE(firstSource.expired());
+
+    int steps = 0;
+    while (undoManager.undo())
+        ++steps;
+    REQUIRE(steps == 1);
+    REQUIRE(processor.getStemSources()[0]->readEntireStem()->getSample(0, 0) == Approx(0.3f));
+
+    for (const auto& file : files)
+        file.deleteFile();
+}
@@ -0,0 +1,30 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/ml/ONNXModelLoader.h"
+
+using undergroundBeats::ml::ONNXModelLoader;
+
+TEST_CASE("ONNXModelLoader replaces an optimized graph it cannot load", "[ml][onnx]") {
+    const auto modelPath = juce::File(UNDERGROUNDBEATS_TEST_DIR).getChildFile("ml/fixtures/identity_separation.onnx")
+                               .getFullPathName().toStdString();
+    const auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("optimized", "");
+
+    ONNXModelLoader loader;
+    ONNXModelLoader::SessionSettings settings;
+    settings.optimizedModelDirectory = directory;
+
+    // The first session saves the graph it optimized
+    REQUIRE(loader.loadModel(modelPath, settings) != nullptr);
+    const auto saved = directory.findChildFiles(juce::File::findFiles, false, "*.onnx");
+    REQUIRE(saved.size() == 1);
+
+    // A damaged copy is deleted and the model optimized again, at the level asked for
+    REQUIRE(saved[0].replaceWithText("not a model"));
+    REQUIRE(loader.loadModel(modelPath, settings) != nullptr);
+    REQUIRE(saved[0].existsAsFile());
+    REQUIRE(saved[0].loadFileAsString() != "not a model");
+
+    // Which the next session loads as it is
+    REQUIRE(loader.loadModel(modelPath, settings) != nullptr);
+
+    directory.deleteRecursively();
+}
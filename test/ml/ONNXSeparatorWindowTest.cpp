@@ -0,0 +1,119 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/ml/ONNXModelLoader.h"
+#include "undergroundBeats/ml/ONNXSourceSeparator.h"
+#include "TestSignals.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+using undergroundBeats::ml::ONNXModelLoader;
+using undergroundBeats::ml::ONNXSourceSeparator;
+using undergroundBeats::test::makeNoise;
+
+namespace {
+
+// Returns both sources of its [1, 2, 4096] input unchanged; see scripts/make_identity_model.py
+std::string getIdentityModelPath()
+{
+    return juce::File(UNDERGROUNDBEATS_TEST_DIR).getChildFile("ml/fixtures/identity_separation.onnx")
+        .getFullPathName().toStdString();
+}
+
+float maxDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b, int start, int end)
+{
+    float difference = 0.0f;
+    for (int ch = 0; ch < a.getNumChannels(); ++ch)
+        for (int i = start; i < end; ++i)
+            difference = juce::jmax(difference, std::abs(a.getSample(ch, i) - b.getSample(ch, i)));
+    return difference;
+}
+
+} // namespace
+
+TEST_CASE("ONNXSourceSeparator crossfades an identity model's windows back into the mix", "[ml][onnx]") {
+    ONNXModelLoader loader;
+    ONNXSourceSeparator separator(getIdentityModelPath(), loader);
+    REQUIRE(separator.isReady());
+    REQUIRE(separator.getSourceNames() == std::vector<std::string> { "first", "second" });
+
+    const int window = 4096;
+    const int hop = separator.getWindowHop();
+    REQUIRE(hop == window - window / 4);
+
+    // Shorter than a window, whole hops past one, and ends inside a hop or an overlap
+    for (int length : { 1000, window, window + 2 * hop, window + 2 * hop + 100, window + 3 * hop - 50 }) {
+        const auto mix = makeNoise(2, length, length);
+        REQUIRE(separator.separate(mix, 44100.0));
+
+        const int expectedWindows = length <= window ? 1 : 1 + (length - window + hop - 1) / hop;
+        REQUIRE(separator.getLastTimings().numWindows == expectedWindows);
+
+        // sin^2 and 1 - sin^2 sum to one, up to rounding
+        const auto stems = separator.takeStems();
+        REQUIRE(stems.size() == 2);
+        for (const auto& stem : stems) {
+            REQUIRE(stem->getNumSamples() == length);
+            REQUIRE(maxDifference(*stem, mix, 0, length) <= 1.0e-6f);
+        }
+    }
+
+    SECTION("Every segment is reported once, and only when it is final") {
+        const int length = window + 3 * hop + 700;
+        const int numSegments = (length + hop - 1) / hop;
+        const auto mix = makeNoise(2, length, 3);
+
+        std::vector<juce::AudioBuffer<float>> stems(2, juce::AudioBuffer<float>(2, length));
+        for (auto& stem : stems)
+            stem.clear();
+
+        std::vector<int> reported;
+        float worstFinished = 0.0f;
+
+        ONNXSourceSeparator::WindowCallbacks callbacks;
+        callbacks.getPriorityPosition = [&] { return (juce::int64) (2 * hop + 10); };
+        callbacks.segmentFinished = [&](int segment) {
+            reported.push_back(segment);
+            const int start = segment * hop;
+            worstFinished = juce::jmax(worstFinished, maxDifference(stems[1], mix, start, juce::jmin(length, start + hop)));
+        };
+
+        REQUIRE(separator.separateInto(mix, stems, callbacks));
+        REQUIRE(worstFinished <= 1.0e-6f);
+
+        // The segment being played comes first
+        REQUIRE(reported.front() == 2);
+
+        std::sort(reported.begin(), reported.end());
+        std::vector<int> all((size_t) numSegments);
+        std::iota(all.begin(), all.end(), 0);
+        REQUIRE(reported == all);
+    }
+}
+
+TEST_CASE("ONNXSourceSeparator gives the same stems however many windows run at once", "[ml][onnx]") {
+    ONNXModelLoader loader;
+    ONNXSourceSeparator separator(getIdentityModelPath(), loader);
+    REQUIRE(separator.isReady());
+
+    // Enough windows to keep four lanes busy, ending part-way through a hop
+    const int length = 4096 + 11 * separator.getWindowHop() + 333;
+    const auto mix = makeNoise(2, length, 11);
+
+    separator.setParallelWindows(1);
+    REQUIRE(separator.getParallelWindows() == 1);
+    REQUIRE(separator.separate(mix, 44100.0));
+    const auto serial = separator.takeStems();
+
+    separator.setParallelWindows(4);
+    REQUIRE(separator.getParallelWindows() == 4);
+    REQUIRE(separator.separate(mix, 44100.0));
+    const auto parallel = separator.takeStems();
+
+    // Windows are added in the order they started, so the sums round the same way
+    REQUIRE(parallel.size() == serial.size());
+    for (size_t source = 0; source < serial.size(); ++source)
+        for (int ch = 0; ch < serial[source]->getNumChannels(); ++ch)
+            REQUIRE(std::memcmp(parallel[source]->getReadPointer(ch), serial[source]->getReadPointer(ch),
+                                sizeof(float) * (size_t) length) == 0);
+}
@@ -0,0 +1,57 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/ml/STFTProcessor.h"
+#include "TestSignals.h"
+#include <cmath>
+
+using undergroundBeats::ml::STFTProcessor;
+using undergroundBeats::test::makeNoise;
+
+TEST_CASE("STFTProcessor inverts its own transform on several threads", "[ml][stft]") {
+    STFTProcessor::Settings settings;
+    settings.fftOrder = 10;
+    settings.hopSize = 256;
+    settings.numThreads = 3;
+    STFTProcessor stft(settings);
+
+    const auto input = makeNoise(2, 20000);
+    STFTProcessor::Spectrogram spectrogram;
+    stft.forward(input, 0, input.getNumSamples(), spectrogram);
+
+    REQUIRE(spectrogram.numChannels == 2);
+    REQUIRE(spectrogram.numFrames == stft.getNumFrames(20000));
+    REQUIRE(spectrogram.numBins == 513);
+
+    juce::AudioBuffer<float> output(2, input.getNumSamples());
+    stft.inverse(spectrogram, output, 0, output.getNumSamples());
+
+    float maxError = 0.0f;
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < input.getNumSamples(); ++i)
+            maxError = juce::jmax(maxError, std::abs(output.getSample(ch, i) - input.getSample(ch, i)));
+
+    REQUIRE(maxError < 1.0e-4f);
+}
+
+TEST_CASE("STFTProcessor masks in the model's [channel][bin][frame] layout", "[ml][stft]") {
+    STFTProcessor::Settings settings;
+    settings.fftOrder = 9;
+    settings.hopSize = 128;
+    settings.numThreads = 1;
+    STFTProcessor stft(settings);
+
+    const auto input = makeNoise(1, 4000);
+    STFTProcessor::Spectrogram spectrogram, masked;
+    stft.forward(input, 0, input.getNumSamples(), spectrogram);
+
+    std::vector<float> magnitudes(static_cast<size_t>(spectrogram.numBins) * spectrogram.numFrames);
+    STFTProcessor::getMagnitudes(spectrogram, magnitudes.data());
+    REQUIRE(magnitudes[3 * static_cast<size_t>(spectrogram.numFrames) + 5] == Approx(std::abs(spectrogram.getFrame(0, 5)[3])));
+
+    // Half of every bin gives half the signal back
+    std::vector<float> mask(magnitudes.size(), 0.5f);
+    STFTProcessor::applyMask(spectrogram, mask.data(), 1, masked);
+
+    juce::AudioBuffer<float> output(1, input.getNumSamples());
+    stft.inverse(masked, output, 0, output.getNumSamples());
+    REQUIRE(output.getSample(0, 1234) == Approx(0.5f * input.getSample(0, 1234)).margin(1.0e-4f));
+}
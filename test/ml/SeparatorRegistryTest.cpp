@@ -0,0 +1,78 @@
+#include <catch2/catch.hpp>
+#include "undergroundBeats/ml/SeparatorRegistry.h"
+
+using undergroundBeats::ml::AudioSourceSeparator;
+using undergroundBeats::ml::ModelVariant;
+using undergroundBeats::ml::ONNXModelLoader;
+using undergroundBeats::ml::SeparatorRegistry;
+
+namespace {
+
+// Hands the mix back as every stem; needs no model
+class CopySeparator : public AudioSourceSeparator {
+public:
+    explicit CopySeparator(std::vector<std::string> stemNames) : names(std::move(stemNames)) {}
+
+    std::map<std::string, juce::AudioBuffer<float>> process(const juce::AudioBuffer<float>& inputBuffer) override
+    {
+        std::map<std::string, juce::AudioBuffer<float>> stems;
+        for (const auto& name : names)
+            stems[name] = inputBuffer;
+        return stems;
+    }
+
+    std::vector<std::string> getSourceNames() const override { return names; }
+    bool isReady() const override { return true; }
+
+private:
+    std::vector<std::string> names;
+};
+
+SeparatorRegistry::Backend makeBackend(const std::string& id, std::vector<std::string> stems, float cost,
+                                       double latencySeconds = 0.0)
+{
+    SeparatorRegistry::Backend backend;
+    backend.capabilities.id = id;
+    backend.capabilities.stemNames = stems;
+    backend.capabilities.relativeCost = cost;
+    backend.capabilities.latencySeconds = latencySeconds;
+    backend.create = [stems](ONNXModelLoader&, ModelVariant) { return std::make_unique<CopySeparator>(stems); };
+    return backend;
+}
+
+} // namespace
+
+TEST_CASE("SeparatorRegistry picks the cheapest backend that gives every stem", "[ml][registry]") {
+    SeparatorRegistry registry;
+    registry.add(makeBackend("4stem", { "drums", "bass", "vocals", "other" }, 1.0f));
+    registry.add(makeBackend("vocals", { "vocals", "accompaniment" }, 0.35f));
+    registry.add(makeBackend("cheap-vocals", { "vocals", "accompaniment" }, 0.2f));
+
+    REQUIRE(registry.select({ { "Vocals" } })->capabilities.id == "cheap-vocals");
+    REQUIRE(registry.select({ { "vocals", "bass" } })->capabilities.id == "4stem");
+    REQUIRE(registry.select({})->capabilities.id == "4stem");
+    REQUIRE_FALSE(registry.select({ { "piano" } }).has_value());
+}
+
+TEST_CASE("SeparatorRegistry passes over backends slower than the latency asked for", "[ml][registry]") {
+    SeparatorRegistry registry;
+    registry.add(makeBackend("4stem", { "drums", "bass", "vocals", "other" }, 1.0f, 2.0));
+    registry.add(makeBackend("slow-drums", { "drums", "rest" }, 0.3f, 8.0));
+
+    REQUIRE(registry.select({ { "drums" } })->capabilities.id == "slow-drums");
+    REQUIRE(registry.select({ { "drums" }, 4.0 })->capabilities.id == "4stem");
+    REQUIRE_FALSE(registry.select({ { "drums" }, 1.0 }).has_value());
+}
+
+TEST_CASE("SeparatorRegistry skips ONNX backends whose model isn't installed", "[ml][registry]") {
+    SeparatorRegistry registry;
+    registry.add(makeBackend("4stem", { "drums", "bass", "vocals", "other" }, 1.0f));
+    registry.add(SeparatorRegistry::makeONNXBackend({ "drums", { "drums", "rest" }, 44100.0, 0, 0.0, 0.1f },
+                                                    "models/not_installed.onnx"));
+
+    REQUIRE_FALSE(SeparatorRegistry::isAvailable(registry.getBackends()[1]));
+    REQUIRE(registry.select({ { "drums" } })->capabilities.id == "4stem");
+
+    // Backends without a model file are cached by id and variant
+    REQUIRE(SeparatorRegistry::getIdentity(registry.getBackends()[0], ModelVariant::Fast) == "4stem|fast");
+}